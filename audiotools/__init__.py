@@ -269,11 +269,38 @@ if config.has_option("System", "maximum_jobs"):
     MAX_JOBS = config.getint_default("System", "maximum_jobs", 1)
 else:
     try:
-        from multiprocessing import cpu_count
-        MAX_JOBS = cpu_count()
-    except (ImportError, AttributeError):
+        from audiotools.topology import available_cpus
+        MAX_JOBS = max(len(available_cpus()), 1)
+    except (ImportError, NotImplementedError):
         MAX_JOBS = 1
 
+WORKER_PLACEMENTS = ("none", "node", "cache")
+WORKER_PLACEMENT = config.get_default("System", "worker_placement", "cache")
+if WORKER_PLACEMENT not in WORKER_PLACEMENTS:
+    WORKER_PLACEMENT = "cache"
+
+DECODE_AHEAD = config.getint_default("System", "decode_ahead", 0)
+
+ENCODE_THREADS = config.getint_default("System", "encode_threads", 1)
+
+VERIFY_ENCODING = config.getboolean_default("System", "verify_encoding", False)
+
+RESAMPLE_QUALITIES = ("fastest", "medium", "best")
+RESAMPLE_QUALITY = config.get_default("System", "resample_quality", "best")
+if RESAMPLE_QUALITY not in RESAMPLE_QUALITIES:
+    RESAMPLE_QUALITY = "best"
+
+THUMBNAIL_FORMAT = config.get_default("Thumbnail", "format", "jpeg")
+THUMBNAIL_SIZE = config.getint_default("Thumbnail", "size", 150)
+THUMBNAIL_CACHE = config.get_default("Thumbnail", "cache",
+                                     os.path.join("~", ".cache",
+                                                  "audiotools", "art"))
+
+LOOKUP_CACHE = config.get_default("Lookup", "cache", "")
+LOOKUP_CACHE_DAYS = config.getint_default("Lookup", "cache_days", 30)
+LOOKUP_MIRROR = config.get_default("Lookup", "mirror", "")
+LOOKUP_WORKERS = config.getint_default("Lookup", "workers", 4)
+
 
 class Messenger(object):
     """this class is for displaying formatted output in a consistent way"""
@@ -2667,9 +2694,31 @@ def transfer_framelist_data(pcmreader, to_function,
 
     the pcmreader is closed when decoding is complete or fails with an error
 
+    if to_function is the write method of a binary file
+    backed by a file descriptor, FrameLists are converted and written
+    directly to that descriptor by a pcm.PCMSink object
+    rather than being converted to intermediate strings
+
     may raise IOError or ValueError if a problem occurs during decoding
     """
 
+    sink = __pcm_sink__(to_function, signed, big_endian)
+    if sink is not None:
+        try:
+            with sink:
+                f = pcmreader.read(FRAMELIST_SIZE)
+                while len(f) > 0:
+                    sink.write(f)
+                    f = pcmreader.read(FRAMELIST_SIZE)
+        finally:
+            pcmreader.close()
+            # resynchronize the file object with its descriptor
+            try:
+                to_function.__self__.tell()
+            except (IOError, OSError, ValueError):
+                pass
+        return
+
     try:
         f = pcmreader.read(FRAMELIST_SIZE)
         while len(f) > 0:
@@ -2679,6 +2728,34 @@ def transfer_framelist_data(pcmreader, to_function,
         pcmreader.close()
 
 
+def __pcm_sink__(to_function, signed, big_endian):
+    """given a function which takes strings of bytes
+    returns a pcm.PCMSink writing to its file descriptor
+    if the function is the write method of an OS-backed binary file
+    or None if it isn't"""
+
+    import io
+
+    stream = getattr(to_function, "__self__", None)
+    if ((stream is None) or
+        (getattr(to_function, "__name__", None) != "write") or
+        (not isinstance(stream, (io.BufferedIOBase, io.RawIOBase))) or
+        (getattr(stream, "closed", True))):
+        return None
+
+    try:
+        fd = stream.fileno()
+    except (AttributeError, IOError, OSError, ValueError):
+        # file-like objects such as BytesIO have no descriptor
+        return None
+
+    # anything already buffered by the file object
+    # must reach the descriptor before any PCM data
+    stream.flush()
+
+    return pcm.PCMSink(fd, big_endian, signed)
+
+
 def pcm_cmp(pcmreader1, pcmreader2):
     """returns True if the PCM data in pcmreader1 equals pcmreader2
 
@@ -2754,12 +2831,20 @@ def pcm_frame_cmp(pcmreader1, pcmreader2):
 class PCMCat(PCMReader):
     """a PCMReader for concatenating several PCMReaders"""
 
-    def __init__(self, pcmreaders):
+    def __init__(self, pcmreaders, envelope=None):
         """pcmreaders is a list of PCMReader objects
 
-        all must have the same stream attributes"""
+        all must have the same stream attributes
+
+        envelope is an optional list of (pcm_frame, gain) tuples
+        in PCM frame order, with gains from 0.0 to 1.0,
+        which the output's gain ramps linearly between
+        and holds steady before the first and after the last
+
+        for example, [(0, 0.0), (44100, 1.0)] fades in over 1 second
+        while [(b - 4410, 1.0), (b, 0.0), (b + 4410, 1.0)]
+        dips out and in around a boundary at PCM frame b"""
 
-        self.index = 0
         self.pcmreaders = list(pcmreaders)
 
         if len(self.pcmreaders) == 0:
@@ -2778,41 +2863,28 @@ class PCMCat(PCMReader):
             from audiotools.text import ERR_BPS_MISMATCH
             raise ValueError(ERR_BPS_MISMATCH)
 
-        first_reader = self.pcmreaders[self.index]
+        first_reader = self.pcmreaders[0]
         PCMReader.__init__(self,
                            sample_rate=first_reader.sample_rate,
                            channels=first_reader.channels,
                            channel_mask=first_reader.channel_mask,
                            bits_per_sample=first_reader.bits_per_sample)
 
+        from audiotools.pcmconverter import CatReader
+
+        self.__catreader__ = CatReader(self.pcmreaders, envelope)
+
     def read(self, pcm_frames):
         """try to read a pcm.FrameList with the given number of frames
 
         raises ValueError if any of the streams is mismatched"""
 
-        if self.index < len(self.pcmreaders):
-            # read a FrameList from the current PCMReader
-            framelist = self.pcmreaders[self.index].read(pcm_frames)
-            if len(framelist) > 0:
-                # if it has data, return it
-                return framelist
-            else:
-                # otherwise, move on to next pcmreader
-                self.index += 1
-                return self.read(pcm_frames)
-        else:
-            # all PCMReaders exhausted, so return empty FrameList
-            return pcm.empty_framelist(self.channels, self.bits_per_sample)
-
-    def read_closed(self, pcm_frames):
-        raise ValueError()
+        return self.__catreader__.read(pcm_frames)
 
     def close(self):
         """closes the stream for reading"""
 
-        self.read = self.read_closed
-        for reader in self.pcmreaders:
-            reader.close()
+        self.__catreader__.close()
 
 
 from audiotools.pcmconverter import BufferedPCMReader
@@ -2902,7 +2974,8 @@ def PCMConverter(pcmreader,
                  sample_rate,
                  channels,
                  channel_mask,
-                 bits_per_sample):
+                 bits_per_sample,
+                 resample_quality=None):
     """a PCMReader wrapper for converting attributes
 
     for example, this can be used to alter sample_rate, bits_per_sample,
@@ -2910,6 +2983,9 @@ def PCMConverter(pcmreader,
     attributes.  It resamples, downsamples, etc. to achieve the proper
     output
 
+    resample_quality is "fastest", "medium" or "best"
+    and defaults to RESAMPLE_QUALITY
+
     may raise ValueError if any of the attributes are unsupported
     or invalid
     """
@@ -2964,7 +3040,11 @@ def PCMConverter(pcmreader,
     if pcmreader.sample_rate != sample_rate:
         # convert sample rate through resampling
         from audiotools.pcmconverter import Resampler
-        pcmreader = Resampler(pcmreader, sample_rate)
+        pcmreader = Resampler(pcmreader,
+                              sample_rate,
+                              resample_quality if
+                              resample_quality is not None else
+                              RESAMPLE_QUALITY)
 
     if pcmreader.bits_per_sample != bits_per_sample:
         # use bitshifts/dithering to adjust bits-per-sample
@@ -5370,6 +5450,86 @@ def accuraterip_sheet_lookup(sheet, total_pcm_frames, sample_rate,
                           accuraterip_port)
 
 
+def metadata_lookups(musicbrainz_disc_ids,
+                     musicbrainz_server="musicbrainz.org",
+                     musicbrainz_port=80,
+                     use_musicbrainz=True,
+                     workers=None):
+    """given a list of MusicBrainz DiscID objects
+    performs metadata_lookup() on each of them concurrently
+
+    returns a list of metadata[c][t] lists of lists,
+    one per disc ID in the same order
+
+    workers is the most lookups performed at once
+    and defaults to the configured number of lookup workers"""
+
+    from audiotools.lookup import default_client
+
+    return default_client().map(
+        lambda disc_id: metadata_lookup(
+            musicbrainz_disc_id=disc_id,
+            musicbrainz_server=musicbrainz_server,
+            musicbrainz_port=musicbrainz_port,
+            use_musicbrainz=use_musicbrainz),
+        musicbrainz_disc_ids,
+        workers)
+
+
+def track_metadata_lookups(albums,
+                           musicbrainz_server="musicbrainz.org",
+                           musicbrainz_port=80,
+                           use_musicbrainz=True,
+                           workers=None):
+    """given a list of albums, each a list of AudioFile objects,
+    performs track_metadata_lookup() on each of them concurrently
+
+    returns a list of metadata[c][t] lists of lists,
+    one per album in the same order
+
+    workers is the most lookups performed at once
+    and defaults to the configured number of lookup workers"""
+
+    from audiotools.lookup import default_client
+
+    return default_client().map(
+        lambda audiofiles: track_metadata_lookup(
+            audiofiles=audiofiles,
+            musicbrainz_server=musicbrainz_server,
+            musicbrainz_port=musicbrainz_port,
+            use_musicbrainz=use_musicbrainz),
+        albums,
+        workers)
+
+
+def accuraterip_lookups(albums,
+                        accuraterip_server="www.accuraterip.com",
+                        accuraterip_port=80,
+                        workers=None):
+    """given a list of albums, each a list of sorted AudioFile objects,
+    performs accuraterip_lookup() on each of them concurrently
+
+    returns a list of
+    {track_number:[(confidence, crc, crc2), ...], ...}
+    dicts, one per album in the same order
+
+    workers is the most lookups performed at once
+    and defaults to the configured number of lookup workers
+
+    may raise urllib2.HTTPError if an error occurs querying the server
+    """
+
+    from audiotools.lookup import default_client
+
+    return default_client().map(
+        lambda sorted_tracks: accuraterip_lookup(
+            sorted_tracks,
+            accuraterip_server=accuraterip_server,
+            accuraterip_port=accuraterip_port),
+        albums,
+        workers)
+
+
 def output_progress(u, current, total):
     """given a unicode string and current/total integers,
     returns a u'[<current>/<total>]  <string>'  unicode string
@@ -5385,6 +5545,9 @@ def output_progress(u, current, total):
 class ExecProgressQueue(object):
     """a class for running multiple jobs in parallel with progress updates"""
 
+    # how often, in seconds, progress is sampled and redisplayed
+    PROGRESS_REFRESH = 0.25
+
     def __init__(self, messenger):
         """takes a Messenger object"""
 
@@ -5483,42 +5646,36 @@ class ExecProgressQueue(object):
         return results
 
     def __run_parallel__(self, max_processes=1):
-        """runs all the queued jobs in parallel"""
+        """runs all the queued jobs in parallel
+
+        a pool of worker processes is forked once up front
+        and reused for as many jobs as are queued
+
+        since workers inherit the queued jobs when forked,
+        only job indexes are sent to them
+        and only results are sent back, once each job completes
+
+        progress is published by each worker to its own slot
+        in a shared memory array which is sampled at a fixed rate"""
 
         from select import select
+        from time import time
 
-        def execute_next_job(progress_display):
-            """pulls the next job from the queue and returns a
-            (Process, Array, Connection, progress_text, completed_text) tuple
-            where Process is the subprocess
-            Array is shared memory of the current progress
-            Connection is the listening end of a pipe
-            progress_text is unicode to display during progress
-            and completed_text is unicode to display when finished"""
+        total_jobs = len(self.__queued_jobs__)
 
-            # pull parameters from job queue
-            (job_index,
-             progress_text,
-             completion_output,
-             function,
-             args,
-             kwargs) = self.__queued_jobs__.popleft()
+        # return values from the executed functions
+        results = [None] * total_jobs
 
-            # spawn new __ProgressQueueJob__ object
-            job = __ProgressQueueJob__.spawn(
-                job_index=job_index,
-                function=function,
-                args=args,
-                kwargs=kwargs,
-                progress_text=progress_text,
-                completion_output=completion_output)
+        if total_jobs == 0:
+            # nothing to do
+            return results
 
-            # add job to progress display, if any text to display
-            if progress_text is not None:
-                self.__displayed_rows__[job.job_fd()] = \
-                    progress_display.add_row(progress_text)
+        # job_index -> (progress_text, completion_output) for display
+        job_output = dict((job[0], (job[1], job[2]))
+                          for job in self.__queued_jobs__)
 
-            return job
+        # jobs are kept in a list so that workers can find them by index
+        jobs = list(self.__queued_jobs__)
 
         progress_display = ProgressDisplay(self.messenger)
 
@@ -5526,45 +5683,68 @@ class ExecProgressQueue(object):
         # Note that the order a job is inserted into the queue
         # (as captured by its job_index value)
         # may differ from the order in which it is completed.
-        total_jobs = len(self.__queued_jobs__)
         completed_job_number = 1
 
-        # a dict of job file descriptors -> __ProgressQueueJob__ objects
-        job_pool = {}
+        # fork our pool of workers, each pinned to its own cluster of CPUs
+        # so that a job's threads and memory stay close together
+        from audiotools.topology import cpu_clusters
 
-        # return values from the executed functions
-        results = [None] * total_jobs
+        workers = __ProgressQueueWorker__.spawn_pool(
+            jobs, min(max_processes, total_jobs),
+            cpu_clusters(WORKER_PLACEMENT))
 
-        if total_jobs == 0:
-            # nothing to do
-            return results
+        # a dict of result file descriptors -> __ProgressQueueWorker__ objects
+        worker_pool = dict((worker.worker_fd(), worker) for worker in workers)
+
+        def execute_next_job(worker):
+            """pulls the next job from the queue and hands it to worker"""
+
+            (job_index,
+             progress_text,
+             completion_output,
+             function,
+             args,
+             kwargs) = self.__queued_jobs__.popleft()
+
+            worker.start_job(job_index)
+
+            # add job to progress display, if any text to display
+            if progress_text is not None:
+                self.__displayed_rows__[worker.worker_fd()] = \
+                    progress_display.add_row(progress_text)
 
-        # populate job pool up to "max_processes" number of jobs
-        for i in range(min(max_processes, len(self.__queued_jobs__))):
-            job = execute_next_job(progress_display)
-            job_pool[job.job_fd()] = job
+        # start one job per worker
+        for worker in workers:
+            execute_next_job(worker)
+
+        next_refresh = time() + self.PROGRESS_REFRESH
 
-        # while the pool still contains running jobs
         try:
-            while len(job_pool) > 0:
-                # wait for zero or more jobs to finish (may timeout)
+            # while any worker is still running a job
+            while len([w for w in workers if w.job_index is not None]) > 0:
+                # wait for zero or more jobs to finish
+                # or until it's time to refresh the display
                 (rlist,
                  wlist,
-                 elist) = select(job_pool.keys(), [], [], 0.25)
+                 elist) = select([w.worker_fd() for w in workers
+                                  if w.job_index is not None],
+                                 [], [],
+                                 max(next_refresh - time(), 0))
 
-                # clear out old display
-                progress_display.clear_rows()
+                if len(rlist) > 0:
+                    # clear out old display before any output
+                    progress_display.clear_rows()
 
-                for finished_job in [job_pool[fd] for fd in rlist]:
-                    job_fd = finished_job.job_fd()
+                for finished_worker in [worker_pool[fd] for fd in rlist]:
+                    worker_fd = finished_worker.worker_fd()
 
-                    (exception, result) = finished_job.result()
+                    (job_index, exception, result) = finished_worker.result()
 
                     if not exception:
                         # job completed successfully
 
                         # display any output message attached to job
-                        completion_output = finished_job.completion_output
+                        completion_output = job_output[job_index][1]
                         if callable(completion_output):
                             output = completion_output(result)
                         else:
@@ -5577,7 +5757,7 @@ class ExecProgressQueue(object):
                                                 total_jobs))
 
                         # attach result to output in the order it was received
-                        results[finished_job.job_index] = result
+                        results[job_index] = result
                     else:
                         # job raised an exception
 
@@ -5588,37 +5768,50 @@ class ExecProgressQueue(object):
                         while len(self.__queued_jobs__) > 0:
                             self.__queued_jobs__.popleft()
 
-                    # remove job from pool
-                    del(job_pool[job_fd])
-
                     # remove job from progress display, if present
-                    if job_fd in self.__displayed_rows__:
-                        self.__displayed_rows__[job_fd].finish()
+                    if worker_fd in self.__displayed_rows__:
+                        self.__displayed_rows__[worker_fd].finish()
+                        del(self.__displayed_rows__[worker_fd])
 
-                    # add new jobs from the job queue, if any
+                    # hand worker a new job from the job queue, if any
                     if len(self.__queued_jobs__) > 0:
-                        job = execute_next_job(progress_display)
-                        job_pool[job.job_fd()] = job
+                        execute_next_job(finished_worker)
 
                     # updated completed job number for X/Y display
                     completed_job_number += 1
 
-                # update progress rows with progress taken from shared memory
-                for job in job_pool.values():
-                    if job.job_fd() in self.__displayed_rows__:
-                        self.__displayed_rows__[job.job_fd()].update(
-                            job.progress())
+                if (len(rlist) > 0) or (time() >= next_refresh):
+                    progress_display.clear_rows()
+
+                    # update progress rows with progress
+                    # sampled from shared memory
+                    for worker in workers:
+                        if ((worker.job_index is not None) and
+                            (worker.worker_fd() in self.__displayed_rows__)):
+                            self.__displayed_rows__[worker.worker_fd()].update(
+                                worker.progress())
+
+                    # display new set of progress rows
+                    progress_display.display_rows()
 
-                # display new set of progress rows
-                progress_display.display_rows()
+                    next_refresh = time() + self.PROGRESS_REFRESH
         except:
             # an exception occurred (perhaps KeyboardInterrupt)
-            # so kill any running child jobs
+            # so kill any running workers
+            for worker in workers:
+                worker.terminate()
             # clear any progress rows
             progress_display.clear_rows()
+            self.__displayed_rows__.clear()
             # and pass exception to caller
             raise
 
+        # shut down the pool now that all jobs are finished
+        for worker in workers:
+            worker.stop()
+
+        progress_display.clear_rows()
+
         # if any jobs have raised an exception,
         # re-raise it in the main process
         if self.__raised_exception__ is not None:
@@ -5628,141 +5821,171 @@ class ExecProgressQueue(object):
             return results
 
 
-class __ProgressQueueJob__(object):
-    """this class is a the parent process end of a running child job"""
+class __ProgressQueueWorker__(object):
+    """this class is the parent process end of a pooled worker process"""
+
+    # progress is stored in shared memory as a single fixed-point word
+    # so it can be read and written without locking
+    PROGRESS_SCALE = 1 << 20
 
     def __init__(self,
-                 job_index,
                  process,
                  progress,
-                 lock,
-                 result_pipe,
-                 progress_text,
-                 completion_output):
-        """job_index is the order this job was inserted into the queue
+                 slot,
+                 job_pipe,
+                 result_pipe):
+        """process is the Process object of the running worker
 
-        process is the Process object of the running child
+        progress is an Array object shared by all workers in the pool
 
-        progress is an Array object of [current, total] progress status
+        slot is this worker's index in the "progress" Array
 
-        lock is a Lock object to synchronize access to "progress"
+        job_pipe is a Connection object job indexes are sent to
 
-        result_pipe is a Connection object which will be read for data
-
-        progress_text is unicode to display while the job is in progress
-
-        completion_output is either unicode or a callable function
-        to be displayed when the job finishes
+        result_pipe is a Connection object which will be read for results
         """
 
-        self.job_index = job_index
         self.process = process
         self.__progress__ = progress
-        self.__lock__ = lock
+        self.__slot__ = slot
+        self.job_pipe = job_pipe
         self.result_pipe = result_pipe
-        self.progress_text = progress_text
-        self.completion_output = completion_output
+        self.job_index = None
 
-    def job_fd(self):
+    def worker_fd(self):
         """returns file descriptor of parent-side result pipe"""
 
         return self.result_pipe.fileno()
 
     def progress(self):
-        self.__lock__.acquire()
-        (current, total) = self.__progress__
-        self.__lock__.release()
-        if total > 0:
-            return Fraction(current, total)
-        else:
-            return Fraction(0, 1)
+        """returns the progress of the current job as a Fraction"""
 
-    @classmethod
-    def spawn(cls,
-              job_index,
-              function,
-              args,
-              kwargs,
-              progress_text,
-              completion_output):
-        """spawns a subprocess and returns the parent-side
-        __ProgressQueueJob__ object
-
-        job_index is the order this job was inserted into the queue
+        return Fraction(self.__progress__[self.__slot__],
+                        self.PROGRESS_SCALE)
 
-        function is the function to execute
+    @classmethod
+    def spawn_pool(cls, jobs, workers, clusters=None):
+        """spawns the given number of worker subprocesses
+        and returns a list of parent-side __ProgressQueueWorker__ objects
 
-        args is a tuple of positional arguments
+        jobs is a list of
+        (job_index, progress_text, completion_output, function, args, kwargs)
+        tuples which are inherited by the forked workers
+        so that jobs can be started by sending only their index
 
-        kwargs is a dict of keyword arguments
+        clusters is an optional list of CPU lists
+        which workers are pinned to in turn
+        """
 
-        progress_text is unicode to display while the job is in progress
+        def execute_jobs(jobs, progress, slot, job_pipe, result_pipe, cpus):
+            if cpus is not None:
+                from audiotools.topology import set_cpus
+                set_cpus(cpus)
+
+            def update(fraction):
+                progress[slot] = (fraction.numerator *
+                                  cls.PROGRESS_SCALE //
+                                  fraction.denominator)
+
+            while True:
+                try:
+                    job_index = job_pipe.recv()
+                except EOFError:
+                    break
+                if job_index is None:
+                    break
+
+                (job_index,
+                 progress_text,
+                 completion_output,
+                 function,
+                 args,
+                 kwargs) = jobs[job_index]
+
+                try:
+                    result_pipe.send((job_index, False,
+                                      function(*args,
+                                               progress=update,
+                                               **kwargs)))
+                except Exception as exception:
+                    result_pipe.send((job_index, True, exception))
+
+            job_pipe.close()
+            result_pipe.close()
 
-        completion_output is either unicode or a callable function
-        to be displayed when the job finishes
-        """
+        from multiprocessing import Process, Array, Pipe
 
-        class __progress__(object):
-            def __init__(self, memory, lock):
-                self.memory = memory
-                self.lock = lock
+        # construct shared memory array to store each worker's progress
+        # with one slot per worker,
+        # only that worker writes its slot and the parent only reads it
+        progress = Array("L", workers, lock=False)
 
-            def update(self, progress):
-                self.lock.acquire()
-                self.memory[0] = progress.numerator
-                self.memory[1] = progress.denominator
-                self.lock.release()
+        pool = []
 
-        def execute_job(function, args, kwargs, progress, result_pipe):
-            try:
-                result_pipe.send((False, function(*args,
-                                                  progress=progress,
-                                                  **kwargs)))
-            except Exception as exception:
-                result_pipe.send((True, exception))
+        # a single cluster holds every CPU, so there's nothing to pin
+        if (clusters is not None) and (len(clusters) < 2):
+            clusters = None
 
-            result_pipe.close()
+        for slot in range(workers):
+            # construct one-way pipes to send jobs and collect results
+            (job_recv, job_send) = Pipe(False)
+            (result_recv, result_send) = Pipe(False)
 
-        from multiprocessing import Process, Array, Pipe, Lock
+            process = Process(target=execute_jobs,
+                              args=(jobs,
+                                    progress,
+                                    slot,
+                                    job_recv,
+                                    result_send,
+                                    (clusters[slot % len(clusters)]
+                                     if clusters is not None else None)))
 
-        # construct shared memory array to store progress
-        progress = Array("L", [0, 1])
+            process.start()
 
-        # construct lock to keep array access process-safe
-        lock = Lock()
+            # close our copies of the child-side ends
+            job_recv.close()
+            result_send.close()
 
-        # construct one-way pipe to collect result
-        (parent_conn, child_conn) = Pipe(False)
+            pool.append(cls(process=process,
+                            progress=progress,
+                            slot=slot,
+                            job_pipe=job_send,
+                            result_pipe=result_recv))
 
-        # build child job to execute function
-        process = Process(target=execute_job,
-                          args=(function,
-                                args,
-                                kwargs,
-                                __progress__(progress, lock).update,
-                                child_conn))
+        return pool
 
-        # start child job
-        process.start()
+    def start_job(self, job_index):
+        """sends the given job index to the worker to be executed"""
 
-        # return populated __ProgressQueueJob__ object
-        return cls(job_index=job_index,
-                   process=process,
-                   progress=progress,
-                   lock=lock,
-                   result_pipe=parent_conn,
-                   progress_text=progress_text,
-                   completion_output=completion_output)
+        self.__progress__[self.__slot__] = 0
+        self.job_index = job_index
+        self.job_pipe.send(job_index)
 
     def result(self):
-        """returns (exception, result) from parent-side pipe
+        """returns (job_index, exception, result) from parent-side pipe
         where exception is True if result is an exception
         or False if it's the result of the called child function"""
 
-        (exception, result) = self.result_pipe.recv()
+        (job_index, exception, result) = self.result_pipe.recv()
+        self.job_index = None
+        return (job_index, exception, result)
+
+    def stop(self):
+        """signals the worker to exit once idle and waits for it"""
+
+        self.job_pipe.send(None)
+        self.job_pipe.close()
         self.result_pipe.close()
         self.process.join()
-        return (exception, result)
+
+    def terminate(self):
+        """kills the worker outright, if still running"""
+
+        if self.process.is_alive():
+            self.process.terminate()
+        self.process.join()
+        self.job_pipe.close()
+        self.result_pipe.close()
 
 
 class TemporaryFile(object):
@@ -276,10 +276,11 @@ def perform_lookup(disc_id,
     """
 
     from audiotools.bitstream import BitstreamReader
+    from audiotools.lookup import urlopen, VOLATILE_MAX_AGE
     try:
-        from urllib.request import urlopen, URLError
+        from urllib.request import URLError
     except ImportError:
-        from urllib2 import urlopen, URLError
+        from urllib2 import URLError
 
     matches = {n: [] for n in disc_id.track_numbers()}
 
@@ -291,7 +292,9 @@ def perform_lookup(disc_id,
                                                         disc_id)
 
     try:
-        response = BitstreamReader(urlopen(url), True)
+        # confidence counts grow as discs are submitted
+        response = BitstreamReader(urlopen(url, max_age=VOLATILE_MAX_AGE),
+                                   True)
     except URLError:
         # no CD found matching given parameters
         return matches
@@ -30,11 +30,10 @@ def perform_lookup(mbid,
     from audiotools import FRONT_COVER
     from audiotools import BACK_COVER
 
+    from audiotools.lookup import urlopen
     try:
-        from urllib.request import urlopen
         from urllib.request import URLError
     except ImportError:
-        from urllib2 import urlopen
         from urllib2 import URLError
 
     from json import loads
@@ -0,0 +1,413 @@
+# Audio Tools, a module and set of tools for manipulating audio data
+# Copyright (C) 2007-2016  Brian Langenberger
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""PCM fingerprints of tracks, and an index of them for finding duplicates"""
+
+from audiotools import PCMReader
+from audiotools._fingerprint import (Fingerprinter, FINGERPRINT_BITS)
+
+# the spectral fingerprint is indexed by chunks of this many bits
+# and a track is only compared against those of about the same length
+# sharing at least one chunk with it
+CHUNK_BITS = 8
+
+# spectral fingerprints differing by no more than this many bits
+# are considered to be of the same recording
+SIMILAR_BITS = 48
+
+# tracks whose lengths differ by more than this many seconds
+# are never considered to be of the same recording,
+# which allows for the padding of a few lossy frames
+DURATION_TOLERANCE = 0.2
+
+
+class Fingerprint(object):
+    """the exact and spectral fingerprints of a track's PCM data"""
+
+    def __init__(self, sample_rate, channels, bits_per_sample,
+                 pcm_frames, digest, spectrum):
+        """digest is a binary SHA-1 digest of the stream's format
+        and PCM samples, which matches only identical PCM data
+
+        spectrum is a binary string of FINGERPRINT_BITS
+        which is nearly the same for a track and its lossy encodings"""
+
+        self.sample_rate = sample_rate
+        self.channels = channels
+        self.bits_per_sample = bits_per_sample
+        self.pcm_frames = pcm_frames
+        self.digest = digest
+        self.spectrum = spectrum
+
+    def __repr__(self):
+        return "Fingerprint({})".format(
+            ",".join(["{}={!r}".format(attr, getattr(self, attr))
+                      for attr in ["sample_rate",
+                                   "channels",
+                                   "bits_per_sample",
+                                   "pcm_frames",
+                                   "digest",
+                                   "spectrum"]]))
+
+    def seconds(self):
+        """returns the length of the track in seconds as a float"""
+
+        return float(self.pcm_frames) / self.sample_rate
+
+    def milliseconds(self):
+        """returns the length of the track in milliseconds as an int"""
+
+        return int(round(self.seconds() * 1000))
+
+    def chunks(self):
+        """returns the spectral fingerprint as a list of integers
+        of CHUNK_BITS each, prefixed by their position"""
+
+        value = spectrum_value(self.spectrum)
+        mask = (1 << CHUNK_BITS) - 1
+        return [(i << CHUNK_BITS) | ((value >> (i * CHUNK_BITS)) & mask)
+                for i in range(FINGERPRINT_BITS // CHUNK_BITS)]
+
+    def identical(self, fingerprint):
+        """returns True if both fingerprints are of the same PCM data"""
+
+        return self.digest == fingerprint.digest
+
+    def distance(self, fingerprint):
+        """returns the number of bits by which
+        the spectral fingerprints differ"""
+
+        return bin(spectrum_value(self.spectrum) ^
+                   spectrum_value(fingerprint.spectrum)).count("1")
+
+    def similar(self, fingerprint, threshold=SIMILAR_BITS):
+        """returns True if both fingerprints are likely
+        of the same recording, though not necessarily the same PCM data"""
+
+        return ((abs(self.seconds() - fingerprint.seconds()) <=
+                 DURATION_TOLERANCE) and
+                (self.distance(fingerprint) <= threshold))
+
+
+def spectrum_value(spectrum):
+    """given a spectral fingerprint as a binary string
+    returns it as an integer"""
+
+    from binascii import hexlify
+
+    return int(hexlify(spectrum), 16)
+
+
+class FingerprintReader(PCMReader):
+    """a PCMReader which fingerprints the PCM data read through it
+
+    wrapping the PCMReader of any pass which decodes a whole track,
+    such as a conversion, yields its fingerprint at no extra decoding cost"""
+
+    def __init__(self, pcmreader):
+        """raises ValueError if the reader's sample rate
+        is too low to fingerprint"""
+
+        from hashlib import sha1
+        from struct import pack
+
+        PCMReader.__init__(self,
+                           sample_rate=pcmreader.sample_rate,
+                           channels=pcmreader.channels,
+                           channel_mask=pcmreader.channel_mask,
+                           bits_per_sample=pcmreader.bits_per_sample)
+        self.__pcmreader__ = pcmreader
+        self.__fingerprinter__ = Fingerprinter(pcmreader.sample_rate,
+                                               pcmreader.channels)
+
+        # the stream's format is part of the digest
+        # so that identical samples at different rates don't match
+        self.__digest__ = sha1(pack(">III",
+                                    pcmreader.sample_rate,
+                                    pcmreader.channels,
+                                    pcmreader.bits_per_sample))
+        self.__pcm_frames__ = 0
+        self.__fingerprint__ = None
+
+    def read(self, pcm_frames):
+        framelist = self.__pcmreader__.read(pcm_frames)
+        self.__digest__.update(framelist.to_bytes(False, True))
+        self.__fingerprinter__.update(framelist)
+        self.__pcm_frames__ += framelist.frames
+        return framelist
+
+    def close(self):
+        self.__pcmreader__.close()
+        if self.__fingerprint__ is None:
+            self.__fingerprint__ = Fingerprint(
+                sample_rate=self.sample_rate,
+                channels=self.channels,
+                bits_per_sample=self.bits_per_sample,
+                pcm_frames=self.__pcm_frames__,
+                digest=self.__digest__.digest(),
+                spectrum=self.__fingerprinter__.fingerprint())
+
+    def fingerprint(self):
+        """returns the Fingerprint of the data read
+
+        raises ValueError if the reader hasn't been closed"""
+
+        if self.__fingerprint__ is not None:
+            return self.__fingerprint__
+        else:
+            raise ValueError("cannot get fingerprint before closing pcmreader")
+
+
+def fingerprint_track(audiofile):
+    """given an AudioFile, decodes it and returns its Fingerprint
+
+    may raise IOError or ValueError if a problem occurs
+    decoding the file"""
+
+    from audiotools import FRAMELIST_SIZE
+
+    reader = FingerprintReader(audiofile.to_pcm())
+    try:
+        framelist = reader.read(FRAMELIST_SIZE)
+        while len(framelist) > 0:
+            framelist = reader.read(FRAMELIST_SIZE)
+    finally:
+        reader.close()
+    return reader.fingerprint()
+
+
+class FingerprintIndex(object):
+    """an on-disk table of track fingerprints
+
+    tracks are indexed both by their exact digest
+    and by each chunk of their spectral fingerprint
+    so that finding a track's duplicates only compares it
+    against the few tracks sharing a chunk with it,
+    rather than decoding every pair of tracks"""
+
+    def __init__(self, filename):
+        """filename is the SQLite database to use,
+        which is created if necessary
+
+        raises IOError if the database can't be opened"""
+
+        import sqlite3
+
+        self.filename = filename
+        try:
+            self.__db__ = sqlite3.connect(filename)
+            self.__db__.executescript("""
+PRAGMA journal_mode=WAL;
+CREATE TABLE IF NOT EXISTS tracks (
+    id INTEGER PRIMARY KEY,
+    path TEXT UNIQUE NOT NULL,
+    size INTEGER NOT NULL,
+    mtime INTEGER NOT NULL,
+    sample_rate INTEGER NOT NULL,
+    channels INTEGER NOT NULL,
+    bits_per_sample INTEGER NOT NULL,
+    pcm_frames INTEGER NOT NULL,
+    digest BLOB NOT NULL,
+    spectrum BLOB NOT NULL);
+CREATE INDEX IF NOT EXISTS tracks_digest ON tracks (digest);
+CREATE TABLE IF NOT EXISTS chunks (
+    chunk INTEGER NOT NULL,
+    milliseconds INTEGER NOT NULL,
+    track INTEGER NOT NULL,
+    PRIMARY KEY (chunk, milliseconds, track)) WITHOUT ROWID;
+""")
+        except sqlite3.Error as err:
+            raise IOError(str(err))
+
+    def __len__(self):
+        return self.__db__.execute("SELECT COUNT(*) FROM tracks").fetchone()[0]
+
+    def __contains__(self, path):
+        from os.path import abspath
+
+        return self.__db__.execute("SELECT 1 FROM tracks WHERE path = ?",
+                                   (abspath(path),)).fetchone() is not None
+
+    def paths(self):
+        """returns a sorted list of all the indexed paths"""
+
+        return [row[0] for row in
+                self.__db__.execute("SELECT path FROM tracks ORDER BY path")]
+
+    def get(self, path):
+        """returns the Fingerprint recorded for the given path
+        or None if it isn't indexed
+        or the file has been changed since it was"""
+
+        from audiotools.journal import source_fingerprint
+
+        try:
+            (path, size, mtime) = source_fingerprint(path)
+        except OSError:
+            return None
+
+        row = self.__db__.execute(
+            "SELECT size, mtime, " + FINGERPRINT_COLUMNS +
+            " FROM tracks WHERE path = ?", (path,)).fetchone()
+        if (row is not None) and (row[0:2] == (size, mtime)):
+            return row_fingerprint(row[2:])
+        else:
+            return None
+
+    def add(self, path, fingerprint):
+        """records the Fingerprint of the file at the given path,
+        replacing any fingerprint recorded for it earlier
+
+        the file's size and modification time are recorded as well
+        so that changing the file invalidates its fingerprint
+
+        the entry is committed to disk before returning
+
+        raises OSError if the file can't be found"""
+
+        import sqlite3
+        from audiotools.journal import source_fingerprint
+
+        (path, size, mtime) = source_fingerprint(path)
+
+        with self.__db__:
+            self.__remove__(path)
+            track = self.__db__.execute(
+                "INSERT INTO tracks (path, size, mtime, " +
+                FINGERPRINT_COLUMNS +
+                ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                (path, size, mtime,
+                 fingerprint.sample_rate,
+                 fingerprint.channels,
+                 fingerprint.bits_per_sample,
+                 fingerprint.pcm_frames,
+                 sqlite3.Binary(fingerprint.digest),
+                 sqlite3.Binary(fingerprint.spectrum))).lastrowid
+            self.__db__.executemany(
+                "INSERT INTO chunks (chunk, milliseconds, track) " +
+                "VALUES (?, ?, ?)",
+                [(chunk, fingerprint.milliseconds(), track)
+                 for chunk in fingerprint.chunks()])
+
+    def remove(self, path):
+        """removes any fingerprint recorded for the given path"""
+
+        from os.path import abspath
+
+        with self.__db__:
+            self.__remove__(abspath(path))
+
+    def __remove__(self, path):
+        row = self.__db__.execute(
+            "SELECT id, " + FINGERPRINT_COLUMNS +
+            " FROM tracks WHERE path = ?", (path,)).fetchone()
+        if row is not None:
+            fingerprint = row_fingerprint(row[1:])
+            self.__db__.executemany(
+                "DELETE FROM chunks WHERE " +
+                "chunk = ? AND milliseconds = ? AND track = ?",
+                [(chunk, fingerprint.milliseconds(), row[0])
+                 for chunk in fingerprint.chunks()])
+            self.__db__.execute("DELETE FROM tracks WHERE id = ?", (row[0],))
+
+    def identical(self, fingerprint):
+        """returns a sorted list of indexed paths
+        whose PCM data is identical to the fingerprint's"""
+
+        import sqlite3
+
+        return [row[0] for row in
+                self.__db__.execute(
+                    "SELECT path FROM tracks WHERE digest = ? ORDER BY path",
+                    (sqlite3.Binary(fingerprint.digest),))]
+
+    def similar(self, fingerprint, threshold=SIMILAR_BITS):
+        """returns a list of (distance, path) tuples of indexed paths
+        likely of the same recording as the fingerprint,
+        where distance is the number of bits
+        by which their spectral fingerprints differ,
+        sorted by distance
+
+        identical tracks are included with whatever distance
+        their spectral fingerprints have, which is usually 0"""
+
+        chunks = fingerprint.chunks()
+        tolerance = int(DURATION_TOLERANCE * 1000)
+
+        # identical tracks always share every chunk,
+        # so they are among the candidates
+        matches = []
+        for row in self.__db__.execute(
+            "SELECT path, " + FINGERPRINT_COLUMNS +
+            " FROM tracks WHERE id IN" +
+            " (SELECT track FROM chunks WHERE chunk IN (" +
+                ",".join(["?"] * len(chunks)) + ")" +
+            " AND milliseconds BETWEEN ? AND ?)",
+            chunks + [fingerprint.milliseconds() - tolerance,
+                      fingerprint.milliseconds() + tolerance]):
+            candidate = row_fingerprint(row[1:])
+            if (candidate.identical(fingerprint) or
+                candidate.similar(fingerprint, threshold)):
+                matches.append((candidate.distance(fingerprint), row[0]))
+        matches.sort()
+        return matches
+
+    def duplicates(self, threshold=SIMILAR_BITS):
+        """yields a sorted list of paths for each group
+        of indexed tracks which are likely of the same recording,
+        in a single pass over the index"""
+
+        grouped = set()
+        for row in self.__db__.execute(
+            "SELECT path, " + FINGERPRINT_COLUMNS +
+            " FROM tracks ORDER BY path"):
+            if row[0] in grouped:
+                continue
+            group = [path for (distance, path) in
+                     self.similar(row_fingerprint(row[1:]), threshold)
+                     if path not in grouped]
+            if len(group) > 1:
+                grouped.update(group)
+                yield sorted(group)
+
+    def close(self):
+        """closes the index"""
+
+        self.__db__.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+
+FINGERPRINT_COLUMNS = ("sample_rate, channels, bits_per_sample, " +
+                       "pcm_frames, digest, spectrum")
+
+
+def row_fingerprint(row):
+    """given a row of FINGERPRINT_COLUMNS values, returns a Fingerprint"""
+
+    (sample_rate, channels, bits_per_sample, pcm_frames,
+     digest, spectrum) = row
+    return Fingerprint(sample_rate=sample_rate,
+                       channels=channels,
+                       bits_per_sample=bits_per_sample,
+                       pcm_frames=pcm_frames,
+                       digest=bytes(digest),
+                       spectrum=bytes(spectrum))
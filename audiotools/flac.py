@@ -1477,6 +1477,80 @@ class Flac_PICTURE(Image):
             return (self, [])
 
 
+class FlacEncodingTrial(object):
+    """the result of trial-encoding a sample of audio
+    with a set of encode_flac() options"""
+
+    def __init__(self, options, size, cpu):
+        """options is a dict of encode_flac() keyword arguments
+        size is the sample's encoded size in bytes
+        and cpu is the CPU time spent encoding it, in seconds"""
+
+        self.options = options
+        self.size = size
+        self.cpu = cpu
+
+    def __repr__(self):
+        return "FlacEncodingTrial({!r}, {!r}, {!r})".format(self.options,
+                                                             self.size,
+                                                             self.cpu)
+
+
+def thread_time():
+    """returns the CPU time used by the current thread, in seconds,
+    or by the whole process where that's not available"""
+
+    import time
+
+    if hasattr(time, "thread_time"):
+        return time.thread_time()
+    else:
+        return time.clock()
+
+
+def sample_pcm(pcmreader, total_pcm_frames, sample_frames, windows=4):
+    """returns a FrameList of about sample_frames PCM frames
+    taken from a number of evenly-spaced windows in pcmreader
+
+    total_pcm_frames is the length of the stream,
+    which is only skipped through where the reader can seek
+
+    may raise IOError or ValueError if a problem occurs reading"""
+
+    from audiotools.pcm import empty_framelist
+
+    sample = empty_framelist(pcmreader.channels, pcmreader.bits_per_sample)
+    windows = max(min(windows, total_pcm_frames // max(sample_frames, 1)), 1)
+    window_frames = max(sample_frames // windows, 1)
+    position = 0
+
+    for i in range(windows):
+        window_start = (total_pcm_frames * i) // windows
+
+        # get to the start of the window
+        if hasattr(pcmreader, "seek") and (window_start > position):
+            position = pcmreader.seek(window_start)
+        while position < window_start:
+            framelist = pcmreader.read(min(window_start - position, 4096))
+            if framelist.frames == 0:
+                return sample
+            position += framelist.frames
+
+        # then read the window itself
+        remaining = window_frames
+        while remaining > 0:
+            framelist = pcmreader.read(remaining)
+            if framelist.frames == 0:
+                return sample
+            elif framelist.frames > remaining:
+                (framelist, rest) = framelist.split(remaining)
+            sample += framelist
+            position += framelist.frames
+            remaining -= framelist.frames
+
+    return sample
+
+
 class FlacAudio(WaveContainer, AiffContainer):
     """a Free Lossless Audio Codec file"""
 
@@ -1491,24 +1565,91 @@ class FlacAudio(WaveContainer, AiffContainer):
     COMPRESSION_DESCRIPTIONS = {"0": COMP_FLAC_0,
                                 "8": COMP_FLAC_8}
 
+    # encode_flac() options for each compression mode
+    COMPRESSION_OPTIONS = {
+        "0": {"block_size": 1152,
+              "max_lpc_order": 0,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 3},
+        "1": {"block_size": 1152,
+              "max_lpc_order": 0,
+              "adaptive_mid_side": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 3},
+        "2": {"block_size": 1152,
+              "max_lpc_order": 0,
+              "exhaustive_model_search": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 3},
+        "3": {"block_size": 4096,
+              "max_lpc_order": 6,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 4},
+        "4": {"block_size": 4096,
+              "max_lpc_order": 8,
+              "adaptive_mid_side": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 4},
+        "5": {"block_size": 4096,
+              "max_lpc_order": 8,
+              "mid_side": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 5},
+        "6": {"block_size": 4096,
+              "max_lpc_order": 8,
+              "mid_side": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 6},
+        "7": {"block_size": 4096,
+              "max_lpc_order": 8,
+              "mid_side": True,
+              "exhaustive_model_search": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 6},
+        "8": {"block_size": 4096,
+              "max_lpc_order": 12,
+              "mid_side": True,
+              "exhaustive_model_search": True,
+              "min_residual_partition_order": 0,
+              "max_residual_partition_order": 6}}
+
+    # the options autotune() tries in every combination
+    # along with those of the compression mode being tuned against
+    AUTOTUNE_BLOCK_SIZES = (1152, 4096, 4608)
+    AUTOTUNE_LPC_ORDERS = (0, 6, 8, 12)
+    AUTOTUNE_PARTITION_ORDERS = (4, 6)
+    AUTOTUNE_STEREO_MODES = ({},
+                             {"adaptive_mid_side": True},
+                             {"mid_side": True})
+
     METADATA_CLASS = FlacMetaData
 
     def __init__(self, filename):
         """filename is a plain string"""
 
-        from audiotools.id3 import skip_id3v2_comment
-        from audiotools.bitstream import BitstreamReader
-
         AudioFile.__init__(self, filename)
 
         # setup some dummy placeholder values
         self.__stream_offset__ = 0
+        self.__header__ = None
         self.__samplerate__ = 0
         self.__channels__ = 0
         self.__bitspersample__ = 0
         self.__total_frames__ = 0
         self.__md5__ = b"\x00" * 16
 
+        self.__read_header__()
+
+    def __read_header__(self):
+        """parses the stream's metadata blocks in a single native pass
+
+        the result is kept for FlacDecoder and for lookups
+        which don't need the full FlacMetaData,
+        so it must be reread whenever the metadata is rewritten"""
+
+        from audiotools.id3 import skip_id3v2_comment
+        from audiotools.decoders import FlacHeader
+
         try:
             with open(self.filename, "rb") as f:
                 # check for leading ID3v3 tag
@@ -1518,32 +1659,23 @@ class FlacAudio(WaveContainer, AiffContainer):
                 if f.read(4) != b"fLaC":
                     from audiotools.text import ERR_FLAC_INVALID_FILE
                     raise InvalidFLAC(ERR_FLAC_INVALID_FILE)
+                f.seek(self.__stream_offset__, 0)
 
-                reader = BitstreamReader(f, False)
-
-                # walk metadata blocks looking for STREAMINFO
-                # (should be first block)
-                stop = 0
-                while stop == 0:
-                    stop, header_type, length = reader.parse("1u 7u 24u")
-                    if header_type == 0:
-                        reader.skip(80)
-                        self.__samplerate__ = reader.read(20)
-                        self.__channels__ = reader.read(3) + 1
-                        self.__bitspersample__ = reader.read(5) + 1
-                        self.__total_frames__ = reader.read(36)
-                        self.__md5__ = reader.read_bytes(16)
-                        return
-                    elif header_type in {1, 2, 3, 4, 5, 6}:
-                        # be accepting of out-of-spec files
-                        # whose STREAMINFO blocks aren't first
-                        reader.skip_bytes(length)
-                    else:
-                        from audiotools.text import ERR_FLAC_INVALID_BLOCK
-                        raise InvalidFLAC(ERR_FLAC_INVALID_BLOCK)
+                try:
+                    header = FlacHeader(f)
+                except ValueError:
+                    from audiotools.text import ERR_FLAC_INVALID_BLOCK
+                    raise InvalidFLAC(ERR_FLAC_INVALID_BLOCK)
         except IOError as msg:
             raise InvalidFLAC(str(msg))
 
+        self.__header__ = header
+        self.__samplerate__ = header.sample_rate
+        self.__channels__ = header.channels
+        self.__bitspersample__ = header.bits_per_sample
+        self.__total_frames__ = header.total_samples
+        self.__md5__ = header.md5sum
+
     def channel_mask(self):
         """returns a ChannelMask object of this track's channel layout"""
 
@@ -1552,22 +1684,14 @@ class FlacAudio(WaveContainer, AiffContainer):
         if self.channels() <= 2:
             return ChannelMask.from_channels(self.channels())
 
-        try:
-            metadata = self.get_metadata()
-            if metadata is not None:
-                channel_mask = ChannelMask(
-                    int(metadata.get_block(
-                        Flac_VORBISCOMMENT.BLOCK_ID)[
-                        u"WAVEFORMATEXTENSIBLE_CHANNEL_MASK"][0], 16))
-                if len(channel_mask) == self.channels():
-                    return channel_mask
-                else:
-                    # channel count mismatch in given mask
-                    return ChannelMask(0)
+        if self.__header__.channel_mask is not None:
+            channel_mask = ChannelMask(self.__header__.channel_mask)
+            if len(channel_mask) == self.channels():
+                return channel_mask
             else:
-                # proceed to generate channel mask
-                raise ValueError()
-        except (IndexError, KeyError, ValueError):
+                # channel count mismatch in given mask
+                return ChannelMask(0)
+        else:
             # if there is no VORBIS_COMMENT block
             # or no WAVEFORMATEXTENSIBLE_CHANNEL_MASK in that block
             # or it's not an integer,
@@ -1633,6 +1757,44 @@ class FlacAudio(WaveContainer, AiffContainer):
                 # shouldn't be able to get here
                 return None
 
+    def embedded_images(self):
+        """returns a list of EmbeddedImage objects
+        for this file's PICTURE blocks
+
+        their data is located by the header parse
+        and only read from disk on demand"""
+
+        from audiotools.artcache import EmbeddedImage
+        from audiotools import (FRONT_COVER,
+                                BACK_COVER,
+                                LEAFLET_PAGE,
+                                MEDIA,
+                                OTHER)
+
+        return [EmbeddedImage(filename=self.filename,
+                              offset=self.__stream_offset__ + data_offset,
+                              length=data_length,
+                              mime_type=mime_type,
+                              width=width,
+                              height=height,
+                              color_depth=color_depth,
+                              color_count=color_count,
+                              description=description,
+                              type={0: OTHER,
+                                    3: FRONT_COVER,
+                                    4: BACK_COVER,
+                                    5: LEAFLET_PAGE,
+                                    6: MEDIA}.get(picture_type, OTHER))
+                for (picture_type,
+                     mime_type,
+                     description,
+                     width,
+                     height,
+                     color_depth,
+                     color_count,
+                     data_offset,
+                     data_length) in self.__header__.pictures]
+
     def update_metadata(self, metadata):
         """takes this track's current MetaData object
         as returned by get_metadata() and sets this track's metadata
@@ -1731,6 +1893,8 @@ class FlacAudio(WaveContainer, AiffContainer):
             old_file.close()
             writer.close()
 
+        self.__read_header__()
+
     def set_metadata(self, metadata):
         """takes a MetaData object and sets this track's metadata
 
@@ -1951,7 +2115,7 @@ class FlacAudio(WaveContainer, AiffContainer):
         try:
             if self.__stream_offset__ > 0:
                 flac.seek(self.__stream_offset__)
-            return FlacDecoder(flac)
+            return FlacDecoder(flac, self.__header__)
         except (IOError, ValueError) as err:
             # The only time this is likely to occur is
             # if the FLAC is modified between when FlacAudio
@@ -1975,7 +2139,8 @@ class FlacAudio(WaveContainer, AiffContainer):
     def from_pcm(cls, filename, pcmreader,
                  compression=None,
                  total_pcm_frames=None,
-                 encoding_function=None):
+                 encoding_function=None,
+                 encoding_options=None):
         """encodes a new file from PCM data
 
         takes a filename string, PCMReader object,
@@ -1983,63 +2148,29 @@ class FlacAudio(WaveContainer, AiffContainer):
         optional total_pcm_frames integer
         encodes a new audio file from pcmreader's data
         at the given filename with the specified compression level
-        and returns a new FlacAudio object"""
+        and returns a new FlacAudio object
+
+        encoding_options is an optional dict of encode_flac() options,
+        such as those chosen by autotune(),
+        which override those of the compression level
+
+        each frame is verified as it's encoded if VERIFY_ENCODING is set
+        or if encoding_options includes a true "verify" option"""
 
         from audiotools.encoders import encode_flac
         from audiotools import EncodingError
         from audiotools import __default_quality__
         from audiotools import VERSION
+        from audiotools import VERIFY_ENCODING
 
         if ((compression is None) or (compression not in
                                       cls.COMPRESSION_MODES)):
             compression = __default_quality__(cls.NAME)
 
-        encoding_options = {
-            "0": {"block_size": 1152,
-                  "max_lpc_order": 0,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 3},
-            "1": {"block_size": 1152,
-                  "max_lpc_order": 0,
-                  "adaptive_mid_side": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 3},
-            "2": {"block_size": 1152,
-                  "max_lpc_order": 0,
-                  "exhaustive_model_search": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 3},
-            "3": {"block_size": 4096,
-                  "max_lpc_order": 6,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 4},
-            "4": {"block_size": 4096,
-                  "max_lpc_order": 8,
-                  "adaptive_mid_side": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 4},
-            "5": {"block_size": 4096,
-                  "max_lpc_order": 8,
-                  "mid_side": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 5},
-            "6": {"block_size": 4096,
-                  "max_lpc_order": 8,
-                  "mid_side": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 6},
-            "7": {"block_size": 4096,
-                  "max_lpc_order": 8,
-                  "mid_side": True,
-                  "exhaustive_model_search": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 6},
-            "8": {"block_size": 4096,
-                  "max_lpc_order": 12,
-                  "mid_side": True,
-                  "exhaustive_model_search": True,
-                  "min_residual_partition_order": 0,
-                  "max_residual_partition_order": 6}}[compression]
+        options = cls.COMPRESSION_OPTIONS[compression].copy()
+        options["verify"] = VERIFY_ENCODING
+        if encoding_options is not None:
+            options.update(encoding_options)
 
         if pcmreader.bits_per_sample not in {8, 16, 24}:
             from audiotools import UnsupportedBitsPerSample
@@ -2075,7 +2206,7 @@ class FlacAudio(WaveContainer, AiffContainer):
                 total_pcm_frames=(total_pcm_frames if
                                   total_pcm_frames is not None else 0),
                 padding_size=4096,
-                **encoding_options)
+                **options)
 
             return FlacAudio(filename)
         except (IOError, ValueError) as err:
@@ -2095,10 +2226,100 @@ class FlacAudio(WaveContainer, AiffContainer):
         except ImportError:
             return False
 
+    @classmethod
+    def autotune(cls, audiofiles,
+                 compression=None,
+                 size_tolerance=0.005,
+                 cpu_budget=1.0,
+                 sample_seconds=5,
+                 workers=None):
+        """given a list of AudioFile objects, such as an album's tracks,
+        trial-encodes a sample of their audio with each combination
+        of the AUTOTUNE options on a pool of threads
+        and returns the FlacEncodingTrial of the options chosen
+
+        options are affordable if they take no more than cpu_budget
+        times the CPU time of the given compression mode's options
+        and of those, the cheapest within size_tolerance
+        of the smallest affordable size is chosen
+
+        sample_seconds is the total length of audio sampled
+        across all the files and workers defaults to MAX_JOBS
+
+        the chosen trial's options may be passed to from_pcm()
+        to encode each of the files
+
+        raises ValueError if a file's audio cannot be encoded to FLAC
+        or IOError if a file cannot be read"""
+
+        from multiprocessing.pool import ThreadPool
+        from audiotools.encoders import trial_encode_flac
+        from audiotools import __default_quality__
+        from audiotools import MAX_JOBS
+
+        if ((compression is None) or (compression not in
+                                      cls.COMPRESSION_MODES)):
+            compression = __default_quality__(cls.NAME)
+
+        # sample each file's audio up front
+        # so that every trial encodes the same frames
+        samples = []
+        for audiofile in audiofiles:
+            with audiofile.to_pcm() as pcmreader:
+                samples.append(
+                    (pcmreader.sample_rate,
+                     sample_pcm(pcmreader,
+                                audiofile.total_frames(),
+                                (pcmreader.sample_rate * sample_seconds) //
+                                max(len(audiofiles), 1))))
+
+        reference = cls.COMPRESSION_OPTIONS[compression]
+        candidates = [reference]
+        for block_size in cls.AUTOTUNE_BLOCK_SIZES:
+            for max_lpc_order in cls.AUTOTUNE_LPC_ORDERS:
+                for partition_order in cls.AUTOTUNE_PARTITION_ORDERS:
+                    for stereo_mode in cls.AUTOTUNE_STEREO_MODES:
+                        options = {"block_size": block_size,
+                                   "max_lpc_order": max_lpc_order,
+                                   "min_residual_partition_order": 0,
+                                   "max_residual_partition_order":
+                                   partition_order}
+                        options.update(stereo_mode)
+                        if options != reference:
+                            candidates.append(options)
+
+        def trial(options):
+            start = thread_time()
+            size = sum([trial_encode_flac(framelist, sample_rate, **options)
+                        for (sample_rate, framelist) in samples])
+            return FlacEncodingTrial(options, size, thread_time() - start)
+
+        pool = ThreadPool(workers if workers is not None else MAX_JOBS)
+        try:
+            trials = pool.map(trial, candidates)
+        finally:
+            pool.close()
+            pool.join()
+
+        reference_trial = trials[0]
+        affordable = [t for t in trials
+                      if t.cpu <= reference_trial.cpu * cpu_budget]
+        if len(affordable) == 0:
+            # timings are noisy enough that even the reference
+            # may not make its own budget on a second look
+            return reference_trial
+        target_size = (min([t.size for t in affordable]) *
+                       (1.0 + size_tolerance))
+
+        return min([t for t in affordable if t.size <= target_size],
+                   key=lambda t: (t.cpu, t.size))
+
     def seekable(self):
         """returns True if the file is seekable"""
 
-        return self.get_metadata().has_block(Flac_SEEKTABLE.BLOCK_ID)
+        return Flac_SEEKTABLE.BLOCK_ID in [
+            block_type for (block_type, offset, size) in
+            self.__header__.blocks]
 
     def seektable(self, offsets=None, seekpoint_interval=None):
         """returns a new Flac_SEEKTABLE object
@@ -2681,10 +2902,11 @@ class FlacAudio(WaveContainer, AiffContainer):
 
         from audiotools import ReplayGain
 
-        try:
-            vorbis_metadata = self.get_metadata().get_block(
-                Flac_VORBISCOMMENT.BLOCK_ID)
-        except (IndexError, IOError):
+        if self.__header__.comments is not None:
+            vorbis_metadata = Flac_VORBISCOMMENT(
+                self.__header__.comments,
+                self.__header__.vendor_string)
+        else:
             return None
 
         if ({u'REPLAYGAIN_TRACK_PEAK', u'REPLAYGAIN_TRACK_GAIN',
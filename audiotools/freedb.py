@@ -149,7 +149,6 @@ def perform_lookup(disc_id, freedb_server, freedb_port):
     """
 
     import re
-    from time import sleep
 
     RESPONSE = re.compile(r'(\d{3}) (.+?)[\r\n]+')
     QUERY_RESULT = re.compile(r'(\S+) ([0-9a-fA-F]{8}) (.+)')
@@ -202,8 +201,6 @@ def perform_lookup(disc_id, freedb_server, freedb_port):
     if len(matches) > 0:
         # for each result, query FreeDB for XMCD file data
         for (category, disc_id, title) in matches:
-            sleep(1)  # add a slight delay to keep the server happy
-
             query = freedb_command(freedb_server,
                                    freedb_port,
                                    u"read",
@@ -234,10 +231,7 @@ def freedb_command(freedb_server, freedb_port, cmd, *args):
     command unicode string and argument unicode strings,
     yields a list of Unicode strings"""
 
-    try:
-        from urllib.request import urlopen
-    except ImportError:
-        from urllib2 import urlopen
+    from audiotools.lookup import urlopen
     try:
         from urllib.parse import urlencode
     except ImportError:
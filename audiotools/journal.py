@@ -0,0 +1,192 @@
+# Audio Tools, a module and set of tools for manipulating audio data
+# Copyright (C) 2007-2016  Brian Langenberger
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""a journal of completed batch jobs, for resuming interrupted batches"""
+
+import os
+import os.path
+
+
+def source_fingerprint(filename):
+    """given a path to a file, returns a list of
+    its absolute path, size and modification time
+
+    this identifies the file's contents well enough to notice
+    it's been changed since a job was completed
+    without having to read the file
+
+    raises OSError if the file can't be found"""
+
+    stat = os.stat(filename)
+    return [os.path.abspath(filename),
+            stat.st_size,
+            getattr(stat, "st_mtime_ns", int(stat.st_mtime * 10 ** 9))]
+
+
+def job_key(*parameters):
+    """given a job's parameters, such as its source fingerprints,
+    output filename and encoding options, as JSON-compatible values
+    returns a key for the job as a hex string"""
+
+    from hashlib import sha1
+    from json import dumps
+
+    return sha1(dumps(parameters,
+                      sort_keys=True,
+                      default=str).encode("utf-8")).hexdigest()
+
+
+def metadata_parameters(metadata):
+    """given a MetaData object, or None,
+    returns its fields and embedded images as JSON-compatible values
+    suitable for passing to job_key
+
+    images are represented by their type, MIME type, description
+    and the SHA-1 digest of their data"""
+
+    from hashlib import sha1
+
+    if metadata is None:
+        return None
+    else:
+        return [[getattr(metadata, attr) for attr in metadata.FIELDS],
+                [[image.type,
+                  image.mime_type,
+                  image.description,
+                  sha1(image.data).hexdigest()]
+                 for image in metadata.images()]]
+
+
+def replay_gain_parameters(replay_gain):
+    """given a ReplayGain object, or None,
+    returns its values as JSON-compatible values
+    suitable for passing to job_key"""
+
+    if replay_gain is None:
+        return None
+    else:
+        return [replay_gain.track_gain,
+                replay_gain.track_peak,
+                replay_gain.album_gain,
+                replay_gain.album_peak]
+
+
+def file_checksum(filename):
+    """returns the SHA-1 digest of the given file's data as a hex string"""
+
+    from hashlib import sha1
+
+    digest = sha1()
+    with open(filename, "rb") as f:
+        chunk = f.read(0x10000)
+        while len(chunk) > 0:
+            digest.update(chunk)
+            chunk = f.read(0x10000)
+    return digest.hexdigest()
+
+
+def partial_filename(filename):
+    """returns a hidden path alongside the given output filename
+    with the same extension, to be written to
+    and renamed over the output filename once complete
+
+    an interrupted job then leaves no partial file
+    at the output filename itself"""
+
+    (dirname, basename) = os.path.split(filename)
+    (base, ext) = os.path.splitext(basename)
+    return os.path.join(dirname,
+                        ".{}.{:d}.partial{}".format(base, os.getpid(), ext))
+
+
+class JobJournal(object):
+    """an append-only log of completed jobs
+
+    each entry maps a job's key to its output and result,
+    such as the checksum of the file it wrote,
+    and is written on a line of its own as soon as the job completes
+    so an interrupted batch can skip the jobs already finished"""
+
+    def __init__(self, filename):
+        """filename is the journal to resume from and append to,
+        which is created if necessary
+
+        raises IOError if the journal can't be opened"""
+
+        from json import loads
+
+        self.filename = filename
+
+        # key -> (output, result)
+        self.__entries__ = {}
+
+        line = b"\n"
+        if os.path.isfile(filename):
+            with open(filename, "rb") as f:
+                for line in f:
+                    try:
+                        (key, output, result) = loads(line.decode("utf-8"))
+                    except (ValueError, TypeError):
+                        # the last line may be incomplete
+                        # if the batch was interrupted while writing it
+                        continue
+                    self.__entries__[key] = (output, result)
+
+        self.__journal__ = open(filename, "ab")
+
+        # terminate any incomplete last line
+        # so that the next entry starts on a line of its own
+        if (self.__journal__.tell() > 0) and (not line.endswith(b"\n")):
+            self.__journal__.write(b"\n")
+            self.__journal__.flush()
+
+    def __len__(self):
+        return len(self.__entries__)
+
+    def __contains__(self, key):
+        return key in self.__entries__
+
+    def get(self, key, default=None):
+        """returns the (output, result) tuple recorded for the job key
+        or default if the job hasn't been completed"""
+
+        return self.__entries__.get(key, default)
+
+    def record(self, key, output, result):
+        """records the job key as complete
+        along with its output and result as JSON-compatible values
+
+        the entry is flushed to disk before returning"""
+
+        from json import dumps
+
+        self.__entries__[key] = (output, result)
+        self.__journal__.write(dumps([key, output, result]).encode("utf-8"))
+        self.__journal__.write(b"\n")
+        self.__journal__.flush()
+        os.fsync(self.__journal__.fileno())
+
+    def close(self):
+        """closes the journal"""
+
+        self.__journal__.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
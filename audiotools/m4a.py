@@ -51,6 +51,49 @@ def get_m4a_atom(reader, *atoms):
             raise KeyError(next_atom)
 
 
+def get_edit_length(filename, media_time_scale):
+    """given an M4A filename and its media's time scale
+    returns the length of its track's edit list
+    in that time scale, or None if it has none
+
+    may raise IOError if the file's atoms can't be read"""
+
+    from audiotools.bitstream import BitstreamReader
+
+    with BitstreamReader(open(filename, "rb"), False) as reader:
+        try:
+            moov = get_m4a_atom(reader, b"moov")[1]
+        except KeyError:
+            return None
+        moov_start = moov.getpos()
+
+        try:
+            mvhd = get_m4a_atom(moov, b"mvhd")[1]
+            moov.setpos(moov_start)
+            elst = get_m4a_atom(moov, b"trak", b"edts", b"elst")[1]
+        except KeyError:
+            return None
+
+        (version, ) = mvhd.parse("8u 24p")
+        if version == 0:
+            (movie_time_scale, ) = mvhd.parse("32p 32p 32u")
+        else:
+            (movie_time_scale, ) = mvhd.parse("64p 64p 32u")
+        if movie_time_scale == 0:
+            return None
+
+        # the first edit which isn't empty presents the track
+        (version, edits) = elst.parse("8u 24p 32u")
+        for i in range(edits):
+            if version == 0:
+                (duration, media_time) = elst.parse("32u 32s 32p")
+            else:
+                (duration, media_time) = elst.parse("64U 64S 32p")
+            if media_time >= 0:
+                return (duration * media_time_scale) // movie_time_scale
+        return None
+
+
 def get_m4a_atom_offset(reader, *atoms):
     """given a BitstreamReader and atom name strings
     returns a (size, offset) of the final atom data
@@ -67,7 +110,7 @@ def get_m4a_atom_offset(reader, *atoms):
             (length, stream_atom) = reader.parse("32u 4b")
             offset += 8
             while stream_atom != next_atom:
-                if (length - 8) > 0:
+                if (length - 8) >= 0:
                     reader.skip_bytes(length - 8)
                     offset += (length - 8)
                     (length, stream_atom) = reader.parse("32u 4b")
@@ -299,8 +342,28 @@ class M4ATaggedAudio(object):
         self.set_metadata(MetaData())
 
 
+def __has_aac_decoder__():
+    """returns True if AAC can be decoded in-process"""
+
+    try:
+        from audiotools.decoders import AACDecoder
+        return True
+    except ImportError:
+        return False
+
+
+def __has_aac_encoder__():
+    """returns True if AAC can be encoded in-process"""
+
+    try:
+        from audiotools.encoders import encode_aac
+        return True
+    except ImportError:
+        return False
+
+
 class M4AAudio_faac(M4ATaggedAudio, AudioFile):
-    """an M4A audio file using faac/faad binaries for I/O"""
+    """an M4A audio file using libfaac/libfaad or faac/faad binaries for I/O"""
 
     SUFFIX = "m4a"
     NAME = SUFFIX
@@ -373,6 +436,14 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
             from audiotools.text import ERR_M4A_INVALID_MDHD
             raise InvalidM4A(ERR_M4A_INVALID_MDHD)
 
+        # an edit list, if any, gives the track's exact length
+        # without the encoder's delay and padding
+        try:
+            self.__edit_length__ = get_edit_length(filename,
+                                                   self.__sample_rate__)
+        except IOError:
+            self.__edit_length__ = None
+
     def channel_mask(self):
         """returns a ChannelMask object of this track's channel layout"""
 
@@ -430,19 +501,22 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
 
         each CD frame is 1/75th of a second"""
 
-        return ((self.__length__ - 1024) * 75) // self.__sample_rate__
+        return (self.total_frames() * 75) // self.__sample_rate__
 
     def total_frames(self):
         """returns the total PCM frames of the track as an integer"""
 
-        return self.__length__ - 1024
+        if self.__edit_length__ is not None:
+            return self.__edit_length__
+        else:
+            return self.__length__ - 1024
 
     @classmethod
     def supports_to_pcm(cls):
         """returns True if all necessary components are available
         to support the .to_pcm() method"""
 
-        return BIN.can_execute(BIN["faad"])
+        return __has_aac_decoder__() or BIN.can_execute(BIN["faad"])
 
     def to_pcm(self):
         """returns a PCMReader object containing the track's PCM data"""
@@ -451,6 +525,9 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
         import subprocess
         import os
 
+        if __has_aac_decoder__():
+            return self.__aac_decoder__()
+
         sub = subprocess.Popen(
             [BIN['faad'], "-f", str(2), "-w", self.filename],
             stdout=subprocess.PIPE,
@@ -463,12 +540,27 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
                              bits_per_sample=self.bits_per_sample(),
                              process=sub)
 
+    def __aac_decoder__(self):
+        """returns an in-process AACDecoder for the track's PCM data"""
+
+        from audiotools.decoders import AACDecoder
+        from audiotools import PCMReaderError
+
+        try:
+            return AACDecoder(open(self.filename, "rb"))
+        except (IOError, ValueError) as msg:
+            return PCMReaderError(error_message=str(msg),
+                                  sample_rate=self.sample_rate(),
+                                  channels=self.channels(),
+                                  channel_mask=int(self.channel_mask()),
+                                  bits_per_sample=self.bits_per_sample())
+
     @classmethod
     def supports_from_pcm(cls):
         """returns True if all necessary components are available
         to support the .from_pcm() classmethod"""
 
-        return BIN.can_execute(BIN["faac"])
+        return __has_aac_encoder__() or BIN.can_execute(BIN["faac"])
 
     @classmethod
     def from_pcm(cls, filename, pcmreader,
@@ -509,6 +601,12 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
                                      channel_mask=ChannelMask.from_channels(2),
                                      bits_per_sample=pcmreader.bits_per_sample)
 
+        if __has_aac_encoder__():
+            return cls.__encode_aac__(filename,
+                                      pcmreader,
+                                      compression,
+                                      total_pcm_frames)
+
         # faac requires files to end with .m4a for some reason
         if not filename.endswith(".m4a"):
             import tempfile
@@ -577,6 +675,43 @@ class M4AAudio_faac(M4ATaggedAudio, AudioFile):
                 tempfile.close()
             raise EncodingError(u"unable to write file with faac")
 
+    @classmethod
+    def __encode_aac__(cls, filename, pcmreader, compression,
+                       total_pcm_frames):
+        """encodes pcmreader's data to filename in-process
+        and returns a new M4AAudio object"""
+
+        from audiotools.encoders import encode_aac
+        from audiotools import VERSION, EncodingError
+
+        try:
+            file = open(filename, "wb")
+        except IOError as err:
+            pcmreader.close()
+            raise EncodingError(str(err))
+
+        try:
+            encode_aac(file=file,
+                       pcmreader=pcmreader,
+                       quality=int(compression),
+                       total_pcm_frames=(total_pcm_frames if
+                                         (total_pcm_frames is not None)
+                                         else 0),
+                       version="Python Audio Tools " + VERSION)
+        except (ValueError, IOError) as err:
+            file.close()
+            cls.__unlink__(filename)
+            raise EncodingError(str(err))
+        except Exception:
+            file.close()
+            cls.__unlink__(filename)
+            raise
+        finally:
+            pcmreader.close()
+
+        file.close()
+        return M4AAudio(filename)
+
 
 class M4AAudio_nero(M4AAudio_faac):
     """an M4A audio file using neroAacEnc/neroAacDec binaries for I/O"""
@@ -654,13 +789,16 @@ class M4AAudio_nero(M4AAudio_faac):
         """returns True if all necessary components are available
         to support the .to_pcm() method"""
 
-        return BIN.can_execute(BIN["neroAacDec"])
+        return __has_aac_decoder__() or BIN.can_execute(BIN["neroAacDec"])
 
     def to_pcm(self):
         from audiotools import PCMFileReader
         import subprocess
         import os
 
+        if __has_aac_decoder__():
+            return self.__aac_decoder__()
+
         sub = subprocess.Popen(
             [BIN["neroAacDec"],
              "-if", self.filename,
@@ -697,7 +835,11 @@ class M4AAudio_nero(M4AAudio_faac):
         else:
             return cls(filename)
 
-if BIN.can_execute(BIN["neroAacEnc"]) and BIN.can_execute(BIN["neroAacDec"]):
+# the in-process encoder avoids spawning a subprocess for each track
+# so it takes priority over Nero's binaries if available
+if ((not __has_aac_encoder__()) and
+    BIN.can_execute(BIN["neroAacEnc"]) and
+    BIN.can_execute(BIN["neroAacDec"])):
     M4AAudio = M4AAudio_nero
 else:
     M4AAudio = M4AAudio_faac
@@ -919,10 +1061,12 @@ class ALACAudio(M4ATaggedAudio, AudioFile):
         optional total_pcm_frames integer
         encodes a new audio file from pcmreader's data
         at the given filename with the specified compression level
-        and returns a new ALACAudio object"""
+        and returns a new ALACAudio object
+
+        each frameset is verified as it's encoded if VERIFY_ENCODING is set"""
 
         from audiotools.encoders import encode_alac
-        from audiotools import VERSION, EncodingError
+        from audiotools import VERSION, EncodingError, VERIFY_ENCODING
 
         if pcmreader.bits_per_sample not in {16, 24}:
             from audiotools import UnsupportedBitsPerSample
@@ -962,7 +1106,8 @@ class ALACAudio(M4ATaggedAudio, AudioFile):
                 initial_history=cls.INITIAL_HISTORY,
                 history_multiplier=cls.HISTORY_MULTIPLIER,
                 maximum_k=cls.MAXIMUM_K,
-                version="Python Audio Tools " + VERSION)
+                version="Python Audio Tools " + VERSION,
+                verify=VERIFY_ENCODING)
         except (ValueError, IOError) as err:
             cls.__unlink__(filename)
             raise EncodingError(str(err))
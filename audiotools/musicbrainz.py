@@ -127,10 +127,7 @@ def perform_lookup(disc_id, musicbrainz_server, musicbrainz_port):
     or xml.parsers.expat.ExpatError if there's an error parsing the data
     """
 
-    try:
-        from urllib.request import urlopen
-    except ImportError:
-        from urllib2 import urlopen
+    from audiotools.lookup import urlopen
     try:
         from urllib.parse import urlencode
     except ImportError:
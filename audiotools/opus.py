@@ -179,9 +179,10 @@ class OpusAudio(VorbisAudio):
         return a PCMReaderError with an appropriate error message"""
 
         from audiotools.decoders import OpusDecoder
+        from audiotools import DECODE_AHEAD
 
         try:
-            return OpusDecoder(self.filename)
+            return OpusDecoder(self.filename, decode_ahead=DECODE_AHEAD)
         except ValueError as err:
             from audiotools import PCMReaderError
             return PCMReaderError(error_message=str(err),
@@ -866,10 +866,6 @@ class PulseAudioOutput(AudioOutput):
                                              channels,
                                              bits_per_sample,
                                              "Python Audio Tools")
-            self.__converter__ = {
-                8: lambda f: f.to_bytes(True, False),
-                16: lambda f: f.to_bytes(False, True),
-                24: lambda f: f.to_bytes(False, True)}[self.bits_per_sample]
         elif (not self.compatible(sample_rate=sample_rate,
                                   channels=channels,
                                   channel_mask=channel_mask,
@@ -883,9 +879,13 @@ class PulseAudioOutput(AudioOutput):
                             bits_per_sample=bits_per_sample)
 
     def play(self, framelist):
-        """plays a FrameList"""
+        """plays a FrameList
+
+        the FrameList is queued as-is and converted to the stream's format
+        as the server asks for data, so this only waits
+        if the queue is already full"""
 
-        self.__pulseaudio__.play(self.__converter__(framelist))
+        self.__pulseaudio__.play(framelist)
 
     def pause(self):
         """pauses audio output, with the expectation it will be resumed"""
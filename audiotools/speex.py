@@ -22,8 +22,29 @@ class InvalidSpeex(InvalidFile):
     pass
 
 
+def __has_speex_decoder__():
+    """returns True if Speex can be decoded in-process"""
+
+    try:
+        from audiotools.decoders import SpeexDecoder
+        return True
+    except ImportError:
+        return False
+
+
+def __has_speex_encoder__():
+    """returns True if Speex can be encoded in-process"""
+
+    try:
+        from audiotools.encoders import encode_speex
+        return True
+    except ImportError:
+        return False
+
+
 class SpeexAudio(AudioFile):
-    """an Ogg Speex audio file"""
+    """an Ogg Speex audio file using libspeex
+    or speexdec/speexenc binaries for I/O"""
 
     from audiotools.text import (COMP_SPEEX_0,
                                  COMP_SPEEX_10)
@@ -32,6 +53,7 @@ class SpeexAudio(AudioFile):
     NAME = SUFFIX
     DESCRIPTION = "Ogg Speex"
     COMPRESSION_MODES = tuple(str(i) for i in range(11))
+    DEFAULT_COMPRESSION = "8"
     COMPRESSION_DESCRIPTIONS = {"0": COMP_SPEEX_0, "10": COMP_SPEEX_10}
     BINARIES = ("speexdec", "speexenc")
     BINARY_URLS = {"speexenc": "http://www.speex.org",
@@ -279,7 +301,7 @@ class SpeexAudio(AudioFile):
         """returns True if all necessary components are available
         to support the .to_pcm() method"""
 
-        return BIN.can_execute(BIN["speexdec"])
+        return __has_speex_decoder__() or BIN.can_execute(BIN["speexdec"])
 
     def to_pcm(self):
         """returns a PCMReader object containing the track's PCM data
@@ -291,6 +313,19 @@ class SpeexAudio(AudioFile):
         import os
         import subprocess
 
+        if __has_speex_decoder__():
+            from audiotools.decoders import SpeexDecoder
+            from audiotools import PCMReaderError
+
+            try:
+                return SpeexDecoder(self.filename)
+            except (IOError, ValueError) as msg:
+                return PCMReaderError(error_message=str(msg),
+                                      sample_rate=self.sample_rate(),
+                                      channels=self.channels(),
+                                      channel_mask=int(self.channel_mask()),
+                                      bits_per_sample=self.bits_per_sample())
+
         sub = subprocess.Popen(
             [BIN["speexdec"], self.filename, "-"],
             stdout=subprocess.PIPE,
@@ -310,7 +345,7 @@ class SpeexAudio(AudioFile):
         """returns True if all necessary components are available
         to support the .from_pcm() classmethod"""
 
-        return BIN.can_execute(BIN["speexenc"])
+        return __has_speex_encoder__() or BIN.can_execute(BIN["speexenc"])
 
     @classmethod
     def from_pcm(cls, filename, pcmreader,
@@ -362,6 +397,30 @@ class SpeexAudio(AudioFile):
                 min(pcmreader.channels, 2)),
             bits_per_sample=min(pcmreader.bits_per_sample, 16))
 
+        if __has_speex_encoder__():
+            from audiotools.encoders import encode_speex
+
+            try:
+                encode_speex(filename, pcmreader, quality=int(compression))
+            except (IOError, ValueError) as err:
+                pcmreader.close()
+                cls.__unlink__(filename)
+                raise EncodingError(str(err))
+            except Exception:
+                pcmreader.close()
+                cls.__unlink__(filename)
+                raise
+
+            pcmreader.close()
+
+            if ((total_pcm_frames is None) or
+                (total_pcm_frames == counter_reader.frames_written)):
+                return SpeexAudio(filename)
+            else:
+                from audiotools.text import ERR_TOTAL_PCM_FRAMES_MISMATCH
+                cls.__unlink__(filename)
+                raise EncodingError(ERR_TOTAL_PCM_FRAMES_MISMATCH)
+
         BITS_PER_SAMPLE = {8: ['--8bit'],
                            16: ['--16bit']}[pcmreader.bits_per_sample]
 
@@ -138,6 +138,7 @@ OPT_TRACK_TOTAL = \
 OPT_SPEED = u"the speed to burn the CD at"
 OPT_CUESHEET_TRACK2CD = u"the cuesheet to use for writing tracks"
 OPT_JOINT = u"the maximum number of processes to run at a time"
+OPT_JOURNAL = u"a journal of completed jobs to skip and add to"
 OPT_CUESHEET_TRACKCAT = u"a cuesheet to embed in the output file"
 OPT_ADD_CUESHEET_TRACKCAT = u"create a cuesheet to embed in the output file"
 OPT_CUESHEET_TRACKSPLIT = u"the cuesheet to use for splitting track"
@@ -228,6 +229,7 @@ RG_REPLAYGAIN_APPLIED = u"ReplayGain applied"
 
 # Labels
 LAB_ENCODE = u"{source} -> {destination}"
+LAB_JOURNAL_RESUMED = u"skipping {:d} job(s) already completed"
 LAB_PICTURE = u"picture"
 LAB_T_OPTIONS = u"Please use the -t option to specify {}"
 LAB_AVAILABLE_COMPRESSION_TYPES = u"Available quality modes for \"{}\":"
@@ -580,6 +582,7 @@ ERR_IMAGE_INVALID_BMP = u"invalid BMP"
 ERR_IMAGE_IOERROR_BMP = "I/O error reading BMP data"
 ERR_IMAGE_INVALID_TIFF = u"invalid TIFF"
 ERR_IMAGE_IOERROR_TIFF = u"I/O error reading TIFF data"
+ERR_IMAGE_IOERROR = u"I/O error reading image data"
 ERR_IMAGE_INVALID_GIF = u"invalid GIF"
 ERR_IMAGE_IOERROR_GIF = u"I/O error reading GIF data"
 ERR_M4A_IOERROR = u"I/O error opening M4A file"
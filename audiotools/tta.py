@@ -191,12 +191,16 @@ class TrueAudio(ApeTaggedAudio, ApeGainedAudio, AudioFile):
         or even an EncodingError subclass such as
         "UnsupportedBitsPerSample" if the input stream
         is formatted in a way this class is unable to support
+
+        each frame is verified as it's encoded if VERIFY_ENCODING is set
         """
 
         from audiotools import (BufferedPCMReader,
                                 CounterPCMReader,
                                 transfer_data,
-                                EncodingError)
+                                EncodingError,
+                                ENCODE_THREADS,
+                                VERIFY_ENCODING)
         # from audiotools.py_encoders import encode_tta
         from audiotools.encoders import encode_tta
         from audiotools.bitstream import BitstreamWriter
@@ -219,7 +223,9 @@ class TrueAudio(ApeTaggedAudio, ApeGainedAudio, AudioFile):
                 file=file,
                 pcmreader=pcmreader,
                 total_pcm_frames=(total_pcm_frames if
-                                  total_pcm_frames is not None else 0))
+                                  total_pcm_frames is not None else 0),
+                threads=max(ENCODE_THREADS, 1),
+                verify=VERIFY_ENCODING)
 
             return cls(filename)
         except (IOError, ValueError) as err:
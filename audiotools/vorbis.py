@@ -191,9 +191,10 @@ class VorbisAudio(AudioFile):
         """returns a PCMReader object containing the track's PCM data"""
 
         from audiotools.decoders import VorbisDecoder
+        from audiotools import DECODE_AHEAD
 
         try:
-            return VorbisDecoder(self.filename)
+            return VorbisDecoder(self.filename, decode_ahead=DECODE_AHEAD)
         except ValueError as err:
             from audiotools import PCMReaderError
             return PCMReaderError(str(err),
@@ -0,0 +1,430 @@
+# Audio Tools, a module and set of tools for manipulating audio data
+# Copyright (C) 2007-2016  Brian Langenberger
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""a content-addressed cache of embedded cover art and its thumbnails"""
+
+import os
+import os.path
+import threading
+from audiotools import Image
+
+# the most image data held in memory at once
+# while hashing or copying an EmbeddedImage
+CHUNK_SIZE = 0x10000
+
+
+class EmbeddedImage(Image):
+    """an image located by the offset and length of its data in a file
+
+    unlike an ordinary Image, its data isn't held in memory
+    but is read from the file whenever it's needed"""
+
+    def __init__(self, filename, offset, length, mime_type, width, height,
+                 color_depth, color_count, description, type):
+        """filename is the path to the file containing the image
+        offset and length are the position and size of its data
+        in bytes and the remaining fields are as for Image"""
+
+        # bypass Image's constructor
+        # since "data" is a property read on demand
+        self.filename = filename
+        self.offset = offset
+        self.length = length
+        self.mime_type = mime_type
+        self.width = width
+        self.height = height
+        self.color_depth = color_depth
+        self.color_count = color_count
+        self.description = description
+        self.type = type
+
+    def __repr__(self):
+        return "EmbeddedImage({!r}, {!r}, {!r}, {})".format(
+            self.filename,
+            self.offset,
+            self.length,
+            Image.__repr__(self))
+
+    @property
+    def data(self):
+        """the image's data as a binary string"""
+
+        return b"".join(self.chunks())
+
+    def chunks(self):
+        """yields the image's data as a series of binary strings
+
+        raises IOError if the file is shorter than the image"""
+
+        with open(self.filename, "rb") as f:
+            f.seek(self.offset, 0)
+            remaining = self.length
+            while remaining > 0:
+                chunk = f.read(min(remaining, CHUNK_SIZE))
+                if len(chunk) == 0:
+                    from audiotools.text import ERR_IMAGE_IOERROR
+                    raise IOError(ERR_IMAGE_IOERROR)
+                remaining -= len(chunk)
+                yield chunk
+
+
+class CachedImage(EmbeddedImage):
+    """an image stored in an ArtCache under its digest"""
+
+    def __init__(self, digest, filename, length, mime_type, width, height,
+                 color_depth, color_count, description, type):
+        EmbeddedImage.__init__(self, filename, 0, length,
+                               mime_type, width, height,
+                               color_depth, color_count,
+                               description, type)
+        self.digest = digest
+
+    def __repr__(self):
+        return "CachedImage({!r}, {})".format(self.digest,
+                                              Image.__repr__(self))
+
+
+def image_chunks(image):
+    """yields an Image object's data as a series of binary strings
+    reading an EmbeddedImage's data a chunk at a time"""
+
+    if isinstance(image, EmbeddedImage):
+        for chunk in image.chunks():
+            yield chunk
+    else:
+        yield image.data
+
+
+def image_digest(image):
+    """returns the SHA-1 digest of an Image object's data
+    as a hex string, without reading an EmbeddedImage into memory"""
+
+    from hashlib import sha1
+
+    if isinstance(image, CachedImage):
+        return image.digest
+
+    digest = sha1()
+    for chunk in image_chunks(image):
+        digest.update(chunk)
+    return digest.hexdigest()
+
+
+def make_directory(directory):
+    """creates the given directory and any missing parents
+
+    raises IOError if it doesn't exist and can't be created"""
+
+    try:
+        os.makedirs(directory)
+    except OSError:
+        if not os.path.isdir(directory):
+            raise IOError(directory)
+
+
+def embedded_images(audiofile):
+    """returns a list of Image objects embedded in the given AudioFile
+
+    formats able to locate their images without reading them
+    return EmbeddedImage objects, otherwise the images
+    of the file's parsed metadata are returned"""
+
+    if hasattr(audiofile, "embedded_images"):
+        return audiofile.embedded_images()
+    else:
+        metadata = audiofile.get_metadata()
+        if metadata is not None:
+            return metadata.images()
+        else:
+            return []
+
+
+class ArtCache(object):
+    """a content-addressed store of embedded images and their thumbnails
+
+    each unique image is stored once under the digest of its data
+    no matter how many files embed it,
+    and thumbnails are generated by a pool of background threads
+    so that browsing never waits on them"""
+
+    def __init__(self, directory=None, thumbnail_size=None,
+                 thumbnail_format=None, workers=None):
+        """directory is where images and thumbnails are stored
+        thumbnail_size is the maximum width and height of thumbnails
+        thumbnail_format is a PIL format name such as "jpeg" or "png"
+        workers is the number of background threads to use
+
+        each defaults to its value in the config file"""
+
+        from audiotools import (THUMBNAIL_CACHE,
+                                THUMBNAIL_SIZE,
+                                THUMBNAIL_FORMAT,
+                                MAX_JOBS)
+        try:
+            from queue import Queue
+        except ImportError:
+            from Queue import Queue
+
+        self.directory = os.path.expanduser(
+            directory if directory is not None else THUMBNAIL_CACHE)
+        self.thumbnail_size = (thumbnail_size if thumbnail_size is not None
+                               else THUMBNAIL_SIZE)
+        self.thumbnail_format = (thumbnail_format if thumbnail_format
+                                 is not None else THUMBNAIL_FORMAT).lower()
+
+        # digest -> (mime_type, width, height, color_depth, color_count)
+        # for images whose metrics had to be sniffed from their data
+        self.__metrics__ = {}
+
+        # digests of thumbnails queued but not yet generated
+        self.__pending__ = set()
+        self.__lock__ = threading.Lock()
+
+        self.__jobs__ = Queue()
+        self.__workers__ = []
+        for i in range(max(workers if workers is not None else MAX_JOBS, 1)):
+            worker = threading.Thread(target=self.__run_jobs__)
+            worker.daemon = True
+            worker.start()
+            self.__workers__.append(worker)
+
+    def image_path(self, digest):
+        """returns the path to the cached image with the given digest"""
+
+        return os.path.join(self.directory, digest[0:2], digest)
+
+    def thumbnail_path(self, digest):
+        """returns the path to the thumbnail of the given digest's image
+        which may not have been generated yet"""
+
+        return os.path.join(
+            self.directory,
+            digest[0:2],
+            "{}-{:d}.{}".format(digest,
+                                self.thumbnail_size,
+                                {"jpeg": "jpg"}.get(self.thumbnail_format,
+                                                    self.thumbnail_format)))
+
+    def thumbnail(self, digest):
+        """returns the path to the given digest's thumbnail
+        or None if it isn't available yet"""
+
+        path = self.thumbnail_path(digest)
+        if os.path.isfile(path):
+            return path
+        else:
+            return None
+
+    def add(self, image):
+        """stores the given Image object if not already cached,
+        queues the generation of its thumbnail
+        and returns a CachedImage of it
+
+        may raise IOError if the image cannot be read or stored"""
+
+        if (isinstance(image, EmbeddedImage) and
+            not isinstance(image, CachedImage)):
+            # its digest isn't known until its data has been read
+            # so hash and store it in the same pass
+            digest = self.__store_image__(image)
+            path = self.image_path(digest)
+        else:
+            digest = image_digest(image)
+            path = self.image_path(digest)
+            if not os.path.isfile(path):
+                self.__store__(path, image_chunks(image))
+
+        mime_type = image.mime_type
+        width = image.width
+        height = image.height
+        color_depth = image.color_depth
+        color_count = image.color_count
+
+        if (width == 0) or (height == 0):
+            # some taggers leave an image's metrics unpopulated
+            # so sniff them from the cached copy, once
+            with self.__lock__:
+                metrics = self.__metrics__.get(digest, None)
+            if metrics is None:
+                from audiotools.image import image_metrics
+                from audiotools import InvalidImage
+
+                try:
+                    with open(path, "rb") as f:
+                        img = image_metrics(f.read())
+                    metrics = (img.mime_type, img.width, img.height,
+                               img.bits_per_pixel, img.color_count)
+                except InvalidImage:
+                    metrics = (mime_type, width, height,
+                               color_depth, color_count)
+                with self.__lock__:
+                    self.__metrics__[digest] = metrics
+            (mime_type, width, height, color_depth, color_count) = metrics
+
+        self.__queue_thumbnail__(digest)
+
+        return CachedImage(digest=digest,
+                           filename=path,
+                           length=os.path.getsize(path),
+                           mime_type=mime_type,
+                           width=width,
+                           height=height,
+                           color_depth=color_depth,
+                           color_count=color_count,
+                           description=image.description,
+                           type=image.type)
+
+    def images(self, audiofile):
+        """returns a list of CachedImage objects
+        for the images embedded in the given AudioFile
+
+        may raise IOError if the images cannot be read or stored"""
+
+        return [self.add(image) for image in embedded_images(audiofile)]
+
+    def prefetch(self, filenames):
+        """queues the caching of the images embedded in the given files,
+        along with their thumbnails, for the background threads
+
+        files which can't be opened or read are skipped"""
+
+        for filename in filenames:
+            self.__jobs__.put((self.__prefetch__, filename))
+
+    def join(self):
+        """blocks until every queued job has been completed"""
+
+        self.__jobs__.join()
+
+    def __prefetch__(self, filename):
+        from audiotools import open as open_audiofile
+        from audiotools import InvalidFile
+
+        try:
+            self.images(open_audiofile(filename))
+        except (IOError, ValueError, InvalidFile):
+            pass
+
+    def __queue_thumbnail__(self, digest):
+        if self.thumbnail(digest) is not None:
+            return
+
+        with self.__lock__:
+            if digest in self.__pending__:
+                return
+            else:
+                self.__pending__.add(digest)
+
+        self.__jobs__.put((self.__generate_thumbnail__, digest))
+
+    def __generate_thumbnail__(self, digest):
+        try:
+            self.__make_thumbnail__(digest)
+        finally:
+            with self.__lock__:
+                self.__pending__.discard(digest)
+
+    def __make_thumbnail__(self, digest):
+        try:
+            from PIL import Image as PILImage
+        except ImportError:
+            # no thumbnails without PIL
+            # but the cached images themselves remain usable
+            return
+
+        from io import BytesIO
+
+        try:
+            pil_image = PILImage.open(self.image_path(digest))
+            pil_image.thumbnail((self.thumbnail_size, self.thumbnail_size))
+            if ((self.thumbnail_format == "jpeg") and
+                (pil_image.mode not in ("RGB", "L"))):
+                pil_image = pil_image.convert("RGB")
+            thumbnail = BytesIO()
+            pil_image.save(thumbnail, self.thumbnail_format)
+        except (IOError, ValueError, KeyError, SyntaxError):
+            # images PIL can't read, or formats it can't write,
+            # simply go without thumbnails
+            return
+
+        try:
+            self.__store__(self.thumbnail_path(digest),
+                           [thumbnail.getvalue()])
+        except IOError:
+            return
+
+    def __store__(self, path, chunks):
+        """writes chunks of data to the given path
+        such that the file only appears once complete"""
+
+        from tempfile import mkstemp
+
+        directory = os.path.dirname(path)
+        make_directory(directory)
+
+        (fd, temp_path) = mkstemp(dir=directory, prefix=".")
+        try:
+            with os.fdopen(fd, "wb") as f:
+                for chunk in chunks:
+                    f.write(chunk)
+            os.rename(temp_path, path)
+        except:
+            os.unlink(temp_path)
+            raise
+
+    def __store_image__(self, image):
+        """writes an Image object's data to a temporary file
+        while hashing it, then moves the file under its digest
+        unless that digest is already cached
+
+        returns the digest as a hex string"""
+
+        from hashlib import sha1
+        from tempfile import mkstemp
+
+        make_directory(self.directory)
+
+        (fd, temp_path) = mkstemp(dir=self.directory, prefix=".")
+        try:
+            digest = sha1()
+            with os.fdopen(fd, "wb") as f:
+                for chunk in image_chunks(image):
+                    digest.update(chunk)
+                    f.write(chunk)
+            digest = digest.hexdigest()
+            path = self.image_path(digest)
+            if not os.path.isfile(path):
+                make_directory(os.path.dirname(path))
+                os.rename(temp_path, path)
+                return digest
+        except:
+            os.unlink(temp_path)
+            raise
+
+        os.unlink(temp_path)
+        return digest
+
+    def __run_jobs__(self):
+        while True:
+            (function, argument) = self.__jobs__.get()
+            try:
+                function(argument)
+            except Exception:
+                # a failed job shouldn't take its thread down with it
+                pass
+            finally:
+                self.__jobs__.task_done()
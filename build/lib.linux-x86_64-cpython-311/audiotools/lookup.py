@@ -0,0 +1,477 @@
+# Audio Tools, a module and set of tools for manipulating audio data
+# Copyright (C) 2007-2016  Brian Langenberger
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""a cached, rate-limited client for the metadata lookup services"""
+
+import os
+import os.path
+import threading
+
+try:
+    from time import monotonic as clock
+except ImportError:
+    from time import time as clock
+
+try:
+    from urllib.request import HTTPError
+except ImportError:
+    from urllib2 import HTTPError
+
+# the fewest seconds between requests to each service's hosts,
+# applied to the host and any of its subdomains
+RATE_LIMITS = {"musicbrainz.org": 1.0,
+               "freedb.org": 1.0}
+
+# how many times a request refused with
+# "503 Service Unavailable" or "429 Too Many Requests"
+# is retried before giving up
+RETRIES = 3
+
+# the most seconds responses which may change are reused for,
+# such as "404 Not Found" for discs not yet submitted
+# and AccurateRip's growing confidence counts
+VOLATILE_MAX_AGE = 24 * 60 * 60
+
+
+def request_key(url, data=None):
+    """given a URL string and optional POST data as a binary string
+    returns the SHA-1 digest of the request as a hex string
+
+    since each service's URLs carry the disc ID being looked up,
+    this identifies a response per disc"""
+
+    from hashlib import sha1
+
+    digest = sha1(url.encode("utf-8"))
+    if data is not None:
+        digest.update(b"\x00")
+        digest.update(data)
+    return digest.hexdigest()
+
+
+def not_found(url):
+    """returns an HTTPError for a "404 Not Found" response to the URL"""
+
+    return HTTPError(url, 404, "Not Found", {}, None)
+
+
+class LookupBackend(object):
+    """the source lookup responses are ultimately fetched from"""
+
+    def fetch(self, url, data=None):
+        """given a URL string and optional POST data as a binary string
+        returns the response body as a binary string
+
+        raises HTTPError if the server responds with an error
+        or URLError if the server can't be reached"""
+
+        raise NotImplementedError()
+
+
+class HTTPBackend(LookupBackend):
+    """fetches responses from the services themselves"""
+
+    def __init__(self, timeout=None):
+        """timeout is the most seconds to wait on a server, if any"""
+
+        self.timeout = timeout
+
+    def fetch(self, url, data=None):
+        try:
+            from urllib.request import urlopen
+        except ImportError:
+            from urllib2 import urlopen
+
+        if self.timeout is not None:
+            response = urlopen(url, data, self.timeout)
+        else:
+            response = urlopen(url, data)
+        try:
+            return response.read()
+        finally:
+            response.close()
+
+
+class DirectoryBackend(LookupBackend):
+    """fetches responses from a local mirror directory
+
+    responses are stored under their request keys
+    in the same layout as ResponseCache,
+    so a populated cache directory may be served as a mirror"""
+
+    def __init__(self, directory):
+        self.directory = os.path.expanduser(directory)
+
+    def path(self, key):
+        """returns the path to the response with the given request key"""
+
+        return os.path.join(self.directory, key[0:2], key)
+
+    def fetch(self, url, data=None):
+        try:
+            with open(self.path(request_key(url, data)), "rb") as f:
+                return f.read()
+        except IOError:
+            raise not_found(url)
+
+
+class ResponseCache(object):
+    """a persistent store of lookup responses by request key
+
+    "404 Not Found" responses are also stored
+    so that discs the services don't know about
+    aren't looked up again and again
+    though they may be given a shorter lifetime"""
+
+    def __init__(self, directory, max_age=None, missing_max_age=None):
+        """directory is where responses are stored
+        max_age is the most seconds a response is reused for
+        or None if responses never expire
+        missing_max_age is the most seconds a "404 Not Found" is reused for
+        or None to use max_age"""
+
+        self.directory = os.path.expanduser(directory)
+        self.max_age = max_age
+        self.missing_max_age = missing_max_age
+
+    def path(self, key):
+        """returns the path to the response with the given request key"""
+
+        return os.path.join(self.directory, key[0:2], key)
+
+    def missing_path(self, key):
+        """returns the path marking the given request key as not found"""
+
+        return self.path(key) + "-404"
+
+    def get(self, key, max_age=None):
+        """returns a (status, response) tuple for the given request key
+        where status is 200 or 404 and response is a binary string,
+        or None if no fresh response is cached
+
+        max_age, if given, further limits the seconds
+        a cached response is reused for"""
+
+        from time import time
+
+        missing_max_age = (self.missing_max_age
+                           if self.missing_max_age is not None
+                           else self.max_age)
+
+        for (status, path, ages) in [
+                (200, self.path(key), [self.max_age, max_age]),
+                (404, self.missing_path(key), [missing_max_age, max_age])]:
+            ages = [age for age in ages if age is not None]
+            try:
+                if ((len(ages) > 0) and
+                    (os.path.getmtime(path) + min(ages) < time())):
+                    continue
+                with open(path, "rb") as f:
+                    return (status, f.read())
+            except (IOError, OSError):
+                continue
+        else:
+            return None
+
+    def put(self, key, response):
+        """stores the response binary string under the given request key"""
+
+        self.__store__(self.path(key), response)
+
+    def put_missing(self, key):
+        """marks the given request key as not found"""
+
+        self.__store__(self.missing_path(key), b"")
+
+    def __store__(self, path, data):
+        """writes data to the given path
+        such that the file only appears once complete
+
+        since the cache is only an optimization,
+        failing to store a response isn't an error"""
+
+        from tempfile import mkstemp
+
+        directory = os.path.dirname(path)
+        try:
+            os.makedirs(directory)
+        except OSError:
+            if not os.path.isdir(directory):
+                return
+
+        try:
+            (fd, temp_path) = mkstemp(dir=directory, prefix=".")
+        except (IOError, OSError):
+            return
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(data)
+            os.rename(temp_path, path)
+        except (IOError, OSError):
+            os.unlink(temp_path)
+
+
+class PendingRequest(object):
+    """a request being fetched by one thread on behalf of all of them"""
+
+    def __init__(self):
+        self.finished = threading.Event()
+        self.response = None
+        self.error = None
+
+
+class LookupClient(object):
+    """performs lookup requests through a backend and optional cache
+
+    requests may be made from any number of threads at once,
+    requests to the same host are spaced according to RATE_LIMITS
+    and simultaneous requests for the same response
+    are only fetched once"""
+
+    def __init__(self, backend=None, cache=None,
+                 rate_limits=None, retries=None):
+        """backend is a LookupBackend, defaulting to HTTPBackend
+        cache is a ResponseCache or None
+        rate_limits is a {host:seconds} dict, defaulting to RATE_LIMITS
+        retries is the number of times refused requests are retried"""
+
+        self.backend = backend if backend is not None else HTTPBackend()
+        self.cache = cache
+        self.rate_limits = (rate_limits if rate_limits is not None
+                            else RATE_LIMITS)
+        self.retries = retries if retries is not None else RETRIES
+
+        self.__lock__ = threading.Lock()
+
+        # host -> the earliest time its next request may be made
+        self.__next_request__ = {}
+
+        # request key -> PendingRequest
+        self.__pending__ = {}
+
+    def fetch(self, url, data=None, max_age=None):
+        """given a URL string and optional POST data as a binary string
+        returns the response body as a binary string
+
+        max_age, if given, is the most seconds a cached response
+        is reused for, for responses which may change
+
+        raises HTTPError if the server responds with an error
+        or URLError if the server can't be reached"""
+
+        key = request_key(url, data)
+
+        if self.cache is not None:
+            cached = self.cache.get(key, max_age)
+            if cached is not None:
+                (status, response) = cached
+                if status == 200:
+                    return response
+                else:
+                    raise not_found(url)
+
+        with self.__lock__:
+            pending = self.__pending__.get(key, None)
+            if pending is None:
+                pending = self.__pending__[key] = PendingRequest()
+                owner = True
+            else:
+                owner = False
+
+        if not owner:
+            # another thread is already fetching this response
+            pending.finished.wait()
+            if pending.error is not None:
+                raise pending.error
+            else:
+                return pending.response
+
+        try:
+            pending.response = self.__fetch__(url, data)
+            if self.cache is not None:
+                self.cache.put(key, pending.response)
+            return pending.response
+        except HTTPError as err:
+            if (err.code == 404) and (self.cache is not None):
+                self.cache.put_missing(key)
+            pending.error = err
+            raise
+        except Exception as err:
+            # waiting threads must see every failure,
+            # including timeouts and dropped connections
+            pending.error = err
+            raise
+        finally:
+            with self.__lock__:
+                del(self.__pending__[key])
+            pending.finished.set()
+
+    def urlopen(self, url, data=None, max_age=None):
+        """as fetch(), but returns a file-like object of the response"""
+
+        from io import BytesIO
+
+        return BytesIO(self.fetch(url, data, max_age))
+
+    def map(self, function, items, workers=None):
+        """calls function on each item using up to "workers" threads
+        and returns a list of results in the order of the items
+
+        since requests are rate-limited per host,
+        this keeps each service busy without overrunning it
+
+        workers defaults to the configured number of lookup workers"""
+
+        from audiotools import LOOKUP_WORKERS
+
+        items = list(items)
+        workers = min(workers if workers is not None else LOOKUP_WORKERS,
+                      len(items))
+
+        if workers <= 1:
+            return [function(item) for item in items]
+        else:
+            from multiprocessing.pool import ThreadPool
+
+            pool = ThreadPool(workers)
+            try:
+                return pool.map(function, items, 1)
+            finally:
+                pool.close()
+                pool.join()
+
+    def rate_limit(self, host):
+        """returns the fewest seconds between requests to the given host"""
+
+        for (domain, seconds) in self.rate_limits.items():
+            if (host == domain) or host.endswith("." + domain):
+                return seconds
+        else:
+            return 0
+
+    def __fetch__(self, url, data):
+        try:
+            from urllib.parse import urlparse
+        except ImportError:
+            from urlparse import urlparse
+
+        host = urlparse(url).hostname
+        host = host.lower() if host is not None else ""
+
+        attempt = 0
+        while True:
+            self.__wait_turn__(host)
+            try:
+                return self.backend.fetch(url, data)
+            except HTTPError as err:
+                if (err.code in (429, 503)) and (attempt < self.retries):
+                    self.__back_off__(host, retry_after(err, 2 ** attempt))
+                    attempt += 1
+                else:
+                    raise
+
+    def __wait_turn__(self, host):
+        from time import sleep
+
+        # claim the host's next slot while holding the lock
+        # but wait for it without holding the lock
+        # so other hosts' requests aren't held up
+        with self.__lock__:
+            now = clock()
+            turn = max(now, self.__next_request__.get(host, now))
+            self.__next_request__[host] = turn + self.rate_limit(host)
+
+        if turn > now:
+            sleep(turn - now)
+
+    def __back_off__(self, host, seconds):
+        with self.__lock__:
+            self.__next_request__[host] = max(
+                self.__next_request__.get(host, 0),
+                clock() + seconds)
+
+
+def retry_after(err, default):
+    """given an HTTPError, returns the seconds given by its
+    Retry-After header, or default if there's no usable header"""
+
+    headers = getattr(err, "hdrs", None)
+    try:
+        return max(int(headers.get("Retry-After")), 0)
+    except (AttributeError, TypeError, ValueError):
+        return default
+
+
+__DEFAULT_CLIENT__ = None
+__DEFAULT_CLIENT_LOCK__ = threading.Lock()
+
+
+def default_client():
+    """returns the LookupClient used by the lookup services,
+    built from the config file's [Lookup] section on first use"""
+
+    global __DEFAULT_CLIENT__
+
+    with __DEFAULT_CLIENT_LOCK__:
+        if __DEFAULT_CLIENT__ is None:
+            from audiotools import (LOOKUP_CACHE,
+                                    LOOKUP_CACHE_DAYS,
+                                    LOOKUP_MIRROR)
+
+            if len(LOOKUP_MIRROR) > 0:
+                backend = DirectoryBackend(LOOKUP_MIRROR)
+            else:
+                backend = HTTPBackend()
+
+            if (len(LOOKUP_CACHE) > 0) and (LOOKUP_CACHE_DAYS > 0):
+                cache = ResponseCache(LOOKUP_CACHE,
+                                      LOOKUP_CACHE_DAYS * 24 * 60 * 60,
+                                      VOLATILE_MAX_AGE)
+            else:
+                cache = None
+
+            __DEFAULT_CLIENT__ = LookupClient(backend=backend, cache=cache)
+
+        return __DEFAULT_CLIENT__
+
+
+def set_default_client(client):
+    """replaces the LookupClient used by the lookup services
+    and returns the previous one, which may be None
+
+    passing None restores the client built from the config file"""
+
+    global __DEFAULT_CLIENT__
+
+    with __DEFAULT_CLIENT_LOCK__:
+        previous = __DEFAULT_CLIENT__
+        __DEFAULT_CLIENT__ = client
+        return previous
+
+
+def urlopen(url, data=None, max_age=None):
+    """given a URL string and optional POST data as a binary string
+    returns a file-like object of the response
+    fetched through the default client
+
+    max_age, if given, is the most seconds a cached response
+    is reused for, for responses which may change
+
+    raises HTTPError if the server responds with an error
+    or URLError if the server can't be reached"""
+
+    return default_client().urlopen(url, data, max_age)
@@ -0,0 +1,191 @@
+# Audio Tools, a module and set of tools for manipulating audio data
+# Copyright (C) 2007-2016  Brian Langenberger
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+"""the CPU topology worker processes are placed by"""
+
+import os
+import os.path
+
+SYSFS = os.path.join(os.sep, "sys", "devices", "system")
+
+
+def parse_cpu_list(text):
+    """given a CPU list string such as "0-3,8-11"
+    returns a sorted list of CPU numbers
+
+    raises ValueError if the list is malformed"""
+
+    cpus = set()
+    for part in text.strip().split(","):
+        if len(part) == 0:
+            continue
+        elif "-" in part:
+            (first, last) = part.split("-", 1)
+            cpus.update(range(int(first), int(last) + 1))
+        else:
+            cpus.add(int(part))
+    return sorted(cpus)
+
+
+def read_cpu_list(path):
+    """returns the CPU list at the given sysfs path as a sorted list
+    or None if it can't be read"""
+
+    try:
+        with open(path, "r") as f:
+            return parse_cpu_list(f.read())
+    except (IOError, OSError, ValueError):
+        return None
+
+
+def available_cpus():
+    """returns a sorted list of the CPUs this process may run on"""
+
+    try:
+        return sorted(os.sched_getaffinity(0))
+    except AttributeError:
+        from multiprocessing import cpu_count
+        return list(range(cpu_count()))
+
+
+def set_cpus(cpus):
+    """restricts this process, and any threads it starts afterward,
+    to the given list of CPUs
+
+    memory the process touches from then on
+    is allocated from those CPUs' local NUMA node
+    under the kernel's default policy
+
+    returns True if the process was restricted"""
+
+    try:
+        os.sched_setaffinity(0, cpus)
+        return True
+    except (AttributeError, OSError, ValueError):
+        return False
+
+
+def cpu_nodes(cpus, sysfs=SYSFS):
+    """given a list of CPUs, returns a {cpu:node} dict
+    of the NUMA node each belongs to
+
+    CPUs of systems without NUMA nodes
+    are grouped by their physical package instead"""
+
+    nodes = {}
+
+    node_dir = os.path.join(sysfs, "node")
+    try:
+        node_names = os.listdir(node_dir)
+    except OSError:
+        node_names = []
+    for name in node_names:
+        if name.startswith("node") and name[4:].isdigit():
+            node_cpus = read_cpu_list(os.path.join(node_dir, name, "cpulist"))
+            for cpu in (node_cpus if node_cpus is not None else []):
+                nodes[cpu] = int(name[4:])
+
+    for cpu in cpus:
+        if cpu not in nodes:
+            try:
+                with open(os.path.join(sysfs, "cpu", "cpu{:d}".format(cpu),
+                                       "topology",
+                                       "physical_package_id"), "r") as f:
+                    nodes[cpu] = int(f.read())
+            except (IOError, OSError, ValueError):
+                nodes[cpu] = 0
+
+    return dict((cpu, nodes[cpu]) for cpu in cpus)
+
+
+def shared_cache_cpus(cpu, sysfs=SYSFS):
+    """returns a sorted list of the CPUs sharing
+    the given CPU's last-level cache
+    or None if its caches can't be read"""
+
+    cache_dir = os.path.join(sysfs, "cpu", "cpu{:d}".format(cpu), "cache")
+    try:
+        indexes = os.listdir(cache_dir)
+    except OSError:
+        return None
+
+    # (level, shared CPUs) of the highest level cache found
+    last_level = (0, None)
+    for index in indexes:
+        if not index.startswith("index"):
+            continue
+        try:
+            with open(os.path.join(cache_dir, index, "type"), "r") as f:
+                if f.read().strip() == "Instruction":
+                    continue
+            with open(os.path.join(cache_dir, index, "level"), "r") as f:
+                level = int(f.read())
+        except (IOError, OSError, ValueError):
+            continue
+        shared = read_cpu_list(os.path.join(cache_dir, index,
+                                            "shared_cpu_list"))
+        if (shared is not None) and (level > last_level[0]):
+            last_level = (level, shared)
+
+    return last_level[1]
+
+
+def cpu_clusters(placement, cpus=None, sysfs=SYSFS):
+    """given a placement string and an optional list of CPUs,
+    defaulting to those available,
+    returns a list of CPU lists workers should be pinned to
+
+    "node" places workers on the CPUs of one NUMA node each
+    and "cache" on the CPUs sharing one last-level cache each,
+    while anything else, such as "none",
+    returns a single cluster of all the CPUs
+
+    clusters never span NUMA nodes
+    and are ordered to alternate between nodes
+    so that successive workers are spread across them"""
+
+    if cpus is None:
+        cpus = available_cpus()
+    cpus = sorted(cpus)
+
+    if (placement not in ("node", "cache")) or (len(cpus) < 2):
+        return [cpus]
+
+    nodes = cpu_nodes(cpus, sysfs)
+
+    # node -> list of clusters in that node
+    node_clusters = {}
+    clustered = set()
+    for cpu in cpus:
+        if cpu in clustered:
+            continue
+        cluster = [c for c in cpus if nodes[c] == nodes[cpu]]
+        if placement == "cache":
+            shared = shared_cache_cpus(cpu, sysfs)
+            if shared is not None:
+                cluster = [c for c in cluster if (c in shared) or (c == cpu)]
+        cluster = [c for c in cluster if c not in clustered]
+        clustered.update(cluster)
+        node_clusters.setdefault(nodes[cpu], []).append(cluster)
+
+    clusters = []
+    node_lists = [node_clusters[node] for node in sorted(node_clusters)]
+    for i in range(max(len(l) for l in node_lists)):
+        for node_list in node_lists:
+            if i < len(node_list):
+                clusters.append(node_list[i])
+    return clusters
@@ -64,7 +64,10 @@ LIBRARY_URLS = {"libcdio_paranoia": "http://www.gnu.org/software/libcdio/",
                 "alsa": "http://www.alsa-project.org",
                 "libasound2": "http://www.alsa-project.org",
                 "libpulse": "http://www.freedesktop.org",
-                "wavpack": "http://www.wavpack.com"}
+                "wavpack": "http://www.wavpack.com",
+                "faad2": "http://www.audiocoding.com",
+                "faac": "http://www.audiocoding.com",
+                "speex": "http://www.speex.org"}
 
 
 class SystemLibraries(object):
@@ -603,6 +606,7 @@ class audiotools_pcm(Extension):
         Extension.__init__(self,
                            "audiotools.pcm",
                            sources=["src/pcm.c",
+                                    "src/pcm_sink.c",
                                     "src/pcm_conv.c"],
                            define_macros=[("PCM_MODULE", None)])
 
@@ -640,6 +644,13 @@ class audiotools_replaygain(Extension):
                            define_macros=[("HAS_PYTHON", None)])
 
 
+class audiotools_loudness(Extension):
+    def __init__(self):
+        Extension.__init__(self,
+                           "audiotools.loudness",
+                           sources=["src/loudness.c"])
+
+
 class audiotools_decoders(Extension):
     def __init__(self, system_libraries):
         self.__library_manifest__ = []
@@ -652,7 +663,9 @@ class audiotools_decoders(Extension):
                    "src/func_io.c",
                    "src/mini-gmp.c",
                    "src/huffman.c",
+                   "src/decoders/flac_frame.c",
                    "src/decoders/flac.c",
+                   "src/decoders/oggflac.c",
                    "src/ogg.c",
                    "src/ogg_crc.c",
                    "src/common/flac_crc.c",
@@ -668,7 +681,9 @@ class audiotools_decoders(Extension):
                    "src/libmpcdec/requant.c",
                    "src/libmpcdec/streaminfo.c",
                    "src/libmpcdec/synth_filter.c",
+                   "src/decoders/alac_frame.c",
                    "src/decoders/alac.c",
+                   "src/decoders/tta_frame.c",
                    "src/decoders/tta.c",
                    "src/decoders/mpc.c",
                    "src/decoders/sine.c",
@@ -731,6 +746,48 @@ class audiotools_decoders(Extension):
                                               "Opus decoding",
                                               False))
 
+        if system_libraries.present("faad2"):
+            if system_libraries.guaranteed_present("faad2"):
+                libraries.add("faad")
+            else:
+                extra_compile_args.extend(
+                    system_libraries.extra_compile_args("faad2"))
+                extra_link_args.extend(
+                    system_libraries.extra_link_args("faad2"))
+            defines.append(("HAS_FAAD", None))
+            sources.append("src/decoders/aac.c")
+            self.__library_manifest__.append(("faad2",
+                                              "M4A AAC decoding",
+                                              True))
+        else:
+            self.__library_manifest__.append(("faad2",
+                                              "M4A AAC decoding",
+                                              False))
+
+        if system_libraries.present("speex"):
+            if system_libraries.guaranteed_present("speex"):
+                libraries.add("speex")
+            else:
+                extra_compile_args.extend(
+                    system_libraries.extra_compile_args("speex"))
+                extra_link_args.extend(
+                    system_libraries.extra_link_args("speex"))
+            defines.append(("HAS_SPEEX", None))
+            sources.append("src/decoders/speex.c")
+            self.__library_manifest__.append(("speex",
+                                              "Ogg Speex decoding",
+                                              True))
+        else:
+            self.__library_manifest__.append(("speex",
+                                              "Ogg Speex decoding",
+                                              False))
+
+        if (system_libraries.present("vorbisfile") or
+            system_libraries.present("opusfile")):
+            # decodes blocks ahead of read() on a separate thread
+            sources.append("src/decoders/decode_ahead.c")
+            libraries.add("pthread")
+
         if system_libraries.present("wavpack"):
             if system_libraries.guaranteed_present("wavpack"):
                 libraries.add("wavpack")
@@ -789,13 +846,17 @@ class audiotools_encoders(Extension):
                    "src/mini-gmp.c",
                    "src/common/md5.c",
                    "src/encoders/flac.c",
+                   "src/decoders/flac_frame.c",
                    "src/common/flac_crc.c",
                    "src/common/tta_crc.c",
                    "src/encoders/alac.c",
+                   "src/decoders/alac_frame.c",
                    "src/common/m4a_atoms.c",
                    "src/encoders/tta.c",
+                   "src/decoders/tta_frame.c",
                    "src/encoders.c"]
-        libraries = set()
+        # the TTA encoder can encode frames on several threads
+        libraries = set(["pthread"])
         extra_link_args = []
         extra_compile_args = []
 
@@ -894,6 +955,45 @@ class audiotools_encoders(Extension):
                                               "Wavpack encoding",
                                               False))
 
+        if system_libraries.present("faac"):
+            if system_libraries.guaranteed_present("faac"):
+                libraries.add("faac")
+            else:
+                extra_compile_args.extend(
+                    system_libraries.extra_compile_args("faac"))
+                extra_link_args.extend(
+                    system_libraries.extra_link_args("faac"))
+            defines.append(("HAS_FAAC", None))
+            sources.append("src/encoders/aac.c")
+            self.__library_manifest__.append(("faac",
+                                              "M4A AAC encoding",
+                                              True))
+        else:
+            self.__library_manifest__.append(("faac",
+                                              "M4A AAC encoding",
+                                              False))
+
+        if system_libraries.present("speex"):
+            if system_libraries.guaranteed_present("speex"):
+                libraries.add("speex")
+            else:
+                extra_compile_args.extend(
+                    system_libraries.extra_compile_args("speex"))
+                extra_link_args.extend(
+                    system_libraries.extra_link_args("speex"))
+            defines.append(("HAS_SPEEX", None))
+            # Speex packets are written to Ogg pages natively
+            sources.extend(["src/encoders/speex.c",
+                            "src/ogg.c",
+                            "src/ogg_crc.c"])
+            self.__library_manifest__.append(("speex",
+                                              "Ogg Speex encoding",
+                                              True))
+        else:
+            self.__library_manifest__.append(("speex",
+                                              "Ogg Speex encoding",
+                                              False))
+
         Extension.__init__(self,
                            "audiotools.encoders",
                            sources=sources,
@@ -941,6 +1041,13 @@ class audiotools_accuraterip(Extension):
                            sources=["src/accuraterip.c"])
 
 
+class audiotools_fingerprint(Extension):
+    def __init__(self):
+        Extension.__init__(self,
+                           "audiotools._fingerprint",
+                           sources=["src/fingerprint.c"])
+
+
 class audiotools_output(Extension):
     def __init__(self, system_libraries):
         self.__library_manifest__ = []
@@ -1023,11 +1130,13 @@ ext_audiotools_dvdaudio = audiotools_dvdaudio(system_libraries)
 ext_modules = [audiotools_pcm(),
                audiotools_pcmconverter(),
                audiotools_replaygain(),
+               audiotools_loudness(),
                audiotools_decoders(system_libraries),
                audiotools_encoders(system_libraries),
                audiotools_bitstream(),
                audiotools_ogg(),
                audiotools_accuraterip(),
+               audiotools_fingerprint(),
                audiotools_output(system_libraries)]
 
 scripts = ["audiotools-config",
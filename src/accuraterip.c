@@ -198,6 +198,8 @@ Checksum_update(accuraterip_Checksum* self, PyObject *args)
     if (!PyArg_ParseTuple(args, "O!", self->framelist_class, &framelist))
         return NULL;
 
+    FrameList_interleave(framelist);
+
     /*ensure FrameList is CD-formatted*/
     if (framelist->channels != 2) {
         PyErr_SetString(PyExc_ValueError,
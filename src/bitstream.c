@@ -5249,6 +5249,9 @@ bw_pos_stack_pop(struct bw_pos_stack** stack)
 }
 
 #ifdef HAS_PYTHON
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 unsigned
 br_read_python(void *stream,
@@ -5467,6 +5470,271 @@ python_obj_seekable(PyObject* obj)
     }
 }
 
+/*returns 1 if the Python object reads directly from its
+  file descriptor, without any transformation like decompression*/
+static int
+python_obj_is_os_file(PyObject *obj)
+{
+#if PY_MAJOR_VERSION >= 3
+    PyObject *io;
+    PyObject *file_io;
+    PyObject *buffered_reader;
+    PyObject *buffered_random;
+    int is_file = 0;
+
+    if ((io = PyImport_ImportModule("io")) == NULL) {
+        PyErr_Clear();
+        return 0;
+    }
+    file_io = PyObject_GetAttrString(io, "FileIO");
+    buffered_reader = PyObject_GetAttrString(io, "BufferedReader");
+    buffered_random = PyObject_GetAttrString(io, "BufferedRandom");
+    Py_DECREF(io);
+
+    if (file_io && buffered_reader && buffered_random) {
+        if (PyObject_IsInstance(obj, file_io) == 1) {
+            is_file = 1;
+        } else if ((PyObject_IsInstance(obj, buffered_reader) == 1) ||
+                   (PyObject_IsInstance(obj, buffered_random) == 1)) {
+            /*buffered objects must wrap a FileIO object*/
+            PyObject *raw = PyObject_GetAttrString(obj, "raw");
+            if (raw) {
+                is_file = (PyObject_IsInstance(raw, file_io) == 1);
+                Py_DECREF(raw);
+            }
+        }
+    }
+
+    Py_XDECREF(file_io);
+    Py_XDECREF(buffered_reader);
+    Py_XDECREF(buffered_random);
+    PyErr_Clear();
+    return is_file;
+#else
+    return PyFile_Check(obj);
+#endif
+}
+
+/*seeks the Python object to the given position
+  and returns its new position, or -1 on error*/
+static off_t
+python_obj_seek(PyObject *obj, off_t position, int whence)
+{
+    PyObject *result = PyObject_CallMethod(obj, "seek", "Li",
+                                           (PY_LONG_LONG)position, whence);
+    PY_LONG_LONG new_position;
+
+    if (result == NULL) {
+        PyErr_Clear();
+        return -1;
+    }
+    new_position = PyLong_AsLongLong(result);
+    Py_DECREF(result);
+    if ((new_position == -1) && PyErr_Occurred()) {
+        PyErr_Clear();
+        return -1;
+    }
+    return (off_t)new_position;
+}
+
+/*a Python file object backed by a regular file
+  whose bytes are read directly from its descriptor
+  rather than by calling its read() method
+
+  the reader keeps its own position in the file
+  and only moves the object there when it's set, seeked,
+  closed or freed, so refilling the buffer makes no Python calls*/
+struct python_fd {
+    PyObject *obj;      /*the Python file object, which we hold a reference to*/
+    int fd;             /*its file descriptor*/
+    off_t position;     /*the offset the next refill reads from*/
+    int closed;         /*1 once the object has been closed*/
+};
+
+/*moves the Python object to the reader's position
+  where its read() method would have left it
+
+  returns 0 on success, -1 on failure*/
+static int
+python_fd_sync(struct python_fd *stream)
+{
+    return (python_obj_seek(stream->obj,
+                            stream->position,
+                            SEEK_SET) < 0) ? -1 : 0;
+}
+
+static unsigned
+br_read_python_fd(struct python_fd *stream,
+                  uint8_t *buffer,
+                  unsigned buffer_size)
+{
+    ssize_t result;
+
+    do {
+        result = pread(stream->fd, buffer, buffer_size, stream->position);
+    } while ((result < 0) && (errno == EINTR));
+
+    if (result > 0) {
+        stream->position += result;
+        return (unsigned)result;
+    } else {
+        return 0;
+    }
+}
+
+static int
+bs_setpos_python_fd(struct python_fd *stream, off_t *pos)
+{
+    /*seeking a buffered object also flushes any pending writes
+      which pread() would otherwise miss*/
+    stream->position = *pos;
+    return python_fd_sync(stream) ? EOF : 0;
+}
+
+static off_t*
+bs_getpos_python_fd(struct python_fd *stream)
+{
+    off_t *pos = malloc(sizeof(off_t));
+    *pos = stream->position;
+    return pos;
+}
+
+static void
+bs_free_pos_python_fd(off_t *pos)
+{
+    free(pos);
+}
+
+static int
+bs_fseek_python_fd(struct python_fd *stream, long position, int whence)
+{
+    off_t new_position;
+
+    switch (whence) {
+    case 0:  /*SEEK_SET*/
+        new_position = position;
+        break;
+    case 1:  /*SEEK_CUR*/
+        new_position = stream->position + position;
+        break;
+    case 2:  /*SEEK_END*/
+        /*let the object find its own end, including any pending writes*/
+        if ((new_position = python_obj_seek(stream->obj,
+                                            position,
+                                            SEEK_END)) < 0) {
+            return 1;
+        }
+        break;
+    default:
+        return 1;
+    }
+
+    if (new_position < 0) {
+        return 1;
+    }
+    stream->position = new_position;
+    return python_fd_sync(stream) ? 1 : 0;
+}
+
+static int
+bs_close_python_fd(struct python_fd *stream)
+{
+    /*leave the object's position where read() would have
+      before closing it, in case anyone else shares its descriptor*/
+    python_fd_sync(stream);
+    stream->closed = 1;
+    return bs_close_python(stream->obj);
+}
+
+static void
+bs_free_python_fd(struct python_fd *stream)
+{
+    if (!stream->closed) {
+        /*readers may be freed while an exception is being raised
+          which seeking the object mustn't clobber*/
+        PyObject *type;
+        PyObject *value;
+        PyObject *traceback;
+
+        PyErr_Fetch(&type, &value, &traceback);
+        python_fd_sync(stream);
+        PyErr_Restore(type, value, traceback);
+    }
+    Py_DECREF(stream->obj);
+    free(stream);
+}
+
+BitstreamReader*
+br_open_python(PyObject *obj,
+               bs_endianness endianness,
+               unsigned buffer_size)
+{
+    PyObject *fileno_obj;
+    struct stat info;
+    struct python_fd *stream;
+    BitstreamReader *reader;
+    long fd;
+    off_t position;
+
+    Py_INCREF(obj);
+
+    if (!python_obj_is_os_file(obj)) {
+        goto use_python;
+    }
+
+    if ((fileno_obj = PyObject_CallMethod(obj, "fileno", NULL)) == NULL) {
+        PyErr_Clear();
+        goto use_python;
+    }
+    fd = PyLong_AsLong(fileno_obj);
+    Py_DECREF(fileno_obj);
+    if ((fd == -1) && PyErr_Occurred()) {
+        PyErr_Clear();
+        goto use_python;
+    }
+
+    /*only regular files can be read at arbitrary offsets*/
+    if (fstat((int)fd, &info) || !S_ISREG(info.st_mode)) {
+        goto use_python;
+    }
+
+    /*the object's current position, which also flushes
+      any writes it's still buffering*/
+    if ((position = python_obj_seek(obj, 0, SEEK_CUR)) < 0) {
+        goto use_python;
+    }
+
+    stream = malloc(sizeof(struct python_fd));
+    stream->obj = obj;
+    stream->fd = (int)fd;
+    stream->position = position;
+    stream->closed = 0;
+
+    reader = br_open_external(stream,
+                              endianness,
+                              buffer_size,
+                              (ext_read_f)br_read_python_fd,
+                              (ext_setpos_f)bs_setpos_python_fd,
+                              (ext_getpos_f)bs_getpos_python_fd,
+                              (ext_free_pos_f)bs_free_pos_python_fd,
+                              (ext_seek_f)bs_fseek_python_fd,
+                              (ext_close_f)bs_close_python_fd,
+                              (ext_free_f)bs_free_python_fd);
+    return reader;
+
+use_python:
+    return br_open_external(obj,
+                            endianness,
+                            buffer_size,
+                            br_read_python,
+                            bs_setpos_python,
+                            bs_getpos_python,
+                            bs_free_pos_python,
+                            bs_fseek_python,
+                            bs_close_python,
+                            bs_free_python_decref);
+}
+
 #endif
 
 /*****************************************************************
@@ -1183,6 +1183,20 @@ bs_free_python_nodecref(void *stream);
 int
 python_obj_seekable(PyObject* obj);
 
+/*opens a BitstreamReader around a Python file-like object
+  and takes a new reference to it
+
+  if the object is a file opened on a regular file,
+  its bytes are read from its descriptor rather than by its read() method
+  and its position is moved where read() would have left it
+  only when the reader is set, seeked, closed or freed
+
+  otherwise, its read(), seek() and tell() methods are used*/
+BitstreamReader*
+br_open_python(PyObject *obj,
+               bs_endianness endianness,
+               unsigned buffer_size);
+
 #endif
 
 /*******************************************************************
@@ -128,6 +128,9 @@ CDDAReader_init_image(cdio_CDDAReader *self, const char *device)
     self->_.image.image = NULL;
     self->_.image.current_sector = 0;
     self->_.image.final_sector = 0;
+    self->_.image.buffer = malloc(IMAGE_READ_AHEAD * CDIO_CD_FRAMESIZE_RAW);
+    self->_.image.buffer_start = 0;
+    self->_.image.buffer_sectors = 0;
     self->first_track_num  = CDDAReader_first_track_num_image;
     self->last_track_num = CDDAReader_last_track_num_image;
     self->track_lsn = CDDAReader_track_lsn_image;
@@ -215,6 +218,7 @@ CDDAReader_dealloc_image(cdio_CDDAReader *self)
     if (self->_.image.image != NULL) {
         cdio_destroy(self->_.image.image);
     }
+    free(self->_.image.buffer);
 }
 
 static void
@@ -499,28 +503,82 @@ CDDAReader_read_image(cdio_CDDAReader *self,
 {
     const unsigned samples_per_sector = (44100 / 75) * 2;
     const unsigned initial_sectors_to_read = sectors_to_read;
+    const pcm_to_int_f converter = pcm_to_int_converter(16, 0, 1);
 
     while (sectors_to_read &&
            (self->_.image.current_sector <= self->_.image.final_sector)) {
-        uint8_t sector[CDIO_CD_FRAMESIZE_RAW];
-        const int result = cdio_read_audio_sector(
-            self->_.image.image,
-            sector,
-            self->_.image.current_sector);
-
-        if (result == DRIVER_OP_SUCCESS) {
-            pcm_to_int_converter(16, 0, 1)(samples_per_sector, sector, samples);
-            samples += samples_per_sector;
-            self->_.image.current_sector++;
-            sectors_to_read--;
-        } else {
-            return -1;
+        const lsn_t current_sector = self->_.image.current_sector;
+        unsigned buffer_offset;
+        unsigned to_convert;
+
+        /*refill the read-ahead buffer if it doesn't hold the current sector*/
+        if ((current_sector < self->_.image.buffer_start) ||
+            (current_sector >= (self->_.image.buffer_start +
+                                (lsn_t)self->_.image.buffer_sectors))) {
+            if (CDDAReader_fill_image_buffer(self, current_sector)) {
+                return -1;
+            }
         }
+
+        /*convert as many buffered sectors as possible in a single pass
+          directly into the output samples*/
+        buffer_offset = (unsigned)(current_sector -
+                                   self->_.image.buffer_start);
+        to_convert = MIN(sectors_to_read,
+                         self->_.image.buffer_sectors - buffer_offset);
+
+        converter(to_convert * samples_per_sector,
+                  self->_.image.buffer +
+                  (buffer_offset * CDIO_CD_FRAMESIZE_RAW),
+                  samples);
+
+        samples += to_convert * samples_per_sector;
+        self->_.image.current_sector += to_convert;
+        sectors_to_read -= to_convert;
     }
 
     return initial_sectors_to_read - sectors_to_read;
 }
 
+static int
+CDDAReader_fill_image_buffer(cdio_CDDAReader *self, lsn_t sector)
+{
+    const unsigned to_read =
+        (unsigned)MIN(IMAGE_READ_AHEAD,
+                      self->_.image.final_sector - sector + 1);
+    unsigned i;
+
+    self->_.image.buffer_start = sector;
+    self->_.image.buffer_sectors = 0;
+
+    if (self->_.image.buffer == NULL) {
+        return -1;
+    }
+
+    /*try to read the whole span at once*/
+    if (cdio_read_audio_sectors(self->_.image.image,
+                                self->_.image.buffer,
+                                sector,
+                                to_read) == DRIVER_OP_SUCCESS) {
+        self->_.image.buffer_sectors = to_read;
+        return 0;
+    }
+
+    /*if that fails, fall back to reading one sector at a time
+      and keep whatever could be read*/
+    for (i = 0; i < to_read; i++) {
+        if (cdio_read_audio_sector(
+                self->_.image.image,
+                self->_.image.buffer + (i * CDIO_CD_FRAMESIZE_RAW),
+                sector + i) != DRIVER_OP_SUCCESS) {
+            break;
+        }
+    }
+    self->_.image.buffer_sectors = i;
+
+    return (i > 0) ? 0 : -1;
+}
+
 static int
 CDDAReader_read_device(cdio_CDDAReader *self,
                        unsigned sectors_to_read,
@@ -542,9 +600,9 @@ CDDAReader_read_device(cdio_CDDAReader *self,
         unsigned i;
 
         for (i = 0; i < ((44100 / 75) * 2); i++) {
-            *samples = raw_sector[i];
-            samples += 1;
+            samples[i] = raw_sector[i];
         }
+        samples += ((44100 / 75) * 2);
 
         self->_.drive.current_sector++;
         sectors_to_read--;
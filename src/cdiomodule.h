@@ -34,6 +34,11 @@ static PyMethodDef cdioMethods[] = {
     {NULL, NULL, 0, NULL}  /*sentinel*/
 };
 
+/*how many sectors to read from a CD image at once
+  so that sequential track extraction makes one image read per second of audio
+  rather than one per sector*/
+#define IMAGE_READ_AHEAD 75
+
 struct cdio_log {
     int read;
     int verify;
@@ -68,6 +73,12 @@ typedef struct cdio_CDDAReader_s {
             CdIo_t *image;
             lsn_t current_sector;
             lsn_t final_sector;
+
+            /*up to IMAGE_READ_AHEAD raw sectors read ahead of the caller
+              starting at "buffer_start"*/
+            uint8_t *buffer;
+            lsn_t buffer_start;
+            unsigned buffer_sectors;
         } image;
         struct {
             cdrom_drive_t *drive;
@@ -207,6 +218,11 @@ CDDAReader_read_image(cdio_CDDAReader *self,
                       unsigned sectors_to_read,
                       int *samples);
 
+/*fills the image's read-ahead buffer with sectors starting at "sector"
+  returns 0 on success, or -1 if no sectors could be read*/
+static int
+CDDAReader_fill_image_buffer(cdio_CDDAReader *self, lsn_t sector);
+
 static int
 CDDAReader_read_device(cdio_CDDAReader *self,
                        unsigned sectors_to_read,
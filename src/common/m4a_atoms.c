@@ -2609,6 +2609,7 @@ atom_parser(const char *atom_name)
                                               {"dinf", parse_tree},
                                               {"disk", parse_tree},
                                               {"dref", parse_dref},
+                                              {"edts", parse_tree},
                                               {"free", parse_free},
                                               {"ftyp", parse_ftyp},
                                               {"gnre", parse_tree},
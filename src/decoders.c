@@ -25,7 +25,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
+extern PyTypeObject decoders_FlacHeaderType;
 extern PyTypeObject decoders_FlacDecoderType;
+extern PyTypeObject decoders_OggFlacDecoderType;
 extern PyTypeObject decoders_ALACDecoderType;
 extern PyTypeObject decoders_WavPackDecoderType;
 #ifdef HAS_VORBIS
@@ -37,6 +39,12 @@ extern PyTypeObject decoders_MP3DecoderType;
 #ifdef HAS_OPUS
 extern PyTypeObject decoders_OpusDecoderType;
 #endif
+#ifdef HAS_FAAD
+extern PyTypeObject decoders_AACDecoderType;
+#endif
+#ifdef HAS_SPEEX
+extern PyTypeObject decoders_SpeexDecoderType;
+#endif
 extern PyTypeObject decoders_TTADecoderType;
 extern PyTypeObject decoders_MPCDecoderType;
 extern PyTypeObject decoders_Sine_Mono_Type;
@@ -50,10 +58,18 @@ MOD_INIT(decoders)
 
     MOD_DEF(m, "decoders", "low-level audio format decoders", module_methods)
 
+    decoders_FlacHeaderType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&decoders_FlacHeaderType) < 0)
+        return MOD_ERROR_VAL;
+
     decoders_FlacDecoderType.tp_new = PyType_GenericNew;
     if (PyType_Ready(&decoders_FlacDecoderType) < 0)
         return MOD_ERROR_VAL;
 
+    decoders_OggFlacDecoderType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&decoders_OggFlacDecoderType) < 0)
+        return MOD_ERROR_VAL;
+
     decoders_ALACDecoderType.tp_new = PyType_GenericNew;
     if (PyType_Ready(&decoders_ALACDecoderType) < 0)
         return MOD_ERROR_VAL;
@@ -82,6 +98,18 @@ MOD_INIT(decoders)
         return MOD_ERROR_VAL;
     #endif
 
+    #ifdef HAS_FAAD
+    decoders_AACDecoderType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&decoders_AACDecoderType) < 0)
+        return MOD_ERROR_VAL;
+    #endif
+
+    #ifdef HAS_SPEEX
+    decoders_SpeexDecoderType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&decoders_SpeexDecoderType) < 0)
+        return MOD_ERROR_VAL;
+    #endif
+
     decoders_TTADecoderType.tp_new = PyType_GenericNew;
     if (PyType_Ready(&decoders_TTADecoderType) < 0)
         return MOD_ERROR_VAL;
@@ -106,10 +134,18 @@ MOD_INIT(decoders)
     if (PyType_Ready(&decoders_SameSample_Type) < 0)
         return MOD_ERROR_VAL;
 
+    Py_INCREF(&decoders_FlacHeaderType);
+    PyModule_AddObject(m, "FlacHeader",
+                       (PyObject *)&decoders_FlacHeaderType);
+
     Py_INCREF(&decoders_FlacDecoderType);
     PyModule_AddObject(m, "FlacDecoder",
                        (PyObject *)&decoders_FlacDecoderType);
 
+    Py_INCREF(&decoders_OggFlacDecoderType);
+    PyModule_AddObject(m, "OggFlacDecoder",
+                       (PyObject *)&decoders_OggFlacDecoderType);
+
     Py_INCREF(&decoders_ALACDecoderType);
     PyModule_AddObject(m, "ALACDecoder",
                        (PyObject *)&decoders_ALACDecoderType);
@@ -138,6 +174,18 @@ MOD_INIT(decoders)
                        (PyObject *)&decoders_OpusDecoderType);
     #endif
 
+    #ifdef HAS_FAAD
+    Py_INCREF(&decoders_AACDecoderType);
+    PyModule_AddObject(m, "AACDecoder",
+                       (PyObject *)&decoders_AACDecoderType);
+    #endif
+
+    #ifdef HAS_SPEEX
+    Py_INCREF(&decoders_SpeexDecoderType);
+    PyModule_AddObject(m, "SpeexDecoder",
+                       (PyObject *)&decoders_SpeexDecoderType);
+    #endif
+
     Py_INCREF(&decoders_TTADecoderType);
     PyModule_AddObject(m, "TTADecoder",
                        (PyObject *)&decoders_TTADecoderType);
@@ -0,0 +1,736 @@
+#include "aac.h"
+#include "../framelist.h"
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the size of an "mp4a" sample description
+  before any of its sub-atoms*/
+#define MP4A_HEADER_SIZE 28
+
+/*MPEG-4 elementary stream descriptor tags found in the "esds" atom*/
+#define ES_DESCRIPTOR 0x03
+#define DECODER_CONFIG_DESCRIPTOR 0x04
+#define DECODER_SPECIFIC_INFO 0x05
+
+/*the size of a DecoderConfigDescriptor before its sub-descriptors*/
+#define DECODER_CONFIG_SIZE 13
+
+/*each AAC-LC access unit holds 1024 PCM frames*/
+#define AAC_FRAME_SIZE 1024
+
+/*reads one of the esds atom's variable-length descriptor sizes*/
+static unsigned
+read_descriptor_length(BitstreamReader *stream);
+
+static PyObject*
+AACDecoder_new(PyTypeObject *type,
+               PyObject *args, PyObject *kwds)
+{
+    decoders_AACDecoder *self;
+
+    self = (decoders_AACDecoder *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+AACDecoder_init(decoders_AACDecoder *self,
+                PyObject *args, PyObject *kwds)
+{
+    PyObject *file;
+    unsigned atom_size;
+    char atom_name[4];
+    uint8_t *config = NULL;
+    unsigned config_size = 0;
+    int got_frames = 0;
+    unsigned long sample_rate;
+    unsigned char channels;
+    NeAACDecConfigurationPtr decoder_config;
+    unsigned max_frame_size = 1;
+    unsigned i;
+
+    self->bitstream = NULL;
+    self->decoder = NULL;
+    self->frames = NULL;
+    self->total_frames = 0;
+    self->current_frame = 0;
+    /*no access unit starts at offset 0
+      so the first read always seeks to its frame*/
+    self->next_offset = 0;
+    self->skip_frames = 0;
+    self->remaining_frames = UINT64_MAX;
+    self->media_time_scale = 0;
+    self->buffer = NULL;
+    self->closed = 0;
+    self->audiotools_pcm = NULL;
+
+    if (!PyArg_ParseTuple(args, "O", &file)) {
+        return -1;
+    }
+
+    self->bitstream = br_open_python(file, BS_BIG_ENDIAN, 4096);
+
+    /*walk through atoms*/
+    while (read_atom_header(self->bitstream, &atom_size, atom_name)) {
+        if (!memcmp(atom_name, "moov", 4)) {
+            /*find decoder configuration and frame list from moov atom*/
+            const static char *mp4a_path[] =
+                {"trak", "mdia", "minf", "stbl", "stsd", "mp4a", NULL};
+            struct qt_atom *moov_atom;
+            struct qt_atom *mp4a_atom;
+
+            if (!setjmp(*br_try(self->bitstream))) {
+                moov_atom = qt_atom_parse_by_name(self->bitstream,
+                                                  atom_size,
+                                                  atom_name);
+
+                br_etry(self->bitstream);
+            } else {
+                br_etry(self->bitstream);
+                free(config);
+                PyErr_SetString(PyExc_IOError, "I/O error parsing moov atom");
+                return -1;
+            }
+
+            if (!config &&
+                ((mp4a_atom = moov_atom->find(moov_atom, mp4a_path)) != NULL) &&
+                (mp4a_atom->type == QT_LEAF)) {
+                get_decoder_config(mp4a_atom->_.leaf.data,
+                                   mp4a_atom->_.leaf.data_size,
+                                   &config,
+                                   &config_size);
+            }
+
+            if (!got_frames && get_frames(self, moov_atom)) {
+                got_frames = 1;
+                get_edit(self, moov_atom);
+            }
+
+            moov_atom->free(moov_atom);
+        } else {
+            /*skip remaining atoms, including mdat*/
+
+            if (atom_size >= 8) {
+                self->bitstream->seek(self->bitstream,
+                                      atom_size - 8,
+                                      BS_SEEK_CUR);
+            }
+        }
+    }
+
+    if (!config) {
+        PyErr_SetString(PyExc_ValueError, "no AAC decoder configuration");
+        return -1;
+    }
+
+    if (!got_frames) {
+        free(config);
+        PyErr_SetString(PyExc_ValueError, "no AAC frames found in stream");
+        return -1;
+    }
+
+    /*initialize decoder from AudioSpecificConfig*/
+    if ((self->decoder = NeAACDecOpen()) == NULL) {
+        free(config);
+        PyErr_SetString(PyExc_ValueError, "error initializing decoder");
+        return -1;
+    }
+
+    decoder_config = NeAACDecGetCurrentConfiguration(self->decoder);
+    decoder_config->outputFormat = FAAD_FMT_16BIT;
+    decoder_config->downMatrix = 0;
+    NeAACDecSetConfiguration(self->decoder, decoder_config);
+
+    if (NeAACDecInit2(self->decoder,
+                      config,
+                      config_size,
+                      &sample_rate,
+                      &channels) < 0) {
+        free(config);
+        PyErr_SetString(PyExc_ValueError, "invalid AAC decoder configuration");
+        return -1;
+    }
+    free(config);
+
+    self->sample_rate = (unsigned)sample_rate;
+    self->channels = channels;
+
+    /*the edit is in the media's time scale
+      which needn't be the decoded sample rate*/
+    if (self->media_time_scale &&
+        (self->media_time_scale != self->sample_rate)) {
+        self->skip_frames = (self->skip_frames * self->sample_rate) /
+                            self->media_time_scale;
+        if (self->remaining_frames != UINT64_MAX) {
+            self->remaining_frames =
+                (self->remaining_frames * self->sample_rate) /
+                self->media_time_scale;
+        }
+    }
+
+    /*allocate a buffer large enough for any single access unit*/
+    for (i = 0; i < self->total_frames; i++) {
+        if (self->frames[i].byte_size > max_frame_size) {
+            max_frame_size = self->frames[i].byte_size;
+        }
+    }
+    self->buffer = malloc(max_frame_size);
+
+    /*open FrameList generator*/
+    if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+AACDecoder_dealloc(decoders_AACDecoder *self)
+{
+    if (self->bitstream) {
+        self->bitstream->free(self->bitstream);
+    }
+    if (self->decoder) {
+        NeAACDecClose(self->decoder);
+    }
+    free(self->frames);
+    free(self->buffer);
+    Py_XDECREF(self->audiotools_pcm);
+
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+AACDecoder_sample_rate(decoders_AACDecoder *self, void *closure)
+{
+    return Py_BuildValue("I", self->sample_rate);
+}
+
+static PyObject*
+AACDecoder_bits_per_sample(decoders_AACDecoder *self, void *closure)
+{
+    return Py_BuildValue("i", 16);
+}
+
+static PyObject*
+AACDecoder_channels(decoders_AACDecoder *self, void *closure)
+{
+    return Py_BuildValue("I", self->channels);
+}
+
+static PyObject*
+AACDecoder_channel_mask(decoders_AACDecoder *self, void *closure)
+{
+    switch (self->channels) {
+    case 1:
+        return Py_BuildValue("I", 0x4);
+    case 2:
+        return Py_BuildValue("I", 0x3);
+    case 3:
+        return Py_BuildValue("I", 0x7);
+    case 4:
+        return Py_BuildValue("I", 0x33);
+    case 5:
+        return Py_BuildValue("I", 0x37);
+    case 6:
+        return Py_BuildValue("I", 0x3F);
+    default:
+        return Py_BuildValue("I", 0);
+    }
+}
+
+static PyObject*
+AACDecoder_read(decoders_AACDecoder* self, PyObject *args)
+{
+    if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "cannot read closed stream");
+        return NULL;
+    }
+
+    /*decode access units until one generates some output
+      since the decoder's first unit may be consumed silently
+      and units may fall entirely outside the edit*/
+    while ((self->current_frame < self->total_frames) &&
+           (self->remaining_frames > 0)) {
+        const struct aac_frame *frame = &self->frames[self->current_frame];
+        NeAACDecFrameInfo info;
+        int16_t *decoded;
+
+        /*access units are usually contiguous within mdat
+          so only seek when the next one isn't already at hand*/
+        if (!setjmp(*br_try(self->bitstream))) {
+            if (frame->offset != self->next_offset) {
+                self->bitstream->seek(self->bitstream,
+                                      (long)frame->offset,
+                                      BS_SEEK_SET);
+            }
+            self->bitstream->read_bytes(self->bitstream,
+                                        self->buffer,
+                                        frame->byte_size);
+            br_etry(self->bitstream);
+        } else {
+            br_etry(self->bitstream);
+            PyErr_SetString(PyExc_IOError, "I/O error reading stream");
+            return NULL;
+        }
+
+        self->next_offset = frame->offset + frame->byte_size;
+        self->current_frame += 1;
+
+        decoded = NeAACDecDecode(self->decoder,
+                                 &info,
+                                 self->buffer,
+                                 frame->byte_size);
+
+        if (info.error) {
+            PyErr_SetString(PyExc_ValueError,
+                            NeAACDecGetErrorMessage(info.error));
+            return NULL;
+        }
+
+        if (decoded && info.samples && info.channels) {
+            unsigned pcm_frames = (unsigned)(info.samples / info.channels);
+            unsigned skipped;
+            pcm_FrameList *framelist;
+
+            if (info.channels != self->channels) {
+                PyErr_SetString(PyExc_ValueError,
+                                "channel count changed mid-stream");
+                return NULL;
+            }
+
+            /*trim the encoder's delay from the start
+              and its padding from the end*/
+            skipped = (unsigned)MIN(self->skip_frames, pcm_frames);
+            self->skip_frames -= skipped;
+            pcm_frames = (unsigned)MIN(pcm_frames - skipped,
+                                       self->remaining_frames);
+            self->remaining_frames -= pcm_frames;
+            if (pcm_frames == 0) {
+                continue;
+            }
+
+            framelist = new_FrameList(self->audiotools_pcm,
+                                      self->channels,
+                                      16,
+                                      pcm_frames);
+
+            reorder_channels(self->channels,
+                             pcm_frames,
+                             info.channel_position,
+                             decoded + (skipped * self->channels),
+                             framelist->samples);
+
+            return (PyObject*)framelist;
+        } else if (!info.error) {
+            /*a unit the decoder withholds the output of
+              still counts against the delay to skip*/
+            self->skip_frames -= MIN(self->skip_frames, AAC_FRAME_SIZE);
+        }
+    }
+
+    return empty_FrameList(self->audiotools_pcm, self->channels, 16);
+}
+
+static PyObject*
+AACDecoder_close(decoders_AACDecoder* self, PyObject *args)
+{
+    /*mark stream as closed so more calls to read()
+      generate ValueErrors*/
+    self->closed = 1;
+
+    /*close internal stream*/
+    self->bitstream->close_internal_stream(self->bitstream);
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+AACDecoder_enter(decoders_AACDecoder* self, PyObject *args)
+{
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject*
+AACDecoder_exit(decoders_AACDecoder* self, PyObject *args)
+{
+    self->closed = 1;
+
+    self->bitstream->close_internal_stream(self->bitstream);
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/**************************************/
+/*  private function implementations  */
+/**************************************/
+
+static int
+read_atom_header(BitstreamReader *stream,
+                 unsigned *atom_size,
+                 char atom_name[4])
+{
+    if (!setjmp(*br_try(stream))) {
+        *atom_size = stream->read(stream, 32);
+        stream->read_bytes(stream, (uint8_t*)atom_name, 4);
+        br_etry(stream);
+        return 1;
+    } else {
+        br_etry(stream);
+        return 0;
+    }
+}
+
+static unsigned
+read_descriptor_length(BitstreamReader *stream)
+{
+    unsigned length = 0;
+    unsigned i;
+
+    /*up to 4 bytes of 7 bits each, the high bit flagging another byte*/
+    for (i = 0; i < 4; i++) {
+        const unsigned byte = stream->read(stream, 8);
+        length = (length << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    return length;
+}
+
+static int
+get_decoder_config(const uint8_t mp4a[],
+                   unsigned mp4a_size,
+                   uint8_t **config,
+                   unsigned *config_size)
+{
+    BitstreamReader *stream;
+
+    if (mp4a_size < MP4A_HEADER_SIZE) {
+        return 0;
+    }
+
+    stream = br_open_buffer(mp4a + MP4A_HEADER_SIZE,
+                            mp4a_size - MP4A_HEADER_SIZE,
+                            BS_BIG_ENDIAN);
+
+    if (!setjmp(*br_try(stream))) {
+        unsigned atom_size;
+        uint8_t atom_name[4];
+
+        /*find the esds atom among the description's sub-atoms*/
+        for (;;) {
+            atom_size = stream->read(stream, 32);
+            stream->read_bytes(stream, atom_name, 4);
+            if (!memcmp(atom_name, "esds", 4)) {
+                break;
+            } else if (atom_size < 8) {
+                br_etry(stream);
+                stream->close(stream);
+                return 0;
+            } else {
+                stream->skip_bytes(stream, atom_size - 8);
+            }
+        }
+
+        stream->skip(stream, 32);  /*version and flags*/
+
+        /*descriptors are nested, so walk through them in order
+          until the DecoderSpecificInfo is reached*/
+        for (;;) {
+            const unsigned tag = stream->read(stream, 8);
+            const unsigned length = read_descriptor_length(stream);
+
+            switch (tag) {
+            case ES_DESCRIPTOR:
+                {
+                    unsigned stream_dependence;
+                    unsigned url;
+                    unsigned ocr_stream;
+
+                    stream->skip(stream, 16);  /*ES_ID*/
+                    stream_dependence = stream->read(stream, 1);
+                    url = stream->read(stream, 1);
+                    ocr_stream = stream->read(stream, 1);
+                    stream->skip(stream, 5);   /*stream priority*/
+                    if (stream_dependence) {
+                        stream->skip(stream, 16);
+                    }
+                    if (url) {
+                        stream->skip_bytes(stream, stream->read(stream, 8));
+                    }
+                    if (ocr_stream) {
+                        stream->skip(stream, 16);
+                    }
+                }
+                break;
+            case DECODER_CONFIG_DESCRIPTOR:
+                stream->skip_bytes(stream, DECODER_CONFIG_SIZE);
+                break;
+            case DECODER_SPECIFIC_INFO:
+                *config = malloc(length ? length : 1);
+                *config_size = length;
+                stream->read_bytes(stream, *config, length);
+                br_etry(stream);
+                stream->close(stream);
+                return 1;
+            default:
+                stream->skip_bytes(stream, length);
+                break;
+            }
+        }
+    } else {
+        /*ran out of data before finding an AudioSpecificConfig*/
+        br_etry(stream);
+        stream->close(stream);
+        if (*config) {
+            free(*config);
+            *config = NULL;
+        }
+        return 0;
+    }
+}
+
+static int
+get_frames(decoders_AACDecoder *self, struct qt_atom *moov_atom)
+{
+    const static char *stsc_path[] =
+        {"trak", "mdia", "minf", "stbl", "stsc", NULL};
+    const static char *stsz_path[] =
+        {"trak", "mdia", "minf", "stbl", "stsz", NULL};
+    const static char *stco_path[] =
+        {"trak", "mdia", "minf", "stbl", "stco", NULL};
+    struct qt_atom *stsc_atom;
+    struct qt_atom *stsz_atom;
+    struct qt_atom *stco_atom;
+    unsigned total_frames;
+    unsigned frame = 0;
+    unsigned entry = 0;
+    unsigned chunk;
+
+    if (((stsz_atom = moov_atom->find(moov_atom, stsz_path)) == NULL) ||
+        (stsz_atom->type != QT_STSZ)) {
+        return 0;
+    }
+
+    if ((total_frames = stsz_atom->_.stsz.frames_count) == 0) {
+        /*an empty stream has no chunks to locate*/
+        self->frames = malloc(sizeof(struct aac_frame));
+        self->total_frames = 0;
+        return 1;
+    }
+
+    if (((stsc_atom = moov_atom->find(moov_atom, stsc_path)) == NULL) ||
+        (stsc_atom->type != QT_STSC) ||
+        (stsc_atom->_.stsc.entries_count == 0)) {
+        return 0;
+    }
+    if (((stco_atom = moov_atom->find(moov_atom, stco_path)) == NULL) ||
+        (stco_atom->type != QT_STCO)) {
+        return 0;
+    }
+
+    self->frames = malloc(total_frames * sizeof(struct aac_frame));
+
+    /*each chunk holds a run of consecutive frames
+      and the number of frames per chunk is taken from the latest
+      stsc entry whose first chunk (counting from 1) has been reached*/
+    for (chunk = 0;
+         (chunk < stco_atom->_.stco.offsets_count) && (frame < total_frames);
+         chunk++) {
+        unsigned offset = stco_atom->_.stco.chunk_offset[chunk];
+        unsigned i;
+
+        while (((entry + 1) < stsc_atom->_.stsc.entries_count) &&
+               (stsc_atom->_.stsc.entries[entry + 1].first_chunk <=
+                (chunk + 1))) {
+            entry++;
+        }
+
+        for (i = 0;
+             (i < stsc_atom->_.stsc.entries[entry].frames_per_chunk) &&
+             (frame < total_frames);
+             i++) {
+            const unsigned byte_size = stsz_atom->_.stsz.frame_byte_size ?
+                stsz_atom->_.stsz.frame_byte_size :
+                stsz_atom->_.stsz.frame_size[frame];
+
+            self->frames[frame].offset = offset;
+            self->frames[frame].byte_size = byte_size;
+            offset += byte_size;
+            frame++;
+        }
+    }
+
+    if (frame != total_frames) {
+        /*chunk table doesn't cover every frame*/
+        free(self->frames);
+        self->frames = NULL;
+        return 0;
+    }
+
+    self->total_frames = total_frames;
+    return 1;
+}
+
+static void
+get_edit(decoders_AACDecoder *self, struct qt_atom *moov_atom)
+{
+    const static char *mvhd_path[] = {"mvhd", NULL};
+    const static char *mdhd_path[] = {"trak", "mdia", "mdhd", NULL};
+    const static char *elst_path[] = {"trak", "edts", "elst", NULL};
+    struct qt_atom *mvhd_atom;
+    struct qt_atom *mdhd_atom;
+    struct qt_atom *elst_atom;
+    BitstreamReader *stream;
+
+    if (((mvhd_atom = moov_atom->find(moov_atom, mvhd_path)) == NULL) ||
+        (mvhd_atom->type != QT_MVHD) ||
+        (mvhd_atom->_.mvhd.time_scale == 0)) {
+        return;
+    }
+    if (((mdhd_atom = moov_atom->find(moov_atom, mdhd_path)) == NULL) ||
+        (mdhd_atom->type != QT_MDHD) ||
+        (mdhd_atom->_.mdhd.time_scale == 0)) {
+        return;
+    }
+    if (((elst_atom = moov_atom->find(moov_atom, elst_path)) == NULL) ||
+        (elst_atom->type != QT_LEAF)) {
+        return;
+    }
+
+    stream = br_open_buffer(elst_atom->_.leaf.data,
+                            elst_atom->_.leaf.data_size,
+                            BS_BIG_ENDIAN);
+
+    if (!setjmp(*br_try(stream))) {
+        const unsigned version = stream->read(stream, 8);
+        unsigned edits;
+
+        stream->skip(stream, 24);  /*flags*/
+
+        /*use the first edit which isn't an empty one
+          and ignore any after it*/
+        for (edits = stream->read(stream, 32); edits; edits--) {
+            uint64_t duration;
+            int64_t media_time;
+
+            if (version == 1) {
+                duration = stream->read_64(stream, 64);
+                media_time = stream->read_signed_64(stream, 64);
+            } else {
+                duration = stream->read(stream, 32);
+                media_time = stream->read_signed(stream, 32);
+            }
+            stream->skip(stream, 32);  /*media rate*/
+
+            if (media_time >= 0) {
+                /*the edit's duration is in the movie's time scale
+                  while its start is in the media's*/
+                self->media_time_scale = mdhd_atom->_.mdhd.time_scale;
+                self->skip_frames = (uint64_t)media_time;
+                self->remaining_frames =
+                    (duration * self->media_time_scale) /
+                    mvhd_atom->_.mvhd.time_scale;
+                break;
+            }
+        }
+
+        br_etry(stream);
+    } else {
+        /*ignore a truncated edit list*/
+        br_etry(stream);
+    }
+
+    stream->close(stream);
+}
+
+static unsigned
+position_rank(unsigned char position)
+{
+    switch (position) {
+    case FRONT_CHANNEL_LEFT:
+        return 0;
+    case FRONT_CHANNEL_RIGHT:
+        return 1;
+    case FRONT_CHANNEL_CENTER:
+        return 2;
+    case LFE_CHANNEL:
+        return 3;
+    case BACK_CHANNEL_LEFT:
+        return 4;
+    case BACK_CHANNEL_RIGHT:
+        return 5;
+    case BACK_CHANNEL_CENTER:
+        return 8;
+    case SIDE_CHANNEL_LEFT:
+        return 9;
+    case SIDE_CHANNEL_RIGHT:
+        return 10;
+    default:
+        /*unknown channels go last, in their original order*/
+        return 32;
+    }
+}
+
+static void
+reorder_channels(unsigned channels,
+                 unsigned pcm_frames,
+                 const unsigned char positions[],
+                 const int16_t decoded[],
+                 int samples[])
+{
+    unsigned order[64];
+    unsigned i;
+    unsigned c;
+
+    if (channels <= 2) {
+        /*mono and stereo are already in the correct order*/
+        const unsigned total = pcm_frames * channels;
+        for (i = 0; i < total; i++) {
+            samples[i] = decoded[i];
+        }
+        return;
+    }
+
+    /*sort decoded channels by their RIFF WAVE position
+      with a stable insertion sort*/
+    for (c = 0; c < channels; c++) {
+        unsigned j = c;
+        while ((j > 0) &&
+               (position_rank(positions[order[j - 1]]) >
+                position_rank(positions[c]))) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = c;
+    }
+
+    for (i = 0; i < pcm_frames; i++) {
+        for (c = 0; c < channels; c++) {
+            samples[i * channels + c] = decoded[i * channels + order[c]];
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <neaacdec.h>
+#include "../bitstream.h"
+#include "../common/m4a_atoms.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the location of a single AAC access unit in the M4A file*/
+struct aac_frame {
+    unsigned offset;
+    unsigned byte_size;
+};
+
+typedef struct {
+    PyObject_HEAD
+
+    BitstreamReader *bitstream;
+    NeAACDecHandle decoder;
+
+    unsigned sample_rate;
+    unsigned channels;
+
+    /*every access unit in stream order,
+      as determined by the stsz, stsc and stco atoms*/
+    struct aac_frame *frames;
+    unsigned total_frames;
+    unsigned current_frame;
+    unsigned next_offset;  /*the stream position after the last frame read*/
+
+    /*PCM frames still to be discarded from the start of the media
+      and still to be returned after that, as given by the edit list
+      in the media's time scale, or all of them if there isn't one*/
+    uint64_t skip_frames;
+    uint64_t remaining_frames;
+    unsigned media_time_scale;
+
+    /*a buffer large enough to hold the largest access unit*/
+    uint8_t *buffer;
+
+    int closed;
+
+    PyObject *audiotools_pcm;
+} decoders_AACDecoder;
+
+static PyObject*
+AACDecoder_new(PyTypeObject *type,
+               PyObject *args, PyObject *kwds);
+
+int
+AACDecoder_init(decoders_AACDecoder *self,
+                PyObject *args, PyObject *kwds);
+
+void
+AACDecoder_dealloc(decoders_AACDecoder *self);
+
+static PyObject*
+AACDecoder_sample_rate(decoders_AACDecoder *self, void *closure);
+
+static PyObject*
+AACDecoder_bits_per_sample(decoders_AACDecoder *self, void *closure);
+
+static PyObject*
+AACDecoder_channels(decoders_AACDecoder *self, void *closure);
+
+static PyObject*
+AACDecoder_channel_mask(decoders_AACDecoder *self, void *closure);
+
+static PyObject*
+AACDecoder_read(decoders_AACDecoder* self, PyObject *args);
+
+static PyObject*
+AACDecoder_close(decoders_AACDecoder* self, PyObject *args);
+
+static PyObject*
+AACDecoder_enter(decoders_AACDecoder* self, PyObject *args);
+
+static PyObject*
+AACDecoder_exit(decoders_AACDecoder* self, PyObject *args);
+
+/*reads an atom header to the given size and name
+  returns 1 on success, 0 if a read error occurs*/
+static int
+read_atom_header(BitstreamReader *stream,
+                 unsigned *atom_size,
+                 char atom_name[4]);
+
+/*given an "mp4a" sample description's contents,
+  finds its "esds" atom's AudioSpecificConfig
+  and returns a newly allocated copy of it in "config"
+  returns 1 on success, 0 on failure*/
+static int
+get_decoder_config(const uint8_t mp4a[],
+                   unsigned mp4a_size,
+                   uint8_t **config,
+                   unsigned *config_size);
+
+/*given a "moov" atom, populates the decoder's list of access units
+  returns 1 on success, 0 on failure*/
+static int
+get_frames(decoders_AACDecoder *self, struct qt_atom *moov_atom);
+
+/*given a "moov" atom, sets the frames to skip and return
+  from its track's edit list, if any*/
+static void
+get_edit(decoders_AACDecoder *self, struct qt_atom *moov_atom);
+
+/*given decoded samples and the channel positions reported by the decoder,
+  stores them in "samples" in RIFF WAVE channel order*/
+static void
+reorder_channels(unsigned channels,
+                 unsigned pcm_frames,
+                 const unsigned char positions[],
+                 const int16_t decoded[],
+                 int samples[]);
+
+/*returns the bit of a RIFF WAVE channel mask
+  for the given faad2 channel position*/
+static unsigned
+position_rank(unsigned char position);
+
+PyGetSetDef AACDecoder_getseters[] = {
+    {"sample_rate",
+     (getter)AACDecoder_sample_rate, NULL, "sample rate", NULL},
+    {"bits_per_sample",
+     (getter)AACDecoder_bits_per_sample, NULL, "bits-per-sample", NULL},
+    {"channels",
+     (getter)AACDecoder_channels, NULL, "channels", NULL},
+    {"channel_mask",
+     (getter)AACDecoder_channel_mask, NULL, "channel mask", NULL},
+    {NULL}
+};
+
+PyMethodDef AACDecoder_methods[] = {
+    {"read", (PyCFunction)AACDecoder_read,
+     METH_VARARGS, "read(pcm_frame_count) -> FrameList"},
+    {"close", (PyCFunction)AACDecoder_close,
+     METH_NOARGS, "close() -> None"},
+    {"__enter__", (PyCFunction)AACDecoder_enter,
+     METH_NOARGS, "enter() -> self"},
+    {"__exit__", (PyCFunction)AACDecoder_exit,
+     METH_VARARGS, "exit(exc_type, exc_value, traceback) -> None"},
+    {NULL}
+};
+
+PyTypeObject decoders_AACDecoderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "decoders.AACDecoder",     /* tp_name */
+    sizeof(decoders_AACDecoder), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)AACDecoder_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    "AACDecoder objects",      /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    AACDecoder_methods,        /* tp_methods */
+    0,                         /* tp_members */
+    AACDecoder_getseters,      /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)AACDecoder_init, /* tp_init */
+    0,                         /* tp_alloc */
+    AACDecoder_new,            /* tp_new */
+};
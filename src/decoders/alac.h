@@ -4,6 +4,8 @@
 #endif
 #include <stdint.h>
 #include "../bitstream.h"
+#include "alac_frame.h"
+#include "../framelist.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -24,13 +26,6 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
-struct alac_parameters {
-    unsigned block_size;
-    unsigned history_multiplier;
-    unsigned initial_history;
-    unsigned maximum_K;
-};
-
 struct alac_seekpoint {
     unsigned pcm_frames;
     unsigned byte_size;
@@ -61,6 +56,9 @@ typedef struct {
 #ifndef STANDALONE
     /*a framelist generator*/
     PyObject *audiotools_pcm;
+
+    /*the remainder of a frameset too large for the last read*/
+    struct frame_buffer buffer;
 #endif
 } decoders_ALACDecoder;
 
@@ -88,6 +86,9 @@ ALACDecoder_channels(decoders_ALACDecoder *self, void *closure);
 static PyObject*
 ALACDecoder_channel_mask(decoders_ALACDecoder *self, void *closure);
 
+/*reads as many whole framesets as fit in the requested
+  number of PCM frames into a single FrameList
+  keeping any remainder of the last one for the next read*/
 static PyObject*
 ALACDecoder_read(decoders_ALACDecoder* self, PyObject *args);
 
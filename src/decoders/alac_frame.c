@@ -0,0 +1,668 @@
+#include "alac_frame.h"
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the maximum coefficients that can fit in an unsigned 5-bit field*/
+#define MAX_COEFFICIENTS 31
+
+struct subframe_header {
+    unsigned prediction_type;
+    unsigned shift_needed;
+    unsigned rice_modifier;
+    unsigned coeff_count;
+    int coeff[MAX_COEFFICIENTS];
+};
+
+/**********************************/
+/*  private function definitions  */
+/**********************************/
+
+static alac_status
+decode_frame(BitstreamReader *br,
+             const struct alac_parameters *params,
+             unsigned bits_per_sample,
+             unsigned *block_size,
+             unsigned channels,
+             int channel_0[],
+             int channel_1[]);
+
+static alac_status
+decode_uncompressed_frame(BitstreamReader *br,
+                          unsigned bits_per_sample,
+                          unsigned block_size,
+                          unsigned channels,
+                          int channel_0[],
+                          int channel_1[]);
+
+static alac_status
+decode_compressed_frame(BitstreamReader *br,
+                        const struct alac_parameters *params,
+                        unsigned uncompressed_LSBs,
+                        unsigned bits_per_sample,
+                        unsigned block_size,
+                        unsigned channels,
+                        int channel_0[],
+                        int channel_1[]);
+
+static alac_status
+read_subframe_header(BitstreamReader *br,
+                     struct subframe_header *subframe_header);
+
+static void
+read_residual_block(BitstreamReader *br,
+                    const struct alac_parameters *params,
+                    unsigned sample_size,
+                    unsigned block_size,
+                    int residual[]);
+
+static unsigned
+read_residual(BitstreamReader *br,
+              unsigned int k,
+              unsigned int sample_size);
+
+static void
+decode_subframe(unsigned block_size,
+                unsigned sample_size,
+                struct subframe_header *subframe_header,
+                const int residuals[],
+                int subframe[]);
+
+static void
+decorrelate_channels(unsigned block_size,
+                     unsigned interlacing_shift,
+                     unsigned interlacing_leftweight,
+                     const int subframe_0[],
+                     const int subframe_1[],
+                     int left[],
+                     int right[]);
+
+/*returns the .wav order position of the given channel
+  in a frameset with the given number of channels*/
+static unsigned
+wav_channel(unsigned channel_count, unsigned alac_channel);
+
+/*************************************/
+/*  public function implementations  */
+/*************************************/
+
+alac_status
+alacdec_decode_frameset(BitstreamReader *br,
+                        const struct alac_parameters *params,
+                        unsigned bits_per_sample,
+                        unsigned channel_count,
+                        unsigned *pcm_frames_read,
+                        int samples[])
+{
+    int channel_0[params->block_size];
+    int channel_1[params->block_size];
+    unsigned c = 0;
+    unsigned block_size = params->block_size;
+    unsigned channels = br->read(br, 3) + 1;
+
+    while (channels != 8) {
+        alac_status status;
+        unsigned frame_block_size;
+
+        if ((channels != 1) && (channels != 2)) {
+            /*only handle 1 or 2 channel frames*/
+            return INVALID_FRAME_CHANNEL_COUNT;
+        } else if ((c + channels) > channel_count) {
+            /*ensure one doesn't decode too many channels*/
+            return EXCESSIVE_FRAME_CHANNEL_COUNT;
+        }
+
+        if ((status = decode_frame(br,
+                                   params,
+                                   bits_per_sample,
+                                   c == 0 ? &block_size : &frame_block_size,
+                                   channels,
+                                   channel_0,
+                                   channel_1)) != OK) {
+            return status;
+        } else if ((c != 0) && (block_size != frame_block_size)) {
+            return FRAME_BLOCK_SIZE_MISMATCH;
+        }
+
+        /*place channels directly at their .wav order positions*/
+        memcpy(samples + (wav_channel(channel_count, c++) * block_size),
+               channel_0,
+               block_size * sizeof(int));
+
+        if (channels == 2) {
+            memcpy(samples + (wav_channel(channel_count, c++) * block_size),
+                   channel_1,
+                   block_size * sizeof(int));
+        }
+
+        channels = br->read(br, 3) + 1;
+    }
+    br->byte_align(br);
+    *pcm_frames_read = block_size;
+    return OK;
+}
+
+#ifndef STANDALONE
+PyObject*
+alac_exception(alac_status status)
+{
+    switch (status) {
+    default: /*shouldn't happen*/
+        return PyExc_ValueError;
+    case INVALID_FRAME_CHANNEL_COUNT:
+    case EXCESSIVE_FRAME_CHANNEL_COUNT:
+    case FRAME_BLOCK_SIZE_MISMATCH:
+    case INVALID_BLOCK_SIZE:
+    case INVALID_PREDICTION_TYPE:
+    case NOT_IMPLEMENTED_ERROR:
+        return PyExc_ValueError;
+    }
+}
+#endif
+
+const char*
+alac_strerror(alac_status status)
+{
+    switch (status) {
+    default:
+        return "unknown error";
+    case INVALID_FRAME_CHANNEL_COUNT:
+        return "frame channel count not 1 or 2";
+    case EXCESSIVE_FRAME_CHANNEL_COUNT:
+        return "frameset channels too large";
+    case FRAME_BLOCK_SIZE_MISMATCH:
+        return "all frames not the same block size";
+    case INVALID_BLOCK_SIZE:
+        return "frame block size greater than maximum block size";
+    case INVALID_PREDICTION_TYPE:
+        return "invalid prediction type";
+    case NOT_IMPLEMENTED_ERROR:
+        return "not yet implemented";
+    }
+}
+
+/**************************************/
+/*  private function implementations  */
+/**************************************/
+
+static alac_status
+decode_frame(BitstreamReader *br,
+             const struct alac_parameters *params,
+             unsigned bits_per_sample,
+             unsigned *block_size,
+             unsigned channels,
+             int channel_0[],
+             int channel_1[])
+{
+    unsigned has_sample_count;
+    unsigned uncompressed_LSBs;
+    unsigned not_uncompressed;
+
+    /*20 or 52-bit frame header*/
+    br->skip(br, 16);
+    has_sample_count = br->read(br, 1);
+    uncompressed_LSBs = br->read(br, 2);
+    not_uncompressed = br->read(br, 1);
+    if (has_sample_count == 0) {
+        *block_size = params->block_size;
+    } else {
+        *block_size = br->read(br, 32);
+        if (*block_size > params->block_size) {
+            return INVALID_BLOCK_SIZE;
+        }
+    }
+
+    /*either compressed or uncompressed frame based on header*/
+    if (not_uncompressed == 0) {
+        return decode_compressed_frame(br,
+                                       params,
+                                       uncompressed_LSBs,
+                                       bits_per_sample,
+                                       *block_size,
+                                       channels,
+                                       channel_0,
+                                       channel_1);
+    } else {
+        return decode_uncompressed_frame(br,
+                                         bits_per_sample,
+                                         *block_size,
+                                         channels,
+                                         channel_0,
+                                         channel_1);
+    }
+}
+
+static alac_status
+decode_uncompressed_frame(BitstreamReader *br,
+                          unsigned bits_per_sample,
+                          unsigned block_size,
+                          unsigned channels,
+                          int channel_0[],
+                          int channel_1[])
+{
+    unsigned i;
+
+    if (channels == 2) {
+        for (i = 0; i < block_size; i++) {
+            channel_0[i] = br->read_signed(br, bits_per_sample);
+            channel_1[i] = br->read_signed(br, bits_per_sample);
+        }
+    } else {
+        for (i = 0; i < block_size; i++) {
+            channel_0[i] = br->read_signed(br, bits_per_sample);
+        }
+    }
+
+    return OK;
+}
+
+static alac_status
+decode_compressed_frame(BitstreamReader *br,
+                        const struct alac_parameters *params,
+                        unsigned uncompressed_LSBs,
+                        unsigned bits_per_sample,
+                        unsigned block_size,
+                        unsigned channels,
+                        int channel_0[],
+                        int channel_1[])
+{
+
+    const unsigned uncompressed_bits = uncompressed_LSBs * 8;
+    const unsigned sample_size =
+        bits_per_sample - uncompressed_bits + (channels - 1);
+    const unsigned interlacing_shift = br->read(br, 8);
+    const unsigned interlacing_leftweight = br->read(br, 8);
+    struct subframe_header subframe_header[channels];
+    int subframe[channels][block_size];
+    unsigned i;
+    unsigned c;
+    alac_status status;
+
+    for (c = 0; c < channels; c++) {
+        if ((status = read_subframe_header(br, &subframe_header[c])) != OK) {
+            return status;
+        }
+    }
+
+    if (!uncompressed_bits) {
+        /*the common case where there's no uncompressed
+          least-significant bits to handle, such as 16bps audio*/
+
+        for (c = 0; c < channels; c++) {
+            int residual[block_size];
+
+            read_residual_block(br, params, sample_size, block_size, residual);
+
+            decode_subframe(block_size,
+                            sample_size,
+                            &subframe_header[c],
+                            residual,
+                            subframe[c]);
+        }
+
+        /*perform channel decorrelation, if necessary*/
+        if (channels == 2) {
+            if (interlacing_leftweight > 0) {
+                decorrelate_channels(block_size,
+                                     interlacing_shift,
+                                     interlacing_leftweight,
+                                     subframe[0],
+                                     subframe[1],
+                                     channel_0,
+                                     channel_1);
+            } else {
+                memcpy(channel_0, subframe[0], block_size * sizeof(int));
+                memcpy(channel_1, subframe[1], block_size * sizeof(int));
+            }
+        } else {
+            memcpy(channel_0, subframe[0], block_size * sizeof(int));
+        }
+    } else {
+        /*the case where there are least significant bits to handle
+          such as for 24bps audio*/
+
+        int LSBs[channels][block_size];
+
+        for (i = 0; i < block_size; i++) {
+            for (c = 0; c < channels; c++) {
+                LSBs[c][i] = br->read(br, uncompressed_bits);
+            }
+        }
+
+        for (c = 0; c < channels; c++) {
+            int residual[block_size];
+
+            read_residual_block(br, params, sample_size, block_size, residual);
+
+            decode_subframe(block_size,
+                            sample_size,
+                            &subframe_header[c],
+                            residual,
+                            subframe[c]);
+        }
+
+        /*perform channel decorrelation, if necessary*/
+        if (channels == 2) {
+            if (interlacing_leftweight > 0) {
+                decorrelate_channels(block_size,
+                                     interlacing_shift,
+                                     interlacing_leftweight,
+                                     subframe[0],
+                                     subframe[1],
+                                     channel_0,
+                                     channel_1);
+            } else {
+                memcpy(channel_0, subframe[0], block_size * sizeof(int));
+                memcpy(channel_1, subframe[1], block_size * sizeof(int));
+            }
+
+            /*apply uncompressed LSBs to channel data*/
+            for (i = 0; i < block_size; i++) {
+                channel_0[i] <<= uncompressed_bits;
+                channel_0[i] |= LSBs[0][i];
+                channel_1[i] <<= uncompressed_bits;
+                channel_1[i] |= LSBs[1][i];
+            }
+        } else {
+            memcpy(channel_0, subframe[0], block_size * sizeof(int));
+
+            /*apply uncompressed LSBs to channel data*/
+            for (i = 0; i < block_size; i++) {
+                channel_0[i] <<= uncompressed_bits;
+                channel_0[i] |= LSBs[0][i];
+            }
+        }
+    }
+
+    return OK;
+}
+
+static alac_status
+read_subframe_header(BitstreamReader *br,
+                     struct subframe_header *subframe_header)
+{
+    unsigned i;
+
+    subframe_header->prediction_type = br->read(br, 4);
+    if (subframe_header->prediction_type != 0) {
+        return INVALID_PREDICTION_TYPE;
+    }
+    subframe_header->shift_needed = br->read(br, 4);
+    subframe_header->rice_modifier = br->read(br, 3);
+    subframe_header->coeff_count = br->read(br, 5);
+    for (i = 0; i < subframe_header->coeff_count; i++) {
+        subframe_header->coeff[i] = br->read_signed(br, 16);
+    }
+    return OK;
+}
+
+/*this is the slow version*/
+/*
+  static inline int LOG2(int value) {
+  double newvalue = trunc(log((double)value) / log((double)2));
+
+  return (int)(newvalue);
+  }
+*/
+
+/*the fast version used by ffmpeg and the "alac" decoder
+  subtracts MSB zero bits from total bit size - 1,
+  essentially counting the number of LSB non-zero bits, -1*/
+
+/*my version just counts the number of non-zero bits and subtracts 1
+  which is good enough for now*/
+static inline int
+LOG2(int value)
+{
+    int bits = -1;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+static void
+read_residual_block(BitstreamReader *br,
+                    const struct alac_parameters *params,
+                    unsigned sample_size,
+                    unsigned block_size,
+                    int residual[])
+{
+    const unsigned maximum_k = params->maximum_K;
+    const unsigned history_multiplier = params->history_multiplier;
+    int history = params->initial_history;
+    unsigned sign_modifier = 0;
+    unsigned i = 0;
+
+    while (i < block_size) {
+        /*get an unsigned residual based on "history"
+          and on "sample_size" as a last resort*/
+        const unsigned k = LOG2((history >> 9) + 3);
+        const unsigned unsigned_residual =
+            read_residual(br,
+                          MIN(k, maximum_k),
+                          sample_size) + sign_modifier;
+
+        /*clear out old sign modifier, if any */
+        sign_modifier = 0;
+
+        /*change unsigned residual into a signed residual
+          and append it to "residuals"*/
+        if (unsigned_residual & 1) {
+            residual[i++] = -((unsigned_residual + 1) >> 1);
+        } else {
+            residual[i++] = unsigned_residual >> 1;
+        }
+
+        /*then use our old unsigned residual to update "history"*/
+        if (unsigned_residual > 0xFFFF)
+            history = 0xFFFF;
+        else
+            history += ((unsigned_residual * history_multiplier) -
+                        ((history * history_multiplier) >> 9));
+
+        /*if history gets too small, we may have a block of 0 samples
+          which can be compressed more efficiently*/
+        if ((history < 128) && (i < block_size)) {
+            unsigned zero_block_size = read_residual(
+                br,
+                MIN(7 - LOG2(history) + ((history + 16) / 64), (int)maximum_k),
+                16);
+
+            if (zero_block_size > 0) {
+                /*block of 0s found, so write them out*/
+
+                /*ensure block of zeroes doesn't exceed
+                  remaining residual count*/
+
+                unsigned j;
+
+                for (j = 0; (j < zero_block_size) && (i < block_size); j++) {
+                    residual[i++] = 0;
+                }
+            }
+
+            history = 0;
+
+            if (zero_block_size <= 0xFFFF) {
+                sign_modifier = 1;
+            }
+        }
+    }
+}
+
+static unsigned
+read_residual(BitstreamReader *br,
+              unsigned int k,
+              unsigned int sample_size)
+{
+    static br_huffman_table_t MSB[] =
+#include "alac_residual.h"
+    ;
+    const int msb = br->read_huffman_code(br, MSB);
+
+    /*read a unary 0 value to a maximum of 9 bits*/
+    if (msb == -1) {
+        /*we've exceeded the maximum number of 1 bits,
+          so return an unencoded value*/
+        return br->read(br, sample_size);
+    } else if ((k == 0) || (k == 1)) {
+        /*no least-significant bits to read, so return most-significant bits*/
+        return (unsigned)msb;
+    } else {
+        /*read a set of least-significant bits*/
+        unsigned lsb = br->read(br, k - 1);
+        if (lsb == 0) {
+            return (unsigned)msb * ((1 << k) - 1);
+        } else {
+            lsb <<= 1;
+            lsb |= br->read(br, 1);
+            return (msb * ((1 << k) - 1)) + (lsb - 1);
+        }
+    }
+}
+
+static inline int
+SIGN_ONLY(int value)
+{
+    if (value > 0)
+        return 1;
+    else if (value < 0)
+        return -1;
+    else
+        return 0;
+}
+
+static inline int
+TRUNCATE_BITS(int value, unsigned bits)
+{
+    /*truncate value to bits*/
+    const int truncated = value & ((1 << bits) - 1);
+
+    /*apply sign bit*/
+    if (truncated & (1 << (bits - 1))) {
+        return truncated - (1 << bits);
+    } else {
+        return truncated;
+    }
+}
+
+static void
+decode_subframe(unsigned block_size,
+                unsigned sample_size,
+                struct subframe_header *subframe_header,
+                const int residuals[],
+                int subframe[])
+{
+    const unsigned qlp_shift_needed = subframe_header->shift_needed;
+    const unsigned coeff_count = subframe_header->coeff_count;
+    int *coeff = subframe_header->coeff;
+    unsigned i;
+
+    subframe[0] = residuals[0];
+
+    for (i = 1; i < coeff_count + 1; i++) {
+        subframe[i] = TRUNCATE_BITS(residuals[i] + subframe[i - 1],
+                                    sample_size);
+    }
+
+    for (i = coeff_count + 1; i < block_size; i++) {
+        int residual = residuals[i];
+        const int base_sample = subframe[i - coeff_count - 1];
+        register int64_t qlp_sum = 0;
+        unsigned j;
+
+        for (j = 0; j < coeff_count; j++) {
+            qlp_sum += coeff[j] * (subframe[i - j - 1] - base_sample);
+        }
+
+        qlp_sum += (1 << (qlp_shift_needed - 1));
+        qlp_sum >>= qlp_shift_needed;
+
+        subframe[i] = TRUNCATE_BITS((int)(qlp_sum) + residual + base_sample,
+                                    sample_size);
+
+        if (residual > 0) {
+            for (j = 0; j < coeff_count; j++) {
+                int diff = base_sample - subframe[i - coeff_count + j];
+                int sign = SIGN_ONLY(diff);
+                coeff[coeff_count - j - 1] -= sign;
+                residual -= ((diff * sign) >> qlp_shift_needed) * (j + 1);
+                if (residual <= 0) {
+                    break;
+                }
+            }
+        } else if (residual < 0) {
+            for (j = 0; j < coeff_count; j++) {
+                int diff = base_sample - subframe[i - coeff_count + j];
+                int sign = SIGN_ONLY(diff);
+                coeff[coeff_count - j - 1] += sign;
+                residual -= ((diff * -sign) >> qlp_shift_needed) * (j + 1);
+                if (residual >= 0) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void
+decorrelate_channels(unsigned block_size,
+                     unsigned interlacing_shift,
+                     unsigned interlacing_leftweight,
+                     const int subframe_0[],
+                     const int subframe_1[],
+                     int left[],
+                     int right[])
+{
+    unsigned i;
+    for (i = 0; i < block_size; i++) {
+        register int64_t leftweight = subframe_1[i];
+        leftweight *= interlacing_leftweight;
+        leftweight >>= interlacing_shift;
+        right[i] = subframe_0[i] - (int)leftweight;
+        left[i] = subframe_1[i] + right[i];
+    }
+}
+
+static unsigned
+wav_channel(unsigned channel_count, unsigned alac_channel)
+{
+    static const unsigned wav_order[9][8] = {
+        {0},
+        {0},
+        {0, 1},
+        /*fC fL fR -> fL fR fC*/
+        {2, 0, 1},
+        /*fC fL fR bC -> fL fR fC bC*/
+        {2, 0, 1, 3},
+        /*fC fL fR bL bR -> fL fR fC bL bR*/
+        {2, 0, 1, 3, 4},
+        /*fC fL fR bL bR LFE -> fL fR fC LFE bL bR*/
+        {2, 0, 1, 4, 5, 3},
+        /*fC fL fR bL bR bC LFE -> fL fR fC LFE bL bR bC*/
+        {2, 0, 1, 4, 5, 6, 3},
+        /*fC sL sR fL fR bL bR LFE -> fL fR fC LFE bL bR sL sR*/
+        {2, 6, 7, 0, 1, 4, 5, 3}
+    };
+
+    return wav_order[channel_count][alac_channel];
+}
@@ -0,0 +1,75 @@
+#ifndef ALAC_FRAME_H
+#define ALAC_FRAME_H
+
+#ifndef STANDALONE
+#include <Python.h>
+#endif
+#include <stdint.h>
+#include "../bitstream.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the ALAC frameset decoding engine shared by
+  the ALAC decoder and the ALAC encoder's verification
+
+  every function reads from a generic BitstreamReader
+  which may be a file stream or a single frameset's bytes
+  and none of them hold state between framesets*/
+
+struct alac_parameters {
+    unsigned block_size;
+    unsigned history_multiplier;
+    unsigned initial_history;
+    unsigned maximum_K;
+};
+
+typedef enum {OK,
+              INVALID_FRAME_CHANNEL_COUNT,
+              EXCESSIVE_FRAME_CHANNEL_COUNT,
+              FRAME_BLOCK_SIZE_MISMATCH,
+              INVALID_BLOCK_SIZE,
+              INVALID_PREDICTION_TYPE,
+              NOT_IMPLEMENTED_ERROR} alac_status;
+
+/*decodes a frameset into "samples" as planar PCM data
+  already in .wav channel order,
+  every sample of channel 0 followed by every sample of channel 1
+  and so on, each channel "pcm_frames_read" samples long
+
+  "samples" must hold at least block_size * channel_count ints
+
+  may call br_abort() if an I/O error occurs reading the frameset*/
+alac_status
+alacdec_decode_frameset(BitstreamReader *br,
+                        const struct alac_parameters *params,
+                        unsigned bits_per_sample,
+                        unsigned channel_count,
+                        unsigned *pcm_frames_read,
+                        int samples[]);
+
+#ifndef STANDALONE
+PyObject*
+alac_exception(alac_status status);
+#endif
+
+const char*
+alac_strerror(alac_status status);
+
+#endif
@@ -0,0 +1,390 @@
+#include "decode_ahead.h"
+#include <stdlib.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+static void*
+decode_ahead_thread(DecodeAhead *ahead);
+
+DecodeAhead*
+decode_ahead_open(void *decoder,
+                  da_decode_f decode,
+                  unsigned channel_count,
+                  unsigned max_pcm_frames,
+                  unsigned block_count)
+{
+    DecodeAhead *ahead = malloc(sizeof(DecodeAhead));
+    unsigned i;
+
+    ahead->decoder = decoder;
+    ahead->decode = decode;
+    ahead->max_pcm_frames = max_pcm_frames;
+    ahead->block_count = block_count;
+    ahead->blocks = malloc(sizeof(struct da_block) * block_count);
+    for (i = 0; i < block_count; i++) {
+        ahead->blocks[i].status = DA_OK;
+        ahead->blocks[i].pcm_frames = 0;
+        ahead->blocks[i].samples =
+            malloc(sizeof(int) * channel_count * max_pcm_frames);
+        ahead->blocks[i].error = NULL;
+        ahead->blocks[i].io_error = 0;
+    }
+    ahead->head = 0;
+    ahead->tail = 0;
+    ahead->filled = 0;
+    ahead->stop = 0;
+
+    pthread_mutex_init(&(ahead->lock), NULL);
+    pthread_cond_init(&(ahead->block_ready), NULL);
+    pthread_cond_init(&(ahead->block_free), NULL);
+
+    if (pthread_create(&(ahead->thread),
+                       NULL,
+                       (void*(*)(void*))decode_ahead_thread,
+                       ahead)) {
+        pthread_cond_destroy(&(ahead->block_free));
+        pthread_cond_destroy(&(ahead->block_ready));
+        pthread_mutex_destroy(&(ahead->lock));
+        for (i = 0; i < block_count; i++) {
+            free(ahead->blocks[i].samples);
+        }
+        free(ahead->blocks);
+        free(ahead);
+        return NULL;
+    } else {
+        return ahead;
+    }
+}
+
+const struct da_block*
+decode_ahead_next(DecodeAhead *ahead)
+{
+    const struct da_block *block;
+
+    pthread_mutex_lock(&(ahead->lock));
+    while (ahead->filled == 0) {
+        pthread_cond_wait(&(ahead->block_ready), &(ahead->lock));
+    }
+    block = &(ahead->blocks[ahead->head]);
+    pthread_mutex_unlock(&(ahead->lock));
+
+    return block;
+}
+
+void
+decode_ahead_release(DecodeAhead *ahead)
+{
+    pthread_mutex_lock(&(ahead->lock));
+    /*the final block is never released
+      so that further reads keep returning it*/
+    if ((ahead->filled > 0) &&
+        (ahead->blocks[ahead->head].status == DA_OK)) {
+        ahead->head = (ahead->head + 1) % ahead->block_count;
+        ahead->filled--;
+        pthread_cond_signal(&(ahead->block_free));
+    }
+    pthread_mutex_unlock(&(ahead->lock));
+}
+
+void
+decode_ahead_close(DecodeAhead *ahead)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&(ahead->lock));
+    ahead->stop = 1;
+    pthread_cond_signal(&(ahead->block_free));
+    pthread_mutex_unlock(&(ahead->lock));
+
+    /*if the thread is in the middle of decoding a block
+      this waits for that block to finish*/
+    pthread_join(ahead->thread, NULL);
+
+    pthread_cond_destroy(&(ahead->block_free));
+    pthread_cond_destroy(&(ahead->block_ready));
+    pthread_mutex_destroy(&(ahead->lock));
+    for (i = 0; i < ahead->block_count; i++) {
+        free(ahead->blocks[i].samples);
+    }
+    free(ahead->blocks);
+    free(ahead);
+}
+
+static void*
+decode_ahead_thread(DecodeAhead *ahead)
+{
+    for (;;) {
+        struct da_block *block;
+        int finished;
+
+        /*wait for a free block in the ring*/
+        pthread_mutex_lock(&(ahead->lock));
+        while ((ahead->filled == ahead->block_count) && (!ahead->stop)) {
+            pthread_cond_wait(&(ahead->block_free), &(ahead->lock));
+        }
+        if (ahead->stop) {
+            pthread_mutex_unlock(&(ahead->lock));
+            return NULL;
+        }
+        block = &(ahead->blocks[ahead->tail]);
+        pthread_mutex_unlock(&(ahead->lock));
+
+        /*the block at the tail isn't visible to the reader
+          until "filled" is incremented, so decode without the lock*/
+        ahead->decode(ahead->decoder, ahead->max_pcm_frames, block);
+        finished = (block->status != DA_OK);
+
+        pthread_mutex_lock(&(ahead->lock));
+        ahead->tail = (ahead->tail + 1) % ahead->block_count;
+        ahead->filled++;
+        pthread_cond_signal(&(ahead->block_ready));
+        pthread_mutex_unlock(&(ahead->lock));
+
+        /*nothing is decoded after the stream's final block*/
+        if (finished) {
+            return NULL;
+        }
+    }
+}
+
+
+#ifdef EXECUTABLE
+
+#include <assert.h>
+#include <unistd.h>
+
+/*a synthetic decoder whose samples count up from 0
+  so that every block's contents and order can be checked*/
+struct test_decoder {
+    unsigned channels;
+    unsigned total_pcm_frames;
+    unsigned error_at;        /*PCM frame at which decoding fails*/
+    unsigned delay;           /*microseconds spent decoding each block*/
+    unsigned position;        /*PCM frames decoded so far*/
+};
+
+static void
+test_decode(struct test_decoder *decoder,
+            unsigned max_pcm_frames,
+            struct da_block *block)
+{
+    unsigned remaining;
+    unsigned i;
+
+    if (decoder->delay) {
+        usleep(decoder->delay);
+    }
+
+    if (decoder->position >= decoder->error_at) {
+        block->status = DA_ERROR;
+        block->pcm_frames = 0;
+        block->error = "test error";
+        block->io_error = 1;
+        return;
+    } else if (decoder->position == decoder->total_pcm_frames) {
+        block->status = DA_FINISHED;
+        block->pcm_frames = 0;
+        return;
+    }
+
+    remaining = decoder->total_pcm_frames - decoder->position;
+    block->status = DA_OK;
+    block->pcm_frames = remaining < max_pcm_frames ? remaining : max_pcm_frames;
+    for (i = 0; i < block->pcm_frames * decoder->channels; i++) {
+        block->samples[i] = (decoder->position * decoder->channels) + i;
+    }
+    decoder->position += block->pcm_frames;
+}
+
+static DecodeAhead*
+open_test_decoder(struct test_decoder *decoder,
+                  unsigned channels,
+                  unsigned total_pcm_frames,
+                  unsigned error_at,
+                  unsigned delay,
+                  unsigned max_pcm_frames,
+                  unsigned block_count)
+{
+    DecodeAhead *ahead;
+
+    decoder->channels = channels;
+    decoder->total_pcm_frames = total_pcm_frames;
+    decoder->error_at = error_at;
+    decoder->delay = delay;
+    decoder->position = 0;
+
+    ahead = decode_ahead_open(decoder,
+                              (da_decode_f)test_decode,
+                              channels,
+                              max_pcm_frames,
+                              block_count);
+    assert(ahead != NULL);
+    return ahead;
+}
+
+/*reads blocks until the stream's final block
+  checking that samples arrive in order
+  and returns the final block's status*/
+static da_status
+test_read_all(DecodeAhead *ahead,
+              unsigned channels,
+              unsigned max_pcm_frames,
+              unsigned *pcm_frames)
+{
+    const struct da_block *block;
+    int expected = 0;
+
+    *pcm_frames = 0;
+    while ((block = decode_ahead_next(ahead))->status == DA_OK) {
+        unsigned i;
+        assert(block->pcm_frames > 0);
+        assert(block->pcm_frames <= max_pcm_frames);
+        for (i = 0; i < block->pcm_frames * channels; i++) {
+            assert(block->samples[i] == expected++);
+        }
+        *pcm_frames += block->pcm_frames;
+        decode_ahead_release(ahead);
+    }
+
+    /*the final block keeps being returned*/
+    decode_ahead_release(ahead);
+    assert(decode_ahead_next(ahead) == block);
+    decode_ahead_release(ahead);
+    assert(decode_ahead_next(ahead) == block);
+
+    return block->status;
+}
+
+static void
+test_full_streams(void)
+{
+    const unsigned max_pcm_frames = 64;
+    const unsigned lengths[] = {0, 1, 63, 64, 65, 128, 1000};
+    const unsigned block_counts[] = {1, 2, 4};
+    unsigned l;
+    unsigned b;
+    unsigned channels;
+
+    for (channels = 1; channels <= 2; channels++) {
+        for (l = 0; l < sizeof(lengths) / sizeof(unsigned); l++) {
+            for (b = 0; b < sizeof(block_counts) / sizeof(unsigned); b++) {
+                struct test_decoder decoder;
+                DecodeAhead *ahead = open_test_decoder(&decoder,
+                                                       channels,
+                                                       lengths[l],
+                                                       lengths[l] + 1,
+                                                       0,
+                                                       max_pcm_frames,
+                                                       block_counts[b]);
+                unsigned pcm_frames;
+
+                assert(test_read_all(ahead,
+                                     channels,
+                                     max_pcm_frames,
+                                     &pcm_frames) == DA_FINISHED);
+                assert(pcm_frames == lengths[l]);
+                decode_ahead_close(ahead);
+            }
+        }
+    }
+}
+
+static void
+test_errors(void)
+{
+    struct test_decoder decoder;
+    DecodeAhead *ahead = open_test_decoder(&decoder, 2, 1000, 200, 0, 64, 3);
+    const struct da_block *block;
+    unsigned pcm_frames;
+
+    /*blocks before the error are returned intact*/
+    assert(test_read_all(ahead, 2, 64, &pcm_frames) == DA_ERROR);
+    assert(pcm_frames == 256);
+    block = decode_ahead_next(ahead);
+    assert(block->io_error == 1);
+    assert(block->error != NULL);
+    decode_ahead_close(ahead);
+}
+
+static void
+test_ring_bound(void)
+{
+    struct test_decoder decoder;
+    DecodeAhead *ahead = open_test_decoder(&decoder, 1, 100000, 100001,
+                                           0, 10, 3);
+    unsigned filled;
+
+    /*with nothing read, the thread stops once the ring is full*/
+    usleep(50000);
+    pthread_mutex_lock(&(ahead->lock));
+    filled = ahead->filled;
+    pthread_mutex_unlock(&(ahead->lock));
+    assert(filled == 3);
+
+    /*and refills each released block*/
+    decode_ahead_next(ahead);
+    decode_ahead_release(ahead);
+    usleep(50000);
+    pthread_mutex_lock(&(ahead->lock));
+    filled = ahead->filled;
+    pthread_mutex_unlock(&(ahead->lock));
+    assert(filled == 3);
+
+    decode_ahead_close(ahead);
+    assert(decoder.position == 40);
+}
+
+static void
+test_early_close(void)
+{
+    struct test_decoder decoder;
+    DecodeAhead *ahead;
+
+    /*closing without reading anything*/
+    ahead = open_test_decoder(&decoder, 2, 100000, 100001, 0, 64, 4);
+    decode_ahead_close(ahead);
+    assert(decoder.position < 100000);
+
+    /*closing while the thread waits for a free block*/
+    ahead = open_test_decoder(&decoder, 2, 100000, 100001, 0, 64, 2);
+    decode_ahead_next(ahead);
+    decode_ahead_release(ahead);
+    decode_ahead_next(ahead);
+    usleep(20000);
+    decode_ahead_close(ahead);
+    assert(decoder.position == 64 * 3);
+
+    /*closing while the thread is in the middle of decoding a block*/
+    ahead = open_test_decoder(&decoder, 2, 100000, 100001, 20000, 64, 4);
+    usleep(10000);
+    decode_ahead_close(ahead);
+    assert(decoder.position <= 64);
+}
+
+int main(int argc, char* argv[]) {
+    test_full_streams();
+    test_errors();
+    test_ring_bound();
+    test_early_close();
+
+    return 0;
+}
+
+#endif
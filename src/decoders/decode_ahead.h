@@ -0,0 +1,116 @@
+#ifndef DECODE_AHEAD_H
+#define DECODE_AHEAD_H
+
+#include <pthread.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*a DecodeAhead runs a decoder's decode function on its own native thread,
+  filling a bounded ring of interleaved integer sample blocks
+  which the decoder's read() method then pops in order
+
+  this lets decoding overlap with whatever the caller does with
+  the previous block, such as encoding it on another core
+
+  once started, the decoding thread has exclusive use of the decoder's
+  codec state until decode_ahead_close() is called*/
+
+typedef enum {DA_OK,        /*block contains decoded samples*/
+              DA_FINISHED,  /*stream is exhausted*/
+              DA_ERROR      /*an error occurred decoding the stream*/
+             } da_status;
+
+struct da_block {
+    da_status status;
+    unsigned pcm_frames;
+
+    /*interleaved samples, room for channel_count * max_pcm_frames*/
+    int *samples;
+
+    /*if status is DA_ERROR, a static error message
+      and whether it should be raised as an IOError
+      rather than a ValueError*/
+    const char *error;
+    int io_error;
+};
+
+/*fills "block" with up to "max_pcm_frames" PCM frames from "decoder"
+  and sets its status, pcm_frames and error fields
+
+  this is only ever called from the decoding thread
+  and so must not touch any Python objects*/
+typedef void (*da_decode_f)(void *decoder,
+                            unsigned max_pcm_frames,
+                            struct da_block *block);
+
+typedef struct DecodeAhead_s {
+    void *decoder;
+    da_decode_f decode;
+
+    unsigned max_pcm_frames;
+    unsigned block_count;
+    struct da_block *blocks;
+
+    unsigned head;       /*next block to be returned*/
+    unsigned tail;       /*next block to be filled*/
+    unsigned filled;     /*blocks decoded but not yet released*/
+    int stop;            /*set when the decoding thread should exit*/
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t block_ready;
+    pthread_cond_t block_free;
+} DecodeAhead;
+
+/*allocates "block_count" blocks of "max_pcm_frames" frames
+  across "channel_count" channels and starts the decoding thread
+
+  returns NULL if the thread cannot be started*/
+DecodeAhead*
+decode_ahead_open(void *decoder,
+                  da_decode_f decode,
+                  unsigned channel_count,
+                  unsigned max_pcm_frames,
+                  unsigned block_count);
+
+/*waits for the next decoded block and returns it
+
+  the block remains owned by the DecodeAhead
+  and must be given back with decode_ahead_release()
+  once the caller is finished with its samples
+
+  a DA_FINISHED or DA_ERROR block is the last one the thread produces
+  and is returned again on every subsequent call
+
+  since this may block, it should be called with the GIL released*/
+const struct da_block*
+decode_ahead_next(DecodeAhead *ahead);
+
+/*returns the block from the last call to decode_ahead_next()
+  to the ring so that the thread may refill it*/
+void
+decode_ahead_release(DecodeAhead *ahead);
+
+/*stops the decoding thread, waits for it to exit
+  and deallocates the DecodeAhead*/
+void
+decode_ahead_close(DecodeAhead *ahead);
+
+#endif
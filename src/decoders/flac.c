@@ -2,7 +2,9 @@
 #include "../framelist.h"
 #include "../common/flac_crc.h"
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
+#include <ctype.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -23,47 +25,6 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
-typedef enum {OK,
-              INVALID_SYNC_CODE,
-              INVALID_SAMPLE_RATE,
-              INVALID_BPS,
-              INVALID_CHANNEL_ASSIGNMENT,
-              INVALID_UTF8,
-              INVALID_CRC8,
-              IOERROR_HEADER,
-              IOERROR_SUBFRAME,
-              IOERROR_CRC16,
-              INVALID_SUBFRAME_HEADER,
-              INVALID_FIXED_ORDER,
-              INVALID_LPC_ORDER,
-              INVALID_CODING_METHOD,
-              INVALID_WASTED_BPS,
-              INVALID_PARTITION_ORDER,
-              BLOCK_SIZE_MISMATCH,
-              SAMPLE_RATE_MISMATCH,
-              BPS_MISMATCH,
-              CHANNEL_COUNT_MISMATCH} status_t;
-
-typedef enum {INDEPENDENT,
-              LEFT_DIFFERENCE,
-              DIFFERENCE_RIGHT,
-              AVERAGE_DIFFERENCE} channel_assignment_t;
-
-typedef enum {CONSTANT,
-              VERBATIM,
-              FIXED,
-              LPC} subframe_type_t;
-
-struct frame_header {
-    unsigned blocking_strategy;
-    unsigned block_size;
-    unsigned sample_rate;
-    channel_assignment_t channel_assignment;
-    unsigned channel_count;
-    unsigned bits_per_sample;
-    unsigned frame_number;
-};
-
 const static uint8_t empty_md5[16] = {0, 0, 0, 0, 0, 0, 0, 0,
                                       0, 0, 0, 0, 0, 0, 0, 0};
 
@@ -88,162 +49,278 @@ read_SEEKTABLE(BitstreamReader *r,
                unsigned block_size,
                struct SEEKTABLE *seektable);
 
-static void
-read_VORBIS_COMMENT(BitstreamReader *r, unsigned *channel_mask);
-
-static status_t
-read_frame_header(BitstreamReader *r,
-                  const struct STREAMINFO *streaminfo,
-                  struct frame_header *frame_header);
-
-static status_t
-read_utf8(BitstreamReader *r, unsigned *utf8);
-
-typedef status_t (*decode_f)(BitstreamReader *r,
-                             const struct frame_header *frame_header,
-                             int samples[]);
-
-static decode_f
-get_decoder(channel_assignment_t channel_assignment);
-
-static status_t
-decode_independent(BitstreamReader *r,
-                   const struct frame_header *frame_header,
-                   int samples[]);
-
-static status_t
-decode_left_difference(BitstreamReader *r,
-                       const struct frame_header *frame_header,
-                       int samples[]);
-static status_t
-decode_difference_right(BitstreamReader *r,
-                        const struct frame_header *frame_header,
-                        int samples[]);
-
-static status_t
-decode_average_difference(BitstreamReader *r,
-                          const struct frame_header *frame_header,
-                          int samples[]);
-
-static status_t
-read_subframe(BitstreamReader *r,
-              unsigned block_size,
-              unsigned bits_per_sample,
-              int channel_data[]);
-
-static status_t
-read_subframe_header(BitstreamReader *r,
-                     subframe_type_t *type,
-                     unsigned *order,
-                     unsigned *wasted_bps);
+/*reads a PICTURE block's fields up to its image data, which is left unread
+  and sets "consumed" to the number of the block's bytes read
+  returns 1 on success, or 0 if the block's lengths are inconsistent
+  in which case nothing is allocated in "picture"*/
+static int
+read_PICTURE(BitstreamReader *r,
+             unsigned block_size,
+             unsigned *consumed,
+             struct flac_picture *picture);
+
+/*reads the vendor string and entries of a VORBIS_COMMENT substream
+  returns 1 on success, or 0 if the block is malformed
+  in which case the header is left without a comment*/
+static int
+read_VORBIS_COMMENT(BitstreamReader *r, struct flac_header *header);
 
-static void
-read_CONSTANT_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample,
-                       int channel_data[]);
+#ifndef STANDALONE
+/*the channel mask assumed for streams that don't specify one*/
+static unsigned
+default_channel_mask(unsigned channel_count);
+
+/*positions the reader at the first frame the header points to
+  returning 1 if a frame sync code is found there
+  or 0 with the reader back where it started
+  if the stream has changed since the header was parsed*/
+static int
+seek_to_frames(BitstreamReader *r, const struct flac_header *header);
 
-static void
-read_VERBATIM_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample,
-                       int channel_data[]);
-
-static status_t
-read_FIXED_subframe(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned bits_per_sample,
-                    unsigned predictor_order,
-                    int channel_data[]);
-
-static status_t
-read_LPC_subframe(BitstreamReader *r,
-                  unsigned block_size,
-                  unsigned bits_per_sample,
-                  unsigned predictor_order,
-                  int channel_data[]);
-
-static status_t
-read_residual_block(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned predictor_order,
-                    int residuals[]);
-
-static status_t
-read_crc16(BitstreamReader *r);
+/*returns 1 if a frame sync code is at the reader's position,
+  or "may_be_empty" if there's no more data at all*/
+static int
+frame_sync_follows(BitstreamReader *r, int may_be_empty);
 
+/*seeks past the stream ID and metadata blocks the header describes*/
 static void
-decorrelate_left_difference(unsigned block_size,
-                            const int left[],
-                            const int difference[],
-                            int samples[]);
-static void
-decorrelate_difference_right(unsigned block_size,
-                             const int difference[],
-                             const int right[],
-                             int samples[]);
+skip_metadata(BitstreamReader *r, const struct flac_header *header);
 
-static void
-decorrelate_average_difference(unsigned block_size,
-                               const int average[],
-                               const int difference[],
-                               int samples[]);
+/*takes the decoder's stream parameters from a parsed header
+  returns 0 on success, or -1 with a Python exception set
+  if the header isn't suitable for decoding*/
+static int
+setup_decoder(decoders_FlacDecoder *self, const struct flac_header *header);
+#endif
 
-static status_t
-skip_subframe(BitstreamReader *r,
-              unsigned block_size,
-              unsigned bits_per_sample);
+/***********************************
+ * public function implementations *
+ ***********************************/
 
-static void
-skip_CONSTANT_subframe(BitstreamReader *r,
-                       unsigned bits_per_sample);
+#ifndef STANDALONE
+PyObject*
+FlacHeader_new(PyTypeObject *type,
+               PyObject *args, PyObject *kwds)
+{
+    decoders_FlacHeader *self;
 
-static void
-skip_VERBATIM_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample);
-
-static status_t
-skip_FIXED_subframe(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned bits_per_sample,
-                    unsigned predictor_order);
-
-static status_t
-skip_LPC_subframe(BitstreamReader *r,
-                  unsigned block_size,
-                  unsigned bits_per_sample,
-                  unsigned predictor_order);
-
-static status_t
-skip_residual_block(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned predictor_order);
+    self = (decoders_FlacHeader *)type->tp_alloc(type, 0);
 
-static void
-update_md5sum(audiotools__MD5Context *md5sum,
-              const int pcm_data[],
-              unsigned channels,
-              unsigned bits_per_sample,
-              unsigned pcm_frames);
+    return (PyObject *)self;
+}
 
-static int
-verify_md5sum(audiotools__MD5Context *stream_md5,
-              const uint8_t streaminfo_md5[]);
+int
+FlacHeader_init(decoders_FlacHeader *self,
+                PyObject *args, PyObject *kwds)
+{
+    PyObject *file;
+    BitstreamReader *reader;
+    flac_status status;
 
-#ifndef STANDALONE
-PyObject*
-flac_exception(status_t status);
-#endif
+    if (!PyArg_ParseTuple(args, "O", &file)) {
+        return -1;
+    }
 
-const char*
-flac_strerror(status_t status);
+    /*an init called twice shouldn't leak the first parse*/
+    flacdec_free_header(&(self->header));
+
+    reader = br_open_python(file, BS_BIG_ENDIAN, 4096);
+    status = flacdec_read_header(reader, &(self->header));
+    reader->free(reader);
+
+    if (status == OK) {
+        return 0;
+    } else {
+        PyErr_SetString(flac_exception(status), flac_strerror(status));
+        return -1;
+    }
+}
+
+void
+FlacHeader_dealloc(decoders_FlacHeader *self)
+{
+    flacdec_free_header(&(self->header));
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+FlacHeader_sample_rate(decoders_FlacHeader *self, void *closure)
+{
+    return Py_BuildValue("I", self->header.streaminfo.sample_rate);
+}
+
+static PyObject*
+FlacHeader_bits_per_sample(decoders_FlacHeader *self, void *closure)
+{
+    return Py_BuildValue("I", self->header.streaminfo.bits_per_sample);
+}
+
+static PyObject*
+FlacHeader_channels(decoders_FlacHeader *self, void *closure)
+{
+    return Py_BuildValue("I", self->header.streaminfo.channel_count);
+}
+
+static PyObject*
+FlacHeader_total_samples(decoders_FlacHeader *self, void *closure)
+{
+    return Py_BuildValue("K", self->header.streaminfo.total_samples);
+}
+
+static PyObject*
+FlacHeader_md5sum(decoders_FlacHeader *self, void *closure)
+{
+    return PyBytes_FromStringAndSize((char *)self->header.streaminfo.MD5, 16);
+}
+
+static PyObject*
+FlacHeader_channel_mask(decoders_FlacHeader *self, void *closure)
+{
+    if (self->header.has_channel_mask) {
+        return Py_BuildValue("I", self->header.channel_mask);
+    } else {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+}
+
+static PyObject*
+FlacHeader_seekpoints(decoders_FlacHeader *self, void *closure)
+{
+    const struct SEEKTABLE *seektable = &(self->header.seektable);
+    PyObject *list = PyList_New(seektable->total_points);
+    unsigned i;
+
+    if (!list) {
+        return NULL;
+    }
+
+    for (i = 0; i < seektable->total_points; i++) {
+        PyObject *point = Py_BuildValue(
+            "(K, K, I)",
+            seektable->seek_points[i].sample_number,
+            seektable->seek_points[i].frame_offset,
+            seektable->seek_points[i].frame_samples);
+        if (!point) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, point);
+    }
+
+    return list;
+}
+
+static PyObject*
+FlacHeader_vendor_string(decoders_FlacHeader *self, void *closure)
+{
+    if (self->header.vendor_string) {
+        return PyUnicode_DecodeUTF8(self->header.vendor_string,
+                                    strlen(self->header.vendor_string),
+                                    "replace");
+    } else {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+}
+
+static PyObject*
+FlacHeader_comments(decoders_FlacHeader *self, void *closure)
+{
+    PyObject *list;
+    unsigned i;
+
+    if (!self->header.vendor_string) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    } else if ((list = PyList_New(self->header.total_comments)) == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < self->header.total_comments; i++) {
+        PyObject *comment =
+            PyUnicode_DecodeUTF8(self->header.comments[i],
+                                 strlen(self->header.comments[i]),
+                                 "replace");
+        if (!comment) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, comment);
+    }
+
+    return list;
+}
+
+static PyObject*
+FlacHeader_pictures(decoders_FlacHeader *self, void *closure)
+{
+    PyObject *list = PyList_New(self->header.total_pictures);
+    unsigned i;
+
+    if (!list) {
+        return NULL;
+    }
+
+    for (i = 0; i < self->header.total_pictures; i++) {
+        const struct flac_picture *picture = &(self->header.pictures[i]);
+        PyObject *tuple = Py_BuildValue(
+            "(I, N, N, I, I, I, I, K, I)",
+            picture->type,
+            PyUnicode_DecodeASCII(picture->mime_type,
+                                  strlen(picture->mime_type),
+                                  "replace"),
+            PyUnicode_DecodeUTF8(picture->description,
+                                 strlen(picture->description),
+                                 "replace"),
+            picture->width,
+            picture->height,
+            picture->color_depth,
+            picture->color_count,
+            picture->data_offset,
+            picture->data_length);
+        if (!tuple) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, tuple);
+    }
+
+    return list;
+}
+
+static PyObject*
+FlacHeader_blocks(decoders_FlacHeader *self, void *closure)
+{
+    PyObject *list = PyList_New(self->header.total_blocks);
+    unsigned i;
+
+    if (!list) {
+        return NULL;
+    }
+
+    for (i = 0; i < self->header.total_blocks; i++) {
+        PyObject *block = Py_BuildValue("(I, K, I)",
+                                        self->header.blocks[i].type,
+                                        self->header.blocks[i].offset,
+                                        self->header.blocks[i].size);
+        if (!block) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, block);
+    }
+
+    return list;
+}
+
+static PyObject*
+FlacHeader_frames_offset(decoders_FlacHeader *self, void *closure)
+{
+    return Py_BuildValue("K", self->header.frames_offset);
+}
 
-/***********************************
- * public function implementations *
- ***********************************/
 
-#ifndef STANDALONE
 PyObject*
 FlacDecoder_new(PyTypeObject *type,
                 PyObject *args, PyObject *kwds)
@@ -261,11 +338,7 @@ FlacDecoder_init(decoders_FlacDecoder *self,
                  PyObject *args, PyObject *kwds)
 {
     PyObject *file;
-    int streaminfo_read = 0;
-    int vorbis_comment_read = 0;
-    unsigned last;
-    unsigned type;
-    unsigned size;
+    decoders_FlacHeader *header = NULL;
 
     self->bitstream = NULL;
     self->seektable.total_points = 0;
@@ -277,142 +350,44 @@ FlacDecoder_init(decoders_FlacDecoder *self,
     self->perform_validation = 1;
     self->stream_finalized = 0;
     self->audiotools_pcm = NULL;
+    frame_buffer_init(&(self->buffer));
     self->beginning_of_frames = NULL;
 
-    if (!PyArg_ParseTuple(args, "O", &file)) {
+    if (!PyArg_ParseTuple(args, "O|O!",
+                          &file,
+                          &decoders_FlacHeaderType,
+                          &header)) {
         return -1;
-    } else {
-        Py_INCREF(file);
     }
 
-    self->bitstream = br_open_external(file,
-                                       BS_BIG_ENDIAN,
-                                       4096,
-                                       br_read_python,
-                                       bs_setpos_python,
-                                       bs_getpos_python,
-                                       bs_free_pos_python,
-                                       bs_fseek_python,
-                                       bs_close_python,
-                                       bs_free_python_decref);
+    self->bitstream = br_open_python(file, BS_BIG_ENDIAN, 4096);
 
-    if (!setjmp(*br_try(self->bitstream))) {
-        /*validate stream ID*/
-        if (!valid_stream_id(self->bitstream)) {
-            PyErr_SetString(PyExc_ValueError, "invalid stream ID");
-            br_etry(self->bitstream);
+    /*reuse the caller's parse of the metadata blocks, if given,
+      provided the stream still has a frame where it says*/
+    if ((header != NULL) && seek_to_frames(self->bitstream, &(header->header))) {
+        if (setup_decoder(self, &(header->header))) {
             return -1;
         }
+    } else {
+        struct flac_header parsed;
+        const flac_status status = flacdec_read_header(self->bitstream,
+                                                       &parsed);
 
-        /*parse metadata blocks*/
-        do {
-            read_block_header(self->bitstream, &last, &type, &size);
-
-            switch (type) {
-            case 0: /*STREAMINFO*/
-                if (!streaminfo_read) {
-                    const static unsigned fL  = 0x1;
-                    const static unsigned fR  = 0x2;
-                    const static unsigned fC  = 0x4;
-                    const static unsigned LFE = 0x8;
-                    const static unsigned bL  = 0x10;
-                    const static unsigned bR  = 0x20;
-                    const static unsigned bC  = 0x100;
-                    const static unsigned sL  = 0x200;
-                    const static unsigned sR  = 0x400;
-
-                    read_STREAMINFO(self->bitstream, &(self->streaminfo));
-                    /*use a dummy channel mask for now*/
-                    switch (self->streaminfo.channel_count) {
-                    case 1:
-                        self->channel_mask = fC;
-                        break;
-                    case 2:
-                        self->channel_mask = fL | fR;
-                        break;
-                    case 3:
-                        self->channel_mask = fL | fR | fC;
-                        break;
-                    case 4:
-                        self->channel_mask = fL | fR | bL | bR;
-                        break;
-                    case 5:
-                        self->channel_mask = fL | fR | fC | bL | bR;
-                        break;
-                    case 6:
-                        self->channel_mask = fL | fR | fC | bL | bR | LFE;
-                        break;
-                    case 7:
-                        self->channel_mask =
-                        fL | fR | fC | LFE | bC | sL | sR;
-                        break;
-                    case 8:
-                        self->channel_mask =
-                        fL | fR | fC | LFE | bL | bR | sL | sR;
-                        break;
-                    }
-
-                    /*turn off MD5 checking if MD5 sum is empty*/
-                    if (memcmp(self->streaminfo.MD5, empty_md5, 16) == 0) {
-                        self->perform_validation = 0;
-                    }
-
-                    streaminfo_read = 1;
-                } else {
-                    PyErr_SetString(PyExc_ValueError,
-                                    "multiple STREAMINFO blocks in stream");
-                    br_etry(self->bitstream);
-                    return -1;
-                }
-                break;
-            case 1: /*PADDING*/
-            case 2: /*APPLICATION*/
-            case 5: /*CUESHEET*/
-            case 6: /*PICTURE*/
-                self->bitstream->skip_bytes(self->bitstream, size);
-                break;
-            case 3: /*SEEKTABLE*/
-                if (!(self->seektable.seek_points)) {
-                    read_SEEKTABLE(self->bitstream, size, &(self->seektable));
-                } else {
-                    PyErr_SetString(PyExc_ValueError,
-                                    "multiple SEEKTABLE blocks in stream");
-                    br_etry(self->bitstream);
-                    return -1;
-                }
-                break;
-            case 4: /*VORBIS_COMMENT*/
-                if (!vorbis_comment_read) {
-                    BitstreamReader *comment =
-                        self->bitstream->substream(self->bitstream, size);
-                    read_VORBIS_COMMENT(comment, &(self->channel_mask));
-                    comment->close(comment);
-                    vorbis_comment_read = 1;
-                } else {
-                    PyErr_SetString(PyExc_ValueError,
-                                    "multiple VORBIS_COMMENT blocks in stream");
-                    br_etry(self->bitstream);
-                    return -1;
-                }
-                break;
-            default:
-                PyErr_SetString(PyExc_ValueError, "unknown block ID in stream");
-                br_etry(self->bitstream);
-                return -1;
-            }
-        } while (last == 0);
-
-        if (streaminfo_read) {
-            self->remaining_samples = self->streaminfo.total_samples;
-        } else {
-            PyErr_SetString(PyExc_ValueError, "no STREAMINFO block in stream");
-            br_etry(self->bitstream);
+        if (status != OK) {
+            flacdec_free_header(&parsed);
+            PyErr_SetString(flac_exception(status), flac_strerror(status));
+            return -1;
+        } else if (setup_decoder(self, &parsed)) {
+            flacdec_free_header(&parsed);
             return -1;
+        } else {
+            flacdec_free_header(&parsed);
         }
+    }
 
-        /*mark beginning of frames for start of decoding*/
+    /*mark beginning of frames for start of decoding*/
+    if (!setjmp(*br_try(self->bitstream))) {
         self->beginning_of_frames = self->bitstream->getpos(self->bitstream);
-
         br_etry(self->bitstream);
     } else {
         br_etry(self->bitstream);
@@ -435,6 +410,7 @@ FlacDecoder_dealloc(decoders_FlacDecoder *self)
     }
     free(self->seektable.seek_points);
     Py_XDECREF(self->audiotools_pcm);
+    frame_buffer_free(&(self->buffer));
     if (self->beginning_of_frames) {
         self->beginning_of_frames->del(self->beginning_of_frames);
     }
@@ -500,19 +476,29 @@ FlacDecoder_channel_mask(decoders_FlacDecoder *self, void *closure)
 PyObject*
 FlacDecoder_read(decoders_FlacDecoder* self, PyObject *args)
 {
-    status_t status;
-    struct frame_header frame_header;
-    uint16_t crc16 = 0;
+    int pcm_frames;
+    uint64_t available;
+    pcm_FrameList *framelist;
+    unsigned position;
+
+    if (!PyArg_ParseTuple(args, "i", &pcm_frames)) {
+        return NULL;
+    }
 
     if (self->closed) {
         /*ensure file isn't closed*/
         PyErr_SetString(PyExc_ValueError, "cannot read closed stream");
         return NULL;
-    } else if (self->remaining_samples == 0) {
+    }
+
+    available = (frame_buffer_remaining(&(self->buffer)) +
+                 self->remaining_samples);
+
+    if (available == 0) {
         /*validate MD5 sum if still validating
           (if we haven't seeked to the middle of the file, for instance)*/
         if (self->perform_validation) {
-            if (verify_md5sum(&(self->md5), self->streaminfo.MD5)) {
+            if (flacdec_verify_md5sum(&(self->md5), self->streaminfo.MD5)) {
                 self->perform_validation = 0;
                 /*return empty FrameList if nothing left to send*/
                 return empty_FrameList(self->audiotools_pcm,
@@ -530,72 +516,101 @@ FlacDecoder_read(decoders_FlacDecoder* self, PyObject *args)
         }
     }
 
+    /*always return at least 1 PCM frame
+      since an empty FrameList indicates the end of the stream*/
+    framelist = new_FrameList(self->audiotools_pcm,
+                              self->streaminfo.channel_count,
+                              self->streaminfo.bits_per_sample,
+                              (unsigned)MIN(available,
+                                            (uint64_t)MAX(pcm_frames, 1)));
+    framelist->planar = 1;
+
+    /*hand out what's left of the previous frame, if anything,
+      then as many frames as fit, buffering the rest of the last*/
+    position = frame_buffer_move(&(self->buffer), framelist, 0);
+
+    while ((position < framelist->frames) && self->remaining_samples) {
+        const flac_status status = decode_frame(self);
+        if (status != OK) {
+            Py_DECREF((PyObject*)framelist);
+            PyErr_SetString(flac_exception(status), flac_strerror(status));
+            return NULL;
+        }
+        position += frame_buffer_move(&(self->buffer), framelist, position);
+    }
+
+    if (position < framelist->frames) {
+        /*the stream's frames came up short of STREAMINFO's total*/
+        shrink_FrameList(framelist, position);
+    }
+
+    return (PyObject*)framelist;
+}
+
+static flac_status
+decode_frame(decoders_FlacDecoder *self)
+{
+    flac_status status;
+    struct flac_frame_header frame_header;
+    uint16_t crc16 = 0;
+    int *samples;
+
     self->bitstream->add_callback(self->bitstream,
                                   (bs_callback_f)flac_crc16,
                                   &crc16);
 
     /*ensure frame header is read successfully*/
-    if ((status = read_frame_header(self->bitstream,
-                                    &(self->streaminfo),
-                                    &frame_header)) != OK) {
+    if ((status = flacdec_read_frame_header(self->bitstream,
+                                            &(self->streaminfo),
+                                            &frame_header)) != OK) {
         self->bitstream->pop_callback(self->bitstream, NULL);
-        PyErr_SetString(flac_exception(status), flac_strerror(status));
-        return NULL;
-    } else {
-        /*setup framelist to be output once populated*/
-        pcm_FrameList *framelist = new_FrameList(self->audiotools_pcm,
-                                                 frame_header.channel_count,
-                                                 frame_header.bits_per_sample,
-                                                 frame_header.block_size);
-
-        /*decode subframes based on channel assignment*/
-        decode_f decode = get_decoder(frame_header.channel_assignment);
-        assert(decode);
-
-        if ((status = decode(self->bitstream,
-                             &frame_header,
-                             framelist->samples)) != OK) {
-            Py_DECREF((PyObject*)framelist);
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            return NULL;
-        }
+        return status;
+    }
 
-        /*validate CRC-16 in frame footer*/
-        status = read_crc16(self->bitstream);
-        self->bitstream->pop_callback(self->bitstream, NULL);
-        if (status != OK) {
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            Py_DECREF((PyObject*)framelist);
-            return NULL;
-        } else if (crc16) {
-            PyErr_SetString(PyExc_ValueError, "frame CRC-16 mismatch");
-            Py_DECREF((PyObject*)framelist);
-            return NULL;
-        }
+    samples = frame_buffer_fill(&(self->buffer),
+                                frame_header.channel_count,
+                                frame_header.block_size);
 
-        /*if validating, update running MD5 sum*/
-        if (self->perform_validation) {
-            update_md5sum(&(self->md5),
-                          framelist->samples,
-                          frame_header.channel_count,
-                          frame_header.bits_per_sample,
-                          frame_header.block_size);
-        }
+    /*decode subframes based on channel assignment*/
+    if ((status = flacdec_decode_subframes(self->bitstream,
+                                           &frame_header,
+                                           samples)) != OK) {
+        frame_buffer_clear(&(self->buffer));
+        self->bitstream->pop_callback(self->bitstream, NULL);
+        return status;
+    }
 
-        self->remaining_samples -= MIN(self->remaining_samples,
-                                       frame_header.block_size);
+    /*validate CRC-16 in frame footer*/
+    status = flacdec_read_crc16(self->bitstream);
+    self->bitstream->pop_callback(self->bitstream, NULL);
+    if (status != OK) {
+        frame_buffer_clear(&(self->buffer));
+        return status;
+    } else if (crc16) {
+        frame_buffer_clear(&(self->buffer));
+        return INVALID_CRC16;
+    }
 
-        return (PyObject*)framelist;
+    /*if validating, update running MD5 sum*/
+    if (self->perform_validation) {
+        flacdec_update_md5sum(&(self->md5),
+                              samples,
+                              frame_header.channel_count,
+                              frame_header.bits_per_sample,
+                              frame_header.block_size);
     }
+
+    self->remaining_samples -= MIN(self->remaining_samples,
+                                   frame_header.block_size);
+
+    return OK;
 }
 
 static PyObject*
 FlacDecoder_frame_size(decoders_FlacDecoder* self, PyObject *args)
 {
-    status_t status;
-    struct frame_header frame_header;
-    unsigned c;
+    flac_status status;
+    struct flac_frame_header frame_header;
     uint16_t crc16 = 0;
     unsigned frame_size = 0;
 
@@ -620,9 +635,9 @@ FlacDecoder_frame_size(decoders_FlacDecoder* self, PyObject *args)
                                   &frame_size);
 
     /*ensure frame header is read successfully*/
-    if ((status = read_frame_header(self->bitstream,
-                                    &(self->streaminfo),
-                                    &frame_header)) != OK) {
+    if ((status = flacdec_read_frame_header(self->bitstream,
+                                            &(self->streaminfo),
+                                            &frame_header)) != OK) {
         self->bitstream->pop_callback(self->bitstream, NULL);
         self->bitstream->pop_callback(self->bitstream, NULL);
         PyErr_SetString(flac_exception(status), flac_strerror(status));
@@ -630,56 +645,12 @@ FlacDecoder_frame_size(decoders_FlacDecoder* self, PyObject *args)
     }
 
     /*skip subframes*/
-    switch (frame_header.channel_assignment) {
-    case INDEPENDENT:
-        for (c = 0; c < frame_header.channel_count; c++) {
-            if ((status = skip_subframe(self->bitstream,
-                                        frame_header.block_size,
-                                        frame_header.bits_per_sample)) != OK) {
-                self->bitstream->pop_callback(self->bitstream, NULL);
-                self->bitstream->pop_callback(self->bitstream, NULL);
-                PyErr_SetString(flac_exception(status), flac_strerror(status));
-                return NULL;
-            }
-        }
-        break;
-    case LEFT_DIFFERENCE:
-    case AVERAGE_DIFFERENCE:
-        if ((status = skip_subframe(self->bitstream,
-                                    frame_header.block_size,
-                                    frame_header.bits_per_sample)) != OK) {
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            return NULL;
-        }
-        if ((status = skip_subframe(self->bitstream,
-                                    frame_header.block_size,
-                                    frame_header.bits_per_sample + 1)) != OK) {
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            return NULL;
-        }
-        break;
-    case DIFFERENCE_RIGHT:
-        if ((status = skip_subframe(self->bitstream,
-                                    frame_header.block_size,
-                                    frame_header.bits_per_sample + 1)) != OK) {
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            return NULL;
-        }
-        if ((status = skip_subframe(self->bitstream,
-                                    frame_header.block_size,
-                                    frame_header.bits_per_sample)) != OK) {
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            self->bitstream->pop_callback(self->bitstream, NULL);
-            PyErr_SetString(flac_exception(status), flac_strerror(status));
-            return NULL;
-        }
-        break;
+    if ((status = flacdec_skip_subframes(self->bitstream,
+                                         &frame_header)) != OK) {
+        self->bitstream->pop_callback(self->bitstream, NULL);
+        self->bitstream->pop_callback(self->bitstream, NULL);
+        PyErr_SetString(flac_exception(status), flac_strerror(status));
+        return NULL;
     }
 
     /*validate CRC-16 in frame footer*/
@@ -766,6 +737,7 @@ FlacDecoder_seek(decoders_FlacDecoder* self, PyObject *args)
     /*reset stream's total remaining frames*/
     self->remaining_samples = (self->streaminfo.total_samples -
                                pcm_frames_offset);
+    frame_buffer_clear(&(self->buffer));
 
     if (pcm_frames_offset == 0) {
         /*if pcm_frames_offset is 0, reset MD5 validation*/
@@ -781,6 +753,142 @@ FlacDecoder_seek(decoders_FlacDecoder* self, PyObject *args)
 }
 #endif
 
+flac_status
+flacdec_read_header(BitstreamReader *r, struct flac_header *header)
+{
+    int streaminfo_read = 0;
+    int seektable_read = 0;
+    int vorbis_comment_read = 0;
+    unsigned last;
+
+    header->seektable.total_points = 0;
+    header->seektable.seek_points = NULL;
+    header->vendor_string = NULL;
+    header->total_comments = 0;
+    header->comments = NULL;
+    header->has_channel_mask = 0;
+    header->channel_mask = 0;
+    header->total_pictures = 0;
+    header->pictures = NULL;
+    header->total_blocks = 0;
+    header->blocks = NULL;
+    header->frames_offset = 4;
+
+    if (!setjmp(*br_try(r))) {
+        /*validate stream ID*/
+        if (!valid_stream_id(r)) {
+            br_etry(r);
+            return INVALID_STREAM_ID;
+        }
+
+        /*parse metadata blocks*/
+        do {
+            unsigned type;
+            unsigned size;
+            struct flac_block *block;
+
+            read_block_header(r, &last, &type, &size);
+
+            if (type > 6) {
+                br_etry(r);
+                return INVALID_BLOCK_ID;
+            }
+
+            header->blocks = realloc(header->blocks,
+                                     sizeof(struct flac_block) *
+                                     (header->total_blocks + 1));
+            block = &(header->blocks[header->total_blocks++]);
+            block->type = type;
+            block->offset = header->frames_offset;
+            block->size = size;
+            header->frames_offset += 4 + size;
+
+            switch (type) {
+            case 0: /*STREAMINFO*/
+                if (!streaminfo_read) {
+                    read_STREAMINFO(r, &(header->streaminfo));
+                    streaminfo_read = 1;
+                } else {
+                    r->skip_bytes(r, size);
+                }
+                break;
+            case 3: /*SEEKTABLE*/
+                if (!seektable_read) {
+                    read_SEEKTABLE(r, size, &(header->seektable));
+                    seektable_read = 1;
+                } else {
+                    r->skip_bytes(r, size);
+                }
+                break;
+            case 4: /*VORBIS_COMMENT*/
+                if (!vorbis_comment_read) {
+                    BitstreamReader *comment = r->substream(r, size);
+                    read_VORBIS_COMMENT(comment, header);
+                    comment->close(comment);
+                    vorbis_comment_read = 1;
+                } else {
+                    r->skip_bytes(r, size);
+                }
+                break;
+            case 6: /*PICTURE*/
+                {
+                    struct flac_picture picture;
+                    unsigned consumed;
+
+                    if (read_PICTURE(r, size, &consumed, &picture)) {
+                        picture.data_offset = block->offset + 4 + consumed;
+                        header->pictures =
+                            realloc(header->pictures,
+                                    sizeof(struct flac_picture) *
+                                    (header->total_pictures + 1));
+                        header->pictures[header->total_pictures++] = picture;
+                    }
+                    r->skip_bytes(r, size - consumed);
+                }
+                break;
+            default: /*PADDING, APPLICATION, CUESHEET*/
+                r->skip_bytes(r, size);
+                break;
+            }
+        } while (last == 0);
+
+        br_etry(r);
+    } else {
+        br_etry(r);
+        return IOERROR_METADATA;
+    }
+
+    return streaminfo_read ? OK : NO_STREAMINFO;
+}
+
+void
+flacdec_free_header(struct flac_header *header)
+{
+    unsigned i;
+
+    free(header->seektable.seek_points);
+    header->seektable.seek_points = NULL;
+    header->seektable.total_points = 0;
+    free(header->vendor_string);
+    header->vendor_string = NULL;
+    for (i = 0; i < header->total_comments; i++) {
+        free(header->comments[i]);
+    }
+    free(header->comments);
+    header->comments = NULL;
+    header->total_comments = 0;
+    for (i = 0; i < header->total_pictures; i++) {
+        free(header->pictures[i].mime_type);
+        free(header->pictures[i].description);
+    }
+    free(header->pictures);
+    header->pictures = NULL;
+    header->total_pictures = 0;
+    free(header->blocks);
+    header->blocks = NULL;
+    header->total_blocks = 0;
+}
+
 /************************************
  * private function implementations *
  ************************************/
@@ -837,981 +945,318 @@ read_SEEKTABLE(BitstreamReader *r,
     }
 }
 
-static void
-read_VORBIS_COMMENT(BitstreamReader *r, unsigned *channel_mask)
+static int
+read_PICTURE(BitstreamReader *r,
+             unsigned block_size,
+             unsigned *consumed,
+             struct flac_picture *picture)
 {
-    unsigned total_entries;
-    const char channel_mask_key[] = "WAVEFORMATEXTENSIBLE_CHANNEL_MASK=";
-    const size_t mask_key_len = strlen(channel_mask_key);
-    char channel_mask_entry[] = "WAVEFORMATEXTENSIBLE_CHANNEL_MASK=0x0000";
-    const size_t mask_entry_len = strlen(channel_mask_entry);
+    unsigned remaining = block_size;
+    unsigned mime_type_len;
+    unsigned description_len;
 
-    r->set_endianness(r, BS_LITTLE_ENDIAN);
+    *consumed = 0;
 
-    /*ignore vendor string*/
-    r->skip_bytes(r, r->read(r, 32));
-
-    for (total_entries = r->read(r, 32);
-         total_entries;
-         total_entries--) {
-        const unsigned entry_len = r->read(r, 32);
-        if ((entry_len > mask_key_len) && (entry_len <= mask_entry_len)) {
-            r->read_bytes(r, (uint8_t*)channel_mask_entry, entry_len);
-            channel_mask_entry[entry_len] = '\0';
-            if (strncmp(channel_mask_key,
-                        channel_mask_entry,
-                        mask_key_len) == 0) {
-                errno = 0;
-                const unsigned long mask =
-                    strtoul(channel_mask_entry + mask_key_len, NULL, 16);
-                if ((mask != 0) || (errno == 0)) {
-                    *channel_mask = (unsigned)mask;
-                }
-            }
-        } else {
-            r->skip_bytes(r, entry_len);
-        }
+    /*picture type and MIME type length*/
+    if (remaining < 8) {
+        return 0;
+    }
+    picture->type = r->read(r, 32);
+    mime_type_len = r->read(r, 32);
+    remaining -= 8;
+    *consumed += 8;
+
+    /*MIME type and description length*/
+    if ((mime_type_len > remaining) || ((remaining - mime_type_len) < 4)) {
+        return 0;
+    }
+    picture->mime_type = malloc(mime_type_len + 1);
+    r->read_bytes(r, (uint8_t*)picture->mime_type, mime_type_len);
+    picture->mime_type[mime_type_len] = '\0';
+    description_len = r->read(r, 32);
+    remaining -= mime_type_len + 4;
+    *consumed += mime_type_len + 4;
+
+    /*description and the remaining fixed-size fields*/
+    if ((description_len > remaining) ||
+        ((remaining - description_len) < 20)) {
+        free(picture->mime_type);
+        return 0;
+    }
+    picture->description = malloc(description_len + 1);
+    r->read_bytes(r, (uint8_t*)picture->description, description_len);
+    picture->description[description_len] = '\0';
+    picture->width = r->read(r, 32);
+    picture->height = r->read(r, 32);
+    picture->color_depth = r->read(r, 32);
+    picture->color_count = r->read(r, 32);
+    picture->data_length = r->read(r, 32);
+    remaining -= description_len + 20;
+    *consumed += description_len + 20;
+
+    if (picture->data_length > remaining) {
+        free(picture->mime_type);
+        free(picture->description);
+        return 0;
+    } else {
+        return 1;
     }
-
-    r->set_endianness(r, BS_BIG_ENDIAN);
 }
 
-static status_t
-read_frame_header(BitstreamReader *r,
-                  const struct STREAMINFO *streaminfo,
-                  struct frame_header *frame_header)
+static int
+read_VORBIS_COMMENT(BitstreamReader *r, struct flac_header *header)
 {
-    uint8_t crc8 = 0;
-    unsigned encoded_block_size;
-    unsigned encoded_sample_rate;
-    unsigned encoded_channels;
-    unsigned encoded_bps;
+    const char channel_mask_key[] = "WAVEFORMATEXTENSIBLE_CHANNEL_MASK=";
+    const size_t mask_key_len = strlen(channel_mask_key);
+    /*only the first channel mask entry counts, as with VorbisComment*/
+    int mask_entry_found = 0;
 
-    if (!setjmp(*br_try(r))) {
-        status_t status;
+    r->set_endianness(r, BS_LITTLE_ENDIAN);
 
-        r->add_callback(r, (bs_callback_f)flac_crc8, &crc8);
-        if (r->read(r, 14) != 0x3FFE) {
-            br_etry(r);
-            return INVALID_SYNC_CODE;
-        }
-        r->skip(r, 1);
-        frame_header->blocking_strategy = r->read(r, 1);
-        encoded_block_size = r->read(r, 4);
-        encoded_sample_rate = r->read(r, 4);
-        encoded_channels = r->read(r, 4);
-        encoded_bps = r->read(r, 3);
-        r->skip(r, 1);
-        if ((status = read_utf8(r, &(frame_header->frame_number))) != OK) {
-            br_etry(r);
-            return status;
-        }
+    if (!setjmp(*br_try(r))) {
+        unsigned length = r->read(r, 32);
+        unsigned total_entries;
 
-        switch (encoded_block_size) {
-        case 0:
-        default:
-            frame_header->block_size = streaminfo->maximum_block_size;
-            break;
-        case 1: frame_header->block_size = 192; break;
-        case 2: frame_header->block_size = 576; break;
-        case 3: frame_header->block_size = 1152; break;
-        case 4: frame_header->block_size = 2304; break;
-        case 5: frame_header->block_size = 4608; break;
-        case 6: frame_header->block_size = r->read(r, 8) + 1; break;
-        case 7: frame_header->block_size = r->read(r, 16) + 1; break;
-        case 8: frame_header->block_size = 256; break;
-        case 9: frame_header->block_size = 512; break;
-        case 10: frame_header->block_size = 1024; break;
-        case 11: frame_header->block_size = 2048; break;
-        case 12: frame_header->block_size = 4096; break;
-        case 13: frame_header->block_size = 8192; break;
-        case 14: frame_header->block_size = 16384; break;
-        case 15: frame_header->block_size = 32768; break;
-        }
-        if (frame_header->block_size > streaminfo->maximum_block_size) {
-            br_etry(r);
-            return BLOCK_SIZE_MISMATCH;
+        /*check lengths against what remains of the block
+          before allocating space for them*/
+        if (length > r->size(r)) {
+            br_abort(r);
         }
+        header->vendor_string = malloc(length + 1);
+        r->read_bytes(r, (uint8_t*)header->vendor_string, length);
+        header->vendor_string[length] = '\0';
 
-        switch (encoded_sample_rate) {
-        case 0:
-        default:
-            frame_header->sample_rate = streaminfo->sample_rate;
-            break;
-        case 1: frame_header->sample_rate = 88200; break;
-        case 2: frame_header->sample_rate = 176400; break;
-        case 3: frame_header->sample_rate = 192000; break;
-        case 4: frame_header->sample_rate = 8000; break;
-        case 5: frame_header->sample_rate = 16000; break;
-        case 6: frame_header->sample_rate = 22050; break;
-        case 7: frame_header->sample_rate = 24000; break;
-        case 8: frame_header->sample_rate = 32000; break;
-        case 9: frame_header->sample_rate = 44100; break;
-        case 10: frame_header->sample_rate = 48000; break;
-        case 11: frame_header->sample_rate = 96000; break;
-        case 12: frame_header->sample_rate = r->read(r, 8) * 1000; break;
-        case 13: frame_header->sample_rate = r->read(r, 16); break;
-        case 14: frame_header->sample_rate = r->read(r, 16) * 10; break;
-        case 15:
-            br_etry(r);
-            return INVALID_SAMPLE_RATE;
-        }
-        if (frame_header->sample_rate != streaminfo->sample_rate) {
-            br_etry(r);
-            return SAMPLE_RATE_MISMATCH;
+        total_entries = r->read(r, 32);
+        if (total_entries > (r->size(r) / 4)) {
+            br_abort(r);
         }
+        header->comments = malloc(sizeof(char*) * total_entries);
 
-        switch (encoded_bps) {
-        case 0:
-        default:
-            frame_header->bits_per_sample = streaminfo->bits_per_sample;
-            break;
-        case 1: frame_header->bits_per_sample = 8; break;
-        case 2: frame_header->bits_per_sample = 12; break;
-        case 4: frame_header->bits_per_sample = 16; break;
-        case 5: frame_header->bits_per_sample = 20; break;
-        case 6: frame_header->bits_per_sample = 24; break;
-        case 3:
-        case 7:
-            br_etry(r);
-            return INVALID_BPS;
-        }
-        if (frame_header->bits_per_sample != streaminfo->bits_per_sample) {
-            br_etry(r);
-            return BPS_MISMATCH;
-        }
+        while (header->total_comments < total_entries) {
+            char *entry;
 
-        switch (encoded_channels) {
-        case 0:
-        case 1:
-        case 2:
-        case 3:
-        case 4:
-        case 5:
-        case 6:
-        case 7:
-            frame_header->channel_assignment = INDEPENDENT;
-            frame_header->channel_count = encoded_channels + 1;
-            break;
-        case 8:
-            frame_header->channel_assignment = LEFT_DIFFERENCE;
-            frame_header->channel_count = 2;
-            break;
-        case 9:
-            frame_header->channel_assignment = DIFFERENCE_RIGHT;
-            frame_header->channel_count = 2;
-            break;
-        case 10:
-            frame_header->channel_assignment = AVERAGE_DIFFERENCE;
-            frame_header->channel_count = 2;
-            break;
-        default:
-            br_etry(r);
-            return INVALID_CHANNEL_ASSIGNMENT;
-        }
-        if (frame_header->channel_count != streaminfo->channel_count) {
-            br_etry(r);
-            return CHANNEL_COUNT_MISMATCH;
+            if ((length = r->read(r, 32)) > r->size(r)) {
+                br_abort(r);
+            }
+            entry = malloc(length + 1);
+            header->comments[header->total_comments++] = entry;
+            r->read_bytes(r, (uint8_t*)entry, length);
+            entry[length] = '\0';
+
+            if ((!mask_entry_found) &&
+                (length > mask_key_len) &&
+                (strncasecmp(entry, channel_mask_key, mask_key_len) == 0)) {
+                const char *value = entry + mask_key_len;
+                char *end;
+                unsigned long mask;
+
+                mask_entry_found = 1;
+                errno = 0;
+                /*strtoul skips whitespace and accepts a sign,
+                  neither of which belong in a mask*/
+                mask = strtoul(value, &end, 16);
+                if (isxdigit((unsigned char)value[0]) &&
+                    (errno == 0) && (*end == '\0')) {
+                    header->has_channel_mask = 1;
+                    header->channel_mask = (unsigned)mask;
+                }
+            }
         }
 
-        r->skip(r, 8); /*CRC-8*/
         br_etry(r);
-        r->pop_callback(r, NULL);
-        if (crc8) {
-            return INVALID_CRC8;
-        } else {
-            return OK;
-        }
+        r->set_endianness(r, BS_BIG_ENDIAN);
+        return 1;
     } else {
-        br_etry(r);
-        return IOERROR_HEADER;
-    }
-}
-
-static status_t
-read_utf8(BitstreamReader *r, unsigned *utf8)
-{
-    const unsigned count = r->read_unary(r, 0);
-    unsigned i;
-    *utf8 = r->read(r, 7 - count);
-    if (count > 0) {
-        for (i = 0; i < (count - 1); i++) {
-            if (r->read(r, 2) == 2) {
-                *utf8 = (*utf8 << 8) | (r->read(r, 6));
-            } else {
-                return INVALID_UTF8;
-            }
-        }
-    }
-    return OK;
-}
-
-static decode_f
-get_decoder(channel_assignment_t channel_assignment)
-{
-    switch (channel_assignment) {
-    case INDEPENDENT:
-        return decode_independent;
-    case LEFT_DIFFERENCE:
-        return decode_left_difference;
-    case DIFFERENCE_RIGHT:
-        return decode_difference_right;
-    case AVERAGE_DIFFERENCE:
-        return decode_average_difference;
-    }
-
-    /*shouldn't get here*/
-    return NULL;
-}
+        unsigned i;
 
-static status_t
-decode_independent(BitstreamReader *r,
-                   const struct frame_header *frame_header,
-                   int samples[])
-{
-    unsigned c;
-    status_t status;
-    for (c = 0; c < frame_header->channel_count; c++) {
-        int channel_data[frame_header->block_size];
-        if ((status = read_subframe(r,
-                                    frame_header->block_size,
-                                    frame_header->bits_per_sample,
-                                    channel_data)) != OK) {
-            return status;
-        } else {
-            put_channel_data(samples,
-                             c,
-                             frame_header->channel_count,
-                             frame_header->block_size,
-                             channel_data);
+        br_etry(r);
+        r->set_endianness(r, BS_BIG_ENDIAN);
+        for (i = 0; i < header->total_comments; i++) {
+            free(header->comments[i]);
         }
+        free(header->comments);
+        free(header->vendor_string);
+        header->vendor_string = NULL;
+        header->total_comments = 0;
+        header->comments = NULL;
+        header->has_channel_mask = 0;
+        header->channel_mask = 0;
+        return 0;
     }
-
-    return OK;
-}
-
-static status_t
-decode_left_difference(BitstreamReader *r,
-                       const struct frame_header *frame_header,
-                       int samples[])
-{
-    status_t status;
-    int left_data[frame_header->block_size];
-    int difference_data[frame_header->block_size];
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample,
-                                left_data)) != OK) {
-        return status;
-    }
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample + 1,
-                                difference_data)) != OK) {
-        return status;
-    }
-
-    decorrelate_left_difference(frame_header->block_size,
-                                left_data,
-                                difference_data,
-                                samples);
-
-    return OK;
 }
 
-static status_t
-decode_difference_right(BitstreamReader *r,
-                        const struct frame_header *frame_header,
-                        int samples[])
+#ifndef STANDALONE
+static unsigned
+default_channel_mask(unsigned channel_count)
 {
-    status_t status;
-    int difference_data[frame_header->block_size];
-    int right_data[frame_header->block_size];
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample + 1,
-                                difference_data)) != OK) {
-        return status;
-    }
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample,
-                                right_data)) != OK) {
-        return status;
+    const static unsigned fL  = 0x1;
+    const static unsigned fR  = 0x2;
+    const static unsigned fC  = 0x4;
+    const static unsigned LFE = 0x8;
+    const static unsigned bL  = 0x10;
+    const static unsigned bR  = 0x20;
+    const static unsigned bC  = 0x100;
+    const static unsigned sL  = 0x200;
+    const static unsigned sR  = 0x400;
+
+    switch (channel_count) {
+    case 1:
+        return fC;
+    case 2:
+        return fL | fR;
+    case 3:
+        return fL | fR | fC;
+    case 4:
+        return fL | fR | bL | bR;
+    case 5:
+        return fL | fR | fC | bL | bR;
+    case 6:
+        return fL | fR | fC | bL | bR | LFE;
+    case 7:
+        return fL | fR | fC | LFE | bC | sL | sR;
+    case 8:
+        return fL | fR | fC | LFE | bL | bR | sL | sR;
+    default:
+        return 0;
     }
-
-    decorrelate_difference_right(frame_header->block_size,
-                                 difference_data,
-                                 right_data,
-                                 samples);
-
-    return OK;
 }
 
-static status_t
-decode_average_difference(BitstreamReader *r,
-                          const struct frame_header *frame_header,
-                          int samples[])
+static int
+seek_to_frames(BitstreamReader *r, const struct flac_header *header)
 {
-    status_t status;
-    int average_data[frame_header->block_size];
-    int difference_data[frame_header->block_size];
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample,
-                                average_data)) != OK) {
-        return status;
-    }
-
-    if ((status = read_subframe(r,
-                                frame_header->block_size,
-                                frame_header->bits_per_sample + 1,
-                                difference_data)) != OK) {
-        return status;
-    }
+    br_pos_t *start;
+    int found;
 
-    decorrelate_average_difference(frame_header->block_size,
-                                   average_data,
-                                   difference_data,
-                                   samples);
-
-    return OK;
-}
-
-static status_t
-read_subframe(BitstreamReader *r,
-              unsigned block_size,
-              unsigned bits_per_sample,
-              int channel_data[])
-{
     if (!setjmp(*br_try(r))) {
-        subframe_type_t type;
-        unsigned order;
-        unsigned wasted_bps;
-        status_t status;
-
-        if ((status =
-             read_subframe_header(r, &type, &order, &wasted_bps)) != OK) {
-            br_etry(r);
-            return status;
-        } else {
-            const unsigned effective_bps = bits_per_sample - wasted_bps;
-
-            if (wasted_bps >= bits_per_sample) {
-                br_etry(r);
-                return INVALID_WASTED_BPS;
-            }
-
-            switch (type) {
-            case CONSTANT:
-                read_CONSTANT_subframe(r,
-                                       block_size,
-                                       effective_bps,
-                                       channel_data);
-                break;
-            case VERBATIM:
-                read_VERBATIM_subframe(r,
-                                       block_size,
-                                       effective_bps,
-                                       channel_data);
-                break;
-            case FIXED:
-                if ((status =
-                     read_FIXED_subframe(r,
-                                         block_size,
-                                         effective_bps,
-                                         order,
-                                         channel_data)) != OK) {
-                    br_etry(r);
-                    return status;
-                }
-                break;
-            case LPC:
-                if ((status =
-                     read_LPC_subframe(r,
-                                       block_size,
-                                       effective_bps,
-                                       order,
-                                       channel_data)) != OK) {
-                    br_etry(r);
-                    return status;
-                }
-                break;
-            }
-            br_etry(r);
-            if (wasted_bps) {
-                unsigned i;
-                for (i = 0; i < block_size; i++) {
-                    channel_data[i] <<= wasted_bps;
-                }
-            }
-            return OK;
-        }
-    } else {
+        start = r->getpos(r);
         br_etry(r);
-        return IOERROR_SUBFRAME;
-    }
-}
-
-static status_t
-read_subframe_header(BitstreamReader *r,
-                     subframe_type_t *type,
-                     unsigned *order,
-                     unsigned *wasted_bps)
-{
-    unsigned type_and_order;
-    unsigned has_wasted_bps;
-
-    r->skip(r, 1);
-    type_and_order = r->read(r, 6);
-    has_wasted_bps = r->read(r, 1);
-    if (has_wasted_bps) {
-        *wasted_bps = r->read_unary(r, 1) + 1;
-    } else {
-        *wasted_bps = 0;
-    }
-    if (type_and_order == 0) {
-        *type = CONSTANT;
-        return OK;
-    } else if (type_and_order == 1) {
-        *type = VERBATIM;
-        return OK;
-    } else if ((8 <= type_and_order) && (type_and_order <= 12)) {
-        *type = FIXED;
-        *order = type_and_order - 8;
-        return OK;
-    } else if ((32 <= type_and_order) && (type_and_order <= 63)) {
-        *type = LPC;
-        *order = type_and_order - 31;
-        return OK;
     } else {
-        return INVALID_SUBFRAME_HEADER;
-    }
-}
-
-static void
-read_CONSTANT_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample,
-                       int channel_data[])
-{
-    const int constant = r->read_signed(r, bits_per_sample);
-    for (; block_size; block_size--) {
-        channel_data[0] = constant;
-        channel_data += 1;
-    }
-}
-
-static void
-read_VERBATIM_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample,
-                       int channel_data[])
-{
-    for (; block_size; block_size--) {
-        channel_data[0] = r->read_signed(r, bits_per_sample);
-        channel_data += 1;
-    }
-}
-
-static status_t
-read_FIXED_subframe(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned bits_per_sample,
-                    unsigned predictor_order,
-                    int channel_data[])
-{
-    if ((predictor_order > 4) || (predictor_order > block_size)) {
-        return INVALID_FIXED_ORDER;
-    } else {
-        unsigned i;
-        int residuals[block_size - predictor_order];
-        status_t status;
-
-        /*warm-up samples*/
-        for (i = 0; i < predictor_order; i++) {
-            channel_data[i] = r->read_signed(r, bits_per_sample);
-        }
-
-        /*residuals*/
-        if ((status = read_residual_block(r,
-                                          block_size,
-                                          predictor_order,
-                                          residuals)) != OK) {
-            return status;
-        }
-
-        switch (predictor_order) {
-        case 0:
-            for (i = 0; i < block_size; i++) {
-                channel_data[i] = residuals[i];
-            }
-            return OK;
-        case 1:
-            for (i = 1; i < block_size; i++) {
-                channel_data[i] = channel_data[i - 1] + residuals[i - 1];
-            }
-            return OK;
-        case 2:
-            for (i = 2; i < block_size; i++) {
-                channel_data[i] = (2 * channel_data[i - 1]) -
-                                  channel_data[i - 2] +
-                                  residuals[i - 2];
-            }
-            return OK;
-        case 3:
-            for (i = 3; i < block_size; i++) {
-                channel_data[i] = (3 * channel_data[i - 1]) -
-                                  (3 * channel_data[i - 2]) +
-                                  channel_data[i - 3] +
-                                  residuals[i - 3];
-            }
-            return OK;
-        case 4:
-            for (i = 4; i < block_size; i++) {
-                channel_data[i] = (4 * channel_data[i - 1]) -
-                                  (6 * channel_data[i - 2]) +
-                                  (4 * channel_data[i - 3]) -
-                                  channel_data[i - 4] +
-                                  residuals[i - 4];
-            }
-            return OK;
-        default:
-            return INVALID_FIXED_ORDER;
-        }
+        br_etry(r);
+        return 0;
     }
-}
 
-static status_t
-read_LPC_subframe(BitstreamReader *r,
-                  unsigned block_size,
-                  unsigned bits_per_sample,
-                  unsigned predictor_order,
-                  int channel_data[])
-{
-    if (predictor_order > block_size) {
-        return INVALID_LPC_ORDER;
-    } else {
-        unsigned i;
-        unsigned precision;
-        int shift;
-        int coefficient[predictor_order];
-        int residuals[block_size - predictor_order];
-        status_t status;
-
-        /*warm-up samples*/
-        for (i = 0; i < predictor_order; i++) {
-            channel_data[i] = r->read_signed(r, bits_per_sample);
-        }
-
-        precision = r->read(r, 4) + 1;
-        shift = r->read_signed(r, 5);
-        if (shift < 0) {
-            shift = 0;
-        }
+    if (!setjmp(*br_try(r))) {
+        skip_metadata(r, header);
 
-        /*coefficients*/
-        for (i = 0; i < predictor_order; i++) {
-            coefficient[i] = r->read_signed(r, precision);
-        }
+        /*only a stream without samples may have no frames,
+          but a stream of unknown length may have samples
+          so check for frames either way*/
+        found = frame_sync_follows(
+            r, header->streaminfo.total_samples == 0);
 
-        if ((status = read_residual_block(r,
-                                          block_size,
-                                          predictor_order,
-                                          residuals)) != OK) {
-            return status;
-        }
-
-        for (i = predictor_order; i < block_size; i++) {
-            register int64_t sum = 0;
-            unsigned j;
-            for (j = 0; j < predictor_order; j++) {
-                sum += (int64_t)coefficient[j] *
-                       (int64_t)channel_data[i - j - 1];
-            }
-            sum >>= shift;
-            channel_data[i] = (int)sum + residuals[i - predictor_order];
+        r->setpos(r, start);
+        if (found) {
+            skip_metadata(r, header);
         }
-
-        return OK;
-    }
-}
-
-static status_t
-read_residual_block(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned predictor_order,
-                    int residuals[])
-{
-    br_read_f read = r->read;
-    br_read_unary_f read_unary = r->read_unary;
-    const unsigned coding_method = read(r, 2);
-    const unsigned partition_order = read(r, 4);
-    const unsigned partition_count = 1 << partition_order;
-    unsigned rice_bits;
-    unsigned i = 0;
-    unsigned p;
-
-    if (coding_method == 0) {
-        rice_bits = 4;
-    } else if (coding_method == 1) {
-        rice_bits = 5;
+        br_etry(r);
     } else {
-        return INVALID_CODING_METHOD;
-    }
-
-    if ((block_size % partition_count) ||
-        (predictor_order > (block_size / partition_count))) {
-        return INVALID_PARTITION_ORDER;
-    }
+        br_etry(r);
+        found = 0;
 
-    for (p = 0; p < partition_count; p++) {
-        const unsigned rice = read(r, rice_bits);
-        const unsigned partition_size = block_size / partition_count -
-                                        (p == 0 ? predictor_order : 0);
-        register unsigned j;
-        if (((coding_method == 0) && (rice == 15)) ||
-            ((coding_method == 1) && (rice == 31))) {
-            const unsigned escape_code = read(r, 5);
-            br_read_signed_f read_signed = r->read_signed;
-            for (j = 0; j < partition_size; j++) {
-                residuals[i++] = read_signed(r, escape_code);
-            }
-        } else {
-            for (j = 0; j < partition_size; j++) {
-                const unsigned MSB = read_unary(r, 1);
-                const unsigned LSB = read(r, rice);
-                const unsigned unsigned_ = (MSB << rice) | LSB;
-                residuals[i++] = (unsigned_ % 2) ?
-                                 (-(unsigned_ >> 1) - 1) :
-                                 (unsigned_ >> 1);
-            }
+        /*if this fails, the full parse will report the I/O error*/
+        if (!setjmp(*br_try(r))) {
+            r->setpos(r, start);
         }
+        br_etry(r);
     }
 
-    return OK;
+    start->del(start);
+    return found;
 }
 
-static status_t
-read_crc16(BitstreamReader *r)
+static int
+frame_sync_follows(BitstreamReader *r, int may_be_empty)
 {
+    unsigned first_byte;
+
     if (!setjmp(*br_try(r))) {
-        r->byte_align(r);
-        r->skip(r, 16);
+        first_byte = r->read(r, 8);
         br_etry(r);
-        return OK;
     } else {
         br_etry(r);
-        return IOERROR_CRC16;
+        return may_be_empty;
     }
-}
 
-static void
-decorrelate_left_difference(unsigned block_size,
-                            const int left[],
-                            const int difference[],
-                            int samples[])
-{
-    for (; block_size; block_size--) {
-        /*samples[0] = left[0];*/
-        /*samples[1] = left[0] - difference[0];*/
-        samples[1] = (samples[0] = left[0]) - difference[0];
-        left += 1;
-        difference += 1;
-        samples += 2;
-    }
+    /*a frame cut short is caught by the caller's try*/
+    return (((first_byte << 6) | r->read(r, 6)) == 0x3FFE);
 }
 
 static void
-decorrelate_difference_right(unsigned block_size,
-                             const int difference[],
-                             const int right[],
-                             int samples[])
+skip_metadata(BitstreamReader *r, const struct flac_header *header)
 {
-    for (; block_size; block_size--) {
-        /*samples[0] = difference[0] + right[0];*/
-        /*samples[1] = right[0];*/
-        samples[0] = difference[0] + (samples[1] = right[0]);
-        difference += 1;
-        right += 1;
-        samples += 2;
+    uint64_t offset = header->frames_offset;
+
+    while (offset) {
+        /*perform this in chunks in case the metadata
+          is longer than a "long" taken by fseek*/
+        const uint64_t seek = MIN(offset, LONG_MAX);
+        r->seek(r, (long)seek, BS_SEEK_CUR);
+        offset -= seek;
     }
 }
 
-static void
-decorrelate_average_difference(unsigned block_size,
-                               const int average[],
-                               const int difference[],
-                               int samples[])
-{
-    for (; block_size; block_size--) {
-        const int sum = (average[0] * 2) + (abs(difference[0]) % 2);
-        samples[0] = (sum + difference[0]) >> 1;
-        samples[1] = (sum - difference[0]) >> 1;
-        average += 1;
-        difference += 1;
-        samples += 2;
-    }
-}
-
-static status_t
-skip_subframe(BitstreamReader *r,
-              unsigned block_size,
-              unsigned bits_per_sample)
+static int
+setup_decoder(decoders_FlacDecoder *self, const struct flac_header *header)
 {
-    if (!setjmp(*br_try(r))) {
-        subframe_type_t type;
-        unsigned order;
-        unsigned wasted_bps;
-        status_t status;
+    unsigned streaminfos = 0;
+    unsigned seektables = 0;
+    unsigned vorbis_comments = 0;
+    unsigned i;
 
-        if ((status =
-             read_subframe_header(r, &type, &order, &wasted_bps)) != OK) {
-            br_etry(r);
-            return status;
-        } else {
-            const unsigned effective_bps = bits_per_sample - wasted_bps;
-            switch (type) {
-            case CONSTANT:
-                skip_CONSTANT_subframe(r, effective_bps);
-                break;
-            case VERBATIM:
-                skip_VERBATIM_subframe(r, block_size, effective_bps);
-                break;
-            case FIXED:
-                if ((status =
-                     skip_FIXED_subframe(r,
-                                         block_size,
-                                         effective_bps,
-                                         order)) != OK) {
-                    return status;
-                }
-                break;
-            case LPC:
-                if ((status =
-                     skip_LPC_subframe(r,
-                                       block_size,
-                                       effective_bps,
-                                       order)) != OK) {
-                    return status;
-                }
-                break;
-            }
-            br_etry(r);
-            return OK;
+    for (i = 0; i < header->total_blocks; i++) {
+        switch (header->blocks[i].type) {
+        case 0:
+            streaminfos++;
+            break;
+        case 3:
+            seektables++;
+            break;
+        case 4:
+            vorbis_comments++;
+            break;
         }
-    } else {
-        br_etry(r);
-        return IOERROR_SUBFRAME;
     }
-}
-
-static void
-skip_CONSTANT_subframe(BitstreamReader *r,
-                       unsigned bits_per_sample)
-{
-    r->skip(r, bits_per_sample);
-}
-
-static void
-skip_VERBATIM_subframe(BitstreamReader *r,
-                       unsigned block_size,
-                       unsigned bits_per_sample)
-{
-    r->skip(r, block_size * bits_per_sample);
-}
 
-static status_t
-skip_FIXED_subframe(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned bits_per_sample,
-                    unsigned predictor_order)
-{
-    if ((predictor_order > 4) || (predictor_order > block_size)) {
-        return INVALID_FIXED_ORDER;
-    } else {
-        /*warm-up samples*/
-        r->skip(r, predictor_order * bits_per_sample);
-        return skip_residual_block(r, block_size, predictor_order);
-    }
-}
-
-static status_t
-skip_LPC_subframe(BitstreamReader *r,
-                  unsigned block_size,
-                  unsigned bits_per_sample,
-                  unsigned predictor_order)
-{
-    if (predictor_order >= block_size) {
-        return INVALID_LPC_ORDER;
-    } else {
-        unsigned precision;
-
-        /*warm-up samples*/
-        r->skip(r, predictor_order * bits_per_sample);
-        precision = r->read(r, 4) + 1;
-        r->skip(r, 5);
-        /*coefficients*/
-        r->skip(r, predictor_order * precision);
-        return skip_residual_block(r, block_size, predictor_order);
+    if (streaminfos > 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "multiple STREAMINFO blocks in stream");
+        return -1;
+    } else if (seektables > 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "multiple SEEKTABLE blocks in stream");
+        return -1;
+    } else if (vorbis_comments > 1) {
+        PyErr_SetString(PyExc_ValueError,
+                        "multiple VORBIS_COMMENT blocks in stream");
+        return -1;
     }
-}
 
-static status_t
-skip_residual_block(BitstreamReader *r,
-                    unsigned block_size,
-                    unsigned predictor_order)
-{
-    br_skip_f skip = r->skip;
-    br_skip_unary_f skip_unary = r->skip_unary;
-    const unsigned coding_method = r->read(r, 2);
-    const unsigned partition_order = r->read(r, 4);
-    const unsigned partition_count = 1 << partition_order;
-    unsigned rice_bits;
-    unsigned p;
-
-    if (coding_method == 0) {
-        rice_bits = 4;
-    } else if (coding_method == 1) {
-        rice_bits = 5;
-    } else {
-        return INVALID_CODING_METHOD;
-    }
+    self->streaminfo = header->streaminfo;
 
-    for (p = 0; p < partition_count; p++) {
-        const unsigned rice = r->read(r, rice_bits);
-        const unsigned partition_size = block_size / partition_count -
-                                        (p == 0 ? predictor_order : 0);
-        register unsigned j;
-        if (((coding_method == 0) && (rice == 15)) ||
-            ((coding_method == 1) && (rice == 31))) {
-            const unsigned escape_code = r->read(r, 5);
-            r->skip(r, partition_size * escape_code);
-        } else {
-            for (j = 0; j < partition_size; j++) {
-                skip_unary(r, 1);
-                skip(r, rice);
-            }
-        }
+    if (header->seektable.total_points) {
+        self->seektable.total_points = header->seektable.total_points;
+        self->seektable.seek_points =
+            malloc(sizeof(struct SEEKPOINT) * header->seektable.total_points);
+        memcpy(self->seektable.seek_points,
+               header->seektable.seek_points,
+               sizeof(struct SEEKPOINT) * header->seektable.total_points);
     }
 
-    return OK;
-
-}
-
-static void
-update_md5sum(audiotools__MD5Context *md5sum,
-              const int pcm_data[],
-              unsigned channels,
-              unsigned bits_per_sample,
-              unsigned pcm_frames)
-{
-    const unsigned total_samples = pcm_frames * channels;
-    const unsigned buffer_size = total_samples * (bits_per_sample / 8);
-    unsigned char buffer[buffer_size];
+    self->channel_mask = header->has_channel_mask ?
+        header->channel_mask :
+        default_channel_mask(self->streaminfo.channel_count);
 
-    int_to_pcm_converter(bits_per_sample, 0, 1)(total_samples,
-                                                pcm_data,
-                                                buffer);
+    /*turn off MD5 checking if MD5 sum is empty*/
+    if (memcmp(self->streaminfo.MD5, empty_md5, 16) == 0) {
+        self->perform_validation = 0;
+    }
 
-    audiotools__MD5Update(md5sum, buffer, buffer_size);
-}
+    self->remaining_samples = self->streaminfo.total_samples;
 
-static int
-verify_md5sum(audiotools__MD5Context *stream_md5,
-              const uint8_t streaminfo_md5[])
-{
-    unsigned char digest[16];
-    audiotools__MD5Final(digest, stream_md5);
-    return (memcmp(digest, streaminfo_md5, 16) == 0);
-}
-
-#ifndef STANDALONE
-PyObject*
-flac_exception(status_t status)
-{
-    switch (status) {
-    case OK:
-    default:
-    case INVALID_SYNC_CODE:
-    case INVALID_SAMPLE_RATE:
-    case INVALID_BPS:
-    case INVALID_CHANNEL_ASSIGNMENT:
-    case INVALID_UTF8:
-    case INVALID_CRC8:
-    case INVALID_SUBFRAME_HEADER:
-    case INVALID_FIXED_ORDER:
-    case INVALID_LPC_ORDER:
-    case INVALID_CODING_METHOD:
-    case INVALID_WASTED_BPS:
-    case INVALID_PARTITION_ORDER:
-    case BLOCK_SIZE_MISMATCH:
-    case SAMPLE_RATE_MISMATCH:
-    case BPS_MISMATCH:
-    case CHANNEL_COUNT_MISMATCH:
-        return PyExc_ValueError;
-    case IOERROR_HEADER:
-    case IOERROR_SUBFRAME:
-    case IOERROR_CRC16:
-        return PyExc_IOError;
-    }
+    return 0;
 }
 #endif
 
-const char*
-flac_strerror(status_t status)
-{
-    switch (status) {
-    default:
-        return "undefined error";
-    case OK:
-        return "OK";
-    case INVALID_SYNC_CODE:
-        return "invalid sync code in frame header";
-    case INVALID_SAMPLE_RATE:
-        return "invalid sample rate in frame header";
-    case INVALID_BPS:
-        return "invalid bits-per-sample in frame header";
-    case INVALID_CHANNEL_ASSIGNMENT:
-        return "invalid channel assignment in frame header";
-    case INVALID_UTF8:
-        return "invalid UTF-8 value in frame header";
-    case INVALID_CRC8:
-        return "invalid CRC-8 in frame header";
-    case IOERROR_HEADER:
-        return "I/O error reading frame header";
-    case IOERROR_SUBFRAME:
-        return "I/O error reading subframe data";
-    case IOERROR_CRC16:
-        return "I/O error reading CRC-16";
-    case INVALID_SUBFRAME_HEADER:
-        return "invalid subframe header";
-    case INVALID_FIXED_ORDER:
-        return "invalid FIXED subframe order";
-    case INVALID_LPC_ORDER:
-        return "invalid LPC subframe order";
-    case INVALID_CODING_METHOD:
-        return "invalid coding method";
-    case INVALID_WASTED_BPS:
-        return "invalid wasted BPS in subframe header";
-    case INVALID_PARTITION_ORDER:
-        return "invalid residual partition order";
-    case BLOCK_SIZE_MISMATCH:
-        return "frame header block size larger than maximum";
-    case SAMPLE_RATE_MISMATCH:
-        return "frame header sample rate mismatch";
-    case BPS_MISMATCH:
-        return "frame header bits-per-sample mismatch";
-    case CHANNEL_COUNT_MISMATCH:
-        return "frame header channel count mismatch";
-    }
-}
-
 /*******************************
  * main function for debugging *
  *******************************/
@@ -1840,43 +1285,18 @@ main(int argc, char *argv[])
         input = br_open(flac, BS_BIG_ENDIAN);
     }
 
-    if (!setjmp(*br_try(input))) {
-        unsigned last;
-        unsigned type;
-        unsigned size;
-        int streaminfo_read = 0;
-
-        /*ensure 4 byte stream ID is valid*/
-        if (!valid_stream_id(input)) {
-            fputs("*** Error: invalid stream ID\n", stderr);
-            br_etry(input);
-            goto error;
-        }
+    /*read metadata blocks*/
+    {
+        struct flac_header header;
+        const flac_status status = flacdec_read_header(input, &header);
 
-        /*read metadata blocks*/
-        do {
-            read_block_header(input, &last, &type, &size);
-            if (type == 0) {
-                if (!streaminfo_read) {
-                    read_STREAMINFO(input, &streaminfo);
-                    streaminfo_read = 1;
-                }
-            } else {
-                input->skip_bytes(input, size);
-            }
-        } while (!last);
-
-        br_etry(input);
-
-        /*ensure STREAMINFO has been read*/
-        if (!streaminfo_read) {
-            fputs("*** Error: no STREAMINFO block in stream\n", stderr);
+        if (status != OK) {
+            fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
+            flacdec_free_header(&header);
             goto error;
         }
-    } else {
-        fputs("*** Error: I/O error reading metadata\n", stderr);
-        br_etry(input);
-        goto error;
+        streaminfo = header.streaminfo;
+        flacdec_free_header(&header);
     }
 
     /*perform stream initialization*/
@@ -1886,15 +1306,17 @@ main(int argc, char *argv[])
 
     /*while samples remain*/
     while (total_samples) {
-        struct frame_header frame_header;
-        status_t status;
+        struct flac_frame_header frame_header;
+        flac_status status;
         uint16_t crc16 = 0;
 
         input->add_callback(input, (bs_callback_f)flac_crc16, &crc16);
 
         /*read header*/
         if ((status =
-             read_frame_header(input, &streaminfo, &frame_header)) != OK) {
+             flacdec_read_frame_header(input,
+                                       &streaminfo,
+                                       &frame_header)) != OK) {
             fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
             input->pop_callback(input, NULL);
             goto error;
@@ -1904,22 +1326,22 @@ main(int argc, char *argv[])
                                           frame_header.block_size;
 
             int samples[sample_count];
+            int pcm_data[sample_count];
 
             unsigned char pcm_samples[sample_count *
                                       (frame_header.bits_per_sample / 8)];
 
             /*decode subframes based on channel assignment*/
-            decode_f decode = get_decoder(frame_header.channel_assignment);
-            assert(decode);
-
-            if ((status = decode(input, &frame_header, samples)) != OK) {
+            if ((status = flacdec_decode_subframes(input,
+                                                   &frame_header,
+                                                   samples)) != OK) {
                 fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
                 input->pop_callback(input, NULL);
                 goto error;
             }
 
             /*validate CRC-16 in frame footer*/
-            status = read_crc16(input);
+            status = flacdec_read_crc16(input);
             input->pop_callback(input, NULL);
             if (status != OK) {
                 fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
@@ -1930,15 +1352,19 @@ main(int argc, char *argv[])
             }
 
             /*output samples to stdout*/
-            converter(sample_count, samples, pcm_samples);
+            interleave_channel_data(pcm_data,
+                                    frame_header.channel_count,
+                                    frame_header.block_size,
+                                    samples);
+            converter(sample_count, pcm_data, pcm_samples);
             fwrite(pcm_samples, sizeof(pcm_samples), 1, stdout);
 
             /*update MD5 sum*/
-            update_md5sum(&stream_md5,
-                          samples,
-                          frame_header.channel_count,
-                          frame_header.bits_per_sample,
-                          frame_header.block_size);
+            flacdec_update_md5sum(&stream_md5,
+                                  samples,
+                                  frame_header.channel_count,
+                                  frame_header.bits_per_sample,
+                                  frame_header.block_size);
 
             /*decrement remaining samples*/
             total_samples -= frame_header.block_size;
@@ -1947,7 +1373,7 @@ main(int argc, char *argv[])
 
     /*validate MD5 signature*/
     if (memcmp(streaminfo.MD5, empty_md5, 16)) {
-        if (!verify_md5sum(&stream_md5, streaminfo.MD5)) {
+        if (!flacdec_verify_md5sum(&stream_md5, streaminfo.MD5)) {
             fputs("*** Error: MD5 mismatch at end of stream\n", stderr);
             goto error;
         }
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include "../bitstream.h"
 #include "../common/md5.h"
+#include "flac_frame.h"
+#include "../framelist.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -24,18 +26,6 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
-struct STREAMINFO {
-    unsigned minimum_block_size;
-    unsigned maximum_block_size;
-    unsigned minimum_frame_size;
-    unsigned maximum_frame_size;
-    unsigned sample_rate;
-    unsigned channel_count;
-    unsigned bits_per_sample;
-    uint64_t total_samples;
-    uint8_t MD5[16];
-};
-
 struct SEEKPOINT {
     uint64_t sample_number;
     uint64_t frame_offset;
@@ -47,7 +37,203 @@ struct SEEKTABLE {
     struct SEEKPOINT *seek_points;
 };
 
+struct flac_block {
+    unsigned type;
+    uint64_t offset;   /*of the block's header, from the start of the stream*/
+    unsigned size;     /*of the block's data, not including its header*/
+};
+
+/*a PICTURE block's fields, less its image data*/
+struct flac_picture {
+    unsigned type;             /*FLAC picture type, as in ID3v2*/
+    char *mime_type;
+    char *description;
+    unsigned width;
+    unsigned height;
+    unsigned color_depth;
+    unsigned color_count;
+    uint64_t data_offset;      /*of the image data, from the start of the stream*/
+    unsigned data_length;
+};
+
+/*everything in a FLAC stream ahead of its first frame*/
+struct flac_header {
+    struct STREAMINFO streaminfo;
+
+    /*the first SEEKTABLE, with no points if the stream has none*/
+    struct SEEKTABLE seektable;
+
+    /*the first VORBIS_COMMENT's vendor string and entries
+      NULL if the stream has no VORBIS_COMMENT*/
+    char *vendor_string;
+    unsigned total_comments;
+    char **comments;
+
+    /*the first WAVEFORMATEXTENSIBLE_CHANNEL_MASK entry's value, if any*/
+    int has_channel_mask;
+    unsigned channel_mask;
+
+    /*every well-formed PICTURE block in stream order*/
+    unsigned total_pictures;
+    struct flac_picture *pictures;
+
+    /*every metadata block in stream order*/
+    unsigned total_blocks;
+    struct flac_block *blocks;
+
+    /*bytes from the start of the stream to its first frame*/
+    uint64_t frames_offset;
+};
+
+/*parses the "fLaC" stream ID and every metadata block that follows
+  leaving the reader positioned at the stream's first frame
+
+  only the first STREAMINFO, SEEKTABLE and VORBIS_COMMENT are kept
+  PADDING, APPLICATION and CUESHEET data are skipped
+  as is PICTURE image data, whose location is kept instead
+  but every block is listed in "blocks" so that callers
+  can decide for themselves whether duplicates are acceptable
+
+  "header" is initialized by this function and must be freed
+  with flacdec_free_header whether or not the parse succeeds*/
+flac_status
+flacdec_read_header(BitstreamReader *r, struct flac_header *header);
+
+void
+flacdec_free_header(struct flac_header *header);
+
 #ifndef STANDALONE
+typedef struct {
+    PyObject_HEAD
+
+    struct flac_header header;
+} decoders_FlacHeader;
+
+static PyObject*
+FlacHeader_new(PyTypeObject *type,
+               PyObject *args, PyObject *kwds);
+
+int
+FlacHeader_init(decoders_FlacHeader *self,
+                PyObject *args, PyObject *kwds);
+
+void
+FlacHeader_dealloc(decoders_FlacHeader *self);
+
+static PyObject*
+FlacHeader_sample_rate(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_bits_per_sample(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_channels(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_total_samples(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_md5sum(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_channel_mask(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_seekpoints(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_vendor_string(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_comments(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_pictures(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_blocks(decoders_FlacHeader *self, void *closure);
+
+static PyObject*
+FlacHeader_frames_offset(decoders_FlacHeader *self, void *closure);
+
+PyGetSetDef FlacHeader_getseters[] = {
+    {"sample_rate",
+     (getter)FlacHeader_sample_rate, NULL, "sample rate", NULL},
+    {"bits_per_sample",
+     (getter)FlacHeader_bits_per_sample, NULL, "bits-per-sample", NULL},
+    {"channels",
+     (getter)FlacHeader_channels, NULL, "channels", NULL},
+    {"total_samples",
+     (getter)FlacHeader_total_samples, NULL, "total PCM frames", NULL},
+    {"md5sum",
+     (getter)FlacHeader_md5sum, NULL, "STREAMINFO MD5 sum", NULL},
+    {"channel_mask",
+     (getter)FlacHeader_channel_mask, NULL,
+     "WAVEFORMATEXTENSIBLE_CHANNEL_MASK value, or None", NULL},
+    {"seekpoints",
+     (getter)FlacHeader_seekpoints, NULL,
+     "list of (PCM frame offset, byte offset, PCM frame count) tuples", NULL},
+    {"vendor_string",
+     (getter)FlacHeader_vendor_string, NULL,
+     "VORBIS_COMMENT vendor string, or None", NULL},
+    {"comments",
+     (getter)FlacHeader_comments, NULL,
+     "list of VORBIS_COMMENT entries, or None", NULL},
+    {"pictures",
+     (getter)FlacHeader_pictures, NULL,
+     "list of (picture type, MIME type, description, width, height, "
+     "color depth, color count, data offset, data length) tuples", NULL},
+    {"blocks",
+     (getter)FlacHeader_blocks, NULL,
+     "list of (block type, byte offset, block size) tuples", NULL},
+    {"frames_offset",
+     (getter)FlacHeader_frames_offset, NULL,
+     "bytes from start of stream to first frame", NULL},
+    {NULL}
+};
+
+PyTypeObject decoders_FlacHeaderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "decoders.FlacHeader",     /* tp_name */
+    sizeof(decoders_FlacHeader), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)FlacHeader_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    "FlacHeader objects",      /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    0,                         /* tp_methods */
+    0,                         /* tp_members */
+    FlacHeader_getseters,      /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)FlacHeader_init, /* tp_init */
+    0,                         /* tp_alloc */
+    FlacHeader_new,            /* tp_new */
+};
+
 typedef struct {
     PyObject_HEAD
 
@@ -65,6 +251,9 @@ typedef struct {
     /*a framelist generator*/
     PyObject* audiotools_pcm;
 
+    /*the remainder of a FLAC frame too large for the last read*/
+    struct frame_buffer buffer;
+
     /*a mark for seeking purposes*/
     br_pos_t* beginning_of_frames;
 } decoders_FlacDecoder;
@@ -81,9 +270,17 @@ FlacDecoder_channels(decoders_FlacDecoder *self, void *closure);
 static PyObject*
 FlacDecoder_channel_mask(decoders_FlacDecoder *self, void *closure);
 
+/*reads as many whole FLAC frames as fit in the requested
+  number of PCM frames into a single FrameList
+  keeping any remainder of the last one for the next read*/
 static PyObject*
 FlacDecoder_read(decoders_FlacDecoder* self, PyObject *args);
 
+/*decodes the next FLAC frame into the decoder's buffer
+  returns OK on success, or an error status*/
+static flac_status
+decode_frame(decoders_FlacDecoder *self);
+
 static PyObject*
 FlacDecoder_frame_size(decoders_FlacDecoder* self, PyObject *args);
 
@@ -0,0 +1,1150 @@
+#include "flac_frame.h"
+#include "../framelist.h"
+#include "../pcm_conv.h"
+#include "../common/flac_crc.h"
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+typedef enum {CONSTANT,
+              VERBATIM,
+              FIXED,
+              LPC} subframe_type_t;
+
+/*******************************
+ * private function signatures *
+ *******************************/
+
+static flac_status
+read_utf8(BitstreamReader *r, unsigned *utf8);
+
+typedef flac_status (*decode_f)(BitstreamReader *r,
+                                const struct flac_frame_header *frame_header,
+                                int samples[]);
+
+static decode_f
+get_decoder(channel_assignment_t channel_assignment);
+
+static flac_status
+decode_independent(BitstreamReader *r,
+                   const struct flac_frame_header *frame_header,
+                   int samples[]);
+
+static flac_status
+decode_left_difference(BitstreamReader *r,
+                       const struct flac_frame_header *frame_header,
+                       int samples[]);
+static flac_status
+decode_difference_right(BitstreamReader *r,
+                        const struct flac_frame_header *frame_header,
+                        int samples[]);
+
+static flac_status
+decode_average_difference(BitstreamReader *r,
+                          const struct flac_frame_header *frame_header,
+                          int samples[]);
+
+static flac_status
+read_subframe(BitstreamReader *r,
+              unsigned block_size,
+              unsigned bits_per_sample,
+              int channel_data[]);
+
+static flac_status
+read_subframe_header(BitstreamReader *r,
+                     subframe_type_t *type,
+                     unsigned *order,
+                     unsigned *wasted_bps);
+
+static void
+read_CONSTANT_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample,
+                       int channel_data[]);
+
+static void
+read_VERBATIM_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample,
+                       int channel_data[]);
+
+static flac_status
+read_FIXED_subframe(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned bits_per_sample,
+                    unsigned predictor_order,
+                    int channel_data[]);
+
+static flac_status
+read_LPC_subframe(BitstreamReader *r,
+                  unsigned block_size,
+                  unsigned bits_per_sample,
+                  unsigned predictor_order,
+                  int channel_data[]);
+
+static flac_status
+read_residual_block(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned predictor_order,
+                    int residuals[]);
+
+/*each decorrelator rebuilds the left and right channels in place
+  from the pair of subframes decoded into them*/
+static void
+decorrelate_left_difference(unsigned block_size,
+                            const int left[],
+                            int difference[]);
+static void
+decorrelate_difference_right(unsigned block_size,
+                             int difference[],
+                             const int right[]);
+
+static void
+decorrelate_average_difference(unsigned block_size,
+                               int average[],
+                               int difference[]);
+
+static flac_status
+skip_subframe(BitstreamReader *r,
+              unsigned block_size,
+              unsigned bits_per_sample);
+
+static void
+skip_CONSTANT_subframe(BitstreamReader *r,
+                       unsigned bits_per_sample);
+
+static void
+skip_VERBATIM_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample);
+
+static flac_status
+skip_FIXED_subframe(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned bits_per_sample,
+                    unsigned predictor_order);
+
+static flac_status
+skip_LPC_subframe(BitstreamReader *r,
+                  unsigned block_size,
+                  unsigned bits_per_sample,
+                  unsigned predictor_order);
+
+static flac_status
+skip_residual_block(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned predictor_order);
+
+/***********************************
+ * public function implementations *
+ ***********************************/
+
+flac_status
+flacdec_decode_subframes(BitstreamReader *r,
+                         const struct flac_frame_header *frame_header,
+                         int samples[])
+{
+    decode_f decode = get_decoder(frame_header->channel_assignment);
+    assert(decode);
+    return decode(r, frame_header, samples);
+}
+
+flac_status
+flacdec_skip_subframes(BitstreamReader *r,
+                       const struct flac_frame_header *frame_header)
+{
+    const unsigned block_size = frame_header->block_size;
+    const unsigned bits_per_sample = frame_header->bits_per_sample;
+    flac_status status;
+    unsigned c;
+
+    switch (frame_header->channel_assignment) {
+    case INDEPENDENT:
+    default:
+        for (c = 0; c < frame_header->channel_count; c++) {
+            if ((status = skip_subframe(r,
+                                        block_size,
+                                        bits_per_sample)) != OK) {
+                return status;
+            }
+        }
+        return OK;
+    case LEFT_DIFFERENCE:
+    case AVERAGE_DIFFERENCE:
+        if ((status = skip_subframe(r,
+                                    block_size,
+                                    bits_per_sample)) != OK) {
+            return status;
+        }
+        return skip_subframe(r, block_size, bits_per_sample + 1);
+    case DIFFERENCE_RIGHT:
+        if ((status = skip_subframe(r,
+                                    block_size,
+                                    bits_per_sample + 1)) != OK) {
+            return status;
+        }
+        return skip_subframe(r, block_size, bits_per_sample);
+    }
+}
+
+flac_status
+flacdec_read_frame_header(BitstreamReader *r,
+                          const struct STREAMINFO *streaminfo,
+                          struct flac_frame_header *frame_header)
+{
+    uint8_t crc8 = 0;
+    unsigned encoded_block_size;
+    unsigned encoded_sample_rate;
+    unsigned encoded_channels;
+    unsigned encoded_bps;
+
+    if (!setjmp(*br_try(r))) {
+        flac_status status;
+
+        r->add_callback(r, (bs_callback_f)flac_crc8, &crc8);
+        if (r->read(r, 14) != 0x3FFE) {
+            br_etry(r);
+            return INVALID_SYNC_CODE;
+        }
+        r->skip(r, 1);
+        frame_header->blocking_strategy = r->read(r, 1);
+        encoded_block_size = r->read(r, 4);
+        encoded_sample_rate = r->read(r, 4);
+        encoded_channels = r->read(r, 4);
+        encoded_bps = r->read(r, 3);
+        r->skip(r, 1);
+        if ((status = read_utf8(r, &(frame_header->frame_number))) != OK) {
+            br_etry(r);
+            return status;
+        }
+
+        switch (encoded_block_size) {
+        case 0:
+        default:
+            frame_header->block_size = streaminfo->maximum_block_size;
+            break;
+        case 1: frame_header->block_size = 192; break;
+        case 2: frame_header->block_size = 576; break;
+        case 3: frame_header->block_size = 1152; break;
+        case 4: frame_header->block_size = 2304; break;
+        case 5: frame_header->block_size = 4608; break;
+        case 6: frame_header->block_size = r->read(r, 8) + 1; break;
+        case 7: frame_header->block_size = r->read(r, 16) + 1; break;
+        case 8: frame_header->block_size = 256; break;
+        case 9: frame_header->block_size = 512; break;
+        case 10: frame_header->block_size = 1024; break;
+        case 11: frame_header->block_size = 2048; break;
+        case 12: frame_header->block_size = 4096; break;
+        case 13: frame_header->block_size = 8192; break;
+        case 14: frame_header->block_size = 16384; break;
+        case 15: frame_header->block_size = 32768; break;
+        }
+        if (frame_header->block_size > streaminfo->maximum_block_size) {
+            br_etry(r);
+            return BLOCK_SIZE_MISMATCH;
+        }
+
+        switch (encoded_sample_rate) {
+        case 0:
+        default:
+            frame_header->sample_rate = streaminfo->sample_rate;
+            break;
+        case 1: frame_header->sample_rate = 88200; break;
+        case 2: frame_header->sample_rate = 176400; break;
+        case 3: frame_header->sample_rate = 192000; break;
+        case 4: frame_header->sample_rate = 8000; break;
+        case 5: frame_header->sample_rate = 16000; break;
+        case 6: frame_header->sample_rate = 22050; break;
+        case 7: frame_header->sample_rate = 24000; break;
+        case 8: frame_header->sample_rate = 32000; break;
+        case 9: frame_header->sample_rate = 44100; break;
+        case 10: frame_header->sample_rate = 48000; break;
+        case 11: frame_header->sample_rate = 96000; break;
+        case 12: frame_header->sample_rate = r->read(r, 8) * 1000; break;
+        case 13: frame_header->sample_rate = r->read(r, 16); break;
+        case 14: frame_header->sample_rate = r->read(r, 16) * 10; break;
+        case 15:
+            br_etry(r);
+            return INVALID_SAMPLE_RATE;
+        }
+        if (frame_header->sample_rate != streaminfo->sample_rate) {
+            br_etry(r);
+            return SAMPLE_RATE_MISMATCH;
+        }
+
+        switch (encoded_bps) {
+        case 0:
+        default:
+            frame_header->bits_per_sample = streaminfo->bits_per_sample;
+            break;
+        case 1: frame_header->bits_per_sample = 8; break;
+        case 2: frame_header->bits_per_sample = 12; break;
+        case 4: frame_header->bits_per_sample = 16; break;
+        case 5: frame_header->bits_per_sample = 20; break;
+        case 6: frame_header->bits_per_sample = 24; break;
+        case 3:
+        case 7:
+            br_etry(r);
+            return INVALID_BPS;
+        }
+        if (frame_header->bits_per_sample != streaminfo->bits_per_sample) {
+            br_etry(r);
+            return BPS_MISMATCH;
+        }
+
+        switch (encoded_channels) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+        case 6:
+        case 7:
+            frame_header->channel_assignment = INDEPENDENT;
+            frame_header->channel_count = encoded_channels + 1;
+            break;
+        case 8:
+            frame_header->channel_assignment = LEFT_DIFFERENCE;
+            frame_header->channel_count = 2;
+            break;
+        case 9:
+            frame_header->channel_assignment = DIFFERENCE_RIGHT;
+            frame_header->channel_count = 2;
+            break;
+        case 10:
+            frame_header->channel_assignment = AVERAGE_DIFFERENCE;
+            frame_header->channel_count = 2;
+            break;
+        default:
+            br_etry(r);
+            return INVALID_CHANNEL_ASSIGNMENT;
+        }
+        if (frame_header->channel_count != streaminfo->channel_count) {
+            br_etry(r);
+            return CHANNEL_COUNT_MISMATCH;
+        }
+
+        r->skip(r, 8); /*CRC-8*/
+        br_etry(r);
+        r->pop_callback(r, NULL);
+        if (crc8) {
+            return INVALID_CRC8;
+        } else {
+            return OK;
+        }
+    } else {
+        br_etry(r);
+        return IOERROR_HEADER;
+    }
+}
+
+/************************************
+ * private function implementations *
+ ************************************/
+
+static flac_status
+read_utf8(BitstreamReader *r, unsigned *utf8)
+{
+    const unsigned count = r->read_unary(r, 0);
+    unsigned i;
+    *utf8 = r->read(r, 7 - count);
+    if (count > 0) {
+        for (i = 0; i < (count - 1); i++) {
+            if (r->read(r, 2) == 2) {
+                *utf8 = (*utf8 << 8) | (r->read(r, 6));
+            } else {
+                return INVALID_UTF8;
+            }
+        }
+    }
+    return OK;
+}
+
+static decode_f
+get_decoder(channel_assignment_t channel_assignment)
+{
+    switch (channel_assignment) {
+    case INDEPENDENT:
+        return decode_independent;
+    case LEFT_DIFFERENCE:
+        return decode_left_difference;
+    case DIFFERENCE_RIGHT:
+        return decode_difference_right;
+    case AVERAGE_DIFFERENCE:
+        return decode_average_difference;
+    }
+
+    /*shouldn't get here*/
+    return NULL;
+}
+
+static flac_status
+decode_independent(BitstreamReader *r,
+                   const struct flac_frame_header *frame_header,
+                   int samples[])
+{
+    unsigned c;
+    flac_status status;
+    for (c = 0; c < frame_header->channel_count; c++) {
+        if ((status = read_subframe(r,
+                                    frame_header->block_size,
+                                    frame_header->bits_per_sample,
+                                    samples +
+                                    (c * frame_header->block_size))) != OK) {
+            return status;
+        }
+    }
+
+    return OK;
+}
+
+static flac_status
+decode_left_difference(BitstreamReader *r,
+                       const struct flac_frame_header *frame_header,
+                       int samples[])
+{
+    flac_status status;
+    int *left_data = samples;
+    int *difference_data = samples + frame_header->block_size;
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample,
+                                left_data)) != OK) {
+        return status;
+    }
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample + 1,
+                                difference_data)) != OK) {
+        return status;
+    }
+
+    decorrelate_left_difference(frame_header->block_size,
+                                left_data,
+                                difference_data);
+
+    return OK;
+}
+
+static flac_status
+decode_difference_right(BitstreamReader *r,
+                        const struct flac_frame_header *frame_header,
+                        int samples[])
+{
+    flac_status status;
+    int *difference_data = samples;
+    int *right_data = samples + frame_header->block_size;
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample + 1,
+                                difference_data)) != OK) {
+        return status;
+    }
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample,
+                                right_data)) != OK) {
+        return status;
+    }
+
+    decorrelate_difference_right(frame_header->block_size,
+                                 difference_data,
+                                 right_data);
+
+    return OK;
+}
+
+static flac_status
+decode_average_difference(BitstreamReader *r,
+                          const struct flac_frame_header *frame_header,
+                          int samples[])
+{
+    flac_status status;
+    int *average_data = samples;
+    int *difference_data = samples + frame_header->block_size;
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample,
+                                average_data)) != OK) {
+        return status;
+    }
+
+    if ((status = read_subframe(r,
+                                frame_header->block_size,
+                                frame_header->bits_per_sample + 1,
+                                difference_data)) != OK) {
+        return status;
+    }
+
+    decorrelate_average_difference(frame_header->block_size,
+                                   average_data,
+                                   difference_data);
+
+    return OK;
+}
+
+static flac_status
+read_subframe(BitstreamReader *r,
+              unsigned block_size,
+              unsigned bits_per_sample,
+              int channel_data[])
+{
+    if (!setjmp(*br_try(r))) {
+        subframe_type_t type;
+        unsigned order;
+        unsigned wasted_bps;
+        flac_status status;
+
+        if ((status =
+             read_subframe_header(r, &type, &order, &wasted_bps)) != OK) {
+            br_etry(r);
+            return status;
+        } else {
+            const unsigned effective_bps = bits_per_sample - wasted_bps;
+
+            if (wasted_bps >= bits_per_sample) {
+                br_etry(r);
+                return INVALID_WASTED_BPS;
+            }
+
+            switch (type) {
+            case CONSTANT:
+                read_CONSTANT_subframe(r,
+                                       block_size,
+                                       effective_bps,
+                                       channel_data);
+                break;
+            case VERBATIM:
+                read_VERBATIM_subframe(r,
+                                       block_size,
+                                       effective_bps,
+                                       channel_data);
+                break;
+            case FIXED:
+                if ((status =
+                     read_FIXED_subframe(r,
+                                         block_size,
+                                         effective_bps,
+                                         order,
+                                         channel_data)) != OK) {
+                    br_etry(r);
+                    return status;
+                }
+                break;
+            case LPC:
+                if ((status =
+                     read_LPC_subframe(r,
+                                       block_size,
+                                       effective_bps,
+                                       order,
+                                       channel_data)) != OK) {
+                    br_etry(r);
+                    return status;
+                }
+                break;
+            }
+            br_etry(r);
+            if (wasted_bps) {
+                unsigned i;
+                for (i = 0; i < block_size; i++) {
+                    channel_data[i] <<= wasted_bps;
+                }
+            }
+            return OK;
+        }
+    } else {
+        br_etry(r);
+        return IOERROR_SUBFRAME;
+    }
+}
+
+static flac_status
+read_subframe_header(BitstreamReader *r,
+                     subframe_type_t *type,
+                     unsigned *order,
+                     unsigned *wasted_bps)
+{
+    unsigned type_and_order;
+    unsigned has_wasted_bps;
+
+    r->skip(r, 1);
+    type_and_order = r->read(r, 6);
+    has_wasted_bps = r->read(r, 1);
+    if (has_wasted_bps) {
+        *wasted_bps = r->read_unary(r, 1) + 1;
+    } else {
+        *wasted_bps = 0;
+    }
+    if (type_and_order == 0) {
+        *type = CONSTANT;
+        return OK;
+    } else if (type_and_order == 1) {
+        *type = VERBATIM;
+        return OK;
+    } else if ((8 <= type_and_order) && (type_and_order <= 12)) {
+        *type = FIXED;
+        *order = type_and_order - 8;
+        return OK;
+    } else if ((32 <= type_and_order) && (type_and_order <= 63)) {
+        *type = LPC;
+        *order = type_and_order - 31;
+        return OK;
+    } else {
+        return INVALID_SUBFRAME_HEADER;
+    }
+}
+
+static void
+read_CONSTANT_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample,
+                       int channel_data[])
+{
+    const int constant = r->read_signed(r, bits_per_sample);
+    for (; block_size; block_size--) {
+        channel_data[0] = constant;
+        channel_data += 1;
+    }
+}
+
+static void
+read_VERBATIM_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample,
+                       int channel_data[])
+{
+    for (; block_size; block_size--) {
+        channel_data[0] = r->read_signed(r, bits_per_sample);
+        channel_data += 1;
+    }
+}
+
+static flac_status
+read_FIXED_subframe(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned bits_per_sample,
+                    unsigned predictor_order,
+                    int channel_data[])
+{
+    if ((predictor_order > 4) || (predictor_order > block_size)) {
+        return INVALID_FIXED_ORDER;
+    } else {
+        unsigned i;
+        int residuals[block_size - predictor_order];
+        flac_status status;
+
+        /*warm-up samples*/
+        for (i = 0; i < predictor_order; i++) {
+            channel_data[i] = r->read_signed(r, bits_per_sample);
+        }
+
+        /*residuals*/
+        if ((status = read_residual_block(r,
+                                          block_size,
+                                          predictor_order,
+                                          residuals)) != OK) {
+            return status;
+        }
+
+        switch (predictor_order) {
+        case 0:
+            for (i = 0; i < block_size; i++) {
+                channel_data[i] = residuals[i];
+            }
+            return OK;
+        case 1:
+            for (i = 1; i < block_size; i++) {
+                channel_data[i] = channel_data[i - 1] + residuals[i - 1];
+            }
+            return OK;
+        case 2:
+            for (i = 2; i < block_size; i++) {
+                channel_data[i] = (2 * channel_data[i - 1]) -
+                                  channel_data[i - 2] +
+                                  residuals[i - 2];
+            }
+            return OK;
+        case 3:
+            for (i = 3; i < block_size; i++) {
+                channel_data[i] = (3 * channel_data[i - 1]) -
+                                  (3 * channel_data[i - 2]) +
+                                  channel_data[i - 3] +
+                                  residuals[i - 3];
+            }
+            return OK;
+        case 4:
+            for (i = 4; i < block_size; i++) {
+                channel_data[i] = (4 * channel_data[i - 1]) -
+                                  (6 * channel_data[i - 2]) +
+                                  (4 * channel_data[i - 3]) -
+                                  channel_data[i - 4] +
+                                  residuals[i - 4];
+            }
+            return OK;
+        default:
+            return INVALID_FIXED_ORDER;
+        }
+    }
+}
+
+static flac_status
+read_LPC_subframe(BitstreamReader *r,
+                  unsigned block_size,
+                  unsigned bits_per_sample,
+                  unsigned predictor_order,
+                  int channel_data[])
+{
+    if (predictor_order > block_size) {
+        return INVALID_LPC_ORDER;
+    } else {
+        unsigned i;
+        unsigned precision;
+        int shift;
+        int coefficient[predictor_order];
+        int residuals[block_size - predictor_order];
+        flac_status status;
+
+        /*warm-up samples*/
+        for (i = 0; i < predictor_order; i++) {
+            channel_data[i] = r->read_signed(r, bits_per_sample);
+        }
+
+        precision = r->read(r, 4) + 1;
+        shift = r->read_signed(r, 5);
+        if (shift < 0) {
+            shift = 0;
+        }
+
+        /*coefficients*/
+        for (i = 0; i < predictor_order; i++) {
+            coefficient[i] = r->read_signed(r, precision);
+        }
+
+        if ((status = read_residual_block(r,
+                                          block_size,
+                                          predictor_order,
+                                          residuals)) != OK) {
+            return status;
+        }
+
+        for (i = predictor_order; i < block_size; i++) {
+            register int64_t sum = 0;
+            unsigned j;
+            for (j = 0; j < predictor_order; j++) {
+                sum += (int64_t)coefficient[j] *
+                       (int64_t)channel_data[i - j - 1];
+            }
+            sum >>= shift;
+            channel_data[i] = (int)sum + residuals[i - predictor_order];
+        }
+
+        return OK;
+    }
+}
+
+static flac_status
+read_residual_block(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned predictor_order,
+                    int residuals[])
+{
+    br_read_f read = r->read;
+    br_read_unary_f read_unary = r->read_unary;
+    const unsigned coding_method = read(r, 2);
+    const unsigned partition_order = read(r, 4);
+    const unsigned partition_count = 1 << partition_order;
+    unsigned rice_bits;
+    unsigned i = 0;
+    unsigned p;
+
+    if (coding_method == 0) {
+        rice_bits = 4;
+    } else if (coding_method == 1) {
+        rice_bits = 5;
+    } else {
+        return INVALID_CODING_METHOD;
+    }
+
+    if ((block_size % partition_count) ||
+        (predictor_order > (block_size / partition_count))) {
+        return INVALID_PARTITION_ORDER;
+    }
+
+    for (p = 0; p < partition_count; p++) {
+        const unsigned rice = read(r, rice_bits);
+        const unsigned partition_size = block_size / partition_count -
+                                        (p == 0 ? predictor_order : 0);
+        register unsigned j;
+        if (((coding_method == 0) && (rice == 15)) ||
+            ((coding_method == 1) && (rice == 31))) {
+            const unsigned escape_code = read(r, 5);
+            br_read_signed_f read_signed = r->read_signed;
+            for (j = 0; j < partition_size; j++) {
+                residuals[i++] = read_signed(r, escape_code);
+            }
+        } else {
+            for (j = 0; j < partition_size; j++) {
+                const unsigned MSB = read_unary(r, 1);
+                const unsigned LSB = read(r, rice);
+                const unsigned unsigned_ = (MSB << rice) | LSB;
+                residuals[i++] = (unsigned_ % 2) ?
+                                 (-(unsigned_ >> 1) - 1) :
+                                 (unsigned_ >> 1);
+            }
+        }
+    }
+
+    return OK;
+}
+
+flac_status
+flacdec_read_crc16(BitstreamReader *r)
+{
+    if (!setjmp(*br_try(r))) {
+        r->byte_align(r);
+        r->skip(r, 16);
+        br_etry(r);
+        return OK;
+    } else {
+        br_etry(r);
+        return IOERROR_CRC16;
+    }
+}
+
+static void
+decorrelate_left_difference(unsigned block_size,
+                            const int left[],
+                            int difference[])
+{
+    for (; block_size; block_size--) {
+        /*right[0] = left[0] - difference[0];*/
+        difference[0] = left[0] - difference[0];
+        left += 1;
+        difference += 1;
+    }
+}
+
+static void
+decorrelate_difference_right(unsigned block_size,
+                             int difference[],
+                             const int right[])
+{
+    for (; block_size; block_size--) {
+        /*left[0] = difference[0] + right[0];*/
+        difference[0] += right[0];
+        difference += 1;
+        right += 1;
+    }
+}
+
+static void
+decorrelate_average_difference(unsigned block_size,
+                               int average[],
+                               int difference[])
+{
+    for (; block_size; block_size--) {
+        const int sum = (average[0] * 2) + (abs(difference[0]) % 2);
+        /*left[0] = (sum + difference[0]) >> 1;*/
+        /*right[0] = (sum - difference[0]) >> 1;*/
+        average[0] = (sum + difference[0]) >> 1;
+        difference[0] = (sum - difference[0]) >> 1;
+        average += 1;
+        difference += 1;
+    }
+}
+
+static flac_status
+skip_subframe(BitstreamReader *r,
+              unsigned block_size,
+              unsigned bits_per_sample)
+{
+    if (!setjmp(*br_try(r))) {
+        subframe_type_t type;
+        unsigned order;
+        unsigned wasted_bps;
+        flac_status status;
+
+        if ((status =
+             read_subframe_header(r, &type, &order, &wasted_bps)) != OK) {
+            br_etry(r);
+            return status;
+        } else {
+            const unsigned effective_bps = bits_per_sample - wasted_bps;
+            switch (type) {
+            case CONSTANT:
+                skip_CONSTANT_subframe(r, effective_bps);
+                break;
+            case VERBATIM:
+                skip_VERBATIM_subframe(r, block_size, effective_bps);
+                break;
+            case FIXED:
+                if ((status =
+                     skip_FIXED_subframe(r,
+                                         block_size,
+                                         effective_bps,
+                                         order)) != OK) {
+                    br_etry(r);
+                    return status;
+                }
+                break;
+            case LPC:
+                if ((status =
+                     skip_LPC_subframe(r,
+                                       block_size,
+                                       effective_bps,
+                                       order)) != OK) {
+                    br_etry(r);
+                    return status;
+                }
+                break;
+            }
+            br_etry(r);
+            return OK;
+        }
+    } else {
+        br_etry(r);
+        return IOERROR_SUBFRAME;
+    }
+}
+
+static void
+skip_CONSTANT_subframe(BitstreamReader *r,
+                       unsigned bits_per_sample)
+{
+    r->skip(r, bits_per_sample);
+}
+
+static void
+skip_VERBATIM_subframe(BitstreamReader *r,
+                       unsigned block_size,
+                       unsigned bits_per_sample)
+{
+    r->skip(r, block_size * bits_per_sample);
+}
+
+static flac_status
+skip_FIXED_subframe(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned bits_per_sample,
+                    unsigned predictor_order)
+{
+    if ((predictor_order > 4) || (predictor_order > block_size)) {
+        return INVALID_FIXED_ORDER;
+    } else {
+        /*warm-up samples*/
+        r->skip(r, predictor_order * bits_per_sample);
+        return skip_residual_block(r, block_size, predictor_order);
+    }
+}
+
+static flac_status
+skip_LPC_subframe(BitstreamReader *r,
+                  unsigned block_size,
+                  unsigned bits_per_sample,
+                  unsigned predictor_order)
+{
+    if (predictor_order >= block_size) {
+        return INVALID_LPC_ORDER;
+    } else {
+        unsigned precision;
+
+        /*warm-up samples*/
+        r->skip(r, predictor_order * bits_per_sample);
+        precision = r->read(r, 4) + 1;
+        r->skip(r, 5);
+        /*coefficients*/
+        r->skip(r, predictor_order * precision);
+        return skip_residual_block(r, block_size, predictor_order);
+    }
+}
+
+static flac_status
+skip_residual_block(BitstreamReader *r,
+                    unsigned block_size,
+                    unsigned predictor_order)
+{
+    br_skip_f skip = r->skip;
+    br_skip_unary_f skip_unary = r->skip_unary;
+    const unsigned coding_method = r->read(r, 2);
+    const unsigned partition_order = r->read(r, 4);
+    const unsigned partition_count = 1 << partition_order;
+    unsigned rice_bits;
+    unsigned p;
+
+    if (coding_method == 0) {
+        rice_bits = 4;
+    } else if (coding_method == 1) {
+        rice_bits = 5;
+    } else {
+        return INVALID_CODING_METHOD;
+    }
+
+    for (p = 0; p < partition_count; p++) {
+        const unsigned rice = r->read(r, rice_bits);
+        const unsigned partition_size = block_size / partition_count -
+                                        (p == 0 ? predictor_order : 0);
+        register unsigned j;
+        if (((coding_method == 0) && (rice == 15)) ||
+            ((coding_method == 1) && (rice == 31))) {
+            const unsigned escape_code = r->read(r, 5);
+            r->skip(r, partition_size * escape_code);
+        } else {
+            for (j = 0; j < partition_size; j++) {
+                skip_unary(r, 1);
+                skip(r, rice);
+            }
+        }
+    }
+
+    return OK;
+
+}
+
+void
+flacdec_update_md5sum(audiotools__MD5Context *md5sum,
+                      const int planar_data[],
+                      unsigned channels,
+                      unsigned bits_per_sample,
+                      unsigned pcm_frames)
+{
+    const unsigned total_samples = pcm_frames * channels;
+    const unsigned buffer_size = total_samples * (bits_per_sample / 8);
+    int pcm_data[total_samples];
+    unsigned char buffer[buffer_size];
+
+    /*the sum is taken over interleaved samples*/
+    interleave_channel_data(pcm_data, channels, pcm_frames, planar_data);
+    int_to_pcm_converter(bits_per_sample, 0, 1)(total_samples,
+                                                pcm_data,
+                                                buffer);
+
+    audiotools__MD5Update(md5sum, buffer, buffer_size);
+}
+
+int
+flacdec_verify_md5sum(audiotools__MD5Context *stream_md5,
+                      const uint8_t streaminfo_md5[])
+{
+    unsigned char digest[16];
+    audiotools__MD5Final(digest, stream_md5);
+    return (memcmp(digest, streaminfo_md5, 16) == 0);
+}
+
+#ifndef STANDALONE
+PyObject*
+flac_exception(flac_status status)
+{
+    switch (status) {
+    case OK:
+    default:
+    case INVALID_SYNC_CODE:
+    case INVALID_SAMPLE_RATE:
+    case INVALID_BPS:
+    case INVALID_CHANNEL_ASSIGNMENT:
+    case INVALID_UTF8:
+    case INVALID_CRC8:
+    case INVALID_CRC16:
+    case INVALID_SUBFRAME_HEADER:
+    case INVALID_FIXED_ORDER:
+    case INVALID_LPC_ORDER:
+    case INVALID_CODING_METHOD:
+    case INVALID_WASTED_BPS:
+    case INVALID_PARTITION_ORDER:
+    case BLOCK_SIZE_MISMATCH:
+    case SAMPLE_RATE_MISMATCH:
+    case BPS_MISMATCH:
+    case CHANNEL_COUNT_MISMATCH:
+    case INVALID_STREAM_ID:
+    case INVALID_BLOCK_ID:
+    case NO_STREAMINFO:
+        return PyExc_ValueError;
+    case IOERROR_HEADER:
+    case IOERROR_SUBFRAME:
+    case IOERROR_CRC16:
+    case IOERROR_METADATA:
+        return PyExc_IOError;
+    }
+}
+#endif
+
+const char*
+flac_strerror(flac_status status)
+{
+    switch (status) {
+    default:
+        return "undefined error";
+    case OK:
+        return "OK";
+    case INVALID_SYNC_CODE:
+        return "invalid sync code in frame header";
+    case INVALID_SAMPLE_RATE:
+        return "invalid sample rate in frame header";
+    case INVALID_BPS:
+        return "invalid bits-per-sample in frame header";
+    case INVALID_CHANNEL_ASSIGNMENT:
+        return "invalid channel assignment in frame header";
+    case INVALID_UTF8:
+        return "invalid UTF-8 value in frame header";
+    case INVALID_CRC8:
+        return "invalid CRC-8 in frame header";
+    case IOERROR_HEADER:
+        return "I/O error reading frame header";
+    case IOERROR_SUBFRAME:
+        return "I/O error reading subframe data";
+    case IOERROR_CRC16:
+        return "I/O error reading CRC-16";
+    case INVALID_CRC16:
+        return "frame CRC-16 mismatch";
+    case INVALID_SUBFRAME_HEADER:
+        return "invalid subframe header";
+    case INVALID_FIXED_ORDER:
+        return "invalid FIXED subframe order";
+    case INVALID_LPC_ORDER:
+        return "invalid LPC subframe order";
+    case INVALID_CODING_METHOD:
+        return "invalid coding method";
+    case INVALID_WASTED_BPS:
+        return "invalid wasted BPS in subframe header";
+    case INVALID_PARTITION_ORDER:
+        return "invalid residual partition order";
+    case BLOCK_SIZE_MISMATCH:
+        return "frame header block size larger than maximum";
+    case SAMPLE_RATE_MISMATCH:
+        return "frame header sample rate mismatch";
+    case BPS_MISMATCH:
+        return "frame header bits-per-sample mismatch";
+    case CHANNEL_COUNT_MISMATCH:
+        return "frame header channel count mismatch";
+    case INVALID_STREAM_ID:
+        return "invalid stream ID";
+    case INVALID_BLOCK_ID:
+        return "unknown block ID in stream";
+    case NO_STREAMINFO:
+        return "no STREAMINFO block in stream";
+    case IOERROR_METADATA:
+        return "I/O error reading FLAC metadata";
+    }
+}
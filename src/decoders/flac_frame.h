@@ -0,0 +1,146 @@
+#ifndef FLAC_FRAME_H
+#define FLAC_FRAME_H
+
+#ifndef STANDALONE
+#include <Python.h>
+#endif
+#include <stdint.h>
+#include "../bitstream.h"
+#include "../common/md5.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the FLAC frame decoding engine shared by
+  the native FLAC decoder and the Ogg FLAC decoder
+
+  every function reads from a generic BitstreamReader
+  which may be a file stream or a single Ogg packet's bytes
+  and none of them hold state between frames*/
+
+struct STREAMINFO {
+    unsigned minimum_block_size;
+    unsigned maximum_block_size;
+    unsigned minimum_frame_size;
+    unsigned maximum_frame_size;
+    unsigned sample_rate;
+    unsigned channel_count;
+    unsigned bits_per_sample;
+    uint64_t total_samples;
+    uint8_t MD5[16];
+};
+
+typedef enum {OK,
+              INVALID_SYNC_CODE,
+              INVALID_SAMPLE_RATE,
+              INVALID_BPS,
+              INVALID_CHANNEL_ASSIGNMENT,
+              INVALID_UTF8,
+              INVALID_CRC8,
+              IOERROR_HEADER,
+              IOERROR_SUBFRAME,
+              IOERROR_CRC16,
+              INVALID_CRC16,
+              INVALID_SUBFRAME_HEADER,
+              INVALID_FIXED_ORDER,
+              INVALID_LPC_ORDER,
+              INVALID_CODING_METHOD,
+              INVALID_WASTED_BPS,
+              INVALID_PARTITION_ORDER,
+              BLOCK_SIZE_MISMATCH,
+              SAMPLE_RATE_MISMATCH,
+              BPS_MISMATCH,
+              CHANNEL_COUNT_MISMATCH,
+              INVALID_STREAM_ID,
+              INVALID_BLOCK_ID,
+              NO_STREAMINFO,
+              IOERROR_METADATA} flac_status;
+
+typedef enum {INDEPENDENT,
+              LEFT_DIFFERENCE,
+              DIFFERENCE_RIGHT,
+              AVERAGE_DIFFERENCE} channel_assignment_t;
+
+struct flac_frame_header {
+    unsigned blocking_strategy;
+    unsigned block_size;
+    unsigned sample_rate;
+    channel_assignment_t channel_assignment;
+    unsigned channel_count;
+    unsigned bits_per_sample;
+    unsigned frame_number;
+};
+
+/*a complete frame is decoded by
+  flacdec_read_frame_header, flacdec_decode_subframes
+  and flacdec_read_crc16 in that order
+
+  the caller is expected to attach a flac_crc16 callback to the reader
+  before the header and check that its value is 0 after the footer*/
+
+/*reads a frame header and checks it against the stream's STREAMINFO*/
+flac_status
+flacdec_read_frame_header(BitstreamReader *r,
+                          const struct STREAMINFO *streaminfo,
+                          struct flac_frame_header *frame_header);
+
+/*decodes all of the frame's subframes and decorrelates them
+  into "samples" as planar PCM data, every sample of channel 0
+  followed by every sample of channel 1 and so on
+
+  "samples" must hold at least block_size * channel_count ints*/
+flac_status
+flacdec_decode_subframes(BitstreamReader *r,
+                         const struct flac_frame_header *frame_header,
+                         int samples[]);
+
+/*skips over all of the frame's subframes without decoding them*/
+flac_status
+flacdec_skip_subframes(BitstreamReader *r,
+                       const struct flac_frame_header *frame_header);
+
+/*byte-aligns the stream and reads the frame's CRC-16 footer*/
+flac_status
+flacdec_read_crc16(BitstreamReader *r);
+
+/*adds the given block of planar decoded samples to a running MD5 sum
+  in the interleaved, little-endian, signed format
+  the STREAMINFO sum is taken over*/
+void
+flacdec_update_md5sum(audiotools__MD5Context *md5sum,
+                      const int planar_data[],
+                      unsigned channels,
+                      unsigned bits_per_sample,
+                      unsigned pcm_frames);
+
+/*finalizes the running MD5 sum
+  and returns 1 if it matches the STREAMINFO's sum, 0 if not*/
+int
+flacdec_verify_md5sum(audiotools__MD5Context *stream_md5,
+                      const uint8_t streaminfo_md5[]);
+
+#ifndef STANDALONE
+PyObject*
+flac_exception(flac_status status);
+#endif
+
+const char*
+flac_strerror(flac_status status);
+
+#endif
@@ -1,11 +1,10 @@
-#ifdef STANDALONE
-#include <string.h>
-#include <errno.h>
-#endif
 #include "oggflac.h"
+#include "../ogg_crc.h"
 #include "../common/flac_crc.h"
-#include "../pcmconv.h"
+#include "../pcm_conv.h"
 #include "../framelist.h"
+#include <string.h>
+#include <errno.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -26,6 +25,26 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
+const static uint8_t empty_md5[16] = {0, 0, 0, 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0, 0};
+
+/*******************************
+ * private function signatures *
+ *******************************/
+
+/*reads and discards the next "count" packets from the stream*/
+static ogg_status
+skip_packets(OggPacketIterator *iterator, unsigned count);
+
+/*reads the next page's header and skips over its body
+  without reading the body's contents or validating its checksum*/
+static ogg_status
+skip_page(BitstreamReader *reader, struct ogg_page_header *header);
+
+/***********************************
+ * public function implementations *
+ ***********************************/
+
 #ifndef STANDALONE
 PyObject*
 OggFlacDecoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
@@ -38,14 +57,21 @@ OggFlacDecoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 
 void
 OggFlacDecoder_dealloc(decoders_OggFlacDecoder *self) {
-    self->subframe_data->del(self->subframe_data);
-    self->residuals->del(self->residuals);
-    self->qlp_coeffs->del(self->qlp_coeffs);
-    self->framelist_data->del(self->framelist_data);
     Py_XDECREF(self->audiotools_pcm);
 
-    if (self->ogg_packets != NULL)
+    if (self->beginning_of_stream) {
+        self->beginning_of_stream->del(self->beginning_of_stream);
+    }
+    if (self->beginning_of_frames) {
+        self->beginning_of_frames->del(self->beginning_of_frames);
+    }
+
+    /*closing the iterator also closes its file*/
+    if (self->ogg_packets != NULL) {
         oggiterator_close(self->ogg_packets);
+    } else if (self->ogg_file != NULL) {
+        fclose(self->ogg_file);
+    }
 
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -54,25 +80,31 @@ int
 OggFlacDecoder_init(decoders_OggFlacDecoder *self,
                     PyObject *args, PyObject *kwds) {
     char* filename;
+    int channel_mask;
     ogg_status result;
     BitstreamReader *header_packet;
-    uint16_t header_packets;
+    BitstreamReader *reader;
 
     self->ogg_packets = NULL;
     self->ogg_file = NULL;
-    self->subframe_data = aa_int_new();
-    self->residuals = a_int_new();
-    self->qlp_coeffs = a_int_new();
-    self->framelist_data = a_int_new();
-    self->audiotools_pcm = NULL;
+    self->header_packets = 0;
+    self->closed = 0;
+    audiotools__MD5Init(&(self->md5));
+    self->perform_validation = 1;
     self->stream_finalized = 0;
+    self->audiotools_pcm = NULL;
+    self->beginning_of_stream = NULL;
+    self->beginning_of_frames = NULL;
+    self->beginning_granule = 0;
 
-    if (!PyArg_ParseTuple(args, "si", &filename, &(self->channel_mask)))
+    if (!PyArg_ParseTuple(args, "si", &filename, &channel_mask))
         return -1;
 
-    if (self->channel_mask < 0) {
+    if (channel_mask < 0) {
         PyErr_SetString(PyExc_ValueError, "channel_mask must be >= 0");
         return -1;
+    } else {
+        self->channel_mask = (unsigned)channel_mask;
     }
 
     self->ogg_file = fopen(filename, "rb");
@@ -81,15 +113,26 @@ OggFlacDecoder_init(decoders_OggFlacDecoder *self,
         return -1;
     } else {
         self->ogg_packets = oggiterator_open(self->ogg_file);
+        reader = self->ogg_packets->reader;
+    }
+
+    if (!setjmp(*br_try(reader))) {
+        self->beginning_of_stream = reader->getpos(reader);
+        br_etry(reader);
+    } else {
+        br_etry(reader);
+        PyErr_SetString(PyExc_IOError, "I/O error reading stream position");
+        return -1;
     }
 
     /*the first packet should be the FLAC's STREAMINFO*/
     if ((header_packet = oggiterator_next_packet(self->ogg_packets,
                                                  BS_BIG_ENDIAN,
                                                  &result)) != NULL) {
-        const int streaminfo_ok = oggflac_read_streaminfo(header_packet,
-                                                          &(self->streaminfo),
-                                                          &header_packets);
+        const int streaminfo_ok =
+            oggflac_read_streaminfo(header_packet,
+                                    &(self->streaminfo),
+                                    &(self->header_packets));
         header_packet->close(header_packet);
         if (!streaminfo_ok) {
             return -1;
@@ -99,71 +142,76 @@ OggFlacDecoder_init(decoders_OggFlacDecoder *self,
         return -1;
     }
 
+    /*turn off MD5 checking if MD5 sum is empty*/
+    if (memcmp(self->streaminfo.MD5, empty_md5, 16) == 0) {
+        self->perform_validation = 0;
+    }
+
     /*skip subsequent header packets*/
-    for (; header_packets > 0; header_packets--) {
-        if ((header_packet = oggiterator_next_packet(self->ogg_packets,
-                                                     BS_BIG_ENDIAN,
-                                                     &result)) != NULL) {
-            header_packet->close(header_packet);
-        } else {
-            PyErr_SetString(ogg_exception(result), ogg_strerror(result));
-            return -1;
-        }
+    if ((result = skip_packets(self->ogg_packets,
+                               self->header_packets)) != OGG_OK) {
+        PyErr_SetString(ogg_exception(result), ogg_strerror(result));
+        return -1;
     }
 
-    /*initialize the output MD5 sum*/
-    audiotools__MD5Init(&(self->md5));
+    /*mark the page following the header packets for seeking purposes,
+      whose first sample is the current page's granule position*/
+    if (!setjmp(*br_try(reader))) {
+        self->beginning_of_frames = reader->getpos(reader);
+        self->beginning_granule =
+            self->ogg_packets->page.header.granule_position;
+        br_etry(reader);
+    } else {
+        br_etry(reader);
+        PyErr_SetString(PyExc_IOError, "I/O error reading stream position");
+        return -1;
+    }
 
     /*setup a framelist generator function*/
     if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL)
         return -1;
 
-    /*mark stream as not closed and ready for reading*/
-    self->closed = 0;
-
     return 0;
 }
 
 static PyObject*
 OggFlacDecoder_sample_rate(decoders_OggFlacDecoder *self, void *closure) {
-    return Py_BuildValue("i", self->streaminfo.sample_rate);
+    return Py_BuildValue("I", self->streaminfo.sample_rate);
 }
 
 static PyObject*
 OggFlacDecoder_bits_per_sample(decoders_OggFlacDecoder *self, void *closure) {
-    return Py_BuildValue("i", self->streaminfo.bits_per_sample);
+    return Py_BuildValue("I", self->streaminfo.bits_per_sample);
 }
 
 static PyObject*
 OggFlacDecoder_channels(decoders_OggFlacDecoder *self, void *closure) {
-    return Py_BuildValue("i", self->streaminfo.channels);
+    return Py_BuildValue("I", self->streaminfo.channel_count);
 }
 
 static PyObject*
 OggFlacDecoder_channel_mask(decoders_OggFlacDecoder *self, void *closure) {
-    return Py_BuildValue("i", self->channel_mask);
+    return Py_BuildValue("I", self->channel_mask);
 }
 
 static PyObject*
 OggFlacDecoder_read(decoders_OggFlacDecoder *self, PyObject *args) {
     BitstreamReader *packet;
     ogg_status ogg_status;
-    flac_status flac_status;
+    flac_status status;
     struct flac_frame_header frame_header;
-    int channel;
-    PyObject *framelist;
+    pcm_FrameList *framelist;
+    uint16_t crc16 = 0;
 
     if (self->closed) {
         PyErr_SetString(PyExc_ValueError, "cannot read closed stream");
         return NULL;
     }
 
-    self->subframe_data->reset(self->subframe_data);
-
     /*if all samples have been read, return an empty FrameList*/
     if (self->stream_finalized) {
         return empty_FrameList(self->audiotools_pcm,
-                               self->streaminfo.channels,
+                               self->streaminfo.channel_count,
                                self->streaminfo.bits_per_sample);
     }
 
@@ -171,103 +219,192 @@ OggFlacDecoder_read(decoders_OggFlacDecoder *self, PyObject *args) {
                                      BS_BIG_ENDIAN,
                                      &ogg_status);
 
-    if (ogg_status == OGG_OK) {
-        /*decode the next FrameList from the stream*/
+    if (ogg_status == OGG_STREAM_FINISHED) {
+        /*Ogg stream is finished so verify stream's MD5 sum
+          (if we haven't seeked to the middle of the stream)
+          then return an empty FrameList if it matches correctly*/
+        if (self->perform_validation &&
+            !flacdec_verify_md5sum(&(self->md5), self->streaminfo.MD5)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "MD5 mismatch at end of stream");
+            return NULL;
+        }
 
-        uint16_t crc16 = 0;
-        packet->add_callback(packet, (bs_callback_f)flac_crc16, &crc16);
+        self->perform_validation = 0;
+        self->stream_finalized = 1;
+        return empty_FrameList(self->audiotools_pcm,
+                               self->streaminfo.channel_count,
+                               self->streaminfo.bits_per_sample);
+    } else if (ogg_status != OGG_OK) {
+        /*error reading the next Ogg packet,
+          so raise the appropriate exception*/
+        PyErr_SetString(ogg_exception(ogg_status), ogg_strerror(ogg_status));
+        return NULL;
+    }
 
-        if (!setjmp(*br_try(packet))) {
-            /*read frame header*/
-            if ((flac_status =
-                 flacdec_read_frame_header(packet,
-                                           &(self->streaminfo),
-                                           &frame_header)) != OK) {
-                br_etry(packet);
-                packet->close(packet);
-                PyErr_SetString(PyExc_ValueError,
-                                FlacDecoder_strerror(flac_status));
-                return NULL;
-            }
+    /*decode the packet's FLAC frame with the shared frame engine*/
+    packet->add_callback(packet, (bs_callback_f)flac_crc16, &crc16);
 
-            /*read 1 subframe per channel*/
-            for (channel = 0; channel < frame_header.channel_count; channel++)
-                if ((flac_status = flacdec_read_subframe(
-                        packet,
-                        self->qlp_coeffs,
-                        self->residuals,
-                        frame_header.block_size,
-                        flacdec_subframe_bits_per_sample(&frame_header,
-                                                         channel),
-                        self->subframe_data->append(self->subframe_data))) !=
-                    OK) {
-                    br_etry(packet);
-                    packet->close(packet);
-                    PyErr_SetString(PyExc_ValueError,
-                                    FlacDecoder_strerror(flac_status));
-                    return NULL;
-                }
+    if ((status = flacdec_read_frame_header(packet,
+                                            &(self->streaminfo),
+                                            &frame_header)) != OK) {
+        packet->close(packet);
+        PyErr_SetString(flac_exception(status), flac_strerror(status));
+        return NULL;
+    }
+
+    framelist = new_FrameList(self->audiotools_pcm,
+                              frame_header.channel_count,
+                              frame_header.bits_per_sample,
+                              frame_header.block_size);
+    framelist->planar = 1;
 
+    if (((status = flacdec_decode_subframes(packet,
+                                            &frame_header,
+                                            framelist->samples)) != OK) ||
+        ((status = flacdec_read_crc16(packet)) != OK)) {
+        packet->close(packet);
+        Py_DECREF((PyObject*)framelist);
+        PyErr_SetString(flac_exception(status), flac_strerror(status));
+        return NULL;
+    }
+
+    packet->close(packet);
+
+    if (crc16) {
+        Py_DECREF((PyObject*)framelist);
+        PyErr_SetString(PyExc_ValueError, "frame CRC-16 mismatch");
+        return NULL;
+    }
 
-            /*handle difference channels, if any*/
-            flacdec_decorrelate_channels(frame_header.channel_assignment,
-                                         self->subframe_data,
-                                         self->framelist_data);
+    /*if validating, update running MD5 sum*/
+    if (self->perform_validation) {
+        flacdec_update_md5sum(&(self->md5),
+                              framelist->samples,
+                              frame_header.channel_count,
+                              frame_header.bits_per_sample,
+                              frame_header.block_size);
+    }
+
+    return (PyObject*)framelist;
+}
+
+static PyObject*
+OggFlacDecoder_seek(decoders_OggFlacDecoder *self, PyObject *args)
+{
+    long long seeked_offset;
+    BitstreamReader *reader = self->ogg_packets->reader;
+    br_pos_t *resume_point = NULL;
+    int64_t resume_granule = 0;
 
-            /*check CRC-16*/
-            packet->byte_align(packet);
-            packet->read(packet, 16);
-            if (crc16 != 0) {
-                PyErr_SetString(PyExc_ValueError, "invalid checksum in frame");
-                return NULL;
+    if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "cannot seek closed stream");
+        return NULL;
+    }
+
+    if (!PyArg_ParseTuple(args, "L", &seeked_offset))
+        return NULL;
+
+    if (seeked_offset < 0) {
+        PyErr_SetString(PyExc_ValueError, "cannot seek to negative value");
+        return NULL;
+    }
+
+    self->stream_finalized = 0;
+
+    /*walk page headers from the first page after the header packets
+
+      each page that doesn't continue a packet from the page before
+      begins with a fresh FLAC frame whose first sample
+      is the previous page's granule position,
+      so find the latest such page starting at or before seeked_offset*/
+    if (!setjmp(*br_try(reader))) {
+        int64_t previous_granule = self->beginning_granule;
+
+        reader->setpos(reader, self->beginning_of_frames);
+
+        for (;;) {
+            struct ogg_page_header header;
+            br_pos_t *page_start = reader->getpos(reader);
+
+            if (skip_page(reader, &header) != OGG_OK) {
+                page_start->del(page_start);
+                break;
             }
 
-            br_etry(packet);
-
-            framelist = a_int_to_FrameList(self->audiotools_pcm,
-                                           self->framelist_data,
-                                           frame_header.channel_count,
-                                           frame_header.bits_per_sample);
-
-            if (framelist != NULL) {
-                /*update MD5 sum*/
-                if (OggFlacDecoder_update_md5sum(self, framelist) == 1)
-                    /*return pcm.FrameList Python object*/
-                    return framelist;
-                else {
-                    Py_DECREF(framelist);
-                    return NULL;
+            if ((!header.packet_continuation) && (previous_granule >= 0)) {
+                if (previous_granule <= seeked_offset) {
+                    if (resume_point) {
+                        resume_point->del(resume_point);
+                    }
+                    resume_point = page_start;
+                    resume_granule = previous_granule;
+                } else {
+                    page_start->del(page_start);
+                    break;
                 }
             } else {
-                return NULL;
+                page_start->del(page_start);
+            }
+
+            /*pages on which no packet finishes have a granule of -1*/
+            if (header.granule_position >= 0) {
+                previous_granule = header.granule_position;
+            }
+
+            if (header.stream_end) {
+                break;
             }
+        }
+
+        if (resume_point) {
+            reader->setpos(reader, resume_point);
+            resume_point->del(resume_point);
+            resume_point = NULL;
+            oggiterator_reset(self->ogg_packets);
+        }
+
+        br_etry(reader);
+    } else {
+        br_etry(reader);
+        if (resume_point) {
+            resume_point->del(resume_point);
+        }
+        PyErr_SetString(PyExc_IOError, "I/O error seeking in stream");
+        return NULL;
+    }
+
+    if (resume_granule == 0) {
+        /*if no page starts before the offset, or the first audio page does,
+          decode from the very beginning and reset MD5 validation*/
+        ogg_status result;
+
+        if (!setjmp(*br_try(reader))) {
+            reader->setpos(reader, self->beginning_of_stream);
+            br_etry(reader);
         } else {
-            /*read error decoding FLAC frame*/
-            PyErr_SetString(PyExc_IOError, "I/O error decoding FLAC frame");
-            br_etry(packet);
-            packet->close(packet);
+            br_etry(reader);
+            PyErr_SetString(PyExc_IOError, "I/O error seeking in stream");
             return NULL;
         }
-    } else if (ogg_status == OGG_STREAM_FINISHED) {
-        /*Ogg stream is finished so verify stream's MD5 sum
-          then return an empty FrameList if it matches correctly*/
+        oggiterator_reset(self->ogg_packets);
 
-        if (OggFlacDecoder_verify_okay(self)) {
-            self->stream_finalized = 1;
-            return empty_FrameList(self->audiotools_pcm,
-                                   self->streaminfo.channels,
-                                   self->streaminfo.bits_per_sample);
-        } else {
-            PyErr_SetString(PyExc_ValueError,
-                            "MD5 mismatch at end of stream");
+        if ((result = skip_packets(self->ogg_packets,
+                                   1 + self->header_packets)) != OGG_OK) {
+            PyErr_SetString(ogg_exception(result), ogg_strerror(result));
             return NULL;
         }
+
+        audiotools__MD5Init(&(self->md5));
+        self->perform_validation =
+            (memcmp(self->streaminfo.MD5, empty_md5, 16) != 0);
     } else {
-        /*error reading the next Ogg packet,
-          so raise the appropriate exception*/
-        PyErr_SetString(ogg_exception(ogg_status), ogg_strerror(ogg_status));
-        return NULL;
+        /*otherwise, disable MD5 validation altogether at end of stream*/
+        self->perform_validation = 0;
     }
+
+    /*return actual PCM frames position in file*/
+    return Py_BuildValue("L", (long long)resume_granule);
 }
 
 static PyObject*
@@ -295,52 +432,12 @@ OggFlacDecoder_exit(decoders_OggFlacDecoder* self, PyObject *args)
     Py_INCREF(Py_None);
     return Py_None;
 }
-
-int
-OggFlacDecoder_update_md5sum(decoders_OggFlacDecoder *self,
-                             PyObject *framelist) {
-    PyObject *string = PyObject_CallMethod(framelist,
-                                           "to_bytes","ii",
-                                           0,
-                                           1);
-    char *string_buffer;
-    Py_ssize_t length;
-
-    if (string != NULL) {
-        if (PyBytes_AsStringAndSize(string, &string_buffer, &length) == 0) {
-            audiotools__MD5Update(&(self->md5),
-                                  (unsigned char *)string_buffer,
-                                  length);
-            Py_DECREF(string);
-            return 1;
-        } else {
-            Py_DECREF(string);
-            return 0;
-        }
-    } else {
-        return 0;
-    }
-}
-
-int
-OggFlacDecoder_verify_okay(decoders_OggFlacDecoder *self) {
-    unsigned char stream_md5sum[16];
-    const static unsigned char blank_md5sum[16] = {0, 0, 0, 0, 0, 0, 0, 0,
-                                                   0, 0, 0, 0, 0, 0, 0, 0};
-
-    audiotools__MD5Final(stream_md5sum, &(self->md5));
-
-    return ((memcmp(self->streaminfo.md5sum, blank_md5sum, 16) == 0) ||
-            (memcmp(stream_md5sum, self->streaminfo.md5sum, 16) == 0));
-}
 #endif
 
 int
 oggflac_read_streaminfo(BitstreamReader *packet,
-                        struct flac_STREAMINFO *streaminfo,
-                        uint16_t *header_packets) {
-    int i;
-
+                        struct STREAMINFO *streaminfo,
+                        unsigned *header_packets) {
     if (!setjmp(*br_try(packet))) {
         if (packet->read(packet, 8) != 0x7F) {
 #ifndef STANDALONE
@@ -399,12 +496,10 @@ oggflac_read_streaminfo(BitstreamReader *packet,
         streaminfo->minimum_frame_size = packet->read(packet, 24);
         streaminfo->maximum_frame_size = packet->read(packet, 24);
         streaminfo->sample_rate = packet->read(packet, 20);
-        streaminfo->channels = packet->read(packet, 3) + 1;
+        streaminfo->channel_count = packet->read(packet, 3) + 1;
         streaminfo->bits_per_sample = packet->read(packet, 5) + 1;
         streaminfo->total_samples = packet->read_64(packet, 36);
-        for (i = 0; i < 16; i++) {
-            streaminfo->md5sum[i] = packet->read(packet, 8);
-        }
+        packet->read_bytes(packet, streaminfo->MD5, 16);
     } else {
 #ifndef STANDALONE
         PyErr_SetString(PyExc_IOError, "EOF while reading STREAMINFO block");
@@ -421,64 +516,103 @@ error:
     return 0;
 }
 
-#ifdef STANDALONE
-int main(int argc, char* argv[]) {
-    FILE* ogg_file;
-    OggPacketIterator* ogg_packets = NULL;
-    BitstreamReader* packet;
-    struct flac_STREAMINFO streaminfo;
-    uint16_t header_packets;
-    a_int* residuals = NULL;
-    a_int* qlp_coeffs = NULL;
-    aa_int* subframe_data = NULL;
-    a_int* framelist_data = NULL;
+/************************************
+ * private function implementations *
+ ************************************/
+
+static ogg_status
+skip_packets(OggPacketIterator *iterator, unsigned count)
+{
+    for (; count > 0; count--) {
+        ogg_status result;
+        BitstreamReader *packet = oggiterator_next_packet(iterator,
+                                                          BS_BIG_ENDIAN,
+                                                          &result);
+        if (packet != NULL) {
+            packet->close(packet);
+        } else {
+            return result;
+        }
+    }
+    return OGG_OK;
+}
+
+static ogg_status
+skip_page(BitstreamReader *reader, struct ogg_page_header *header)
+{
+    uint32_t checksum = 0;
     ogg_status result;
-    uint16_t crc16 = 0;
 
-    FrameList_int_to_char_converter converter;
-    unsigned pcm_size;
-    unsigned output_data_size = 1;
-    uint8_t* output_data = NULL;
+    /*read_ogg_page_header expects a checksum callback to be attached*/
+    reader->add_callback(reader, (bs_callback_f)ogg_crc, &checksum);
+    if (!setjmp(*br_try(reader))) {
+        result = read_ogg_page_header(reader, header);
+        br_etry(reader);
+    } else {
+        br_etry(reader);
+        result = OGG_PREMATURE_EOF;
+    }
+    reader->pop_callback(reader, NULL);
+
+    if (result == OGG_OK) {
+        long body_size = 0;
+        unsigned i;
+
+        for (i = 0; i < header->segment_count; i++) {
+            body_size += header->segment_lengths[i];
+        }
 
-    audiotools__MD5Context md5;
-    unsigned char stream_md5sum[16];
-    const static unsigned char blank_md5sum[16] = {0, 0, 0, 0, 0, 0, 0, 0,
-                                                   0, 0, 0, 0, 0, 0, 0, 0};
+        if (!setjmp(*br_try(reader))) {
+            reader->seek(reader, body_size, BS_SEEK_CUR);
+            br_etry(reader);
+        } else {
+            br_etry(reader);
+            result = OGG_PREMATURE_EOF;
+        }
+    }
+
+    return result;
+}
+
+/*******************************
+ * main function for debugging *
+ *******************************/
+
+#ifdef STANDALONE
+int
+main(int argc, char *argv[])
+{
+    FILE *ogg_file;
+    OggPacketIterator *ogg_packets;
+    BitstreamReader *packet;
+    struct STREAMINFO streaminfo;
+    unsigned header_packets;
+    audiotools__MD5Context stream_md5;
+    int_to_pcm_f converter;
+    ogg_status result;
 
     if (argc < 2) {
-        fprintf(stderr, "*** Usage: %s <file.oga>\n", argv[0]);
+        fputs("*** Usage: oggflacdec <file.oga>\n", stderr);
         return 1;
     }
 
-    /*open input file for reading*/
+    errno = 0;
     if ((ogg_file = fopen(argv[1], "rb")) == NULL) {
         fprintf(stderr, "*** %s: %s\n", argv[1], strerror(errno));
         return 1;
     } else {
-        /*open bitstream and setup temporary arrays/buffers*/
         ogg_packets = oggiterator_open(ogg_file);
-        subframe_data = aa_int_new();
-        residuals = a_int_new();
-        qlp_coeffs = a_int_new();
-        framelist_data = a_int_new();
-        output_data = malloc(output_data_size);
     }
 
     /*the first packet should be the FLAC's STREAMINFO*/
     if ((packet = oggiterator_next_packet(ogg_packets,
                                           BS_BIG_ENDIAN,
                                           &result)) != NULL) {
-        int streaminfo_ok = oggflac_read_streaminfo(packet,
+        const int streaminfo_ok = oggflac_read_streaminfo(packet,
                                                           &streaminfo,
                                                           &header_packets);
-
         packet->close(packet);
-
-        if (streaminfo_ok) {
-            converter = FrameList_get_int_to_char_converter(
-                streaminfo.bits_per_sample, 0, 1);
-        } else {
-            fprintf(stderr, "*** Error: STREAMINFO parsing error\n");
+        if (!streaminfo_ok) {
             goto error;
         }
     } else {
@@ -487,140 +621,88 @@ int main(int argc, char* argv[]) {
     }
 
     /*skip subsequent header packets*/
-    for (; header_packets > 0; header_packets--) {
-        if ((packet = oggiterator_next_packet(ogg_packets,
-                                              BS_BIG_ENDIAN,
-                                              &result)) != NULL) {
-            packet->close(packet);
-        } else {
-            fprintf(stderr, "*** Error: %s\n", ogg_strerror(result));
-            goto error;
-        }
+    if ((result = skip_packets(ogg_packets, header_packets)) != OGG_OK) {
+        fprintf(stderr, "*** Error: %s\n", ogg_strerror(result));
+        goto error;
     }
 
-    /*initialize the output MD5 sum*/
-    audiotools__MD5Init(&md5);
+    audiotools__MD5Init(&stream_md5);
+    converter = int_to_pcm_converter(streaminfo.bits_per_sample, 0, 1);
 
+    /*decode one FLAC frame per Ogg packet*/
+    while ((packet = oggiterator_next_packet(ogg_packets,
+                                             BS_BIG_ENDIAN,
+                                             &result)) != NULL) {
+        struct flac_frame_header frame_header;
+        flac_status status;
+        uint16_t crc16 = 0;
 
-    /*decode the next FrameList from the stream*/
-    packet = oggiterator_next_packet(ogg_packets, BS_BIG_ENDIAN, &result);
-    /*add callback for CRC16 calculation*/
-    packet->add_callback(packet, (bs_callback_f)flac_crc16, &crc16);
-
-    while (result != OGG_STREAM_FINISHED) {
-        if (result == OGG_OK) {
-            flac_status flac_status;
-            struct flac_frame_header frame_header;
-            unsigned channel;
-
-            subframe_data->reset(subframe_data);
-
-            if (!setjmp(*br_try(packet))) {
-                /*read frame header*/
-                if ((flac_status =
-                     flacdec_read_frame_header(packet,
-                                               &streaminfo,
-                                               &frame_header)) != OK) {
-                    fprintf(stderr, "*** Error: %s\n",
-                            FlacDecoder_strerror(flac_status));
-                    br_etry(packet);
-                    goto error;
-                }
+        packet->add_callback(packet, (bs_callback_f)flac_crc16, &crc16);
 
-                /*read 1 subframe per channel*/
-                for (channel = 0;
-                     channel < frame_header.channel_count;
-                     channel++)
-                    if ((flac_status = flacdec_read_subframe(
-                        packet,
-                        qlp_coeffs,
-                        residuals,
-                        frame_header.block_size,
-                        flacdec_subframe_bits_per_sample(&frame_header,
-                                                         channel),
-                        subframe_data->append(subframe_data))) != OK) {
-                        fprintf(stderr, "*** Error: %s\n",
-                                FlacDecoder_strerror(flac_status));
-                        br_etry(packet);
-                        goto error;
-                    }
+        if ((status = flacdec_read_frame_header(packet,
+                                                &streaminfo,
+                                                &frame_header)) != OK) {
+            fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
+            packet->close(packet);
+            goto error;
+        } else {
+            const unsigned sample_count = frame_header.channel_count *
+                                          frame_header.block_size;
 
-                br_etry(packet);
-            } else {
-                br_etry(packet);
-                fprintf(stderr, "*** I/O Error reading FLAC frame\n");
-                goto error;
-            }
+            int samples[sample_count];
+            int pcm_data[sample_count];
 
-            /*handle difference channels, if any*/
-            flacdec_decorrelate_channels(frame_header.channel_assignment,
-                                         subframe_data,
-                                         framelist_data);
+            unsigned char pcm_samples[sample_count *
+                                      (frame_header.bits_per_sample / 8)];
 
-            /*check CRC-16*/
-            packet->byte_align(packet);
-            packet->read(packet, 16);
-            if (crc16 != 0) {
-                fprintf(stderr, "*** Error: invalid checksum in frame\n");
+            if (((status = flacdec_decode_subframes(packet,
+                                                    &frame_header,
+                                                    samples)) != OK) ||
+                ((status = flacdec_read_crc16(packet)) != OK)) {
+                fprintf(stderr, "*** Error: %s\n", flac_strerror(status));
+                packet->close(packet);
                 goto error;
             }
+            packet->close(packet);
 
-            /*turn FrameList into string of output*/
-            pcm_size = (streaminfo.bits_per_sample / 8) * framelist_data->len;
-            if (pcm_size > output_data_size) {
-                output_data_size = pcm_size;
-                output_data = realloc(output_data, output_data_size);
+            if (crc16) {
+                fputs("*** Error: CRC-16 mismatch\n", stderr);
+                goto error;
             }
-            FrameList_samples_to_char(output_data,
-                                      framelist_data->_,
-                                      converter,
-                                      framelist_data->len,
-                                      streaminfo.bits_per_sample);
 
-            /*update MD5 sum*/
-            audiotools__MD5Update(&md5, output_data, pcm_size);
-
-            /*output string to stdout*/
-            fwrite(output_data, sizeof(unsigned char), pcm_size, stdout);
-
-            packet->close(packet);
-            packet = oggiterator_next_packet(ogg_packets,
-                                             BS_BIG_ENDIAN,
-                                             &result);
-        } else {
-            /*some error reading Ogg stream*/
-            fprintf(stderr, "*** Error: %s\n", ogg_strerror(result));
-            goto error;
+            /*output samples to stdout*/
+            interleave_channel_data(pcm_data,
+                                    frame_header.channel_count,
+                                    frame_header.block_size,
+                                    samples);
+            converter(sample_count, pcm_data, pcm_samples);
+            fwrite(pcm_samples, sizeof(pcm_samples), 1, stdout);
+
+            flacdec_update_md5sum(&stream_md5,
+                                  samples,
+                                  frame_header.channel_count,
+                                  frame_header.bits_per_sample,
+                                  frame_header.block_size);
         }
     }
 
-    /*Ogg stream is finished so verify stream's MD5 sum*/
-    audiotools__MD5Final(stream_md5sum, &md5);
-
-    if (!((memcmp(streaminfo.md5sum, blank_md5sum, 16) == 0) ||
-          (memcmp(stream_md5sum, streaminfo.md5sum, 16) == 0))) {
-        fprintf(stderr, "*** MD5 mismatch at end of stream\n");
+    if (result != OGG_STREAM_FINISHED) {
+        fprintf(stderr, "*** Error: %s\n", ogg_strerror(result));
         goto error;
     }
 
-    /*close streams, temporary buffers*/
-    oggiterator_close(ogg_packets);
-    subframe_data->del(subframe_data);
-    residuals->del(residuals);
-    qlp_coeffs->del(qlp_coeffs);
-    framelist_data->del(framelist_data);
-    free(output_data);
+    /*validate MD5 signature*/
+    if (memcmp(streaminfo.MD5, empty_md5, 16)) {
+        if (!flacdec_verify_md5sum(&stream_md5, streaminfo.MD5)) {
+            fputs("*** Error: MD5 mismatch at end of stream\n", stderr);
+            goto error;
+        }
+    }
 
+    oggiterator_close(ogg_packets);
     return 0;
-
 error:
     oggiterator_close(ogg_packets);
-    subframe_data->del(subframe_data);
-    residuals->del(residuals);
-    qlp_coeffs->del(qlp_coeffs);
-    framelist_data->del(framelist_data);
-    free(output_data);
-
     return 1;
 }
 #endif
@@ -1,18 +1,11 @@
 #ifndef STANDALONE
-#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #endif
 #include <stdint.h>
 #include "../bitstream.h"
-#include "../array.h"
 #include "../ogg.h"
-#ifndef STANDALONE
-#define STANDALONE
-#include "flac.h"
-#undef STANDALONE
-#else
-#include "flac.h"
-#endif
+#include "../common/md5.h"
+#include "flac_frame.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -33,29 +26,34 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
+/*Ogg FLAC streams carry one FLAC frame per Ogg packet
+  which is decoded by the same frame engine as native FLAC*/
+
 #ifndef STANDALONE
 typedef struct {
     PyObject_HEAD
 
     FILE* ogg_file;
     OggPacketIterator* ogg_packets;
-    int channel_mask;
-
-    struct flac_STREAMINFO streaminfo;
+    struct STREAMINFO streaminfo;
+    unsigned header_packets;
+    unsigned channel_mask;
+    int closed;
 
-    uint32_t crc16;
     audiotools__MD5Context md5;
+    int perform_validation;
     int stream_finalized;
-    int closed;
-
-    /*temporary buffers we don't want to reallocate each time*/
-    aa_int* subframe_data;
-    a_int* residuals;
-    a_int* qlp_coeffs;
-    a_int* framelist_data;
 
     /*a framelist generator*/
     PyObject* audiotools_pcm;
+
+    /*a mark at the start of the stream's first page for rewinding
+      and a mark at the first page after the header packets
+      along with that page's starting granule position
+      for seeking purposes*/
+    br_pos_t* beginning_of_stream;
+    br_pos_t* beginning_of_frames;
+    int64_t beginning_granule;
 } decoders_OggFlacDecoder;
 
 static PyObject*
@@ -73,6 +71,9 @@ OggFlacDecoder_channel_mask(decoders_OggFlacDecoder *self, void *closure);
 static PyObject*
 OggFlacDecoder_read(decoders_OggFlacDecoder *self, PyObject *args);
 
+static PyObject*
+OggFlacDecoder_seek(decoders_OggFlacDecoder *self, PyObject *args);
+
 static PyObject*
 OggFlacDecoder_close(decoders_OggFlacDecoder *self, PyObject *args);
 
@@ -107,6 +108,8 @@ PyGetSetDef OggFlacDecoder_getseters[] = {
 PyMethodDef OggFlacDecoder_methods[] = {
     {"read", (PyCFunction)OggFlacDecoder_read,
      METH_VARARGS, "read(pcm_frame_count) -> FrameList"},
+    {"seek", (PyCFunction)OggFlacDecoder_seek,
+     METH_VARARGS, "seek(desired_pcm_offset) -> actual_pcm_offset"},
     {"close", (PyCFunction)OggFlacDecoder_close,
      METH_NOARGS, "close() -> None"},
     {"__enter__", (PyCFunction)OggFlacDecoder_enter,
@@ -156,13 +159,6 @@ PyTypeObject decoders_OggFlacDecoderType = {
     0,                         /* tp_alloc */
     OggFlacDecoder_new,            /* tp_new */
 };
-
-int
-OggFlacDecoder_update_md5sum(decoders_OggFlacDecoder *self,
-                             PyObject *framelist);
-
-int
-OggFlacDecoder_verify_okay(decoders_OggFlacDecoder *self);
 #endif
 
 /*given a STREAMINFO packet, reads the data into "streaminfo"
@@ -171,5 +167,5 @@ OggFlacDecoder_verify_okay(decoders_OggFlacDecoder *self);
   returns 1 of processed successfully, 0 if not*/
 int
 oggflac_read_streaminfo(BitstreamReader *bitstream,
-                        struct flac_STREAMINFO *streaminfo,
-                        uint16_t *header_packets);
+                        struct STREAMINFO *streaminfo,
+                        unsigned *header_packets);
@@ -1,5 +1,6 @@
 #include "opus.h"
 #include "../framelist.h"
+#include <string.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -20,6 +21,25 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
+/*assume at least 120ms across 8 channels, minimum*/
+#define BUF_SIZE 5760 * 8
+#define BITS_PER_SAMPLE 16
+
+/*decodes the next block of up to "max_pcm_frames" PCM frames
+  from the stream to "block", which may be on the decode-ahead thread*/
+static void
+decode_block(decoders_OpusDecoder *self,
+             unsigned max_pcm_frames,
+             struct da_block *block);
+
+/*reorders interleaved samples from Opus channel order to .wav order*/
+static void
+reorder_channels(int samples[], int channel_count, unsigned pcm_frames);
+
+static PyObject*
+block_to_FrameList(decoders_OpusDecoder *self,
+                   const struct da_block *block);
+
 static PyObject*
 OpusDecoder_new(PyTypeObject *type,
                 PyObject *args, PyObject *kwds)
@@ -35,15 +55,27 @@ int
 OpusDecoder_init(decoders_OpusDecoder *self,
                  PyObject *args, PyObject *kwds)
 {
+    static char *kwlist[] = {"filename", "decode_ahead", NULL};
     char *filename;
+    int decode_ahead = 0;
     int error;
 
     self->opus_file = NULL;
+    self->pcm = NULL;
+    self->samples = NULL;
+    self->decode_ahead = NULL;
     self->audiotools_pcm = NULL;
     self->closed = 0;
 
-    if (!PyArg_ParseTuple(args, "s", &filename))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|i", kwlist,
+                                     &filename,
+                                     &decode_ahead))
+        return -1;
+
+    if (decode_ahead < 0) {
+        PyErr_SetString(PyExc_ValueError, "decode_ahead must be >= 0");
         return -1;
+    }
 
     if ((self->opus_file = op_open_file(filename, &error)) == NULL) {
         PyErr_SetString(PyExc_ValueError, "error opening Opus file");
@@ -55,15 +87,40 @@ OpusDecoder_init(decoders_OpusDecoder *self,
     if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL)
         return -1;
 
+    self->pcm = malloc(sizeof(opus_int16) * BUF_SIZE);
+
+    /*start decoding blocks ahead of read() on a separate thread, if requested,
+      which takes over the stream until the decoder is closed*/
+    if (decode_ahead > 0) {
+        if ((self->decode_ahead =
+             decode_ahead_open(self,
+                               (da_decode_f)decode_block,
+                               (unsigned)self->channel_count,
+                               BUF_SIZE / self->channel_count,
+                               (unsigned)decode_ahead)) == NULL) {
+            PyErr_SetString(PyExc_OSError, "unable to start decoding thread");
+            return -1;
+        }
+    } else {
+        self->samples = malloc(sizeof(int) * BUF_SIZE);
+    }
+
     return 0;
 }
 
 void
 OpusDecoders_dealloc(decoders_OpusDecoder *self)
 {
+    /*the decoding thread must be stopped before the stream is freed*/
+    if (self->decode_ahead)
+        decode_ahead_close(self->decode_ahead);
+
     if (self->opus_file != NULL)
         op_free(self->opus_file);
 
+    free(self->pcm);
+    free(self->samples);
+
     Py_XDECREF(self->audiotools_pcm);
 
     Py_TYPE(self)->tp_free((PyObject*)self);
@@ -153,137 +210,51 @@ OpusDecoder_channel_mask(decoders_OpusDecoder *self, void *closure)
     return Py_BuildValue("i", channel_mask);
 }
 
-/*assume at least 120ms across 8 channels, minimum*/
-#define BUF_SIZE 5760 * 8
-#define BITS_PER_SAMPLE 16
-
 static PyObject*
 OpusDecoder_read(decoders_OpusDecoder* self, PyObject *args)
 {
-    static opus_int16 pcm[BUF_SIZE];
-    int pcm_frames_read;
+    PyObject *framelist;
 
     if (self->closed) {
         PyErr_SetString(PyExc_ValueError, "stream is closed");
         return NULL;
     }
 
-    if ((pcm_frames_read = op_read(self->opus_file,
-                                   pcm,
-                                   BUF_SIZE,
-                                   NULL)) >= 0) {
-        const int channel_count = op_head(self->opus_file, -1)->channel_count;
-        int i;
-        pcm_FrameList *framelist = new_FrameList(self->audiotools_pcm,
-                                                 channel_count,
-                                                 BITS_PER_SAMPLE,
-                                                 pcm_frames_read);
-        int *samples = framelist->samples;
-
-        for (i = 0; i < pcm_frames_read * channel_count; i++) {
-            samples[i] = pcm[i];
-        }
-
-        /*reorder channels to .wav order if necessary*/
-        switch (self->channel_count) {
-        case 1:
-        case 2:
-        default:
-            /*no change*/
-            break;
-        case 3:
-            /*fL fC fR -> fL fR fC*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-            break;
-        case 4:
-            /*fL fR bL bR -> fL fR bL bR*/
-            /*no change*/
-            break;
-        case 5:
-            /*fL fC fR bL bR -> fL fR fC bL bR*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-            break;
-        case 6:
-            /*fL fC fR bL bR LFE -> fL fR fC bL bR LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-
-            /*fL fR fC bL bR LFE -> fL fR fC LFE bR bL*/
-            swap_channel_data(samples, 3, 5,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-
-            /*fL fR fC LFE bR bL -> fL fR fC LFE bL bR*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-            break;
-        case 7:
-            /*fL fC fR sL sR bC LFE -> fL fR fC sL sR bC LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-
-            /*fL fR fC sL sR bC LFE -> fL fR fC LFE sR bC sL*/
-            swap_channel_data(samples, 3, 6,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
+    if (self->decode_ahead) {
+        /*pop the next block already decoded by the decoding thread*/
+        const struct da_block *block;
 
-            /*fL fR fC LFE sR bC sL -> fL fR fC LFE bC sR sL*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-
-            /*fL fR fC LFE bC sR sL -> fL fR fC LFE bC sL sR*/
-            swap_channel_data(samples, 5, 6,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-            break;
-        case 8:
-            /*fL fC fR sL sR bL bR LFE -> fL fR fC sL sR bL bR LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-
-            /*fL fR fC sL sR bL bR LFE -> fL fR fC LFE sR bL bR sL*/
-            swap_channel_data(samples, 3, 6,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
+        Py_BEGIN_ALLOW_THREADS
+        block = decode_ahead_next(self->decode_ahead);
+        Py_END_ALLOW_THREADS
 
-            /*fL fR fC LFE sR bL bR sL -> fL fR fC LFE bL sR bR sL*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
+        framelist = block_to_FrameList(self, block);
+        decode_ahead_release(self->decode_ahead);
+    } else {
+        struct da_block block;
 
-            /*fL fR fC LFE bL sR bR sL -> fL fR fC LFE bL bR sR sL*/
-            swap_channel_data(samples, 5, 6,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
+        block.samples = self->samples;
 
-            /*fL fR fC LFE bL bR sR sL -> fL fR fC LFE bL bR sL sR*/
-            swap_channel_data(samples, 6, 7,
-                              self->channel_count,
-                              (unsigned)pcm_frames_read);
-            break;
-        }
+        Py_BEGIN_ALLOW_THREADS
+        decode_block(self, BUF_SIZE / self->channel_count, &block);
+        Py_END_ALLOW_THREADS
 
-        return (PyObject*)framelist;
-    } else {
-        /*some sort of read error occurred*/
-        PyErr_SetString(PyExc_ValueError, "error reading from file");
-        return NULL;
+        framelist = block_to_FrameList(self, &block);
     }
+
+    return framelist;
 }
 
 static PyObject*
 OpusDecoder_close(decoders_OpusDecoder* self, PyObject *args)
 {
     self->closed = 1;
+
+    if (self->decode_ahead) {
+        decode_ahead_close(self->decode_ahead);
+        self->decode_ahead = NULL;
+    }
+
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -299,6 +270,158 @@ static PyObject*
 OpusDecoder_exit(decoders_OpusDecoder* self, PyObject *args)
 {
     self->closed = 1;
+
+    if (self->decode_ahead) {
+        decode_ahead_close(self->decode_ahead);
+        self->decode_ahead = NULL;
+    }
+
     Py_INCREF(Py_None);
     return Py_None;
 }
+
+static void
+decode_block(decoders_OpusDecoder *self,
+             unsigned max_pcm_frames,
+             struct da_block *block)
+{
+    const int pcm_frames_read =
+        op_read(self->opus_file,
+                self->pcm,
+                (int)(max_pcm_frames * self->channel_count),
+                NULL);
+
+    if (pcm_frames_read > 0) {
+        const unsigned total_samples =
+            (unsigned)pcm_frames_read * self->channel_count;
+        unsigned i;
+
+        for (i = 0; i < total_samples; i++) {
+            block->samples[i] = self->pcm[i];
+        }
+
+        reorder_channels(block->samples,
+                         self->channel_count,
+                         (unsigned)pcm_frames_read);
+
+        block->status = DA_OK;
+        block->pcm_frames = (unsigned)pcm_frames_read;
+    } else if (pcm_frames_read == 0) {
+        block->status = DA_FINISHED;
+        block->pcm_frames = 0;
+    } else {
+        /*some sort of read error occurred*/
+        block->status = DA_ERROR;
+        block->pcm_frames = 0;
+        block->error = "error reading from file";
+        block->io_error = 0;
+    }
+}
+
+static void
+reorder_channels(int samples[], int channel_count, unsigned pcm_frames)
+{
+    switch (channel_count) {
+    case 1:
+    case 2:
+    default:
+        /*no change*/
+        break;
+    case 3:
+        /*fL fC fR -> fL fR fC*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+        break;
+    case 4:
+        /*fL fR bL bR -> fL fR bL bR*/
+        /*no change*/
+        break;
+    case 5:
+        /*fL fC fR bL bR -> fL fR fC bL bR*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+        break;
+    case 6:
+        /*fL fC fR bL bR LFE -> fL fR fC bL bR LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC bL bR LFE -> fL fR fC LFE bR bL*/
+        swap_channel_data(samples, 3, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bR bL -> fL fR fC LFE bL bR*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+        break;
+    case 7:
+        /*fL fC fR sL sR bC LFE -> fL fR fC sL sR bC LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC sL sR bC LFE -> fL fR fC LFE sR bC sL*/
+        swap_channel_data(samples, 3, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE sR bC sL -> fL fR fC LFE bC sR sL*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bC sR sL -> fL fR fC LFE bC sL sR*/
+        swap_channel_data(samples, 5, 6,
+                          channel_count, pcm_frames);
+        break;
+    case 8:
+        /*fL fC fR sL sR bL bR LFE -> fL fR fC sL sR bL bR LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC sL sR bL bR LFE -> fL fR fC LFE sR bL bR sL*/
+        swap_channel_data(samples, 3, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE sR bL bR sL -> fL fR fC LFE bL sR bR sL*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bL sR bR sL -> fL fR fC LFE bL bR sR sL*/
+        swap_channel_data(samples, 5, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bL bR sR sL -> fL fR fC LFE bL bR sL sR*/
+        swap_channel_data(samples, 6, 7,
+                          channel_count, pcm_frames);
+        break;
+    }
+}
+
+static PyObject*
+block_to_FrameList(decoders_OpusDecoder *self,
+                   const struct da_block *block)
+{
+    switch (block->status) {
+    case DA_OK:
+    default:
+        {
+            pcm_FrameList *framelist =
+                new_FrameList(self->audiotools_pcm,
+                              self->channel_count,
+                              BITS_PER_SAMPLE,
+                              block->pcm_frames);
+
+            memcpy(framelist->samples,
+                   block->samples,
+                   sizeof(int) * self->channel_count * block->pcm_frames);
+
+            return (PyObject*)framelist;
+        }
+    case DA_FINISHED:
+        return empty_FrameList(self->audiotools_pcm,
+                               self->channel_count,
+                               BITS_PER_SAMPLE);
+    case DA_ERROR:
+        PyErr_SetString(block->io_error ? PyExc_IOError : PyExc_ValueError,
+                        block->error);
+        return NULL;
+    }
+}
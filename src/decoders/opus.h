@@ -1,6 +1,7 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <opus/opusfile.h>
+#include "decode_ahead.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -28,6 +29,18 @@ typedef struct {
 
     int channel_count;
     int closed;
+
+    /*interleaved 16-bit output from op_read()*/
+    opus_int16 *pcm;
+
+    /*interleaved output of the most recent block
+      when decoding synchronously*/
+    int *samples;
+
+    /*if not NULL, blocks are decoded on a separate thread
+      and read() pops them from this*/
+    DecodeAhead *decode_ahead;
+
     PyObject *audiotools_pcm;
 } decoders_OpusDecoder;
 
@@ -0,0 +1,412 @@
+#include "speex.h"
+#include "../framelist.h"
+#include <speex/speex_header.h>
+#include <speex/speex_callbacks.h>
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+static PyObject*
+SpeexDecoder_new(PyTypeObject *type,
+                 PyObject *args, PyObject *kwds)
+{
+    decoders_SpeexDecoder *self;
+
+    self = (decoders_SpeexDecoder *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+SpeexDecoder_init(decoders_SpeexDecoder *self,
+                  PyObject *args, PyObject *kwds)
+{
+    char *filename;
+    ogg_status status;
+    SpeexHeader *header;
+    const SpeexMode *mode;
+    SpeexCallback callback;
+    int frame_size;
+    int enhancement = 1;
+    int rate;
+    unsigned extra_headers;
+
+    self->ogg_file = NULL;
+    self->ogg_packets = NULL;
+    self->decoder = NULL;
+    self->stereo = NULL;
+    self->packet = NULL;
+    self->packet_size = 0;
+    self->packet_capacity = 0;
+    self->decoded = NULL;
+    self->audio_started = 0;
+    self->skip = 0;
+    self->frames_returned = 0;
+    self->closed = 0;
+    self->audiotools_pcm = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &filename))
+        return -1;
+
+    if ((self->ogg_file = fopen(filename, "rb")) == NULL) {
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, filename);
+        return -1;
+    } else {
+        self->ogg_packets = oggiterator_open(self->ogg_file);
+    }
+
+    /*the bits are released in dealloc,
+      so initialize them before anything can fail*/
+    speex_bits_init(&self->bits);
+
+    /*the first packet is the Speex header*/
+    if ((status = read_packet(self)) != OGG_OK) {
+        PyErr_SetString(ogg_exception(status), ogg_strerror(status));
+        return -1;
+    }
+
+    if ((header = speex_packet_to_header((char*)self->packet,
+                                         (int)self->packet_size)) == NULL) {
+        PyErr_SetString(PyExc_ValueError, "invalid Speex header");
+        return -1;
+    }
+
+    if ((header->mode < 0) || (header->mode >= SPEEX_NB_MODES)) {
+        speex_header_free(header);
+        PyErr_SetString(PyExc_ValueError, "invalid Speex mode");
+        return -1;
+    }
+    mode = speex_lib_get_mode(header->mode);
+    if (header->mode_bitstream_version != mode->bitstream_version) {
+        speex_header_free(header);
+        PyErr_SetString(PyExc_ValueError,
+                        "unsupported Speex bitstream version");
+        return -1;
+    }
+    if ((header->nb_channels != 1) && (header->nb_channels != 2)) {
+        speex_header_free(header);
+        PyErr_SetString(PyExc_ValueError, "invalid Speex channel count");
+        return -1;
+    }
+    if (header->rate <= 0) {
+        speex_header_free(header);
+        PyErr_SetString(PyExc_ValueError, "invalid Speex sample rate");
+        return -1;
+    }
+
+    self->mode_id = header->mode;
+    self->sample_rate = (unsigned)header->rate;
+    self->channels = (unsigned)header->nb_channels;
+    self->frames_per_packet =
+        header->frames_per_packet > 0 ? (unsigned)header->frames_per_packet : 1;
+    extra_headers =
+        header->extra_headers > 0 ? (unsigned)header->extra_headers : 0;
+    speex_header_free(header);
+
+    /*setup decoder much as speexdec does, with perceptual enhancement*/
+    self->decoder = speex_decoder_init(mode);
+    speex_decoder_ctl(self->decoder, SPEEX_GET_FRAME_SIZE, &frame_size);
+    self->frame_size = (unsigned)frame_size;
+    speex_decoder_ctl(self->decoder, SPEEX_SET_ENH, &enhancement);
+    rate = (int)self->sample_rate;
+    speex_decoder_ctl(self->decoder, SPEEX_SET_SAMPLING_RATE, &rate);
+
+    /*stereo information arrives in-band alongside the mono frames*/
+    self->stereo = speex_stereo_state_init();
+    callback.callback_id = SPEEX_INBAND_STEREO;
+    callback.func = speex_std_stereo_request_handler;
+    callback.data = self->stereo;
+    speex_decoder_ctl(self->decoder, SPEEX_SET_HANDLER, &callback);
+
+    self->decoded = malloc(sizeof(int16_t) *
+                           self->frame_size *
+                           self->frames_per_packet *
+                           self->channels);
+
+    /*skip the comment packet and any extra headers*/
+    for (extra_headers += 1; extra_headers; extra_headers--) {
+        if ((status = read_packet(self)) != OGG_OK) {
+            PyErr_SetString(ogg_exception(status), ogg_strerror(status));
+            return -1;
+        }
+    }
+
+    if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL)
+        return -1;
+
+    return 0;
+}
+
+void
+SpeexDecoder_dealloc(decoders_SpeexDecoder *self)
+{
+    /*closing the iterator also closes its file*/
+    if (self->ogg_packets != NULL) {
+        oggiterator_close(self->ogg_packets);
+        speex_bits_destroy(&self->bits);
+    } else if (self->ogg_file != NULL) {
+        fclose(self->ogg_file);
+    }
+    if (self->decoder) {
+        speex_decoder_destroy(self->decoder);
+    }
+    if (self->stereo) {
+        speex_stereo_state_destroy(self->stereo);
+    }
+    free(self->packet);
+    free(self->decoded);
+    Py_XDECREF(self->audiotools_pcm);
+
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+SpeexDecoder_sample_rate(decoders_SpeexDecoder *self, void *closure)
+{
+    return Py_BuildValue("I", self->sample_rate);
+}
+
+static PyObject*
+SpeexDecoder_bits_per_sample(decoders_SpeexDecoder *self, void *closure)
+{
+    return Py_BuildValue("i", 16);
+}
+
+static PyObject*
+SpeexDecoder_channels(decoders_SpeexDecoder *self, void *closure)
+{
+    return Py_BuildValue("I", self->channels);
+}
+
+static PyObject*
+SpeexDecoder_channel_mask(decoders_SpeexDecoder *self, void *closure)
+{
+    return Py_BuildValue("I", self->channels == 2 ? 0x3 : 0x4);
+}
+
+static PyObject*
+SpeexDecoder_read(decoders_SpeexDecoder* self, PyObject *args)
+{
+    if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "cannot read closed stream");
+        return NULL;
+    }
+
+    /*decode packets until one generates some output
+      since leading packets may be entirely encoder delay*/
+    for (;;) {
+        const struct ogg_page_header *page = &(self->ogg_packets->page.header);
+        ogg_status status;
+        int decoded;
+        unsigned start;
+        unsigned end;
+
+        switch (status = read_packet(self)) {
+        case OGG_OK:
+            break;
+        case OGG_STREAM_FINISHED:
+            return empty_FrameList(self->audiotools_pcm, self->channels, 16);
+        default:
+            PyErr_SetString(ogg_exception(status), ogg_strerror(status));
+            return NULL;
+        }
+
+        if (!self->audio_started) {
+            self->skip = leading_delay(self);
+            self->audio_started = 1;
+        }
+
+        if ((decoded = decode_packet(self)) < 0) {
+            return NULL;
+        }
+
+        /*drop any encoder delay from the start of the stream*/
+        start = (unsigned)decoded < self->skip ? (unsigned)decoded : self->skip;
+        self->skip -= start;
+        end = (unsigned)decoded;
+
+        /*and any padding from the end of the stream*/
+        if (page->stream_end && (page->granule_position >= 0)) {
+            const int64_t remaining =
+                page->granule_position - self->frames_returned;
+            if (remaining <= 0) {
+                end = start;
+            } else if (remaining < (end - start)) {
+                end = start + (unsigned)remaining;
+            }
+        }
+
+        if (end > start) {
+            pcm_FrameList *framelist = new_FrameList(self->audiotools_pcm,
+                                                     self->channels,
+                                                     16,
+                                                     end - start);
+            const int16_t *samples =
+                self->decoded + (start * self->channels);
+            unsigned i;
+
+            for (i = 0; i < (end - start) * self->channels; i++) {
+                framelist->samples[i] = samples[i];
+            }
+            self->frames_returned += (end - start);
+
+            return (PyObject*)framelist;
+        }
+    }
+}
+
+static PyObject*
+SpeexDecoder_close(decoders_SpeexDecoder* self, PyObject *args)
+{
+    /*mark stream as closed so more calls to read()
+      generate ValueErrors*/
+    self->closed = 1;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+SpeexDecoder_enter(decoders_SpeexDecoder* self, PyObject *args)
+{
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject*
+SpeexDecoder_exit(decoders_SpeexDecoder* self, PyObject *args)
+{
+    self->closed = 1;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/**************************************/
+/*  private function implementations  */
+/**************************************/
+
+static ogg_status
+read_packet(decoders_SpeexDecoder *self)
+{
+    uint8_t *segment_data;
+    uint8_t segment_size;
+    ogg_status status;
+
+    self->packet_size = 0;
+
+    do {
+        if ((status = oggiterator_next_segment(self->ogg_packets,
+                                               &segment_data,
+                                               &segment_size)) != OGG_OK) {
+            return status;
+        }
+        if ((self->packet_size + segment_size) > self->packet_capacity) {
+            self->packet_capacity += 0x1000;
+            self->packet = realloc(self->packet, self->packet_capacity);
+        }
+        memcpy(self->packet + self->packet_size, segment_data, segment_size);
+        self->packet_size += segment_size;
+    } while (segment_size == 255);
+
+    return OGG_OK;
+}
+
+static unsigned
+leading_delay(decoders_SpeexDecoder *self)
+{
+    const struct ogg_page_header *page = &(self->ogg_packets->page.header);
+    const unsigned packet_frames = self->frame_size * self->frames_per_packet;
+    unsigned packets = 1;
+    unsigned i;
+    int64_t excess;
+
+    if (page->granule_position < 0) {
+        return 0;
+    }
+
+    /*count the first packet and any others completing on its page*/
+    for (i = self->ogg_packets->current_segment;
+         i < page->segment_count;
+         i++) {
+        if (page->segment_lengths[i] < 255) {
+            packets += 1;
+        }
+    }
+
+    excess = ((int64_t)packets * packet_frames) - page->granule_position;
+    if (excess <= 0) {
+        return 0;
+    } else if (!page->stream_end) {
+        return (unsigned)excess;
+    } else {
+        /*when the whole stream fits on a single page, the excess
+          is both leading delay and trailing padding
+          so take only the encoder's lookahead from the start
+          and leave the remainder to be clipped from the end*/
+        void *encoder = speex_encoder_init(speex_lib_get_mode(self->mode_id));
+        int lookahead;
+
+        speex_encoder_ctl(encoder, SPEEX_GET_LOOKAHEAD, &lookahead);
+        speex_encoder_destroy(encoder);
+
+        return lookahead < excess ? (unsigned)lookahead : (unsigned)excess;
+    }
+}
+
+static int
+decode_packet(decoders_SpeexDecoder *self)
+{
+    unsigned pcm_frames = 0;
+    unsigned i;
+
+    speex_bits_read_from(&self->bits,
+                         (char*)self->packet,
+                         (int)self->packet_size);
+
+    for (i = 0; i < self->frames_per_packet; i++) {
+        int16_t *output = self->decoded + (pcm_frames * self->channels);
+
+        switch (speex_decode_int(self->decoder, &self->bits, output)) {
+        case -1:
+            /*end of stream marker*/
+            return (int)pcm_frames;
+        case -2:
+            PyErr_SetString(PyExc_ValueError, "corrupted Speex stream");
+            return -1;
+        default:
+            break;
+        }
+
+        if (speex_bits_remaining(&self->bits) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Speex frame overflow");
+            return -1;
+        }
+
+        if (self->channels == 2) {
+            speex_decode_stereo_int(output, (int)self->frame_size,
+                                    self->stereo);
+        }
+
+        pcm_frames += self->frame_size;
+    }
+
+    return (int)pcm_frames;
+}
@@ -0,0 +1,178 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <speex/speex.h>
+#include <speex/speex_stereo.h>
+#include "../ogg.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+typedef struct {
+    PyObject_HEAD
+
+    FILE *ogg_file;
+    OggPacketIterator *ogg_packets;
+
+    void *decoder;
+    SpeexBits bits;
+    SpeexStereoState *stereo;
+    int mode_id;
+
+    unsigned sample_rate;
+    unsigned channels;
+    unsigned frame_size;         /*PCM frames per Speex frame*/
+    unsigned frames_per_packet;  /*Speex frames per Ogg packet*/
+
+    /*the current Ogg packet, assembled from its segments*/
+    uint8_t *packet;
+    unsigned packet_size;
+    unsigned packet_capacity;
+
+    /*a whole packet's worth of decoded, interleaved samples*/
+    int16_t *decoded;
+
+    /*whether the first audio packet has been read
+      which is when the stream's leading delay is determined*/
+    int audio_started;
+
+    unsigned skip;             /*PCM frames to discard from the start*/
+    int64_t frames_returned;   /*PCM frames returned by read() so far*/
+
+    int closed;
+
+    PyObject *audiotools_pcm;
+} decoders_SpeexDecoder;
+
+static PyObject*
+SpeexDecoder_new(PyTypeObject *type,
+                 PyObject *args, PyObject *kwds);
+
+int
+SpeexDecoder_init(decoders_SpeexDecoder *self,
+                  PyObject *args, PyObject *kwds);
+
+void
+SpeexDecoder_dealloc(decoders_SpeexDecoder *self);
+
+static PyObject*
+SpeexDecoder_sample_rate(decoders_SpeexDecoder *self, void *closure);
+
+static PyObject*
+SpeexDecoder_bits_per_sample(decoders_SpeexDecoder *self, void *closure);
+
+static PyObject*
+SpeexDecoder_channels(decoders_SpeexDecoder *self, void *closure);
+
+static PyObject*
+SpeexDecoder_channel_mask(decoders_SpeexDecoder *self, void *closure);
+
+static PyObject*
+SpeexDecoder_read(decoders_SpeexDecoder* self, PyObject *args);
+
+static PyObject*
+SpeexDecoder_close(decoders_SpeexDecoder* self, PyObject *args);
+
+static PyObject*
+SpeexDecoder_enter(decoders_SpeexDecoder* self, PyObject *args);
+
+static PyObject*
+SpeexDecoder_exit(decoders_SpeexDecoder* self, PyObject *args);
+
+/*assembles the next Ogg packet into the decoder's packet buffer*/
+static ogg_status
+read_packet(decoders_SpeexDecoder *self);
+
+/*given the first audio packet,
+  determines how many leading PCM frames are encoder delay
+  from the granule position of the page it completes on*/
+static unsigned
+leading_delay(decoders_SpeexDecoder *self);
+
+/*decodes the current packet into the decoder's sample buffer
+  returns the number of PCM frames decoded, or -1 on error
+  with the Python exception set*/
+static int
+decode_packet(decoders_SpeexDecoder *self);
+
+PyGetSetDef SpeexDecoder_getseters[] = {
+    {"sample_rate",
+     (getter)SpeexDecoder_sample_rate, NULL, "sample rate", NULL},
+    {"bits_per_sample",
+     (getter)SpeexDecoder_bits_per_sample, NULL, "bits-per-sample", NULL},
+    {"channels",
+     (getter)SpeexDecoder_channels, NULL, "channels", NULL},
+    {"channel_mask",
+     (getter)SpeexDecoder_channel_mask, NULL, "channel mask", NULL},
+    {NULL}
+};
+
+PyMethodDef SpeexDecoder_methods[] = {
+    {"read", (PyCFunction)SpeexDecoder_read,
+     METH_VARARGS, "read(pcm_frame_count) -> FrameList"},
+    {"close", (PyCFunction)SpeexDecoder_close,
+     METH_NOARGS, "close() -> None"},
+    {"__enter__", (PyCFunction)SpeexDecoder_enter,
+     METH_NOARGS, "enter() -> self"},
+    {"__exit__", (PyCFunction)SpeexDecoder_exit,
+     METH_VARARGS, "exit(exc_type, exc_value, traceback) -> None"},
+    {NULL}
+};
+
+PyTypeObject decoders_SpeexDecoderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "decoders.SpeexDecoder",   /* tp_name */
+    sizeof(decoders_SpeexDecoder), /* tp_basicsize */
+    0,                         /* tp_itemsize */
+    (destructor)SpeexDecoder_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_reserved */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    0,                         /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash  */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    0,                         /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT |
+    Py_TPFLAGS_BASETYPE,       /* tp_flags */
+    "SpeexDecoder objects",    /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    SpeexDecoder_methods,      /* tp_methods */
+    0,                         /* tp_members */
+    SpeexDecoder_getseters,    /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)SpeexDecoder_init, /* tp_init */
+    0,                         /* tp_alloc */
+    SpeexDecoder_new,          /* tp_new */
+};
@@ -5,6 +5,8 @@
 
 #include <stdint.h>
 #include "../bitstream.h"
+#include "tta_frame.h"
+#include "../framelist.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -49,6 +51,9 @@ typedef struct {
     /*a framelist generator*/
     PyObject* audiotools_pcm;
 
+    /*the remainder of a TTA frame too large for the last read*/
+    struct frame_buffer buffer;
+
     /*position of start of frames*/
     br_pos_t* frames_start;
 } decoders_TTADecoder;
@@ -65,6 +70,9 @@ TTADecoder_channels(decoders_TTADecoder *self, void *closure);
 static PyObject*
 TTADecoder_channel_mask(decoders_TTADecoder *self, void *closure);
 
+/*reads as many whole TTA frames as fit in the requested
+  number of PCM frames into a single FrameList
+  keeping any remainder of the last one for the next read*/
 static PyObject*
 TTADecoder_read(decoders_TTADecoder *self, PyObject *args);
 
@@ -0,0 +1,407 @@
+#include "tta_frame.h"
+#include "../common/tta_crc.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+struct residual_params {
+    unsigned k0;
+    unsigned k1;
+    unsigned sum0;
+    unsigned sum1;
+};
+
+struct filter_params {
+    unsigned shift;
+    int previous_residual;
+    int round;
+    int qm[8];
+    int dx[8];
+    int dl[8];
+};
+
+struct prediction_params {
+    unsigned shift;
+    int previous_sample;
+};
+
+/*******************************
+ * private function signatures *
+ *******************************/
+
+static void
+init_residual_params(struct residual_params *params);
+
+/*given raw TTA frame data and residual parameters,
+  updates the parameters and returns the next residual*/
+static int
+read_residual(struct residual_params *params, BitstreamReader *frame);
+
+static void
+init_filter_params(unsigned bits_per_sample,
+                   struct filter_params *params);
+
+/*given a residual and filter parameters,
+  updates the parameters and returns a predicted sample*/
+static int
+run_filter(struct filter_params *params, int residual);
+
+static void
+init_prediction_params(unsigned bits_per_sample,
+                       struct prediction_params *params);
+
+/*given a filtered sample and prediction parameters,
+  updates the parameters and returns a predicted sample*/
+static int
+run_prediction(struct prediction_params *params, int filtered);
+
+/*given a PCM frame's worth of predicted samples and channel count,
+  decorrelates the samples into "samples"
+  whose channels are "stride" entries apart*/
+static void
+decorrelate_channels(unsigned channel_count,
+                     const int predicted[],
+                     unsigned stride,
+                     int samples[]);
+
+/***********************************
+ * public function implementations *
+ ***********************************/
+
+void
+tta_checksum_init(BitstreamReader *frame, tta_checksum *checksum)
+{
+    checksum->crc32 = 0xFFFFFFFF;
+    checksum->is_valid = 0;
+
+    frame->add_callback(frame,
+                        (bs_callback_f)tta_crc32,
+                        &checksum->crc32);
+}
+
+void
+tta_checksum_validate(BitstreamReader *frame, tta_checksum *checksum)
+{
+    uint32_t frame_crc32;
+    frame->pop_callback(frame, NULL);
+    frame_crc32 = frame->read(frame, 32);
+    checksum->is_valid = (frame_crc32 == (checksum->crc32 ^ 0xFFFFFFFF));
+}
+
+void
+tta_checksum_clear(BitstreamReader *frame)
+{
+    if (frame->callbacks != NULL) {
+        frame->pop_callback(frame, NULL);
+    }
+}
+
+tta_status
+ttadec_decode_frame(BitstreamReader *frame,
+                    unsigned channels,
+                    unsigned bits_per_sample,
+                    unsigned block_size,
+                    int samples[])
+{
+    tta_checksum checksum;
+    struct residual_params residual_params[channels];
+    struct filter_params filter_params[channels];
+    struct prediction_params prediction_params[channels];
+    const unsigned stride = block_size;
+    unsigned c;
+
+    /*initialize per-channel parameters*/
+    for (c = 0; c < channels; c++) {
+        init_residual_params(&residual_params[c]);
+        init_filter_params(bits_per_sample, &filter_params[c]);
+        init_prediction_params(bits_per_sample, &prediction_params[c]);
+    }
+
+    tta_checksum_init(frame, &checksum);
+
+    if (!setjmp(*br_try(frame))) {
+        /*decode one PCM frame at a time*/
+        for (; block_size; block_size--) {
+            int predicted[channels];
+
+            for (c = 0; c < channels; c++) {
+                /*run fixed prediction over filtered value*/
+                predicted[c] = run_prediction(
+                    &prediction_params[c],
+                    /*run hybrid filter over residual*/
+                    run_filter(
+                        &filter_params[c],
+                        /*decode a residual*/
+                        read_residual(
+                            &residual_params[c],
+                            frame)));
+            }
+
+            /*decorrelate channels to samples*/
+            decorrelate_channels(channels,
+                                 predicted,
+                                 stride,
+                                 samples);
+
+            /*move on to next PCM frame*/
+            samples += 1;
+        }
+
+        frame->byte_align(frame);
+        tta_checksum_validate(frame, &checksum);
+        br_etry(frame);
+    } else {
+        tta_checksum_clear(frame);
+        br_etry(frame);
+        return IO_ERROR;
+    }
+
+    return checksum.is_valid ? OK : CRC_MISMATCH;
+}
+
+#ifndef STANDALONE
+PyObject*
+tta_exception(tta_status error)
+{
+    switch (error) {
+    case OK:
+    default:
+    case CRC_MISMATCH:
+    case INVALID_SIGNATURE:
+    case INVALID_FORMAT:
+        return PyExc_ValueError;
+    case IO_ERROR:
+    case FRAME_TOO_SMALL:
+        return PyExc_IOError;
+    }
+}
+#endif
+
+const char*
+tta_strerror(tta_status error)
+{
+    switch (error) {
+    case OK:
+    default:
+        return "no error";
+    case IO_ERROR:
+        return "I/O error";
+    case CRC_MISMATCH:
+        return "CRC-32 mismatch";
+    case FRAME_TOO_SMALL:
+        return "frame too small";
+    case INVALID_SIGNATURE:
+        return "invalid file signature";
+    case INVALID_FORMAT:
+        return "invalid file format";
+    }
+}
+
+/************************************
+ * private function implementations *
+ ************************************/
+
+static void
+init_residual_params(struct residual_params *params)
+{
+    params->k0 = params->k1 = 10;
+    params->sum0 = params->sum1 = 1 << 14;
+}
+
+static inline int
+adjustment(unsigned sum, unsigned k)
+{
+    if ((k > 0) && (1u << (k + 4) > sum)) {
+        return -1;
+    } else if (sum > (1u << (k + 5))) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+static int
+read_residual(struct residual_params *params, BitstreamReader *frame)
+{
+    const unsigned MSB = frame->read_unary(frame, 0);
+    int unsigned_;
+    int residual;
+
+    if (MSB) {
+        const unsigned LSB = frame->read(frame, params->k1);
+        const unsigned unshifted = ((MSB - 1) << params->k1) | LSB;
+        unsigned_ = unshifted + (1 << params->k0);
+        params->sum1 += (unshifted - (params->sum1 >> 4));
+        params->k1 += adjustment(params->sum1, params->k1);
+    } else {
+        unsigned_ = frame->read(frame, params->k0);
+    }
+
+    if (unsigned_ % 2) {
+        residual = (unsigned_ + 1) >> 1;
+    } else {
+        residual = -(unsigned_ >> 1);
+    }
+    params->sum0 += (unsigned_ - (params->sum0 >> 4));
+    params->k0 += adjustment(params->sum0, params->k0);
+
+    return residual;
+}
+
+static void
+init_filter_params(unsigned bits_per_sample,
+                   struct filter_params *params)
+{
+    switch (bits_per_sample) {
+    case 8:
+        params->shift = 10;
+        break;
+    case 16:
+        params->shift = 9;
+        break;
+    case 24:
+        params->shift = 10;
+        break;
+    }
+    params->previous_residual = 0;
+    params->round = 1 << (params->shift - 1);
+    params->qm[0] =
+    params->qm[1] =
+    params->qm[2] =
+    params->qm[3] =
+    params->qm[4] =
+    params->qm[5] =
+    params->qm[6] =
+    params->qm[7] = 0;
+    params->dx[0] =
+    params->dx[1] =
+    params->dx[2] =
+    params->dx[3] =
+    params->dx[4] =
+    params->dx[5] =
+    params->dx[6] =
+    params->dx[7] = 0;
+    params->dl[0] =
+    params->dl[1] =
+    params->dl[2] =
+    params->dl[3] =
+    params->dl[4] =
+    params->dl[5] =
+    params->dl[6] =
+    params->dl[7] = 0;
+}
+
+static inline int
+sign(int x) {
+    if (x > 0) {
+        return 1;
+    } else if (x < 0) {
+        return -1;
+    } else {
+        return 0;
+    }
+}
+
+static int
+run_filter(struct filter_params *params, int residual)
+{
+    const int previous_sign = sign(params->previous_residual);
+    int32_t sum = params->round;
+    int filtered = residual;
+
+    params->previous_residual = residual;
+
+    sum += params->dl[0] * (params->qm[0] += previous_sign * params->dx[0]);
+    sum += params->dl[1] * (params->qm[1] += previous_sign * params->dx[1]);
+    sum += params->dl[2] * (params->qm[2] += previous_sign * params->dx[2]);
+    sum += params->dl[3] * (params->qm[3] += previous_sign * params->dx[3]);
+    sum += params->dl[4] * (params->qm[4] += previous_sign * params->dx[4]);
+    sum += params->dl[5] * (params->qm[5] += previous_sign * params->dx[5]);
+    sum += params->dl[6] * (params->qm[6] += previous_sign * params->dx[6]);
+    sum += params->dl[7] * (params->qm[7] += previous_sign * params->dx[7]);
+
+    filtered += (sum >> params->shift);
+
+    params->dx[0] = params->dx[1];
+    params->dx[1] = params->dx[2];
+    params->dx[2] = params->dx[3];
+    params->dx[3] = params->dx[4];
+    params->dx[4] = params->dl[4] >= 0 ? 1 : -1;
+    params->dx[5] = params->dl[5] >= 0 ? 2 : -2;
+    params->dx[6] = params->dl[6] >= 0 ? 2 : -2;
+    params->dx[7] = params->dl[7] >= 0 ? 4 : -4;
+    params->dl[0] = params->dl[1];
+    params->dl[1] = params->dl[2];
+    params->dl[2] = params->dl[3];
+    params->dl[3] = params->dl[4];
+    params->dl[4] =
+        -(params->dl[5]) + (-(params->dl[6]) + (filtered - params->dl[7]));
+    params->dl[5] = -(params->dl[6]) + (filtered - params->dl[7]);
+    params->dl[6] = filtered - params->dl[7];
+    params->dl[7] = filtered;
+
+    return filtered;
+}
+
+static void
+init_prediction_params(unsigned bits_per_sample,
+                       struct prediction_params *params)
+{
+    switch (bits_per_sample) {
+    case 8:
+        params->shift = 4;
+        break;
+    case 16:
+        params->shift = 5;
+        break;
+    case 24:
+        params->shift = 5;
+        break;
+    }
+    params->previous_sample = 0;
+}
+
+static int
+run_prediction(struct prediction_params *params, int filtered)
+{
+    const int predicted =
+        filtered + (((params->previous_sample << params->shift) -
+                    params->previous_sample) >> params->shift);
+    params->previous_sample = predicted;
+    return predicted;
+}
+
+static void
+decorrelate_channels(unsigned channel_count,
+                     const int predicted[],
+                     unsigned stride,
+                     int samples[])
+{
+    if (channel_count == 1) {
+        samples[0] = predicted[0];
+    } else if (channel_count > 1) {
+        int sample = predicted[channel_count - 1] +
+                     (predicted[channel_count - 2] / 2);
+        samples[(channel_count - 1) * stride] = sample;
+        for (channel_count--; channel_count; channel_count--) {
+            sample -= predicted[channel_count - 1];
+            samples[(channel_count - 1) * stride] = sample;
+        }
+    }
+}
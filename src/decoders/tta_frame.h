@@ -0,0 +1,85 @@
+#ifndef TTA_FRAME_H
+#define TTA_FRAME_H
+
+#ifndef STANDALONE
+#include <Python.h>
+#endif
+#include <stdint.h>
+#include "../bitstream.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the TTA frame decoding engine shared by
+  the TTA decoder and the TTA encoder's verification
+
+  every function reads from a generic BitstreamReader
+  which may be a file stream or a single frame's bytes
+  and none of them hold state between frames*/
+
+typedef struct {
+    uint32_t crc32;
+    int is_valid;
+} tta_checksum;
+
+typedef enum {
+    OK,
+    IO_ERROR,
+    CRC_MISMATCH,
+    FRAME_TOO_SMALL,
+    INVALID_SIGNATURE,
+    INVALID_FORMAT
+} tta_status;
+
+/*initializes checksum on the given BitstreamReader*/
+void
+tta_checksum_init(BitstreamReader *frame, tta_checksum *checksum);
+
+/*sets checksum's is_valid field to 1 if the checksum validates
+  or sets it to 0 if the checksum does not validate
+
+  does not check for I/O errors when reading checksum
+
+  removes checksum callback from frame*/
+void
+tta_checksum_validate(BitstreamReader *frame, tta_checksum *checksum);
+
+/*stops calculating checksum from stream by removing callback*/
+void
+tta_checksum_clear(BitstreamReader *frame);
+
+/*decodes a TTA frame into "samples" as planar PCM data,
+  every sample of channel 0 followed by every sample of channel 1
+  and so on, each channel "block_size" samples long*/
+tta_status
+ttadec_decode_frame(BitstreamReader *frame,
+                    unsigned channels,
+                    unsigned bits_per_sample,
+                    unsigned block_size,
+                    int samples[]);
+
+#ifndef STANDALONE
+PyObject*
+tta_exception(tta_status error);
+#endif
+
+const char*
+tta_strerror(tta_status error);
+
+#endif
@@ -1,5 +1,6 @@
 #include "vorbis.h"
 #include "../framelist.h"
+#include <string.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -29,6 +30,24 @@
 
 #define BITS_PER_SAMPLE 16
 
+/*the maximum number of PCM frames decoded per read() call*/
+#define BLOCK_SIZE 4096
+
+/*decodes the next block of up to "max_pcm_frames" PCM frames
+  from the stream to "block", which may be on the decode-ahead thread*/
+static void
+decode_block(decoders_VorbisDecoder *self,
+             unsigned max_pcm_frames,
+             struct da_block *block);
+
+/*reorders interleaved samples from Vorbis channel order to .wav order*/
+static void
+reorder_channels(int samples[], int channel_count, unsigned pcm_frames);
+
+static PyObject*
+block_to_FrameList(decoders_VorbisDecoder *self,
+                   const struct da_block *block);
+
 PyObject*
 VorbisDecoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
     decoders_VorbisDecoder *self;
@@ -40,9 +59,15 @@ VorbisDecoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 
 void
 VorbisDecoder_dealloc(decoders_VorbisDecoder *self) {
+    /*the decoding thread must be stopped before the stream is cleared*/
+    if (self->decode_ahead)
+        decode_ahead_close(self->decode_ahead);
+
     if (self->open_ok)
         ov_clear(&(self->vorbisfile));
 
+    free(self->samples);
+
     Py_XDECREF(self->audiotools_pcm);
 
     Py_TYPE(self)->tp_free((PyObject*)self);
@@ -50,18 +75,29 @@ VorbisDecoder_dealloc(decoders_VorbisDecoder *self) {
 
 int
 VorbisDecoder_init(decoders_VorbisDecoder *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"filename", "decode_ahead", NULL};
     char* filename;
+    int decode_ahead = 0;
     vorbis_info* info;
 
     self->open_ok = 0;
     self->channel_count = 0;
     self->rate = 0;
     self->closed = 0;
+    self->samples = NULL;
+    self->decode_ahead = NULL;
     self->audiotools_pcm = NULL;
 
-    if (!PyArg_ParseTuple(args, "s", &filename))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|i", kwlist,
+                                     &filename,
+                                     &decode_ahead))
         return -1;
 
+    if (decode_ahead < 0) {
+        PyErr_SetString(PyExc_ValueError, "decode_ahead must be >= 0");
+        return -1;
+    }
+
     /*open file using reference Ogg Vorbis decoder*/
     switch (ov_fopen(filename, &(self->vorbisfile))) {
     case 0:
@@ -98,6 +134,24 @@ VorbisDecoder_init(decoders_VorbisDecoder *self, PyObject *args, PyObject *kwds)
     if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL)
         return -1;
 
+    /*start decoding blocks ahead of read() on a separate thread, if requested,
+      which takes over the stream until the decoder is closed*/
+    if (decode_ahead > 0) {
+        if ((self->decode_ahead =
+             decode_ahead_open(self,
+                               (da_decode_f)decode_block,
+                               (unsigned)self->channel_count,
+                               BLOCK_SIZE,
+                               (unsigned)decode_ahead)) == NULL) {
+            PyErr_SetString(PyExc_OSError, "unable to start decoding thread");
+            return -1;
+        }
+    } else {
+        self->samples = malloc(sizeof(int) *
+                               self->channel_count *
+                               BLOCK_SIZE);
+    }
+
     return 0;
 }
 
@@ -166,158 +220,47 @@ VorbisDecoder_channel_mask(decoders_VorbisDecoder *self, void *closure) {
 
 static PyObject*
 VorbisDecoder_read(decoders_VorbisDecoder *self, PyObject *args) {
-    int current_bitstream;
-    long samples_read;
-    float **pcm_channels;
+    PyObject *framelist;
 
     if (self->closed) {
         PyErr_SetString(PyExc_ValueError, "stream is closed");
         return NULL;
     }
 
-    samples_read = ov_read_float(&(self->vorbisfile),
-                                 &pcm_channels,
-                                 4096,
-                                 &current_bitstream);
-
-    if (samples_read >= 0) {
-        /*convert floating point samples to integer-based ones*/
-        pcm_FrameList *framelist;
-        int *samples;
-        int c;
-
-        if (samples_read == 0) {
-            if (self->vorbisfile.os.e_o_s == 0) {
-                /*EOF encountered without EOF being marked in stream*/
-                PyErr_SetString(PyExc_IOError,
-                                "I/O error reading from Ogg stream");
-                return NULL;
-            } else {
-                return empty_FrameList(self->audiotools_pcm,
-                                       self->channel_count,
-                                       BITS_PER_SAMPLE);
-            }
-        }
-
-        framelist = new_FrameList(self->audiotools_pcm,
-                                  self->channel_count,
-                                  BITS_PER_SAMPLE,
-                                  (unsigned)samples_read);
+    if (self->decode_ahead) {
+        /*pop the next block already decoded by the decoding thread*/
+        const struct da_block *block;
 
-        samples = framelist->samples;
+        Py_BEGIN_ALLOW_THREADS
+        block = decode_ahead_next(self->decode_ahead);
+        Py_END_ALLOW_THREADS
 
-        for (c = 0; c < self->channel_count; c++) {
-            int channel[samples_read];
-
-            float_to_int_converter(BITS_PER_SAMPLE)(
-                (unsigned)samples_read,
-                pcm_channels[c],
-                channel);
+        framelist = block_to_FrameList(self, block);
+        decode_ahead_release(self->decode_ahead);
+    } else {
+        struct da_block block;
 
-            put_channel_data(samples,
-                             c,
-                             self->channel_count,
-                             (unsigned)samples_read,
-                             channel);
-        }
+        block.samples = self->samples;
 
-        /*reorder channels to .wav order if necessary*/
-        switch (self->channel_count) {
-        case 1:
-        case 2:
-        default:
-            /*no change*/
-            break;
-        case 3:
-            /*fL fC fR -> fL fR fC*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count, (unsigned)samples_read);
-            break;
-        case 4:
-            /*fL fR bL bR -> fL fR bL bR*/
-            /*no change*/
-            break;
-        case 5:
-            /*fL fC fR bL bR -> fL fR fC bL bR*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count, (unsigned)samples_read);
-            break;
-        case 6:
-            /*fL fC fR bL bR LFE -> fL fR fC bL bR LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC bL bR LFE -> fL fR fC LFE bR bL*/
-            swap_channel_data(samples, 3, 5,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE bR bL -> fL fR fC LFE bL bR*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count, (unsigned)samples_read);
-            break;
-        case 7:
-            /*fL fC fR sL sR bC LFE -> fL fR fC sL sR bC LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC sL sR bC LFE -> fL fR fC LFE sR bC sL*/
-            swap_channel_data(samples, 3, 6,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE sR bC sL -> fL fR fC LFE bC sR sL*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE bC sR sL -> fL fR fC LFE bC sL sR*/
-            swap_channel_data(samples, 5, 6,
-                              self->channel_count, (unsigned)samples_read);
-            break;
-        case 8:
-            /*fL fC fR sL sR bL bR LFE -> fL fR fC sL sR bL bR LFE*/
-            swap_channel_data(samples, 1, 2,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC sL sR bL bR LFE -> fL fR fC LFE sR bL bR sL*/
-            swap_channel_data(samples, 3, 6,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE sR bL bR sL -> fL fR fC LFE bL sR bR sL*/
-            swap_channel_data(samples, 4, 5,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE bL sR bR sL -> fL fR fC LFE bL bR sR sL*/
-            swap_channel_data(samples, 5, 6,
-                              self->channel_count, (unsigned)samples_read);
-
-            /*fL fR fC LFE bL bR sR sL -> fL fR fC LFE bL bR sL sR*/
-            swap_channel_data(samples, 6, 7,
-                              self->channel_count, (unsigned)samples_read);
-            break;
-        }
+        Py_BEGIN_ALLOW_THREADS
+        decode_block(self, BLOCK_SIZE, &block);
+        Py_END_ALLOW_THREADS
 
-        return (PyObject*)framelist;
-    } else {
-        switch (samples_read) {
-        case OV_HOLE:
-            PyErr_SetString(PyExc_ValueError, "data interruption detected");
-            return NULL;
-        case OV_EBADLINK:
-            PyErr_SetString(PyExc_ValueError, "invalid stream section");
-            return NULL;
-        case OV_EINVAL:
-            PyErr_SetString(PyExc_ValueError, "initial file headers corrupt");
-            return NULL;
-        default:
-            PyErr_SetString(PyExc_ValueError, "unspecified error");
-            return NULL;
-        }
+        framelist = block_to_FrameList(self, &block);
     }
+
+    return framelist;
 }
 
 static PyObject*
 VorbisDecoder_close(decoders_VorbisDecoder *self, PyObject *args) {
     self->closed = 1;
 
+    if (self->decode_ahead) {
+        decode_ahead_close(self->decode_ahead);
+        self->decode_ahead = NULL;
+    }
+
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -334,6 +277,185 @@ VorbisDecoder_exit(decoders_VorbisDecoder* self, PyObject *args)
 {
     self->closed = 1;
 
+    if (self->decode_ahead) {
+        decode_ahead_close(self->decode_ahead);
+        self->decode_ahead = NULL;
+    }
+
     Py_INCREF(Py_None);
     return Py_None;
 }
+
+static void
+decode_block(decoders_VorbisDecoder *self,
+             unsigned max_pcm_frames,
+             struct da_block *block)
+{
+    int current_bitstream;
+    float **pcm_channels;
+    const long samples_read = ov_read_float(&(self->vorbisfile),
+                                            &pcm_channels,
+                                            (int)max_pcm_frames,
+                                            &current_bitstream);
+
+    if (samples_read > 0) {
+        /*convert floating point samples to integer-based ones
+          one contiguous channel at a time, which vectorizes,
+          then interleave them*/
+        const float_to_int_f converter =
+            float_to_int_converter(BITS_PER_SAMPLE);
+        const unsigned pcm_frames = (unsigned)samples_read;
+        int channel[pcm_frames];
+        int c;
+
+        for (c = 0; c < self->channel_count; c++) {
+            converter(pcm_frames, pcm_channels[c], channel);
+            put_channel_data(block->samples,
+                             c,
+                             self->channel_count,
+                             pcm_frames,
+                             channel);
+        }
+
+        reorder_channels(block->samples, self->channel_count, pcm_frames);
+
+        block->status = DA_OK;
+        block->pcm_frames = pcm_frames;
+    } else if (samples_read == 0) {
+        block->pcm_frames = 0;
+        if (self->vorbisfile.os.e_o_s == 0) {
+            /*EOF encountered without EOF being marked in stream*/
+            block->status = DA_ERROR;
+            block->error = "I/O error reading from Ogg stream";
+            block->io_error = 1;
+        } else {
+            block->status = DA_FINISHED;
+        }
+    } else {
+        block->status = DA_ERROR;
+        block->pcm_frames = 0;
+        block->io_error = 0;
+        switch (samples_read) {
+        case OV_HOLE:
+            block->error = "data interruption detected";
+            break;
+        case OV_EBADLINK:
+            block->error = "invalid stream section";
+            break;
+        case OV_EINVAL:
+            block->error = "initial file headers corrupt";
+            break;
+        default:
+            block->error = "unspecified error";
+            break;
+        }
+    }
+}
+
+static void
+reorder_channels(int samples[], int channel_count, unsigned pcm_frames)
+{
+    switch (channel_count) {
+    case 1:
+    case 2:
+    default:
+        /*no change*/
+        break;
+    case 3:
+        /*fL fC fR -> fL fR fC*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+        break;
+    case 4:
+        /*fL fR bL bR -> fL fR bL bR*/
+        /*no change*/
+        break;
+    case 5:
+        /*fL fC fR bL bR -> fL fR fC bL bR*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+        break;
+    case 6:
+        /*fL fC fR bL bR LFE -> fL fR fC bL bR LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC bL bR LFE -> fL fR fC LFE bR bL*/
+        swap_channel_data(samples, 3, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bR bL -> fL fR fC LFE bL bR*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+        break;
+    case 7:
+        /*fL fC fR sL sR bC LFE -> fL fR fC sL sR bC LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC sL sR bC LFE -> fL fR fC LFE sR bC sL*/
+        swap_channel_data(samples, 3, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE sR bC sL -> fL fR fC LFE bC sR sL*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bC sR sL -> fL fR fC LFE bC sL sR*/
+        swap_channel_data(samples, 5, 6,
+                          channel_count, pcm_frames);
+        break;
+    case 8:
+        /*fL fC fR sL sR bL bR LFE -> fL fR fC sL sR bL bR LFE*/
+        swap_channel_data(samples, 1, 2,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC sL sR bL bR LFE -> fL fR fC LFE sR bL bR sL*/
+        swap_channel_data(samples, 3, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE sR bL bR sL -> fL fR fC LFE bL sR bR sL*/
+        swap_channel_data(samples, 4, 5,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bL sR bR sL -> fL fR fC LFE bL bR sR sL*/
+        swap_channel_data(samples, 5, 6,
+                          channel_count, pcm_frames);
+
+        /*fL fR fC LFE bL bR sR sL -> fL fR fC LFE bL bR sL sR*/
+        swap_channel_data(samples, 6, 7,
+                          channel_count, pcm_frames);
+        break;
+    }
+}
+
+static PyObject*
+block_to_FrameList(decoders_VorbisDecoder *self,
+                   const struct da_block *block)
+{
+    switch (block->status) {
+    case DA_OK:
+    default:
+        {
+            pcm_FrameList *framelist =
+                new_FrameList(self->audiotools_pcm,
+                              self->channel_count,
+                              BITS_PER_SAMPLE,
+                              block->pcm_frames);
+
+            memcpy(framelist->samples,
+                   block->samples,
+                   sizeof(int) * self->channel_count * block->pcm_frames);
+
+            return (PyObject*)framelist;
+        }
+    case DA_FINISHED:
+        return empty_FrameList(self->audiotools_pcm,
+                               self->channel_count,
+                               BITS_PER_SAMPLE);
+    case DA_ERROR:
+        PyErr_SetString(block->io_error ? PyExc_IOError : PyExc_ValueError,
+                        block->error);
+        return NULL;
+    }
+}
@@ -2,6 +2,7 @@
 #include <Python.h>
 #include <stdint.h>
 #include <vorbis/vorbisfile.h>
+#include "decode_ahead.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -32,6 +33,14 @@ typedef struct {
     long rate;
     int closed;
 
+    /*interleaved output of the most recent block
+      when decoding synchronously*/
+    int *samples;
+
+    /*if not NULL, blocks are decoded on a separate thread
+      and read() pops them from this*/
+    DecodeAhead *decode_ahead;
+
     PyObject* audiotools_pcm;
 } decoders_VorbisDecoder;
 
@@ -30,6 +30,9 @@ typedef int Py_ssize_t;
 PyObject*
 encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds);
 
+PyObject*
+encoders_trial_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds);
+
 PyObject*
 encoders_encode_alac(PyObject *dummy, PyObject *args, PyObject *keywds);
 
@@ -62,9 +65,22 @@ PyObject*
 encoders_encode_opus(PyObject *dummy, PyObject *args, PyObject *keywds);
 #endif
 
+#ifdef HAS_FAAC
+PyObject*
+encoders_encode_aac(PyObject *dummy, PyObject *args, PyObject *keywds);
+#endif
+
+#ifdef HAS_SPEEX
+PyObject*
+encoders_encode_speex(PyObject *dummy, PyObject *args, PyObject *keywds);
+#endif
+
 PyMethodDef module_methods[] = {
     {"encode_flac", (PyCFunction)encoders_encode_flac,
      METH_VARARGS | METH_KEYWORDS, "Encode FLAC file from PCMReader"},
+    {"trial_encode_flac", (PyCFunction)encoders_trial_encode_flac,
+     METH_VARARGS | METH_KEYWORDS,
+     "Returns size of FrameList encoded as FLAC frames"},
     {"encode_alac", (PyCFunction)encoders_encode_alac,
      METH_VARARGS | METH_KEYWORDS, "Encode ALAC file from PCMReader"},
 #ifdef HAS_WAVPACK
@@ -90,6 +106,14 @@ PyMethodDef module_methods[] = {
 #ifdef HAS_OPUS
     {"encode_opus", (PyCFunction)encoders_encode_opus,
     METH_VARARGS | METH_KEYWORDS, "Encode Opus file from PCMReader"},
+#endif
+#ifdef HAS_FAAC
+    {"encode_aac", (PyCFunction)encoders_encode_aac,
+    METH_VARARGS | METH_KEYWORDS, "Encode M4A AAC file from PCMReader"},
+#endif
+#ifdef HAS_SPEEX
+    {"encode_speex", (PyCFunction)encoders_encode_speex,
+    METH_VARARGS | METH_KEYWORDS, "Encode Speex file from PCMReader"},
 #endif
     {NULL}
 };
@@ -0,0 +1,596 @@
+#include <faac.h>
+#include <string.h>
+#include <time.h>
+#include "../pcmreader.h"
+#include "../bitstream.h"
+#include "../common/m4a_atoms.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*each AAC access unit holds 1024 PCM frames*/
+#define AAC_FRAME_SIZE 1024
+
+/*faac's output begins with this many PCM frames of priming
+  which the edit list skips on playback*/
+#define AAC_ENCODER_DELAY 1024
+
+/*number of access units per stco chunk*/
+#define AAC_FRAMES_PER_CHUNK 21
+
+/*a growable list of access unit sizes, in bytes*/
+struct aac_frame_sizes {
+    unsigned *sizes;
+    unsigned len;
+    unsigned size;
+};
+
+static void
+add_frame_size(struct aac_frame_sizes *frame_sizes, unsigned byte_size);
+
+/*writes a complete access unit to mdat and records its size*/
+static void
+write_frame(BitstreamWriter *output,
+            struct aac_frame_sizes *frame_sizes,
+            const unsigned char frame[],
+            unsigned byte_size);
+
+/*returns a new "mp4a" sample description
+  whose "esds" atom contains the given AudioSpecificConfig*/
+static struct qt_atom*
+mp4a_atom(unsigned sample_rate,
+          unsigned channels,
+          unsigned avg_bitrate,
+          unsigned max_frame_size,
+          const unsigned char config[],
+          unsigned config_size);
+
+/*returns a new "edts" atom whose edit list
+  presents "pcm_frames" frames of the media
+  starting after the encoder's delay*/
+static struct qt_atom*
+edts_atom(unsigned pcm_frames);
+
+/*writes a moov atom for the given access units
+  which start at "frames_offset" bytes in the file
+  and encode "pcm_frames" frames of audio*/
+static void
+write_moov(BitstreamWriter *output,
+           time_t timestamp,
+           unsigned sample_rate,
+           unsigned channels,
+           unsigned pcm_frames,
+           const struct aac_frame_sizes *frame_sizes,
+           unsigned frames_offset,
+           const unsigned char config[],
+           unsigned config_size,
+           const char encoder_version[]);
+
+PyObject*
+encoders_encode_aac(PyObject *dummy, PyObject *args, PyObject *keywds)
+{
+    static char *kwlist[] = {"file",
+                             "pcmreader",
+                             "quality",
+                             "total_pcm_frames",
+                             "version",
+                             NULL};
+    PyObject *file_obj;
+    struct PCMReader *pcmreader;
+    int quality = 100;
+    long long total_pcm_frames = 0;
+    const char *version = "Python Audio Tools";
+    BitstreamWriter *output = NULL;
+    faacEncHandle encoder = NULL;
+    faacEncConfigurationPtr config;
+    unsigned long input_samples;
+    unsigned long max_output_bytes;
+    unsigned char *decoder_config = NULL;
+    unsigned long decoder_config_size = 0;
+    int *samples = NULL;
+    float *input = NULL;
+    unsigned char *encoded = NULL;
+    struct aac_frame_sizes frame_sizes = {NULL, 0, 0};
+    const time_t timestamp = time(NULL);
+    unsigned ftyp_size;
+    bw_pos_t *mdat_start = NULL;
+    unsigned mdat_size = 8;
+    long long pcm_frames_read = 0;
+    float scale;
+    unsigned block_frames;
+    unsigned pcm_frames;
+    int bytes;
+    struct qt_atom *ftyp;
+
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "OO&|iLs",
+                                     kwlist,
+                                     &file_obj,
+                                     py_obj_to_pcmreader,
+                                     &pcmreader,
+                                     &quality,
+                                     &total_pcm_frames,
+                                     &version)) {
+        return NULL;
+    }
+
+    /*ensure PCMReader object is compatible with AAC output*/
+    if ((pcmreader->channels != 1) && (pcmreader->channels != 2)) {
+        PyErr_SetString(PyExc_ValueError, "channel count must be 1 or 2");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    if ((pcmreader->bits_per_sample != 8) &&
+        (pcmreader->bits_per_sample != 16) &&
+        (pcmreader->bits_per_sample != 24)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "bits per sample must be 8, 16 or 24");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    if (quality < 10) {
+        PyErr_SetString(PyExc_ValueError, "quality must be >= 10");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    /*initialize encoder*/
+    if ((encoder = faacEncOpen(pcmreader->sample_rate,
+                               pcmreader->channels,
+                               &input_samples,
+                               &max_output_bytes)) == NULL) {
+        PyErr_SetString(PyExc_ValueError, "error initializing faac");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    /*raw AAC-LC access units with VBR quality
+      from float input scaled to 16 bits*/
+    config = faacEncGetCurrentConfiguration(encoder);
+    config->mpegVersion = MPEG4;
+    config->aacObjectType = LOW;
+    config->quantqual = quality;
+    config->bitRate = 0;
+    config->outputFormat = 0;
+    config->inputFormat = FAAC_INPUT_FLOAT;
+    if (!faacEncSetConfiguration(encoder, config)) {
+        PyErr_SetString(PyExc_ValueError, "unsupported faac configuration");
+        goto error;
+    }
+
+    if (faacEncGetDecoderSpecificInfo(encoder,
+                                      &decoder_config,
+                                      &decoder_config_size)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "error getting AAC decoder configuration");
+        goto error;
+    }
+
+    samples = malloc(input_samples * sizeof(int));
+    input = malloc(input_samples * sizeof(float));
+    encoded = malloc(max_output_bytes);
+    scale = 32768.0f / (float)(1 << (pcmreader->bits_per_sample - 1));
+
+    output = bw_open_external(file_obj,
+                              BS_BIG_ENDIAN,
+                              4096,
+                              bw_write_python,
+                              bs_setpos_python,
+                              bs_getpos_python,
+                              bs_free_pos_python,
+                              bs_fseek_python,
+                              bw_flush_python,
+                              bs_close_python,
+                              bs_free_python_nodecref);
+
+    if (!setjmp(*bw_try(output))) {
+        /*write ftyp atom*/
+        ftyp = qt_ftyp_new((uint8_t*)"M4A ", 0, 4,
+                           (uint8_t*)"M4A ",
+                           (uint8_t*)"mp42",
+                           (uint8_t*)"isom",
+                           (uint8_t*)"\x00\x00\x00\x00");
+        ftyp->build(ftyp, output);
+        ftyp_size = ftyp->size(ftyp);
+        ftyp->free(ftyp);
+
+        /*write mdat header whose size is filled in once encoding is done
+          so access units go straight to the output file
+          and the moov atom follows them*/
+        mdat_start = output->getpos(output);
+        output->write(output, 32, 0);
+        output->write_bytes(output, (uint8_t*)"mdat", 4);
+
+        bw_etry(output);
+    } else {
+        bw_etry(output);
+        PyErr_SetString(PyExc_IOError, "I/O error writing stream");
+        goto error;
+    }
+
+    /*encode each block of PCM frames from PCMReader
+
+      faac pads any block shorter than "input_samples" with silence
+      so each block is filled from as many reads as it takes
+      and only the stream's final block may be short*/
+    block_frames = (unsigned)(input_samples / pcmreader->channels);
+    do {
+        unsigned total_samples;
+        unsigned frames_read;
+        unsigned i;
+
+        for (pcm_frames = 0; pcm_frames < block_frames;
+             pcm_frames += frames_read) {
+            if ((frames_read =
+                 pcmreader->read(pcmreader,
+                                 block_frames - pcm_frames,
+                                 samples +
+                                 (pcm_frames * pcmreader->channels))) == 0) {
+                break;
+            }
+        }
+
+        if (pcm_frames == 0) {
+            break;
+        }
+
+        total_samples = pcm_frames * pcmreader->channels;
+        pcm_frames_read += pcm_frames;
+
+        for (i = 0; i < total_samples; i++) {
+            input[i] = (float)samples[i] * scale;
+        }
+
+        if ((bytes = faacEncEncode(encoder,
+                                   (int32_t*)input,
+                                   total_samples,
+                                   encoded,
+                                   (unsigned)max_output_bytes)) < 0) {
+            PyErr_SetString(PyExc_ValueError, "error encoding AAC frame");
+            goto error;
+        } else if (bytes > 0) {
+            if (!setjmp(*bw_try(output))) {
+                write_frame(output, &frame_sizes, encoded, bytes);
+                bw_etry(output);
+            } else {
+                bw_etry(output);
+                PyErr_SetString(PyExc_IOError, "I/O error writing stream");
+                goto error;
+            }
+            mdat_size += bytes;
+        }
+    } while (pcm_frames == block_frames);
+
+    if (pcmreader->status != PCM_OK) {
+        PyErr_SetString(PyExc_IOError, "I/O error from pcmreader");
+        goto error;
+    }
+
+    if (total_pcm_frames && (total_pcm_frames != pcm_frames_read)) {
+        PyErr_SetString(PyExc_ValueError, "total PCM frames mismatch");
+        goto error;
+    }
+
+    /*flush remaining access units from encoder*/
+    while ((bytes = faacEncEncode(encoder,
+                                  NULL,
+                                  0,
+                                  encoded,
+                                  (unsigned)max_output_bytes)) > 0) {
+        if (!setjmp(*bw_try(output))) {
+            write_frame(output, &frame_sizes, encoded, bytes);
+            bw_etry(output);
+        } else {
+            bw_etry(output);
+            PyErr_SetString(PyExc_IOError, "I/O error writing stream");
+            goto error;
+        }
+        mdat_size += bytes;
+    }
+
+    if (!setjmp(*bw_try(output))) {
+        /*write moov atom after the encoded data*/
+        write_moov(output,
+                   timestamp,
+                   pcmreader->sample_rate,
+                   pcmreader->channels,
+                   (unsigned)pcm_frames_read,
+                   &frame_sizes,
+                   ftyp_size + 8,
+                   decoder_config,
+                   (unsigned)decoder_config_size,
+                   version);
+
+        /*then go back and fill in the mdat atom's size*/
+        output->setpos(output, mdat_start);
+        output->write(output, 32, mdat_size);
+        output->flush(output);
+
+        bw_etry(output);
+    } else {
+        bw_etry(output);
+        PyErr_SetString(PyExc_IOError, "I/O error writing stream");
+        goto error;
+    }
+
+    mdat_start->del(mdat_start);
+    output->free(output);
+    faacEncClose(encoder);
+    free(decoder_config);
+    free(samples);
+    free(input);
+    free(encoded);
+    free(frame_sizes.sizes);
+    pcmreader->del(pcmreader);
+    Py_INCREF(Py_None);
+    return Py_None;
+error:
+    if (mdat_start) {
+        mdat_start->del(mdat_start);
+    }
+    if (output) {
+        output->free(output);
+    }
+    faacEncClose(encoder);
+    free(decoder_config);
+    free(samples);
+    free(input);
+    free(encoded);
+    free(frame_sizes.sizes);
+    pcmreader->del(pcmreader);
+    return NULL;
+}
+
+static void
+add_frame_size(struct aac_frame_sizes *frame_sizes, unsigned byte_size)
+{
+    if (frame_sizes->len == frame_sizes->size) {
+        frame_sizes->size = frame_sizes->size ? frame_sizes->size * 2 : 256;
+        frame_sizes->sizes = realloc(frame_sizes->sizes,
+                                     frame_sizes->size * sizeof(unsigned));
+    }
+    frame_sizes->sizes[frame_sizes->len++] = byte_size;
+}
+
+static void
+write_frame(BitstreamWriter *output,
+            struct aac_frame_sizes *frame_sizes,
+            const unsigned char frame[],
+            unsigned byte_size)
+{
+    output->write_bytes(output, frame, byte_size);
+    add_frame_size(frame_sizes, byte_size);
+}
+
+static struct qt_atom*
+mp4a_atom(unsigned sample_rate,
+          unsigned channels,
+          unsigned avg_bitrate,
+          unsigned max_frame_size,
+          const unsigned char config[],
+          unsigned config_size)
+{
+    BitstreamRecorder *mp4a = bw_open_bytes_recorder(BS_BIG_ENDIAN);
+    BitstreamWriter *w = (BitstreamWriter*)mp4a;
+    /*DecoderConfigDescriptor is 13 bytes plus DecoderSpecificInfo*/
+    const unsigned decoder_config_size = 13 + 2 + config_size;
+    /*ES_Descriptor is 3 bytes plus DecoderConfigDescriptor
+      plus a 3 byte SLConfigDescriptor*/
+    const unsigned es_size = 3 + 2 + decoder_config_size + 3;
+    uint8_t *data;
+    struct qt_atom *atom;
+
+    /*sample description*/
+    w->write(w, 32, 0);                      /*reserved*/
+    w->write(w, 16, 0);                      /*reserved*/
+    w->write(w, 16, 1);                      /*data reference index*/
+    w->write(w, 16, 0);                      /*version*/
+    w->write(w, 16, 0);                      /*revision level*/
+    w->write(w, 32, 0);                      /*vendor*/
+    w->write(w, 16, channels);
+    w->write(w, 16, 16);                     /*bits per sample*/
+    w->write(w, 16, 0);                      /*compression ID*/
+    w->write(w, 16, 0);                      /*packet size*/
+    w->write(w, 32, sample_rate < 0x10000 ? sample_rate << 16 : 0);
+
+    /*esds atom*/
+    w->write(w, 32, 8 + 4 + 2 + es_size);
+    w->write_bytes(w, (uint8_t*)"esds", 4);
+    w->write(w, 32, 0);                      /*version and flags*/
+
+    /*ES_Descriptor*/
+    w->write(w, 8, 0x03);
+    w->write(w, 8, es_size);
+    w->write(w, 16, 0);                      /*ES_ID*/
+    w->write(w, 8, 0);                       /*flags and priority*/
+
+    /*DecoderConfigDescriptor*/
+    w->write(w, 8, 0x04);
+    w->write(w, 8, decoder_config_size);
+    w->write(w, 8, 0x40);                    /*MPEG-4 audio*/
+    w->write(w, 6, 0x05);                    /*audio stream*/
+    w->write(w, 1, 0);                       /*upstream*/
+    w->write(w, 1, 1);                       /*reserved*/
+    w->write(w, 24, max_frame_size);         /*buffer size*/
+    w->write(w, 32, avg_bitrate);            /*maximum bitrate*/
+    w->write(w, 32, avg_bitrate);            /*average bitrate*/
+
+    /*DecoderSpecificInfo holding the AudioSpecificConfig*/
+    w->write(w, 8, 0x05);
+    w->write(w, 8, config_size);
+    w->write_bytes(w, config, config_size);
+
+    /*SLConfigDescriptor*/
+    w->write(w, 8, 0x06);
+    w->write(w, 8, 1);
+    w->write(w, 8, 0x02);
+
+    data = malloc(mp4a->bytes_written(mp4a));
+    mp4a->data(mp4a, data);
+    atom = qt_leaf_new("mp4a", mp4a->bytes_written(mp4a), data);
+    free(data);
+    mp4a->close(mp4a);
+
+    return atom;
+}
+
+static struct qt_atom*
+edts_atom(unsigned pcm_frames)
+{
+    BitstreamRecorder *elst = bw_open_bytes_recorder(BS_BIG_ENDIAN);
+    BitstreamWriter *w = (BitstreamWriter*)elst;
+    uint8_t *data;
+    struct qt_atom *atom;
+
+    w->write(w, 32, 0);                      /*version and flags*/
+    w->write(w, 32, 1);                      /*number of edits*/
+    w->write(w, 32, pcm_frames);             /*segment duration*/
+    w->write(w, 32, AAC_ENCODER_DELAY);      /*media time*/
+    w->write(w, 32, 0x10000);                /*media rate*/
+
+    data = malloc(elst->bytes_written(elst));
+    elst->data(elst, data);
+    atom = qt_tree_new("edts", 1,
+                       qt_leaf_new("elst", elst->bytes_written(elst), data));
+    free(data);
+    elst->close(elst);
+
+    return atom;
+}
+
+static void
+write_moov(BitstreamWriter *output,
+           time_t timestamp,
+           unsigned sample_rate,
+           unsigned channels,
+           unsigned pcm_frames,
+           const struct aac_frame_sizes *frame_sizes,
+           unsigned frames_offset,
+           const unsigned char config[],
+           unsigned config_size,
+           const char encoder_version[])
+{
+    const qt_time_t qt_timestamp = time_to_mac_utc(timestamp);
+    const unsigned geometry[9] = {0x10000, 0x0, 0x0, 0x0, 0x10000,
+                                  0x0, 0x0, 0x0, 0x40000000};
+    const unsigned duration = frame_sizes->len * AAC_FRAME_SIZE;
+    unsigned long long bitrate = 0;
+    unsigned max_frame_size = 0;
+    unsigned current_chunk = 0;
+    unsigned chunk_size = 0;
+    struct qt_atom *stts = qt_stts_new(0, 0);
+    struct qt_atom *stsc = qt_stsc_new(0, 0);
+    struct qt_atom *stsz = qt_stsz_new(0, 0, 0);
+    struct qt_atom *stco = qt_stco_new(0, 0);
+    struct qt_atom *moov;
+    struct stsc_entry *latest_entry;
+    unsigned i;
+
+    /*walk through access units to populate stbl sub-atoms*/
+    for (i = 0; i < frame_sizes->len; i++) {
+        const unsigned byte_size = frame_sizes->sizes[i];
+
+        bitrate += (byte_size * 8);
+        if (byte_size > max_frame_size) {
+            max_frame_size = byte_size;
+        }
+        qt_stts_add_time(stts, AAC_FRAME_SIZE);
+
+        if (chunk_size == 0) {
+            /*add a new offset at the start of a chunk*/
+            qt_stco_add_offset(stco, frames_offset);
+        }
+
+        if ((chunk_size += 1) == AAC_FRAMES_PER_CHUNK) {
+            latest_entry = qt_stsc_latest_entry(stsc);
+            current_chunk += 1;
+            if ((!latest_entry) ||
+                (latest_entry->frames_per_chunk != chunk_size)) {
+                qt_stsc_add_chunk_size(stsc, current_chunk, chunk_size, 1);
+            }
+            chunk_size = 0;
+        }
+        qt_stsz_add_size(stsz, byte_size);
+        frames_offset += byte_size;
+    }
+    latest_entry = qt_stsc_latest_entry(stsc);
+    if ((chunk_size > 0) &&
+        ((!latest_entry) || (latest_entry->frames_per_chunk != chunk_size))) {
+        current_chunk += 1;
+        qt_stsc_add_chunk_size(stsc, current_chunk, chunk_size, 1);
+    }
+
+    if (duration) {
+        bitrate *= sample_rate;
+        bitrate /= duration;
+    }
+
+    /*the movie and track last as long as the edit list presents
+      while the media includes the encoder's delay and padding*/
+    moov = qt_tree_new("moov", 3,
+      qt_mvhd_new(0, 0, qt_timestamp, qt_timestamp, sample_rate,
+                  pcm_frames, 0x10000, 0x100, geometry,
+                  0, 0, 0, 0, 2),
+      qt_tree_new("trak", 3,
+        qt_tkhd_new(0, 7, qt_timestamp, qt_timestamp, 1,
+                    pcm_frames, 0, 0, 0x100, geometry, 0, 0),
+        edts_atom(pcm_frames),
+        qt_tree_new("mdia", 3,
+          qt_mdhd_new(0, 0, qt_timestamp, qt_timestamp,
+                      sample_rate, duration, "und", 0),
+          qt_hdlr_new(0, 0,
+                      "\x00\x00\x00\x00",
+                      "soun",
+                      "\x00\x00\x00\x00",
+                      0, 0, 2, (uint8_t*)"\x00\x00"),
+          qt_tree_new("minf", 3,
+            qt_smhd_new(0, 0, 0),
+            qt_tree_new("dinf", 1,
+              qt_dref_new(0, 0, 1,
+                qt_leaf_new("url ", 4, (uint8_t*)"\x00\x00\x00\x01"))),
+            qt_tree_new("stbl", 5,
+              qt_stsd_new(0, 0, 1,
+                mp4a_atom(sample_rate,
+                          channels,
+                          (unsigned)bitrate,
+                          max_frame_size,
+                          config,
+                          config_size)),
+              stts,
+              stsc,
+              stsz,
+              stco)))),
+      qt_tree_new("udta", 1,
+        qt_meta_new(0, 0, 3,
+          qt_hdlr_new(0, 0,
+                      "\x00\x00\x00\x00",
+                      "mdir",
+                      "appl",
+                      0, 0, 2, (uint8_t*)"\x00\xFF"),
+          qt_tree_new("ilst", 1,
+            qt_tree_new("\xA9""too", 1,
+              qt_data_new(1,
+                          (unsigned)strlen(encoder_version),
+                          (uint8_t*)encoder_version))),
+          qt_free_new(4096))));
+
+    moov->build(moov, output);
+    moov->free(moov);
+}
@@ -4,6 +4,10 @@
 #include <math.h>
 #include "../common/m4a_atoms.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
  Copyright (C) 2007-2016  Brian Langenberger
@@ -58,6 +62,7 @@ encoders_encode_alac(PyObject *dummy, PyObject *args, PyObject *keywds)
                              "history_multiplier",
                              "maximum_k",
                              "version",
+                             "verify",
                              NULL};
     PyObject *file_obj;
     BitstreamWriter *output = NULL;
@@ -68,10 +73,11 @@ encoders_encode_alac(PyObject *dummy, PyObject *args, PyObject *keywds)
     int history_multiplier;
     int maximum_k;
     const char *version;
+    int verify = 0;
     struct alac_frame_size *frame_sizes;
 
     /*extract a file object, PCMReader-compatible object and encoding options*/
-    if (!PyArg_ParseTupleAndKeywords(args, keywds, "OO&Liiiis",
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "OO&Liiiis|i",
                                      kwlist,
                                      &file_obj,
                                      py_obj_to_pcmreader,
@@ -81,7 +87,8 @@ encoders_encode_alac(PyObject *dummy, PyObject *args, PyObject *keywds)
                                      &initial_history,
                                      &history_multiplier,
                                      &maximum_k,
-                                     &version)) {
+                                     &version,
+                                     &verify)) {
         return NULL;
     }
 
@@ -134,6 +141,7 @@ encoders_encode_alac(PyObject *dummy, PyObject *args, PyObject *keywds)
                               initial_history,
                               history_multiplier,
                               maximum_k,
+                              verify,
                               version);
 
     if (frame_sizes) {
@@ -163,6 +171,7 @@ encode_alac(BitstreamWriter *output,
             int initial_history,
             int history_multiplier,
             int maximum_k,
+            int verify,
             const char encoder_version[])
 {
     time_t timestamp = time(NULL);
@@ -198,7 +207,8 @@ encode_alac(BitstreamWriter *output,
                         block_size,
                         initial_history,
                         history_multiplier,
-                        maximum_k);
+                        maximum_k,
+                        verify);
 
         if (!actual_sizes) {
             free_alac_frame_sizes(dummy_sizes);
@@ -268,7 +278,8 @@ encode_alac(BitstreamWriter *output,
                         block_size,
                         initial_history,
                         history_multiplier,
-                        maximum_k);
+                        maximum_k,
+                        verify);
 
         if (!actual_sizes) {
             metadata_size_writer->close(metadata_size_writer);
@@ -345,12 +356,15 @@ encode_mdat(BitstreamWriter *output,
             int block_size,
             int initial_history,
             int history_multiplier,
-            int maximum_k)
+            int maximum_k,
+            int verify)
 {
     struct alac_context encoder;
     int *samples = malloc(pcmreader->channels *
                           block_size *
                           sizeof(int));
+    const int *channels[pcmreader->channels];
+    unsigned c;
     unsigned frame_byte_size = 0;
     bw_pos_t* mdat_header = NULL;
     unsigned pcm_frames_read;
@@ -364,6 +378,7 @@ encode_mdat(BitstreamWriter *output,
     encoder.options.maximum_k = maximum_k;
     encoder.options.minimum_interlacing_leftweight = 0;
     encoder.options.maximum_interlacing_leftweight = 4;
+    encoder.options.verify = verify;
 
     encoder.bits_per_sample = pcmreader->bits_per_sample;
 
@@ -378,18 +393,58 @@ encode_mdat(BitstreamWriter *output,
     output->write(output, 32, 0);
     output->write_bytes(output, (uint8_t*)"mdat", 4);
 
+    /*channels are read planar, each a whole block apart*/
+    for (c = 0; c < pcmreader->channels; c++) {
+        channels[c] = samples + (c * encoder.options.block_size);
+    }
+
     /*write frames from pcm_reader until empty*/
-    while ((pcm_frames_read = pcmreader->read(pcmreader,
-                                              encoder.options.block_size,
-                                              samples)) > 0) {
+    while ((pcm_frames_read =
+            pcmreader->read_planar(pcmreader,
+                                   encoder.options.block_size,
+                                   samples)) > 0) {
         frame_byte_size = 0;
 
-        /*perform encoding*/
-        write_frameset(output,
-                       &encoder,
-                       pcm_frames_read,
-                       pcmreader->channels,
-                       samples);
+        if (encoder.options.verify) {
+            /*encode frameset to recorder and decode it again
+              while its input is still at hand
+              before passing it along to the output*/
+            encoder.frameset->reset(encoder.frameset);
+            write_frameset((BitstreamWriter*)encoder.frameset,
+                           &encoder,
+                           pcm_frames_read,
+                           pcmreader->channels,
+                           channels);
+
+            if (!verify_frameset(&encoder,
+                                 encoder.frameset,
+                                 pcm_frames_read,
+                                 pcmreader->channels,
+                                 channels)) {
+                output->pop_callback(output, NULL);
+                free(samples);
+                mdat_header->del(mdat_header);
+                free_encoder(&encoder);
+                free_alac_frame_sizes(frame_sizes);
+#ifndef STANDALONE
+                PyErr_SetString(PyExc_ValueError,
+                                "encoded frameset failed verification");
+#else
+                fputs("*** Error: encoded frameset failed verification\n",
+                      stderr);
+#endif
+                return NULL;
+            }
+
+            encoder.frameset->copy(encoder.frameset, output);
+        } else {
+            /*perform encoding*/
+            write_frameset(output,
+                           &encoder,
+                           pcm_frames_read,
+                           pcmreader->channels,
+                           channels);
+        }
 
         /*log each frameset's size in bytes and size in samples*/
         frame_sizes = push_frame_size(frame_sizes,
@@ -506,6 +561,8 @@ init_encoder(struct alac_context* encoder, unsigned block_size)
     encoder->compressed_frame = bw_open_recorder(BS_BIG_ENDIAN);
     encoder->interlaced_frame = bw_open_recorder(BS_BIG_ENDIAN);
     encoder->best_interlaced_frame = bw_open_recorder(BS_BIG_ENDIAN);
+
+    encoder->frameset = bw_open_recorder(BS_BIG_ENDIAN);
 }
 
 static void
@@ -522,6 +579,8 @@ free_encoder(struct alac_context* encoder)
     encoder->compressed_frame->close(encoder->compressed_frame);
     encoder->interlaced_frame->close(encoder->interlaced_frame);
     encoder->best_interlaced_frame->close(encoder->best_interlaced_frame);
+
+    encoder->frameset->close(encoder->frameset);
 }
 
 static void
@@ -529,92 +588,54 @@ write_frameset(BitstreamWriter *bs,
                struct alac_context* encoder,
                unsigned pcm_frames,
                unsigned channel_count,
-               const int channels[])
+               const int *const channels[])
 {
-    int channel0[pcm_frames];
-    int channel1[pcm_frames];
     unsigned i;
 
     switch (channel_count) {
     case 1:
-        write_frame(bs, encoder, pcm_frames, 1, channels, NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[0], NULL);
         break;
     case 2:
-        get_channel_data(channels, 0, 2, pcm_frames, channel0);
-        get_channel_data(channels, 1, 2, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
         break;
     case 3:
-        get_channel_data(channels, 2, 3, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 0, 3, pcm_frames, channel0);
-        get_channel_data(channels, 1, 3, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
         break;
     case 4:
-        get_channel_data(channels, 2, 4, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 0, 4, pcm_frames, channel0);
-        get_channel_data(channels, 1, 4, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 3, 4, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
+        write_frame(bs, encoder, pcm_frames, 1, channels[3], NULL);
         break;
     case 5:
-        get_channel_data(channels, 2, 5, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 0, 5, pcm_frames, channel0);
-        get_channel_data(channels, 1, 5, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 3, 5, pcm_frames, channel0);
-        get_channel_data(channels, 4, 5, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
+        write_frame(bs, encoder, pcm_frames, 2, channels[3], channels[4]);
         break;
     case 6:
-        get_channel_data(channels, 2, 6, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 0, 6, pcm_frames, channel0);
-        get_channel_data(channels, 1, 6, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 4, 6, pcm_frames, channel0);
-        get_channel_data(channels, 5, 6, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 3, 6, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
+        write_frame(bs, encoder, pcm_frames, 2, channels[4], channels[5]);
+        write_frame(bs, encoder, pcm_frames, 1, channels[3], NULL);
         break;
     case 7:
-        get_channel_data(channels, 2, 7, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 0, 7, pcm_frames, channel0);
-        get_channel_data(channels, 1, 7, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 4, 7, pcm_frames, channel0);
-        get_channel_data(channels, 5, 7, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 6, 7, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 3, 7, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
+        write_frame(bs, encoder, pcm_frames, 2, channels[4], channels[5]);
+        write_frame(bs, encoder, pcm_frames, 1, channels[6], NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[3], NULL);
         break;
     case 8:
-        get_channel_data(channels, 2, 8, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
-        get_channel_data(channels, 6, 8, pcm_frames, channel0);
-        get_channel_data(channels, 7, 8, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 0, 8, pcm_frames, channel0);
-        get_channel_data(channels, 1, 8, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 4, 8, pcm_frames, channel0);
-        get_channel_data(channels, 5, 8, pcm_frames, channel1);
-        write_frame(bs, encoder, pcm_frames, 2, channel0, channel1);
-        get_channel_data(channels, 3, 8, pcm_frames, channel0);
-        write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
+        write_frame(bs, encoder, pcm_frames, 1, channels[2], NULL);
+        write_frame(bs, encoder, pcm_frames, 2, channels[6], channels[7]);
+        write_frame(bs, encoder, pcm_frames, 2, channels[0], channels[1]);
+        write_frame(bs, encoder, pcm_frames, 2, channels[4], channels[5]);
+        write_frame(bs, encoder, pcm_frames, 1, channels[3], NULL);
         break;
     default:
         for (i = 0; i < channel_count; i++) {
-            get_channel_data(channels, i, channel_count, pcm_frames, channel0);
-            write_frame(bs, encoder, pcm_frames, 1, channel0, NULL);
+            write_frame(bs, encoder, pcm_frames, 1, channels[i], NULL);
         }
         break;
     }
@@ -623,6 +644,64 @@ write_frameset(BitstreamWriter *bs,
     bs->byte_align(bs);   /*and byte-align frameset*/
 }
 
+static int
+verify_frameset(const struct alac_context *encoder,
+                const BitstreamRecorder *frameset,
+                unsigned pcm_frames,
+                unsigned channel_count,
+                const int *const channels[])
+{
+    const unsigned frameset_bytes = frameset->bytes_written(frameset);
+    uint8_t *data = malloc(frameset_bytes);
+    BitstreamReader *reader;
+    struct alac_parameters params;
+    int samples[encoder->options.block_size * channel_count];
+    unsigned pcm_frames_read;
+    alac_status status;
+    unsigned c;
+
+    params.block_size = encoder->options.block_size;
+    params.history_multiplier = encoder->options.history_multiplier;
+    params.initial_history = encoder->options.initial_history;
+    params.maximum_K = encoder->options.maximum_k;
+
+    frameset->data(frameset, data);
+    reader = br_open_buffer(data, frameset_bytes, BS_BIG_ENDIAN);
+
+    if (!setjmp(*br_try(reader))) {
+        status = alacdec_decode_frameset(reader,
+                                         &params,
+                                         encoder->bits_per_sample,
+                                         channel_count,
+                                         &pcm_frames_read,
+                                         samples);
+        br_etry(reader);
+    } else {
+        /*frameset ends before it's fully decoded*/
+        br_etry(reader);
+        reader->close(reader);
+        free(data);
+        return 0;
+    }
+
+    reader->close(reader);
+    free(data);
+
+    if ((status != OK) || (pcm_frames_read != pcm_frames)) {
+        return 0;
+    }
+
+    for (c = 0; c < channel_count; c++) {
+        if (memcmp(samples + (c * pcm_frames),
+                   channels[c],
+                   pcm_frames * sizeof(int))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 static void
 write_frame(BitstreamWriter *bs,
             struct alac_context* encoder,
@@ -639,16 +718,14 @@ write_frame(BitstreamWriter *bs,
 
     if (pcm_frames >= 10) {
         compressed_frame->reset(compressed_frame);
-        if (!setjmp(encoder->residual_overflow)) {
-            write_compressed_frame(bs,
+        if (write_compressed_frame((BitstreamWriter*)compressed_frame,
                                    encoder,
                                    pcm_frames,
                                    channel_count,
-                                   channel0, channel1);
-
+                                   channel0, channel1)) {
             compressed_frame->copy(compressed_frame, bs);
         } else {
-            /*a residual overflow exception occurred,
+            /*a residual overflowed,
               so write an uncompressed frame instead*/
             write_uncompressed_frame(bs,
                                      encoder,
@@ -705,7 +782,7 @@ write_uncompressed_frame(BitstreamWriter *bs,
     }
 }
 
-static void
+static int
 write_compressed_frame(BitstreamWriter *bs,
                        struct alac_context* encoder,
                        unsigned pcm_frames,
@@ -719,11 +796,11 @@ write_compressed_frame(BitstreamWriter *bs,
         /*no uncompressed least-significant bits*/
 
         if (channel_count == 1) {
-            write_non_interlaced_frame(bs,
-                                       encoder,
-                                       pcm_frames,
-                                       0, NULL,
-                                       channel0);
+            return write_non_interlaced_frame(bs,
+                                              encoder,
+                                              pcm_frames,
+                                              0, NULL,
+                                              channel0);
         } else {
             unsigned leftweight;
             BitstreamRecorder *interlaced_frame =
@@ -740,13 +817,16 @@ write_compressed_frame(BitstreamWriter *bs,
 
                 interlaced_frame->reset(interlaced_frame);
 
-                write_interlaced_frame((BitstreamWriter*)interlaced_frame,
-                                       encoder,
-                                       pcm_frames,
-                                       0, NULL,
-                                       INTERLACING_SHIFT,
-                                       leftweight,
-                                       channel0, channel1);
+                if (!write_interlaced_frame(
+                        (BitstreamWriter*)interlaced_frame,
+                        encoder,
+                        pcm_frames,
+                        0, NULL,
+                        INTERLACING_SHIFT,
+                        leftweight,
+                        channel0, channel1)) {
+                    return 0;
+                }
 
                 if (interlaced_frame->bits_written(interlaced_frame) <
                     best_interlaced_frame_bits) {
@@ -759,6 +839,7 @@ write_compressed_frame(BitstreamWriter *bs,
 
             /*write the smallest leftweight to disk*/
             best_interlaced_frame->copy(best_interlaced_frame, bs);
+            return 1;
         }
     } else {
         unsigned uncompressed_LSBs = (encoder->bits_per_sample - 16) / 8;
@@ -793,13 +874,16 @@ write_compressed_frame(BitstreamWriter *bs,
 
                 interlaced_frame->reset(interlaced_frame);
 
-                write_interlaced_frame((BitstreamWriter*)interlaced_frame,
-                                       encoder,
-                                       pcm_frames,
-                                       uncompressed_LSBs, LSBs,
-                                       INTERLACING_SHIFT,
-                                       leftweight,
-                                       MSBs0, MSBs1);
+                if (!write_interlaced_frame(
+                        (BitstreamWriter*)interlaced_frame,
+                        encoder,
+                        pcm_frames,
+                        uncompressed_LSBs, LSBs,
+                        INTERLACING_SHIFT,
+                        leftweight,
+                        MSBs0, MSBs1)) {
+                    return 0;
+                }
 
                 if (interlaced_frame->bits_written(interlaced_frame) <
                     best_interlaced_frame_bits) {
@@ -812,6 +896,7 @@ write_compressed_frame(BitstreamWriter *bs,
 
             /*write the smallest leftweight to disk*/
             best_interlaced_frame->copy(best_interlaced_frame, bs);
+            return 1;
         } else {
             /*extract uncompressed least-significant bits*/
             for (i = 0; i < pcm_frames; i++) {
@@ -819,16 +904,16 @@ write_compressed_frame(BitstreamWriter *bs,
                 MSBs0[i] = channel0[i] >> msb_shift;
             }
 
-            write_non_interlaced_frame(bs,
-                                       encoder,
-                                       pcm_frames,
-                                       uncompressed_LSBs, LSBs,
-                                       MSBs0);
+            return write_non_interlaced_frame(bs,
+                                              encoder,
+                                              pcm_frames,
+                                              uncompressed_LSBs, LSBs,
+                                              MSBs0);
         }
     }
 }
 
-static void
+static int
 write_non_interlaced_frame(BitstreamWriter *bs,
                            struct alac_context* encoder,
                            unsigned pcm_frames,
@@ -859,13 +944,16 @@ write_non_interlaced_frame(BitstreamWriter *bs,
     bs->write(bs, 8, 0);   /*no interlacing shift*/
     bs->write(bs, 8, 0);   /*no interlacing leftweight*/
 
-    compute_coefficients(encoder,
-                         pcm_frames,
-                         channel0,
-                         (encoder->bits_per_sample - (uncompressed_LSBs * 8)),
-                         &order,
-                         qlp_coefficients,
-                         (BitstreamWriter*)residual);
+    if (!compute_coefficients(encoder,
+                              pcm_frames,
+                              channel0,
+                              (encoder->bits_per_sample -
+                               (uncompressed_LSBs * 8)),
+                              &order,
+                              qlp_coefficients,
+                              (BitstreamWriter*)residual)) {
+        return 0;
+    }
 
     write_subframe_header(bs, order, qlp_coefficients);
 
@@ -876,9 +964,10 @@ write_non_interlaced_frame(BitstreamWriter *bs,
     }
 
     residual->copy(residual, bs);
+    return 1;
 }
 
-static void
+static int
 write_interlaced_frame(BitstreamWriter *bs,
                        struct alac_context* encoder,
                        unsigned pcm_frames,
@@ -926,23 +1015,27 @@ write_interlaced_frame(BitstreamWriter *bs,
                        correlated0,
                        correlated1);
 
-    compute_coefficients(encoder,
-                         pcm_frames,
-                         correlated0,
-                         (encoder->bits_per_sample -
-                          (uncompressed_LSBs * 8) + 1),
-                         &order0,
-                         qlp_coefficients0,
-                         (BitstreamWriter*)residual0);
-
-    compute_coefficients(encoder,
-                         pcm_frames,
-                         correlated1,
-                         (encoder->bits_per_sample -
-                          (uncompressed_LSBs * 8) + 1),
-                         &order1,
-                         qlp_coefficients1,
-                         (BitstreamWriter*)residual1);
+    if (!compute_coefficients(encoder,
+                              pcm_frames,
+                              correlated0,
+                              (encoder->bits_per_sample -
+                               (uncompressed_LSBs * 8) + 1),
+                              &order0,
+                              qlp_coefficients0,
+                              (BitstreamWriter*)residual0)) {
+        return 0;
+    }
+
+    if (!compute_coefficients(encoder,
+                              pcm_frames,
+                              correlated1,
+                              (encoder->bits_per_sample -
+                               (uncompressed_LSBs * 8) + 1),
+                              &order1,
+                              qlp_coefficients1,
+                              (BitstreamWriter*)residual1)) {
+        return 0;
+    }
 
     write_subframe_header(bs, order0, qlp_coefficients0);
     write_subframe_header(bs, order1, qlp_coefficients1);
@@ -955,6 +1048,7 @@ write_interlaced_frame(BitstreamWriter *bs,
 
     residual0->copy(residual0, bs);
     residual1->copy(residual1, bs);
+    return 1;
 }
 
 static void
@@ -982,7 +1076,7 @@ correlate_channels(unsigned pcm_frames,
     }
 }
 
-static void
+static int
 compute_coefficients(struct alac_context* encoder,
                      unsigned sample_count,
                      const int samples[],
@@ -1044,19 +1138,23 @@ compute_coefficients(struct alac_context* encoder,
 
         /*encode residual block for QLP coefficients at order 4*/
         residual_block4->reset(residual_block4);
-        encode_residuals(encoder,
-                         (BitstreamWriter*)residual_block4,
-                         sample_size,
-                         sample_count,
-                         residual_values4);
+        if (!encode_residuals(encoder,
+                              (BitstreamWriter*)residual_block4,
+                              sample_size,
+                              sample_count,
+                              residual_values4)) {
+            return 0;
+        }
 
         /*encode residual block for QLP coefficients at order 8*/
         residual_block8->reset(residual_block8);
-        encode_residuals(encoder,
-                         (BitstreamWriter*)residual_block8,
-                         sample_size,
-                         sample_count,
-                         residual_values8);
+        if (!encode_residuals(encoder,
+                              (BitstreamWriter*)residual_block8,
+                              sample_size,
+                              sample_count,
+                              residual_values8)) {
+            return 0;
+        }
 
         /*return the LPC coefficients/residual which is the smallest*/
         if (residual_block4->bits_written(residual_block4) <
@@ -1071,6 +1169,7 @@ compute_coefficients(struct alac_context* encoder,
             memcpy(qlp_coefficients, qlp_coefficients8, 8 * sizeof(int));
             residual_block8->copy(residual_block8, residual);
         }
+        return 1;
     } else {
         /*all samples are 0, so use a special case*/
         int residual_values4[sample_count];
@@ -1088,11 +1187,11 @@ compute_coefficients(struct alac_context* encoder,
                             qlp_coefficients,
                             residual_values4);
 
-        encode_residuals(encoder,
-                         residual,
-                         sample_size,
-                         sample_count,
-                         residual_values4);
+        return encode_residuals(encoder,
+                                residual,
+                                sample_size,
+                                sample_count,
+                                residual_values4);
     }
 }
 
@@ -1302,7 +1401,7 @@ LOG2(unsigned value)
 }
 
 
-static void
+static int
 encode_residuals(struct alac_context* encoder,
                  BitstreamWriter *residual_block,
                  unsigned sample_size,
@@ -1312,25 +1411,22 @@ encode_residuals(struct alac_context* encoder,
     int history = (int)encoder->options.initial_history;
     unsigned sign_modifier = 0;
     unsigned i = 0;
-    unsigned unsigned_i;
-    const unsigned max_unsigned = (1 << sample_size);
+    unsigned unsigned_residuals[residual_count];
     const unsigned history_multiplier = encoder->options.history_multiplier;
     const unsigned maximum_k = encoder->options.maximum_k;
     unsigned k;
     unsigned zeroes;
 
-    while (i < residual_count) {
-        if (residuals[i] >= 0) {
-            unsigned_i = (unsigned)(residuals[i] << 1);
-        } else {
-            unsigned_i = (unsigned)(-residuals[i] << 1) - 1;
-        }
+    /*check the whole block for overflow before writing any of it*/
+    if (!unsign_residuals(sample_size,
+                          residual_count,
+                          residuals,
+                          unsigned_residuals)) {
+        return 0;
+    }
 
-        if (unsigned_i >= max_unsigned) {
-            /*raise a residual overflow exception
-              which means writing an uncompressed frame instead*/
-            longjmp(encoder->residual_overflow, 1);
-        }
+    while (i < residual_count) {
+        const unsigned unsigned_i = unsigned_residuals[i];
 
         k = LOG2((history >> 9) + 3);
         k = MIN(k, maximum_k);
@@ -1350,7 +1446,7 @@ encode_residuals(struct alac_context* encoder,
                 k = 7 - LOG2(history) + ((history + 16) >> 6);
                 k = MIN(k, maximum_k);
                 zeroes = 0;
-                while ((i < residual_count) && (residuals[i] == 0)) {
+                while ((i < residual_count) && (unsigned_residuals[i] == 0)) {
                     zeroes++;
                     i++;
                 }
@@ -1364,9 +1460,57 @@ encode_residuals(struct alac_context* encoder,
             history = 0xFFFF;
         }
     }
+
+    return 1;
+}
+
+static int
+unsign_residuals(unsigned sample_size,
+                 unsigned residual_count,
+                 const int residuals[],
+                 unsigned unsigned_residuals[])
+{
+    /*residuals are truncated to at most 32 bits,
+      so any unsigned value of "sample_size" bits or more
+      has one of these bits set*/
+    const unsigned overflow_mask = ~((1u << sample_size) - 1);
+    unsigned overflow = 0;
+    unsigned i = 0;
+
+#ifdef __SSE2__
+    __m128i overflow4 = _mm_setzero_si128();
+    const __m128i overflow_mask4 = _mm_set1_epi32((int)overflow_mask);
+
+    for (; (i + 4) <= residual_count; i += 4) {
+        const __m128i residual4 =
+            _mm_loadu_si128((const __m128i*)(residuals + i));
+
+        /*(residual << 1) for positive residuals
+          or (-residual << 1) - 1 for negative ones*/
+        const __m128i unsigned4 =
+            _mm_xor_si128(_mm_slli_epi32(residual4, 1),
+                          _mm_srai_epi32(residual4, 31));
+
+        _mm_storeu_si128((__m128i*)(unsigned_residuals + i), unsigned4);
+        overflow4 = _mm_or_si128(overflow4,
+                                 _mm_and_si128(unsigned4, overflow_mask4));
+    }
+
+    overflow = (unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi32(overflow4, _mm_setzero_si128())) ^ 0xFFFF;
+#endif
+
+    for (; i < residual_count; i++) {
+        const unsigned unsigned_i =
+            ((unsigned)residuals[i] << 1) ^ (unsigned)(residuals[i] >> 31);
+        unsigned_residuals[i] = unsigned_i;
+        overflow |= unsigned_i & overflow_mask;
+    }
+
+    return overflow == 0;
 }
 
-static void
+static inline void
 write_residual(BitstreamWriter* residual_block,
                unsigned value,
                unsigned k,
@@ -1375,17 +1519,20 @@ write_residual(BitstreamWriter* residual_block,
     const unsigned MSB = value / ((1 << k) - 1);
     const unsigned LSB = value % ((1 << k) - 1);
     if (MSB > 8) {
-        residual_block->write(residual_block, 9, 0x1FF);
-        residual_block->write(residual_block, sample_size, value);
+        /*nine 1 bits followed by the value itself*/
+        residual_block->write(residual_block,
+                              9 + sample_size,
+                              (0x1FF << sample_size) | value);
     } else {
-        residual_block->write_unary(residual_block, 0, MSB);
-        if (k > 1) {
-            if (LSB > 0) {
-                residual_block->write(residual_block, k, LSB + 1);
-            } else {
-                residual_block->write(residual_block, k - 1, 0);
-            }
-        }
+        /*MSB 1 bits and a 0 stop bit
+          followed by k bits of LSB + 1, or k - 1 bits of 0 if LSB is 0,
+          all written at once*/
+        const unsigned LSB_bits = (k > 1) ? (k - (LSB == 0)) : 0;
+
+        residual_block->write(residual_block,
+                              MSB + 1 + LSB_bits,
+                              (((1 << MSB) - 1) << (LSB_bits + 1)) |
+                              (LSB + (LSB != 0)));
     }
 }
 
@@ -1628,6 +1775,7 @@ int main(int argc, char *argv[]) {
     int initial_history = 10;
     int history_multiplier = 40;
     int maximum_k = 14;
+    int verify = 0;
 
     struct alac_frame_size *frame_sizes;
 
@@ -1642,8 +1790,9 @@ int main(int argc, char *argv[]) {
         {"initial-history",         required_argument, NULL, 'I'},
         {"history-multiplier",      required_argument, NULL, 'M'},
         {"maximum-K",               required_argument, NULL, 'K'},
+        {"verify",                  no_argument,       NULL, 'V'},
         {NULL,                      no_argument, NULL, 0}};
-    const static char* short_opts = "-hc:r:b:T:B:M:K:";
+    const static char* short_opts = "-hc:r:b:T:B:M:K:V";
 
     while ((c = getopt_long(argc,
                             argv,
@@ -1708,6 +1857,9 @@ int main(int argc, char *argv[]) {
                 return 1;
             }
             break;
+        case 'V':
+            verify = 1;
+            break;
         case 'h': /*fallthrough*/
         case ':':
         case '?':
@@ -1721,6 +1873,8 @@ int main(int argc, char *argv[]) {
             printf("-I, --initial-history=#     initial history\n");
             printf("-M, --history-multiplier=#  history multiplier\n");
             printf("-K, --maximum-K=#           maximum K\n");
+            printf("-V, --verify                "
+                   "decode each frameset to check it\n");
             return 0;
         default:
             break;
@@ -1759,6 +1913,7 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "initial history    %d\n", initial_history);
     fprintf(stderr, "history multiplier %d\n", history_multiplier);
     fprintf(stderr, "maximum K          %d\n", maximum_k);
+    fprintf(stderr, "verify framesets   %d\n", verify);
 
     frame_sizes = encode_alac(output,
                               pcmreader,
@@ -1767,6 +1922,7 @@ int main(int argc, char *argv[]) {
                               initial_history,
                               history_multiplier,
                               maximum_k,
+                              verify,
                               encoder_version);
 
     output->close(output);
@@ -10,6 +10,7 @@
 #include <time.h>
 #include "../pcmreader.h"
 #include "../bitstream.h"
+#include "../decoders/alac_frame.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -45,6 +46,7 @@ struct alac_encoding_options {
     unsigned maximum_k;
     unsigned minimum_interlacing_leftweight;
     unsigned maximum_interlacing_leftweight;
+    int verify;
 };
 
 /*this is a container for encoding options and reusable data buffers*/
@@ -65,11 +67,8 @@ struct alac_context {
     BitstreamRecorder *interlaced_frame;
     BitstreamRecorder *best_interlaced_frame;
 
-    /*set during write_frame
-      in case a single residual value exceeds the maximum allowed
-      when writing a compressed frame
-      which means we need to write an uncompressed frame instead*/
-    jmp_buf residual_overflow;
+    /*holds each frameset until it's verified, if verifying*/
+    BitstreamRecorder *frameset;
 };
 
 enum {LOG_SAMPLE_SIZE, LOG_BYTE_SIZE, LOG_FILE_OFFSET};
@@ -86,7 +85,10 @@ free_encoder(struct alac_context* encoder);
 
   if "total_pcm_frames" is 0, assume the total size of the input
   stream is unknown and write to a temporary file before
-  encoding to output*/
+  encoding to output
+
+  if "verify" is set, each frameset is decoded as soon as it's encoded
+  and compared against its input, failing at the first that differs*/
 static struct alac_frame_size*
 encode_alac(BitstreamWriter *output,
             struct PCMReader *pcmreader,
@@ -95,6 +97,7 @@ encode_alac(BitstreamWriter *output,
             int initial_history,
             int history_multiplier,
             int maximum_k,
+            int verify,
             const char encoder_version[]);
 
 /*encodes the entire mdat atom and returns a linked list of frame sizes*/
@@ -104,16 +107,27 @@ encode_mdat(BitstreamWriter *output,
             int block_size,
             int initial_history,
             int history_multiplier,
-            int maximum_k);
+            int maximum_k,
+            int verify);
 
-/*writes a full set of ALAC frames,
+/*writes a full set of ALAC frames from the given .wav order channels,
   complete with trailing stop '111' bits and byte-aligned*/
 static void
 write_frameset(BitstreamWriter *bs,
                struct alac_context* encoder,
                unsigned pcm_frames,
                unsigned channel_count,
-               const int channels[]);
+               const int *const channels[]);
+
+/*decodes the frameset held by "frameset"
+  and returns 1 if it decodes to the "pcm_frames" samples
+  of each of the given .wav order channels, 0 if not*/
+static int
+verify_frameset(const struct alac_context *encoder,
+                const BitstreamRecorder *frameset,
+                unsigned pcm_frames,
+                unsigned channel_count,
+                const int *const channels[]);
 
 /*write a single ALAC frame, compressed or uncompressed as necessary*/
 static void
@@ -133,7 +147,10 @@ write_uncompressed_frame(BitstreamWriter *bs,
                          const int channel0[],
                          const int channel1[]);
 
-static void
+/*writes a single compressed ALAC frame, not including the channel count
+  and returns 1 on success, or 0 if a residual value exceeds
+  the maximum allowed and an uncompressed frame must be written instead*/
+static int
 write_compressed_frame(BitstreamWriter *bs,
                        struct alac_context* encoder,
                        unsigned pcm_frames,
@@ -141,7 +158,8 @@ write_compressed_frame(BitstreamWriter *bs,
                        const int channel0[],
                        const int channel1[]);
 
-static void
+/*returns 1 on success, 0 on residual overflow*/
+static int
 write_non_interlaced_frame(BitstreamWriter *bs,
                            struct alac_context* encoder,
                            unsigned pcm_frames,
@@ -149,7 +167,8 @@ write_non_interlaced_frame(BitstreamWriter *bs,
                            const int LSBs[],
                            const int channel0[]);
 
-static void
+/*returns 1 on success, 0 on residual overflow*/
+static int
 write_interlaced_frame(BitstreamWriter *bs,
                        struct alac_context* encoder,
                        unsigned pcm_frames,
@@ -169,7 +188,8 @@ correlate_channels(unsigned pcm_frames,
                    int correlated0[],
                    int correlated1[]);
 
-static void
+/*returns 1 on success, 0 on residual overflow*/
+static int
 compute_coefficients(struct alac_context* encoder,
                      unsigned sample_count,
                      const int samples[],
@@ -223,14 +243,28 @@ calculate_residuals(unsigned sample_size,
                     const int qlp_coefficients[],
                     int residuals[]);
 
-static void
+/*scans the residuals for overflow before any are written
+  then writes the whole block to "residual_block"
+
+  returns 1 on success, or 0 if a residual value exceeds the maximum
+  allowed, in which case nothing is written*/
+static int
 encode_residuals(struct alac_context* encoder,
                  BitstreamWriter *residual_block,
                  unsigned sample_size,
                  unsigned residual_count,
                  const int residuals[]);
 
-static void
+/*converts each residual to its unsigned form
+  and returns 1 if they all fit in "sample_size" bits, 0 if not*/
+static int
+unsign_residuals(unsigned sample_size,
+                 unsigned residual_count,
+                 const int residuals[],
+                 unsigned unsigned_residuals[]);
+
+/*writes a single residual value as one combined code*/
+static inline void
 write_residual(BitstreamWriter* residual_block,
                unsigned value,
                unsigned k,
@@ -2,6 +2,8 @@
 #include "../common/md5.h"
 #include "../common/flac_crc.h"
 #include "../pcm_conv.h"
+#include "../framelist.h"
+#include "../decoders/flac_frame.h"
 #include <string.h>
 #include <inttypes.h>
 #include <math.h>
@@ -83,27 +85,50 @@ write_VORBIS_COMMENT(BitstreamWriter *output,
                      const char version[],
                      const struct PCMReader *pcmreader);
 
+/*updates the running MD5 sum with the interleaved form
+  of the given channels*/
 static void
 update_md5sum(audiotools__MD5Context *md5sum,
-              const int pcm_data[],
+              int *const channel_data[],
               unsigned channels,
               unsigned bits_per_sample,
               unsigned pcm_frames);
 
+/*sets the options derived from block size and bits-per-sample
+  and allocates the window, which must be freed once encoding is done*/
+static void
+derive_options(struct flac_encoding_options *options,
+               unsigned bits_per_sample);
+
+/*encodes the whole of the PCMReader's data as FLAC frames
+  and returns a list of their sizes
+  or NULL with "status" set if an error occurs*/
 static struct flac_frame_size*
 encode_frames(struct PCMReader *pcmreader,
               BitstreamWriter *output,
               const struct flac_encoding_options *options,
-              audiotools__MD5Context *md5_context);
+              audiotools__MD5Context *md5_context,
+              flacenc_status_t *status);
 
+/*encodes a frame from the given channels of "pcm_frames" samples each
+  which may be modified in the process*/
 static void
 encode_frame(const struct PCMReader *pcmreader,
              BitstreamWriter *output,
              const struct flac_encoding_options *options,
-             const int pcm_data[],
+             int *const channel_data[],
              unsigned pcm_frames,
              unsigned frame_number);
 
+/*decodes the encoded frame held by "frame"
+  and returns 1 if it decodes to the "pcm_frames" samples
+  of each of the given channels, 0 if not*/
+static int
+verify_frame(const struct PCMReader *pcmreader,
+             const BitstreamRecorder *frame,
+             int *const channel_data[],
+             unsigned pcm_frames);
+
 static void
 correlate_channels(unsigned pcm_frames,
                    const int left_channel[],
@@ -331,6 +356,8 @@ flacenc_init_options(struct flac_encoding_options *options)
     options->use_constant = 1;
     options->use_fixed = 1;
 
+    options->verify = 0;
+
     /*these are just placeholders*/
     options->qlp_coeff_precision = 12;
     options->max_rice_parameter = 14;
@@ -361,6 +388,8 @@ flacenc_display_options(const struct flac_encoding_options *options,
            options->use_constant);
     printf("use FIXED subframes     %d\n",
            options->use_fixed);
+    printf("verify frames           %d\n",
+           options->verify);
 }
 
 #define BUFFER_SIZE 4096
@@ -379,6 +408,7 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
     unsigned maximum_frame_size;
     audiotools__MD5Context md5_context;
     uint8_t md5sum[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    flacenc_status_t status;
 
     /*make seekpoints every 10 seconds, or every 10 frames
       whichever is larger*/
@@ -387,37 +417,7 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
 
     audiotools__MD5Init(&md5_context);
 
-    /*set QLP coeff precision based on block size*/
-    if (options->block_size <= 192) {
-        options->qlp_coeff_precision = 7;
-    } else if (options->block_size <= 384) {
-        options->qlp_coeff_precision = 8;
-    } else if (options->block_size <= 576) {
-        options->qlp_coeff_precision = 9;
-    } else if (options->block_size <= 1152) {
-        options->qlp_coeff_precision = 10;
-    } else if (options->block_size <= 2304) {
-        options->qlp_coeff_precision = 11;
-    } else if (options->block_size <= 4608) {
-        options->qlp_coeff_precision = 12;
-    } else {
-        options->qlp_coeff_precision = 13;
-    }
-
-    /*set maximum Rice parameter based on bits-per-sample*/
-    if (pcmreader->bits_per_sample <= 16) {
-        options->max_rice_parameter = 15;
-    } else {
-        options->max_rice_parameter = 31;
-    }
-
-    /*generate Tukey window, if necessary*/
-    if (options->max_lpc_order) {
-        options->window = malloc(sizeof(double) * options->block_size);
-        tukey_window(0.5, options->block_size, options->window);
-    } else {
-        options->window = NULL;
-    }
+    derive_options(options, pcmreader->bits_per_sample);
 
     /*write signature*/
     output->write_bytes(output, signature, 4);
@@ -463,11 +463,17 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
         frame_sizes = encode_frames(pcmreader,
                                     output,
                                     options,
-                                    &md5_context);
+                                    &md5_context,
+                                    &status);
 
         /*delete window now that we're done with it, if necessary*/
         free(options->window);
 
+        if (!frame_sizes && (status == FLAC_VERIFY_ERROR)) {
+            streaminfo_start->del(streaminfo_start);
+            return FLAC_VERIFY_ERROR;
+        }
+
         /*ensure total PCM frames matches*/
         frame_sizes_info(frame_sizes,
                          &minimum_frame_size,
@@ -524,7 +530,8 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
         frame_sizes = encode_frames(pcmreader,
                                     temp_output,
                                     options,
-                                    &md5_context);
+                                    &md5_context,
+                                    &status);
 
         temp_output->free(temp_output);
 
@@ -533,7 +540,7 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
 
         if (!frame_sizes) {
             fclose(tempfile);
-            return FLAC_READ_ERROR;
+            return status;
         }
 
         /*determine STREAMINFO from frames information*/
@@ -591,8 +598,122 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
 }
 
 
+uint64_t
+flacenc_trial_encode(struct flac_encoding_options *options,
+                     unsigned sample_rate,
+                     unsigned channels,
+                     unsigned bits_per_sample,
+                     unsigned pcm_frames,
+                     const int *samples)
+{
+    BitstreamAccumulator *accumulator = bw_open_accumulator(BS_BIG_ENDIAN);
+    /*encode_frame() only consults the stream's parameters*/
+    struct PCMReader stream;
+    int block_data[options->block_size * channels];
+    int *channel_data[channels];
+    unsigned frame_number = 0;
+    unsigned offset;
+    unsigned c;
+    uint64_t total_bits = 0;
+
+    stream.sample_rate = sample_rate;
+    stream.channels = channels;
+    stream.bits_per_sample = bits_per_sample;
+
+    derive_options(options, bits_per_sample);
+
+    for (c = 0; c < channels; c++) {
+        channel_data[c] = block_data + (c * options->block_size);
+    }
+
+    for (offset = 0; offset < pcm_frames; offset += options->block_size) {
+        const unsigned block_frames = MIN(options->block_size,
+                                          pcm_frames - offset);
+        const unsigned bits_before = accumulator->bits_written(accumulator);
+
+        /*encode_frame() may modify the channels it's given
+          so encode a copy of each block*/
+        for (c = 0; c < channels; c++) {
+            memcpy(channel_data[c],
+                   samples + (c * pcm_frames) + offset,
+                   block_frames * sizeof(int));
+        }
+
+        encode_frame(&stream,
+                     (BitstreamWriter*)accumulator,
+                     options,
+                     channel_data,
+                     block_frames,
+                     frame_number++);
+
+        /*the accumulator's own count may wrap on long samples
+          but no single frame comes anywhere near doing so*/
+        total_bits += accumulator->bits_written(accumulator) - bits_before;
+    }
+
+    free(options->window);
+    options->window = NULL;
+    accumulator->close(accumulator);
+
+    return total_bits / 8;
+}
+
+
 #ifndef STANDALONE
 
+/*sanity-checks the given options and populates the options struct
+  returns 1 on success, or 0 with a ValueError set if an option is invalid*/
+static int
+set_options(struct flac_encoding_options *options,
+            int block_size,
+            int max_lpc_order,
+            int min_residual_partition_order,
+            int max_residual_partition_order)
+{
+    if (block_size < 1) {
+        PyErr_SetString(PyExc_ValueError, "block size must be > 0");
+        return 0;
+    } else if (block_size > 65535) {
+        PyErr_SetString(PyExc_ValueError, "block size must be <= 65535");
+        return 0;
+    } else {
+        options->block_size = block_size;
+    }
+    if (max_lpc_order < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_lpc_order must be >= 0");
+        return 0;
+    } else if (max_lpc_order > 32) {
+        PyErr_SetString(PyExc_ValueError, "max_lpc_order must be <= 32");
+        return 0;
+    } else {
+        options->max_lpc_order = max_lpc_order;
+    }
+    if (min_residual_partition_order < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "min_residual_partition_order must be >= 0");
+        return 0;
+    } else if (min_residual_partition_order > 15) {
+        PyErr_SetString(PyExc_ValueError,
+                        "min_residual_partition_order must be <= 15");
+        return 0;
+    } else {
+        options->min_residual_partition_order = min_residual_partition_order;
+    }
+    if (max_residual_partition_order < 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "max_residual_partition_order must be >= 0");
+        return 0;
+    } else if (max_residual_partition_order > 15) {
+        PyErr_SetString(PyExc_ValueError,
+                        "max_residual_partition_order must be <= 15");
+        return 0;
+    } else {
+        options->max_residual_partition_order = max_residual_partition_order;
+    }
+
+    return 1;
+}
+
 PyObject*
 encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
 {
@@ -615,6 +736,7 @@ encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
                              "disable_fixed_subframes",
                              "disable_lpc_subframes",
                              "padding_size",
+                             "verify",
                              NULL};
 
     char *filename = NULL;
@@ -642,7 +764,7 @@ encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
     if (!PyArg_ParseTupleAndKeywords(
             args,
             keywds,
-            "sO&s|Liiiiiiiiiiii",
+            "sO&s|Liiiiiiiiiiiii",
             kwlist,
             &filename,
             py_obj_to_pcmreader,
@@ -661,7 +783,8 @@ encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
             &no_constant_subframes,
             &no_fixed_subframes,
             &no_lpc_subframes,
-            &padding_size)) {
+            &padding_size,
+            &options.verify)) {
         return NULL;
     }
 
@@ -670,45 +793,12 @@ encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
         PyErr_SetString(PyExc_ValueError, "total PCM frames must be >= 0");
         goto error;
     }
-    if (block_size < 1) {
-        PyErr_SetString(PyExc_ValueError, "block size must be > 0");
+    if (!set_options(&options,
+                     block_size,
+                     max_lpc_order,
+                     min_residual_partition_order,
+                     max_residual_partition_order)) {
         goto error;
-    } else if (block_size > 65535) {
-        PyErr_SetString(PyExc_ValueError, "block size must be <= 65535");
-        goto error;
-    } else {
-        options.block_size = block_size;
-    }
-    if (max_lpc_order < 0) {
-        PyErr_SetString(PyExc_ValueError, "max_lpc_order must be >= 0");
-        goto error;
-    } else if (max_lpc_order > 32) {
-        PyErr_SetString(PyExc_ValueError, "max_lpc_order must be <= 32");
-        goto error;
-    } else {
-        options.max_lpc_order = max_lpc_order;
-    }
-    if (min_residual_partition_order < 0) {
-        PyErr_SetString(PyExc_ValueError,
-                        "min_residual_partition_order must be >= 0");
-        goto error;
-    } else if (min_residual_partition_order > 15) {
-        PyErr_SetString(PyExc_ValueError,
-                        "min_residual_partition_order must be <= 15");
-        goto error;
-    } else {
-        options.min_residual_partition_order = min_residual_partition_order;
-    }
-    if (max_residual_partition_order < 0) {
-        PyErr_SetString(PyExc_ValueError,
-                        "max_residual_partition_order must be >= 0");
-        goto error;
-    } else if (max_residual_partition_order > 15) {
-        PyErr_SetString(PyExc_ValueError,
-                        "max_residual_partition_order must be <= 15");
-        goto error;
-    } else {
-        options.max_residual_partition_order = max_residual_partition_order;
     }
     if (padding_size < 0) {
         PyErr_SetString(PyExc_ValueError, "padding must be >= 0");
@@ -757,6 +847,10 @@ encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
     case FLAC_NO_TEMPFILE:
         PyErr_SetString(PyExc_IOError, "error opening temporary file");
         return NULL;
+    case FLAC_VERIFY_ERROR:
+        PyErr_SetString(PyExc_ValueError,
+                        "encoded frame failed verification");
+        return NULL;
     }
 
 error:
@@ -764,12 +858,172 @@ error:
     return NULL;
 }
 
+PyObject*
+encoders_trial_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds)
+{
+    struct flac_encoding_options options;
+
+    static char *kwlist[] = {"framelist",
+                             "sample_rate",
+
+                             "block_size",
+                             "max_lpc_order",
+                             "min_residual_partition_order",
+                             "max_residual_partition_order",
+                             "mid_side",
+                             "adaptive_mid_side",
+                             "exhaustive_model_search",
+                             NULL};
+
+    PyObject *audiotools_pcm;
+    PyObject *framelist_type;
+    pcm_FrameList *framelist;
+    int sample_rate;
+
+    int block_size = 4096;
+    int max_lpc_order = 12;
+    int min_residual_partition_order = 0;
+    int max_residual_partition_order = 6;
+
+    int *samples;
+    uint64_t encoded_bytes;
+
+    flacenc_init_options(&options);
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args,
+            keywds,
+            "Oi|iiiiiii",
+            kwlist,
+            &framelist,
+            &sample_rate,
+
+            &block_size,
+            &max_lpc_order,
+            &min_residual_partition_order,
+            &max_residual_partition_order,
+            &options.mid_side,
+            &options.adaptive_mid_side,
+            &options.exhaustive_model_search)) {
+        return NULL;
+    }
+
+    /*ensure framelist is a pcm.FrameList object*/
+    if ((audiotools_pcm = open_audiotools_pcm()) == NULL) {
+        return NULL;
+    }
+    framelist_type = PyObject_GetAttrString(audiotools_pcm, "FrameList");
+    Py_DECREF(audiotools_pcm);
+    if (framelist_type == NULL) {
+        return NULL;
+    } else if (Py_TYPE(framelist) != (PyTypeObject*)framelist_type) {
+        Py_DECREF(framelist_type);
+        PyErr_SetString(PyExc_TypeError, "framelist must be a FrameList");
+        return NULL;
+    } else {
+        Py_DECREF(framelist_type);
+    }
+
+    /*sanity-check options and populate options struct*/
+    if ((framelist->bits_per_sample != 8) &&
+        (framelist->bits_per_sample != 16) &&
+        (framelist->bits_per_sample != 24)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "bits per sample must be 8, 16 or 24");
+        return NULL;
+    }
+    if ((framelist->channels < 1) || (framelist->channels > 8)) {
+        PyErr_SetString(PyExc_ValueError, "channels must be 1-8");
+        return NULL;
+    }
+    if (sample_rate < 1) {
+        PyErr_SetString(PyExc_ValueError, "sample rate must be > 0");
+        return NULL;
+    }
+    if (!set_options(&options,
+                     block_size,
+                     max_lpc_order,
+                     min_residual_partition_order,
+                     max_residual_partition_order)) {
+        return NULL;
+    }
+
+    /*trial encoding takes planar samples*/
+    samples = malloc(FrameList_samples_length(framelist) * sizeof(int));
+    if (framelist->planar) {
+        memcpy(samples,
+               framelist->samples,
+               FrameList_samples_length(framelist) * sizeof(int));
+    } else {
+        unsigned c;
+        for (c = 0; c < framelist->channels; c++) {
+            get_channel_data(framelist->samples,
+                             c,
+                             framelist->channels,
+                             framelist->frames,
+                             samples + (c * framelist->frames));
+        }
+    }
+
+    /*the FrameList isn't touched while encoding,
+      so other threads may run trials of their own alongside this one*/
+    Py_BEGIN_ALLOW_THREADS
+    encoded_bytes = flacenc_trial_encode(&options,
+                                         (unsigned)sample_rate,
+                                         framelist->channels,
+                                         framelist->bits_per_sample,
+                                         framelist->frames,
+                                         samples);
+    Py_END_ALLOW_THREADS
+
+    free(samples);
+
+    return Py_BuildValue("K", (unsigned long long)encoded_bytes);
+}
+
 #endif
 
 /************************************
  * private function implementations *
  ************************************/
 
+static void
+derive_options(struct flac_encoding_options *options,
+               unsigned bits_per_sample)
+{
+    /*set QLP coeff precision based on block size*/
+    if (options->block_size <= 192) {
+        options->qlp_coeff_precision = 7;
+    } else if (options->block_size <= 384) {
+        options->qlp_coeff_precision = 8;
+    } else if (options->block_size <= 576) {
+        options->qlp_coeff_precision = 9;
+    } else if (options->block_size <= 1152) {
+        options->qlp_coeff_precision = 10;
+    } else if (options->block_size <= 2304) {
+        options->qlp_coeff_precision = 11;
+    } else if (options->block_size <= 4608) {
+        options->qlp_coeff_precision = 12;
+    } else {
+        options->qlp_coeff_precision = 13;
+    }
+
+    /*set maximum Rice parameter based on bits-per-sample*/
+    if (bits_per_sample <= 16) {
+        options->max_rice_parameter = 15;
+    } else {
+        options->max_rice_parameter = 31;
+    }
+
+    /*generate Tukey window, if necessary*/
+    if (options->max_lpc_order) {
+        options->window = malloc(sizeof(double) * options->block_size);
+        tukey_window(0.5, options->block_size, options->window);
+    } else {
+        options->window = NULL;
+    }
+}
+
 static void
 write_block_header(BitstreamWriter *output,
                    unsigned is_last,
@@ -996,14 +1250,20 @@ write_VORBIS_COMMENT(BitstreamWriter *output,
 
 static void
 update_md5sum(audiotools__MD5Context *md5sum,
-              const int pcm_data[],
+              int *const channel_data[],
               unsigned channels,
               unsigned bits_per_sample,
               unsigned pcm_frames)
 {
     const unsigned total_samples = pcm_frames * channels;
     const unsigned buffer_size = total_samples * (bits_per_sample / 8);
+    int pcm_data[total_samples];
     unsigned char buffer[buffer_size];
+    unsigned c;
+
+    for (c = 0; c < channels; c++) {
+        put_channel_data(pcm_data, c, channels, pcm_frames, channel_data[c]);
+    }
 
     int_to_pcm_converter(bits_per_sample, 0, 1)(total_samples,
                                                 pcm_data,
@@ -1016,33 +1276,97 @@ static struct flac_frame_size*
 encode_frames(struct PCMReader *pcmreader,
               BitstreamWriter *output,
               const struct flac_encoding_options *options,
-              audiotools__MD5Context *md5_context)
+              audiotools__MD5Context *md5_context,
+              flacenc_status_t *status)
 {
     struct flac_frame_size *frame_sizes = NULL;
     int pcm_data[options->block_size * pcmreader->channels];
+    int *channel_data[pcmreader->channels];
+    /*when verifying, encode_frame() is given a copy of each block
+      since it may modify the channels it's given*/
+    int *encoded_data = NULL;
+    int *encoded_channels[pcmreader->channels];
+    BitstreamRecorder *frame = NULL;
     unsigned pcm_frames_read;
     unsigned frame_number = 0;
+    unsigned c;
+
+    /*channels are read planar, each a whole block apart*/
+    for (c = 0; c < pcmreader->channels; c++) {
+        channel_data[c] = pcm_data + (c * options->block_size);
+    }
+
+    if (options->verify) {
+        encoded_data = malloc(sizeof(pcm_data));
+        for (c = 0; c < pcmreader->channels; c++) {
+            encoded_channels[c] = encoded_data + (c * options->block_size);
+        }
+        /*frame CRCs are calculated as bytes are written
+          so the frame must be recorded as bytes*/
+        frame = bw_open_bytes_recorder(BS_BIG_ENDIAN);
+    } else {
+        for (c = 0; c < pcmreader->channels; c++) {
+            encoded_channels[c] = channel_data[c];
+        }
+    }
 
     while ((pcm_frames_read =
-            pcmreader->read(pcmreader, options->block_size, pcm_data)) > 0) {
+            pcmreader->read_planar(pcmreader,
+                                   options->block_size,
+                                   pcm_data)) > 0) {
         unsigned frame_size = 0;
 
         /*update running MD5 of stream*/
         update_md5sum(md5_context,
-                      pcm_data,
+                      channel_data,
                       pcmreader->channels,
                       pcmreader->bits_per_sample,
                       pcm_frames_read);
 
-        /*encode frame itself*/
-        output->add_callback(output, (bs_callback_f)byte_counter, &frame_size);
-        encode_frame(pcmreader,
-                     output,
-                     options,
-                     pcm_data,
-                     pcm_frames_read,
-                     frame_number++);
-        output->pop_callback(output, NULL);
+        if (frame) {
+            /*encode frame to recorder and decode it again
+              while its input is still at hand
+              before passing it along to the output*/
+            for (c = 0; c < pcmreader->channels; c++) {
+                memcpy(encoded_channels[c],
+                       channel_data[c],
+                       pcm_frames_read * sizeof(int));
+            }
+
+            frame->reset(frame);
+            encode_frame(pcmreader,
+                         (BitstreamWriter*)frame,
+                         options,
+                         encoded_channels,
+                         pcm_frames_read,
+                         frame_number++);
+
+            if (!verify_frame(pcmreader,
+                              frame,
+                              channel_data,
+                              pcm_frames_read)) {
+                frame->close(frame);
+                free(encoded_data);
+                free_frame_sizes(frame_sizes);
+                *status = FLAC_VERIFY_ERROR;
+                return NULL;
+            }
+
+            frame_size = frame->bytes_written(frame);
+            frame->copy(frame, output);
+        } else {
+            /*encode frame itself*/
+            output->add_callback(output,
+                                 (bs_callback_f)byte_counter,
+                                 &frame_size);
+            encode_frame(pcmreader,
+                         output,
+                         options,
+                         encoded_channels,
+                         pcm_frames_read,
+                         frame_number++);
+            output->pop_callback(output, NULL);
+        }
 
         /*save total length of frame*/
         frame_sizes = push_frame_size(frame_sizes,
@@ -1050,20 +1374,83 @@ encode_frames(struct PCMReader *pcmreader,
                                       pcm_frames_read);
     }
 
+    if (frame) {
+        frame->close(frame);
+        free(encoded_data);
+    }
+
     if (pcmreader->status == PCM_OK) {
         reverse_frame_sizes(&frame_sizes);
+        *status = FLAC_OK;
         return frame_sizes;
     } else {
         free_frame_sizes(frame_sizes);
+        *status = FLAC_READ_ERROR;
         return NULL;
     }
 }
 
+static int
+verify_frame(const struct PCMReader *pcmreader,
+             const BitstreamRecorder *frame,
+             int *const channel_data[],
+             unsigned pcm_frames)
+{
+    const unsigned frame_bytes = frame->bytes_written(frame);
+    uint8_t *data = malloc(frame_bytes);
+    BitstreamReader *reader;
+    struct STREAMINFO streaminfo;
+    struct flac_frame_header frame_header;
+    int samples[pcm_frames * pcmreader->channels];
+    uint16_t crc16 = 0;
+    flac_status status;
+    unsigned c;
+
+    frame->data(frame, data);
+    reader = br_open_buffer(data, frame_bytes, BS_BIG_ENDIAN);
+
+    /*only the stream parameters the frame header refers to are needed*/
+    streaminfo.maximum_block_size = pcm_frames;
+    streaminfo.sample_rate = pcmreader->sample_rate;
+    streaminfo.channel_count = pcmreader->channels;
+    streaminfo.bits_per_sample = pcmreader->bits_per_sample;
+
+    reader->add_callback(reader, (bs_callback_f)flac_crc16, &crc16);
+
+    if (((status = flacdec_read_frame_header(reader,
+                                             &streaminfo,
+                                             &frame_header)) == OK) &&
+        (frame_header.block_size == pcm_frames) &&
+        ((status = flacdec_decode_subframes(reader,
+                                            &frame_header,
+                                            samples)) == OK)) {
+        status = flacdec_read_crc16(reader);
+    }
+
+    reader->pop_callback(reader, NULL);
+    reader->close(reader);
+    free(data);
+
+    if ((status != OK) || crc16 || (frame_header.block_size != pcm_frames)) {
+        return 0;
+    }
+
+    for (c = 0; c < pcmreader->channels; c++) {
+        if (memcmp(samples + (c * pcm_frames),
+                   channel_data[c],
+                   pcm_frames * sizeof(int))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 static void
 encode_frame(const struct PCMReader *pcmreader,
              BitstreamWriter *output,
              const struct flac_encoding_options *options,
-             const int pcm_data[],
+             int *const channel_data[],
              unsigned pcm_frames,
              unsigned frame_number)
 {
@@ -1075,8 +1462,8 @@ encode_frame(const struct PCMReader *pcmreader,
     if ((pcmreader->channels == 2) &&
         (options->mid_side || options->adaptive_mid_side)) {
         /*attempt different assignments if stereo and mid-side requested*/
-        int left_channel[pcm_frames];
-        int right_channel[pcm_frames];
+        int *left_channel = channel_data[0];
+        int *right_channel = channel_data[1];
         int average_channel[pcm_frames];
         int difference_channel[pcm_frames];
 
@@ -1094,9 +1481,6 @@ encode_frame(const struct PCMReader *pcmreader,
         unsigned side_right;
         unsigned mid_side;
 
-        get_channel_data(pcm_data, 0, 2, pcm_frames, left_channel);
-        get_channel_data(pcm_data, 1, 2, pcm_frames, right_channel);
-
         correlate_channels(pcm_frames,
                            left_channel,
                            right_channel,
@@ -1206,15 +1590,10 @@ encode_frame(const struct PCMReader *pcmreader,
 
         /*write 1 subframe per channel*/
         for (c = 0; c < pcmreader->channels; c++) {
-            int channel_data[pcm_frames];
-
-            get_channel_data(pcm_data, c, pcmreader->channels,
-                             pcm_frames, channel_data);
-
             encode_subframe(output,
                             options,
                             pcm_frames,
-                            channel_data,
+                            channel_data[c],
                             pcmreader->bits_per_sample);
         }
     }
@@ -2385,9 +2764,10 @@ int main(int argc, char *argv[])
          &options.use_constant, 0},
         {"disable-fixed-subframes", no_argument,
          &options.use_fixed, 0},
+        {"verify",                  no_argument,       NULL, 'V'},
         {NULL,                      no_argument,       NULL,  0}
     };
-    const static char* short_opts = "-hc:r:b:T:B:l:P:R:mMe";
+    const static char* short_opts = "-hc:r:b:T:B:l:P:R:mMeV";
 
     flacenc_init_options(&options);
 
@@ -2468,6 +2848,9 @@ int main(int argc, char *argv[])
         case 'e':
             options.exhaustive_model_search = 1;
             break;
+        case 'V':
+            options.verify = 1;
+            break;
         case 'h': /*fallthrough*/
         case ':':
         case '?':
@@ -2487,6 +2870,8 @@ int main(int argc, char *argv[])
             printf("-m, --mid-side                  use mid-side encoding\n");
             printf("-e, --exhaustive-model-search   "
                    "search for best subframe exhaustively\n");
+            printf("-V, --verify                    "
+                   "decode each frame to check it\n");
             return 0;
         default:
             break;
@@ -2538,6 +2923,9 @@ int main(int argc, char *argv[])
     case FLAC_NO_TEMPFILE:
         fputs("*** Error: unable to open temporary file\n", stderr);
         break;
+    case FLAC_VERIFY_ERROR:
+        fputs("*** Error: encoded frame failed verification\n", stderr);
+        break;
     }
 
     output->close(output);
@@ -28,7 +28,8 @@ typedef enum {
     FLAC_OK,           /*everything ok*/
     FLAC_READ_ERROR,   /*read error from PCMReader*/
     FLAC_PCM_MISMATCH, /*total PCM frames mismatch*/
-    FLAC_NO_TEMPFILE   /*unable to open temporary file*/
+    FLAC_NO_TEMPFILE,  /*unable to open temporary file*/
+    FLAC_VERIFY_ERROR  /*an encoded frame didn't decode to its input*/
 } flacenc_status_t;
 
 struct flac_encoding_options {
@@ -44,6 +45,8 @@ struct flac_encoding_options {
     int use_constant;                       /*a boolean for debugging*/
     int use_fixed;                          /*a boolean for debugging*/
 
+    int verify;                             /*a boolean*/
+
     unsigned qlp_coeff_precision;           /*derived from block size*/
     unsigned max_rice_parameter;            /*derived from bits-per-sample*/
     double *window;                         /*for windowing input samples*/
@@ -61,7 +64,11 @@ flacenc_display_options(const struct flac_encoding_options *options,
 
 /*encodes a FLAC file using data from the given PCMReader
   to the given output stream
-  using the given options*/
+  using the given options
+
+  if options->verify is set, each frame is decoded
+  as soon as it's encoded and compared against its input
+  returning FLAC_VERIFY_ERROR at the first frame that differs*/
 flacenc_status_t
 flacenc_encode_flac(struct PCMReader *pcmreader,
                     BitstreamWriter *output,
@@ -70,7 +77,25 @@ flacenc_encode_flac(struct PCMReader *pcmreader,
                     const char version[],
                     unsigned padding_size);
 
+/*encodes "pcm_frames" of samples, stored channel-major with
+  each channel "pcm_frames" long, as a series of FLAC frames
+  using the given options without writing them anywhere
+  and returns their total size in bytes
+
+  this is for comparing sets of options against one another
+  on a sample of a stream before encoding all of it*/
+uint64_t
+flacenc_trial_encode(struct flac_encoding_options *options,
+                     unsigned sample_rate,
+                     unsigned channels,
+                     unsigned bits_per_sample,
+                     unsigned pcm_frames,
+                     const int *samples);
+
 #ifndef STANDALONE
 PyObject*
 encoders_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds);
+
+PyObject*
+encoders_trial_encode_flac(PyObject *dummy, PyObject *args, PyObject *keywds);
 #endif
@@ -35,7 +35,7 @@ encoders_encode_mp2(PyObject *dummy, PyObject *args, PyObject *keywds)
                              NULL};
     int quality;
     twolame_options *twolame_opts = NULL;
-    int buffer[BLOCK_SIZE * 2];
+    const int *buffer;
     short int buffer_l[BLOCK_SIZE];
     short int buffer_r[BLOCK_SIZE];
     unsigned char mp2buf[MP2BUF_SIZE];
@@ -93,7 +93,8 @@ encoders_encode_mp2(PyObject *dummy, PyObject *args, PyObject *keywds)
     twolame_init_params(twolame_opts);
 
     /*for each non-empty FrameList from PCMReader, encode MP2 frame*/
-    while ((pcm_frames = pcmreader->read(pcmreader, BLOCK_SIZE, buffer)) > 0) {
+    while ((pcm_frames =
+            pcmreader->acquire(pcmreader, BLOCK_SIZE, &buffer)) > 0) {
         unsigned i;
         if (pcmreader->channels == 2) {
             for (i = 0; i < pcm_frames; i++) {
@@ -105,6 +106,7 @@ encoders_encode_mp2(PyObject *dummy, PyObject *args, PyObject *keywds)
                 buffer_l[i] = buffer_r[i] = (short int)buffer[i];
             }
         }
+        pcmreader->release(pcmreader, pcm_frames);
 
         if ((to_output = twolame_encode_buffer(twolame_opts,
                                                buffer_l,
@@ -36,7 +36,7 @@ encoders_encode_mp3(PyObject *dummy, PyObject *args, PyObject *keywds)
                              NULL};
     char *quality = NULL;
     lame_global_flags *gfp = NULL;
-    int buffer[BLOCK_SIZE * 2];
+    const int *buffer;
     short int buffer_l[BLOCK_SIZE];
     short int buffer_r[BLOCK_SIZE];
     unsigned char mp3buf[MP3BUF_SIZE];
@@ -143,7 +143,8 @@ encoders_encode_mp3(PyObject *dummy, PyObject *args, PyObject *keywds)
     }
 
     /*for each non-empty FrameList from PCMReader, encode MP3 frame*/
-    while ((pcm_frames = pcmreader->read(pcmreader, BLOCK_SIZE, buffer)) > 0) {
+    while ((pcm_frames =
+            pcmreader->acquire(pcmreader, BLOCK_SIZE, &buffer)) > 0) {
         unsigned i;
         if (pcmreader->channels == 2) {
             for (i = 0; i < pcm_frames; i++) {
@@ -155,6 +156,7 @@ encoders_encode_mp3(PyObject *dummy, PyObject *args, PyObject *keywds)
                 buffer_l[i] = buffer_r[i] = (short int)buffer[i];
             }
         }
+        pcmreader->release(pcmreader, pcm_frames);
 
         switch (to_output = lame_encode_buffer(gfp,
                                                buffer_l,
@@ -0,0 +1,310 @@
+#include <speex/speex.h>
+#include <speex/speex_header.h>
+#include <speex/speex_stereo.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../bitstream.h"
+#include "../pcmreader.h"
+#include "../ogg.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+#define SPEEX_PACKET_LEN 2000
+
+typedef enum {
+    ENCODE_OK,
+    ERR_IOERROR,
+    ERR_WRITE_ERROR,
+    ERR_PCMREADER
+} result_t;
+
+static result_t
+encode_speex_file(char *filename,
+                  struct PCMReader *pcmreader,
+                  int quality);
+
+/*reads a whole Speex frame's worth of PCM frames from pcmreader,
+  returning fewer than "pcm_frames" only at the end of the stream
+  returns 0 and leaves the reader's status set if an error occurs*/
+static unsigned
+read_frame(struct PCMReader *pcmreader, unsigned pcm_frames, int *samples);
+
+/*returns the Speex mode best suited to the given sample rate*/
+static const SpeexMode*
+rate_to_mode(unsigned sample_rate);
+
+#ifndef STANDALONE
+PyObject*
+encoders_encode_speex(PyObject *dummy, PyObject *args, PyObject *keywds)
+{
+    char *filename;
+    struct PCMReader *pcmreader = NULL;
+    int quality;
+    static char *kwlist[] = {"filename",
+                             "pcmreader",
+                             "quality",
+                             NULL};
+    result_t result;
+
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "sO&i",
+                                     kwlist,
+                                     &filename,
+                                     py_obj_to_pcmreader,
+                                     &pcmreader,
+                                     &quality)) {
+        if (pcmreader != NULL)
+            pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    /*sanity check quality*/
+    if ((quality < 0) || (quality > 10)) {
+        PyErr_SetString(PyExc_ValueError, "quality must be 0-10");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    /*sanity check PCMReader*/
+    if ((pcmreader->channels != 1) && (pcmreader->channels != 2)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "PCMReader channels must be 1 or 2");
+        pcmreader->del(pcmreader);
+        return NULL;
+    } else if ((pcmreader->bits_per_sample != 8) &&
+               (pcmreader->bits_per_sample != 16) &&
+               (pcmreader->bits_per_sample != 24)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "PCMReader bits_per_sample must be 8, 16 or 24");
+        pcmreader->del(pcmreader);
+        return NULL;
+    }
+
+    result = encode_speex_file(filename, pcmreader, quality);
+
+    pcmreader->del(pcmreader);
+
+    switch (result) {
+    case ENCODE_OK:
+    default:
+        Py_INCREF(Py_None);
+        return Py_None;
+    case ERR_IOERROR:
+        PyErr_SetFromErrnoWithFilename(PyExc_IOError, filename);
+        return NULL;
+    case ERR_WRITE_ERROR:
+        PyErr_SetString(PyExc_IOError, "I/O error writing stream");
+        return NULL;
+    case ERR_PCMREADER:
+        /*pass error through from PCMReader*/
+        return NULL;
+    }
+}
+#endif
+
+static result_t
+encode_speex_file(char *filename,
+                  struct PCMReader *pcmreader,
+                  int quality)
+{
+    const SpeexMode *mode = rate_to_mode(pcmreader->sample_rate);
+    const unsigned channels = pcmreader->channels;
+    FILE *output_file;
+    OggPacketWriter *ogg_writer;
+    void *encoder;
+    SpeexBits bits;
+    int frame_size;
+    int lookahead;
+    int rate = (int)pcmreader->sample_rate;
+    int *samples = NULL;
+    spx_int16_t *input = NULL;
+    char packet[SPEEX_PACKET_LEN];
+    result_t result = ENCODE_OK;
+
+    /*open output file for writing*/
+    if ((output_file = fopen(filename, "w+b")) == NULL) {
+        return ERR_IOERROR;
+    }
+
+    srand((unsigned)time(NULL));
+    ogg_writer = oggwriter_open(output_file, (unsigned)rand());
+
+    encoder = speex_encoder_init(mode);
+    speex_encoder_ctl(encoder, SPEEX_SET_QUALITY, &quality);
+    speex_encoder_ctl(encoder, SPEEX_SET_SAMPLING_RATE, &rate);
+    speex_encoder_ctl(encoder, SPEEX_GET_FRAME_SIZE, &frame_size);
+    speex_encoder_ctl(encoder, SPEEX_GET_LOOKAHEAD, &lookahead);
+    speex_bits_init(&bits);
+
+    samples = malloc(sizeof(int) * frame_size * channels);
+    input = malloc(sizeof(spx_int16_t) * frame_size * channels);
+
+    if (!setjmp(*bw_try(ogg_writer->writer))) {
+        /*Speex takes 16-bit input only*/
+        const int multiplier = pcmreader->bits_per_sample == 8 ? 256 : 1;
+        const unsigned shift = pcmreader->bits_per_sample == 24 ? 8 : 0;
+        int64_t total_frames = 0;
+        /*PCM frames encoded, less the encoder's delay*/
+        int64_t encoded_frames = -lookahead;
+        int finished = 0;
+
+        /*write header and comment packets on pages of their own*/
+        {
+            SpeexHeader header;
+            char *header_packet;
+            int header_size;
+            const char *speex_version;
+            char vendor_string[64];
+            unsigned vendor_string_len;
+            BitstreamRecorder *comment =
+                bw_open_bytes_recorder(BS_LITTLE_ENDIAN);
+            BitstreamWriter *comment_w = (BitstreamWriter*)comment;
+            uint8_t *comment_packet;
+
+            speex_init_header(&header, rate, 1, mode);
+            header.frames_per_packet = 1;
+            header.vbr = 0;
+            header.nb_channels = (spx_int32_t)channels;
+
+            header_packet = speex_header_to_packet(&header, &header_size);
+            oggwriter_write_packet(ogg_writer,
+                                   (uint8_t*)header_packet,
+                                   (unsigned)header_size,
+                                   0,
+                                   1);
+            speex_header_free(header_packet);
+
+            speex_lib_ctl(SPEEX_LIB_GET_VERSION_STRING, (void*)&speex_version);
+            snprintf(vendor_string, sizeof(vendor_string),
+                     "Encoded with Speex %s", speex_version);
+            vendor_string_len = (unsigned)strlen(vendor_string);
+
+            comment_w->write(comment_w, 32, vendor_string_len);
+            comment_w->write_bytes(comment_w,
+                                   (uint8_t*)vendor_string,
+                                   vendor_string_len);
+            comment_w->write(comment_w, 32, 0);
+
+            comment_packet = malloc(comment->bytes_written(comment));
+            comment->data(comment, comment_packet);
+            oggwriter_write_packet(ogg_writer,
+                                   comment_packet,
+                                   comment->bytes_written(comment),
+                                   0,
+                                   1);
+            free(comment_packet);
+            comment->close(comment);
+        }
+
+        /*encode one frame per packet, as speexenc does,
+          continuing past the end of the input
+          until the encoder's lookahead has been flushed*/
+        do {
+            unsigned pcm_frames = 0;
+            unsigned i;
+            int packet_size;
+
+            if (!finished) {
+                pcm_frames = read_frame(pcmreader,
+                                        (unsigned)frame_size,
+                                        samples);
+                if (pcmreader->status != PCM_OK) {
+                    result = ERR_PCMREADER;
+                    break;
+                }
+                total_frames += pcm_frames;
+                finished = (pcm_frames < (unsigned)frame_size);
+            }
+
+            for (i = 0; i < pcm_frames * channels; i++) {
+                input[i] = (spx_int16_t)((samples[i] * multiplier) >> shift);
+            }
+            for (; i < (unsigned)frame_size * channels; i++) {
+                input[i] = 0;
+            }
+
+            if (channels == 2) {
+                speex_encode_stereo_int(input, frame_size, &bits);
+            }
+            speex_encode_int(encoder, input, &bits);
+            encoded_frames += frame_size;
+
+            speex_bits_insert_terminator(&bits);
+            packet_size = speex_bits_write(&bits, packet, SPEEX_PACKET_LEN);
+            speex_bits_reset(&bits);
+
+            oggwriter_write_packet(ogg_writer,
+                                   (uint8_t*)packet,
+                                   (unsigned)packet_size,
+                                   encoded_frames < total_frames ?
+                                   encoded_frames : total_frames,
+                                   0);
+        } while (!finished || (encoded_frames < total_frames));
+
+        bw_etry(ogg_writer->writer);
+    } else {
+        bw_etry(ogg_writer->writer);
+        result = ERR_WRITE_ERROR;
+    }
+
+    /*closing the writer marks the final page as end-of-stream
+      and closes the file*/
+    if (oggwriter_close(ogg_writer) && (result == ENCODE_OK)) {
+        result = ERR_WRITE_ERROR;
+    }
+    speex_encoder_destroy(encoder);
+    speex_bits_destroy(&bits);
+    free(samples);
+    free(input);
+    return result;
+}
+
+static unsigned
+read_frame(struct PCMReader *pcmreader, unsigned pcm_frames, int *samples)
+{
+    unsigned total = 0;
+
+    while (total < pcm_frames) {
+        const unsigned read =
+            pcmreader->read(pcmreader,
+                            pcm_frames - total,
+                            samples + (total * pcmreader->channels));
+        if (read == 0) {
+            break;
+        } else {
+            total += read;
+        }
+    }
+
+    return total;
+}
+
+static const SpeexMode*
+rate_to_mode(unsigned sample_rate)
+{
+    /*the same thresholds speexenc uses*/
+    if (sample_rate > 25000) {
+        return speex_lib_get_mode(SPEEX_MODEID_UWB);
+    } else if (sample_rate > 12500) {
+        return speex_lib_get_mode(SPEEX_MODEID_WB);
+    } else {
+        return speex_lib_get_mode(SPEEX_MODEID_NB);
+    }
+}
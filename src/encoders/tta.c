@@ -1,5 +1,6 @@
 #include "tta.h"
 #include "../common/tta_crc.h"
+#include <pthread.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -41,6 +42,32 @@ struct residual_params {
     int sum1;
 };
 
+/*a single TTA frame to be encoded by one of the pool's threads*/
+struct tta_frame_job {
+    unsigned bits_per_sample;
+    unsigned channels;
+    unsigned block_size;      /*PCM frames in "samples", 0 if none*/
+    int *samples;
+    BitstreamRecorder *frame; /*the encoded frame*/
+};
+
+/*encoding threads started once per file
+  which take jobs from the batch most recently started*/
+struct tta_frame_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t jobs_ready;    /*signalled when a batch is started*/
+    pthread_cond_t jobs_finished; /*signalled when a batch is done*/
+
+    struct tta_frame_job *jobs;   /*the batch being encoded*/
+    unsigned count;               /*jobs in the batch*/
+    unsigned next;                /*the next job no thread has taken*/
+    unsigned finished;            /*jobs done encoding*/
+    int stop;                     /*1 if threads should exit*/
+
+    unsigned thread_count;        /*threads actually started*/
+    pthread_t *threads;
+};
+
 /*******************************
  * private function signatures *
  *******************************/
@@ -111,6 +138,62 @@ write_residual(struct residual_params *params,
                int residual,
                BitstreamWriter *output);
 
+/*encodes the job's samples to its frame recorder*/
+static void
+encode_frame_job(struct tta_frame_job *job);
+
+/*starts up to "threads" encoding threads,
+  all of which wait for jobs until the pool is closed*/
+static void
+open_frame_pool(struct tta_frame_pool *pool, unsigned threads);
+
+/*stops and joins the pool's threads*/
+static void
+close_frame_pool(struct tta_frame_pool *pool);
+
+/*takes and encodes jobs until the pool is closed*/
+static void*
+frame_pool_thread(struct tta_frame_pool *pool);
+
+/*hands the first "count" jobs to the pool's threads,
+  encoding them immediately if no thread could be started*/
+static void
+start_frame_jobs(struct tta_frame_pool *pool,
+                 struct tta_frame_job jobs[],
+                 unsigned count);
+
+/*waits for the most recently started jobs to finish encoding*/
+static void
+finish_frame_jobs(struct tta_frame_pool *pool);
+
+/*writes the first "count" encoded jobs to output in order,
+  resets their recorders and pushes their sizes onto "frame_sizes"
+
+  if "verify" is set, each job's frame is verified before it's written
+  and returns 0 at the first one which fails
+  otherwise returns 1*/
+static int
+write_frame_jobs(struct tta_frame_job jobs[],
+                 unsigned count,
+                 int verify,
+                 struct tta_frame_size **frame_sizes,
+                 BitstreamWriter *output);
+
+/*decodes the encoded frame and compares it against
+  the interleaved samples it was encoded from
+
+  returns 1 if they match, 0 if not*/
+static int
+verify_frame(unsigned bits_per_sample,
+             unsigned channels,
+             unsigned block_size,
+             const int samples[],
+             const BitstreamRecorder *frame);
+
+/*reports an encoded frame which failed verification*/
+static void
+verification_failed(void);
+
 static struct tta_frame_size*
 append_size(struct tta_frame_size *stack,
             unsigned pcm_frames,
@@ -125,7 +208,8 @@ reverse_frame_sizes(struct tta_frame_size **stack);
 
 struct tta_frame_size*
 ttaenc_encode_tta_frames(struct PCMReader *pcmreader,
-                         BitstreamWriter *output)
+                         BitstreamWriter *output,
+                         int verify)
 {
     struct tta_frame_size *frame_sizes = NULL;
     const unsigned default_block_size = tta_block_size(pcmreader->sample_rate);
@@ -134,22 +218,54 @@ ttaenc_encode_tta_frames(struct PCMReader *pcmreader,
     int *samples = malloc(default_block_size *
                           pcmreader->channels *
                           sizeof(int));
+    BitstreamRecorder *frame =
+        verify ? bw_open_bytes_recorder(BS_LITTLE_ENDIAN) : NULL;
 
     output->add_callback(output, (bs_callback_f)byte_counter, &frame_size);
 
     while ((block_size =
             pcmreader->read(pcmreader, default_block_size, samples)) > 0) {
-        encode_frame(pcmreader->bits_per_sample,
-                     pcmreader->channels,
-                     block_size,
-                     samples,
-                     output);
+        if (frame) {
+            /*encode frame to recorder and decode it again
+              while its input is still at hand
+              before passing it along to the output*/
+            frame->reset(frame);
+            encode_frame(pcmreader->bits_per_sample,
+                         pcmreader->channels,
+                         block_size,
+                         samples,
+                         (BitstreamWriter*)frame);
+
+            if (!verify_frame(pcmreader->bits_per_sample,
+                              pcmreader->channels,
+                              block_size,
+                              samples,
+                              frame)) {
+                output->pop_callback(output, NULL);
+                frame->close(frame);
+                free(samples);
+                free_tta_frame_sizes(frame_sizes);
+                verification_failed();
+                return NULL;
+            }
+
+            frame->copy(frame, output);
+        } else {
+            encode_frame(pcmreader->bits_per_sample,
+                         pcmreader->channels,
+                         block_size,
+                         samples,
+                         output);
+        }
         frame_sizes = append_size(frame_sizes, block_size, frame_size);
         frame_size = 0;
     }
 
     output->pop_callback(output, NULL);
 
+    if (frame) {
+        frame->close(frame);
+    }
     free(samples);
 
     if (pcmreader->status == PCM_OK) {
@@ -164,6 +280,101 @@ ttaenc_encode_tta_frames(struct PCMReader *pcmreader,
 
 }
 
+struct tta_frame_size*
+ttaenc_encode_tta_frames_parallel(struct PCMReader *pcmreader,
+                                  BitstreamWriter *output,
+                                  unsigned threads,
+                                  int verify)
+{
+    struct tta_frame_size *frame_sizes = NULL;
+    const unsigned default_block_size = tta_block_size(pcmreader->sample_rate);
+    /*one batch is being read while the other is being encoded*/
+    struct tta_frame_job batches[2][threads];
+    struct tta_frame_job *reading = batches[0];
+    struct tta_frame_job *encoding = batches[1];
+    unsigned encoding_count = 0;
+    struct tta_frame_pool pool;
+    int verified = 1;
+    unsigned b;
+    unsigned i;
+
+    for (b = 0; b < 2; b++) {
+        for (i = 0; i < threads; i++) {
+            batches[b][i].bits_per_sample = pcmreader->bits_per_sample;
+            batches[b][i].channels = pcmreader->channels;
+            batches[b][i].block_size = 0;
+            batches[b][i].samples = malloc(default_block_size *
+                                           pcmreader->channels *
+                                           sizeof(int));
+            batches[b][i].frame = bw_open_bytes_recorder(BS_LITTLE_ENDIAN);
+        }
+    }
+
+    open_frame_pool(&pool, threads);
+
+    do {
+        struct tta_frame_job *swap;
+        unsigned reading_count;
+
+        /*read a batch of frames while the previous batch is encoding*/
+        for (reading_count = 0; reading_count < threads; reading_count++) {
+            struct tta_frame_job *job = &reading[reading_count];
+            if ((job->block_size =
+                 pcmreader->read(pcmreader,
+                                 default_block_size,
+                                 job->samples)) == 0) {
+                break;
+            }
+        }
+
+        /*write the previous batch
+          and start encoding the new batch in its place*/
+        finish_frame_jobs(&pool);
+        start_frame_jobs(&pool, reading, reading_count);
+        verified = write_frame_jobs(encoding,
+                                    encoding_count,
+                                    verify,
+                                    &frame_sizes,
+                                    output);
+
+        swap = encoding;
+        encoding = reading;
+        reading = swap;
+        encoding_count = reading_count;
+    } while (verified && (encoding_count == threads));
+
+    /*write the final batch*/
+    finish_frame_jobs(&pool);
+    if (verified) {
+        verified = write_frame_jobs(encoding,
+                                    encoding_count,
+                                    verify,
+                                    &frame_sizes,
+                                    output);
+    }
+
+    close_frame_pool(&pool);
+
+    for (b = 0; b < 2; b++) {
+        for (i = 0; i < threads; i++) {
+            free(batches[b][i].samples);
+            batches[b][i].frame->free(batches[b][i].frame);
+        }
+    }
+
+    if (!verified) {
+        free_tta_frame_sizes(frame_sizes);
+        verification_failed();
+        return NULL;
+    } else if (pcmreader->status == PCM_OK) {
+        reverse_frame_sizes(&frame_sizes);
+        return frame_sizes;
+    } else {
+        free_tta_frame_sizes(frame_sizes);
+        return NULL;
+    }
+}
+
 unsigned
 total_tta_frame_sizes(const struct tta_frame_size *frame_sizes)
 {
@@ -463,6 +674,214 @@ write_residual(struct residual_params *params,
     params->k0 += adjustment(params->sum0, params->k0);
 }
 
+static void
+encode_frame_job(struct tta_frame_job *job)
+{
+    encode_frame(job->bits_per_sample,
+                 job->channels,
+                 job->block_size,
+                 job->samples,
+                 (BitstreamWriter*)job->frame);
+}
+
+static void
+open_frame_pool(struct tta_frame_pool *pool, unsigned threads)
+{
+    unsigned i;
+
+    pthread_mutex_init(&(pool->lock), NULL);
+    pthread_cond_init(&(pool->jobs_ready), NULL);
+    pthread_cond_init(&(pool->jobs_finished), NULL);
+    pool->jobs = NULL;
+    pool->count = 0;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->stop = 0;
+    pool->threads = malloc(sizeof(pthread_t) * threads);
+
+    /*if some threads can't be started, the rest take up the slack*/
+    for (i = 0; i < threads; i++) {
+        if (pthread_create(&(pool->threads[i]),
+                           NULL,
+                           (void*(*)(void*))frame_pool_thread,
+                           pool)) {
+            break;
+        }
+    }
+    pool->thread_count = i;
+}
+
+static void
+close_frame_pool(struct tta_frame_pool *pool)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->stop = 1;
+    pthread_cond_broadcast(&(pool->jobs_ready));
+    pthread_mutex_unlock(&(pool->lock));
+
+    for (i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    free(pool->threads);
+    pthread_cond_destroy(&(pool->jobs_finished));
+    pthread_cond_destroy(&(pool->jobs_ready));
+    pthread_mutex_destroy(&(pool->lock));
+}
+
+static void*
+frame_pool_thread(struct tta_frame_pool *pool)
+{
+    pthread_mutex_lock(&(pool->lock));
+    for (;;) {
+        struct tta_frame_job *job;
+
+        while ((pool->next == pool->count) && (!pool->stop)) {
+            pthread_cond_wait(&(pool->jobs_ready), &(pool->lock));
+        }
+        if (pool->next == pool->count) {
+            /*stopped with nothing left to take*/
+            pthread_mutex_unlock(&(pool->lock));
+            return NULL;
+        }
+        job = &(pool->jobs[pool->next++]);
+        pthread_mutex_unlock(&(pool->lock));
+
+        /*no other thread touches a job once it's taken*/
+        encode_frame_job(job);
+
+        pthread_mutex_lock(&(pool->lock));
+        if (++pool->finished == pool->count) {
+            pthread_cond_signal(&(pool->jobs_finished));
+        }
+    }
+}
+
+static void
+start_frame_jobs(struct tta_frame_pool *pool,
+                 struct tta_frame_job jobs[],
+                 unsigned count)
+{
+    if (pool->thread_count == 0) {
+        unsigned i;
+        for (i = 0; i < count; i++) {
+            encode_frame_job(&jobs[i]);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->jobs = jobs;
+    pool->count = count;
+    pool->next = 0;
+    pool->finished = 0;
+    pthread_cond_broadcast(&(pool->jobs_ready));
+    pthread_mutex_unlock(&(pool->lock));
+}
+
+static void
+finish_frame_jobs(struct tta_frame_pool *pool)
+{
+#ifndef STANDALONE
+    /*encoding threads don't need the GIL, so let others have it*/
+    PyThreadState *thread_state = PyEval_SaveThread();
+#endif
+
+    pthread_mutex_lock(&(pool->lock));
+    while (pool->finished < pool->count) {
+        pthread_cond_wait(&(pool->jobs_finished), &(pool->lock));
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+#ifndef STANDALONE
+    PyEval_RestoreThread(thread_state);
+#endif
+}
+
+static int
+write_frame_jobs(struct tta_frame_job jobs[],
+                 unsigned count,
+                 int verify,
+                 struct tta_frame_size **frame_sizes,
+                 BitstreamWriter *output)
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        BitstreamRecorder *frame = jobs[i].frame;
+        if (verify && !verify_frame(jobs[i].bits_per_sample,
+                                    jobs[i].channels,
+                                    jobs[i].block_size,
+                                    jobs[i].samples,
+                                    frame)) {
+            return 0;
+        }
+        *frame_sizes = append_size(*frame_sizes,
+                                   jobs[i].block_size,
+                                   frame->bytes_written(frame));
+        frame->copy(frame, output);
+        frame->reset(frame);
+    }
+
+    return 1;
+}
+
+static int
+verify_frame(unsigned bits_per_sample,
+             unsigned channels,
+             unsigned block_size,
+             const int samples[],
+             const BitstreamRecorder *frame)
+{
+    const unsigned frame_bytes = frame->bytes_written(frame);
+    uint8_t *data = malloc(frame_bytes);
+    int *decoded = malloc(block_size * channels * sizeof(int));
+    BitstreamReader *reader;
+    tta_status status;
+    unsigned i;
+    unsigned c;
+
+    frame->data(frame, data);
+    reader = br_open_buffer(data, frame_bytes, BS_LITTLE_ENDIAN);
+    status = ttadec_decode_frame(reader,
+                                 channels,
+                                 bits_per_sample,
+                                 block_size,
+                                 decoded);
+    reader->close(reader);
+    free(data);
+
+    if (status != OK) {
+        free(decoded);
+        return 0;
+    }
+
+    /*decoded samples are planar, encoded samples interleaved*/
+    for (i = 0; i < block_size; i++) {
+        for (c = 0; c < channels; c++) {
+            if (decoded[(c * block_size) + i] != samples[(i * channels) + c]) {
+                free(decoded);
+                return 0;
+            }
+        }
+    }
+
+    free(decoded);
+    return 1;
+}
+
+static void
+verification_failed(void)
+{
+#ifndef STANDALONE
+    PyErr_SetString(PyExc_ValueError, "encoded frame failed verification");
+#else
+    fputs("*** Error: encoded frame failed verification\n", stderr);
+#endif
+}
+
 static struct tta_frame_size*
 append_size(struct tta_frame_size *stack,
             unsigned pcm_frames,
@@ -493,6 +912,22 @@ reverse_frame_sizes(struct tta_frame_size **stack)
 
 #define BUFFER_SIZE 4096
 
+static struct tta_frame_size*
+encode_frames(struct PCMReader *pcmreader,
+              BitstreamWriter *output,
+              unsigned threads,
+              int verify)
+{
+    if (threads > 1) {
+        return ttaenc_encode_tta_frames_parallel(pcmreader,
+                                                 output,
+                                                 threads,
+                                                 verify);
+    } else {
+        return ttaenc_encode_tta_frames(pcmreader, output, verify);
+    }
+}
+
 PyObject*
 encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
 {
@@ -502,14 +937,23 @@ encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
     const long long maximum_pcm_frames = 0xFFFFFFFFll;
     BitstreamWriter *output;
     struct tta_frame_size *frame_sizes;
-    static char *kwlist[] = {"file", "pcmreader", "total_pcm_frames", NULL};
+    int threads = 1;
+    int verify = 0;
+    static char *kwlist[] = {"file",
+                             "pcmreader",
+                             "total_pcm_frames",
+                             "threads",
+                             "verify",
+                             NULL};
 
     if (!PyArg_ParseTupleAndKeywords(
-            args, keywds, "OO&|L", kwlist,
+            args, keywds, "OO&|Lii", kwlist,
             &file_obj,
             py_obj_to_pcmreader,
             &pcmreader,
-            &total_pcm_frames)) {
+            &total_pcm_frames,
+            &threads,
+            &verify)) {
         return NULL;
     }
 
@@ -524,6 +968,11 @@ encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
         return NULL;
     }
 
+    if (threads < 1) {
+        PyErr_SetString(PyExc_ValueError, "threads must be >= 1");
+        return NULL;
+    }
+
     /*wrap BitstreamWriter around file object*/
     output = bw_open_external(file_obj,
                               BS_LITTLE_ENDIAN,
@@ -561,10 +1010,14 @@ encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
         output->write(output, 32, 0);
 
         /*write frames*/
-        if ((frame_sizes =
-             ttaenc_encode_tta_frames(pcmreader, output)) == NULL) {
+        if ((frame_sizes = encode_frames(pcmreader,
+                                         output,
+                                         (unsigned)threads,
+                                         verify)) == NULL) {
             seektable_pos->del(seektable_pos);
-            PyErr_SetString(PyExc_IOError, "read error during encoding");
+            if (pcmreader->status != PCM_OK) {
+                PyErr_SetString(PyExc_IOError, "read error during encoding");
+            }
             goto error;
         }
 
@@ -597,10 +1050,16 @@ encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
         }
 
         /*write frames to temporary space*/
-        frame_sizes = ttaenc_encode_tta_frames(pcmreader, tempwriter);
+        frame_sizes = encode_frames(pcmreader,
+                                    tempwriter,
+                                    (unsigned)threads,
+                                    verify);
         tempwriter->free(tempwriter);
         if (!frame_sizes) {
-            PyErr_SetString(PyExc_IOError, "read error during encoding");
+            fclose(tempfile);
+            if (pcmreader->status != PCM_OK) {
+                PyErr_SetString(PyExc_IOError, "read error during encoding");
+            }
             goto error;
         }
 
@@ -637,11 +1096,24 @@ encoders_encode_tta(PyObject *dummy, PyObject *args, PyObject *keywds)
     Py_INCREF(Py_None);
     return Py_None;
 error:
-    pcmreader->close(pcmreader);
-    pcmreader->del(pcmreader);
+    {
+        /*closing the PCMReader and flushing the output
+          call Python methods, which mustn't clobber
+          the exception being raised*/
+        PyObject *type;
+        PyObject *value;
+        PyObject *traceback;
 
-    output->flush(output);
-    output->free(output);
+        PyErr_Fetch(&type, &value, &traceback);
+
+        pcmreader->close(pcmreader);
+        pcmreader->del(pcmreader);
+
+        output->flush(output);
+        output->free(output);
+
+        PyErr_Restore(type, value, traceback);
+    }
 
     return NULL;
 }
@@ -661,6 +1133,8 @@ main(int argc, char* argv[]) {
     unsigned sample_rate = 44100;
     unsigned bits_per_sample = 16;
     unsigned total_pcm_frames = 0;
+    unsigned threads = 1;
+    int verify = 0;
 
     struct PCMReader *pcmreader;
     BitstreamWriter *output;
@@ -678,8 +1152,10 @@ main(int argc, char* argv[]) {
         {"sample-rate",             required_argument, NULL, 'r'},
         {"bits-per-sample",         required_argument, NULL, 'b'},
         {"total-pcm-frames",        required_argument, NULL, 'T'},
+        {"threads",                 required_argument, NULL, 't'},
+        {"verify",                  no_argument,       NULL, 'V'},
         {NULL,                      no_argument,       NULL, 0}};
-    const static char* short_opts = "-hc:r:b:T:";
+    const static char* short_opts = "-hc:r:b:T:t:V";
 
     while ((c = getopt_long(argc,
                             argv,
@@ -720,6 +1196,15 @@ main(int argc, char* argv[]) {
                 return 1;
             }
             break;
+        case 't':
+            if (((threads = strtoul(optarg, NULL, 10)) == 0) && errno) {
+                printf("invalid --threads \"%s\"\n", optarg);
+                return 1;
+            }
+            break;
+        case 'V':
+            verify = 1;
+            break;
         case 'h': /*fallthrough*/
         case ':':
         case '?':
@@ -728,6 +1213,8 @@ main(int argc, char* argv[]) {
             printf("-r, --sample_rate=#       input sample rate in Hz\n");
             printf("-b, --bits-per-sample=#   bits per input sample\n");
             printf("-T, --total-pcm-frames=#  total PCM frames of input\n");
+            printf("-t, --threads=#           frames to encode at once\n");
+            printf("-V, --verify              decode each frame to check it\n");
             return 0;
         default:
             break;
@@ -749,6 +1236,7 @@ main(int argc, char* argv[]) {
            (bits_per_sample == 24));
     assert(sample_rate > 0);
     assert(total_pcm_frames > 0);
+    assert(threads > 0);
 
     block_size = tta_block_size(sample_rate);
     total_tta_frames = div_ceil(total_pcm_frames, block_size);
@@ -780,7 +1268,22 @@ main(int argc, char* argv[]) {
     output->write(output, 32, 0);
 
     /*write TTA frames*/
-    frame_sizes = ttaenc_encode_tta_frames(pcmreader, output);
+    if (threads > 1) {
+        frame_sizes = ttaenc_encode_tta_frames_parallel(pcmreader,
+                                                        output,
+                                                        threads,
+                                                        verify);
+    } else {
+        frame_sizes = ttaenc_encode_tta_frames(pcmreader, output, verify);
+    }
+
+    if (frame_sizes == NULL) {
+        seektable_pos->del(seektable_pos);
+        output->close(output);
+        pcmreader->close(pcmreader);
+        pcmreader->del(pcmreader);
+        return 1;
+    }
 
     /*write finalized seektable*/
     output->setpos(output, seektable_pos);
@@ -5,6 +5,7 @@
 
 #include "../bitstream.h"
 #include "../pcmreader.h"
+#include "../decoders/tta_frame.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -36,10 +37,28 @@ struct tta_frame_size {
   which must be deallocated when no longer needed
   using free_tta_frame_sizes()
 
-  returns NULL if some error occurs reading from PCMReader*/
+  if "verify" is set, each frame is decoded again
+  and compared against the samples it was encoded from
+  before being written to output
+
+  returns NULL if some error occurs reading from PCMReader
+  or if a frame fails verification,
+  in which case pcmreader's status is still PCM_OK*/
 struct tta_frame_size*
 ttaenc_encode_tta_frames(struct PCMReader *pcmreader,
-                         BitstreamWriter *output);
+                         BitstreamWriter *output,
+                         int verify);
+
+/*works like ttaenc_encode_tta_frames
+  but encodes up to "threads" frames at once, each on its own thread,
+  while the next batch of frames is read from pcmreader
+
+  since TTA frames are independent, the output is identical*/
+struct tta_frame_size*
+ttaenc_encode_tta_frames_parallel(struct PCMReader *pcmreader,
+                                  BitstreamWriter *output,
+                                  unsigned threads,
+                                  int verify);
 
 /*given a list of TTA frame sizes, returns the total PCM frames*/
 unsigned
@@ -0,0 +1,418 @@
+#include "fingerprint.h"
+#include "pcm.h"
+#include "mod_defs.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/**********************************************************************
+  A spectral fingerprint of a whole track, robust to lossy encoding
+
+  The track is downmixed to mono and split into Hann-windowed frames
+  of about 50ms, whose energy is measured in BANDS logarithmic bands.
+  Once complete, the frames are summed into SEGMENTS segments
+  and each bit of the fingerprint is the sign of the change
+  in energy difference between two neighboring bands
+  from one segment to the next, as in Haitsma and Kalker's
+  "A Highly Robust Audio Fingerprinting System".
+
+  Since every bit compares sums of several seconds of energy,
+  the fingerprint survives lossy encoding, resampling, gain changes
+  and a few milliseconds of encoder delay.
+ **********************************************************************/
+
+#ifndef MIN
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#endif
+#ifndef MAX
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+#endif
+
+/*frames are no longer than this many seconds*/
+#define MAX_FRAME_DURATION 0.05
+
+static PyMethodDef fingerprint_methods[] = {
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+MOD_INIT(_fingerprint)
+{
+    PyObject* m;
+
+    MOD_DEF(m, "_fingerprint",
+            "a spectral audio fingerprint calculation module",
+            fingerprint_methods)
+
+    fingerprint_FingerprinterType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&fingerprint_FingerprinterType) < 0)
+        return MOD_ERROR_VAL;
+
+    Py_INCREF(&fingerprint_FingerprinterType);
+    PyModule_AddObject(m, "Fingerprinter",
+                       (PyObject *)&fingerprint_FingerprinterType);
+    PyModule_AddIntConstant(m, "FINGERPRINT_BITS", FINGERPRINT_BITS);
+
+    return MOD_SUCCESS_VAL(m);
+}
+
+static PyObject*
+Fingerprinter_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    fingerprint_Fingerprinter *self;
+
+    self = (fingerprint_Fingerprinter *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+Fingerprinter_init(fingerprint_Fingerprinter *self,
+                   PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"sample_rate",
+                             "channels",
+                             NULL};
+    int sample_rate;
+    int channels;
+    unsigned bits;
+    unsigned i;
+    PyObject *pcm;
+
+    self->channels = 0;
+    self->window = NULL;
+    self->cos_table = NULL;
+    self->sin_table = NULL;
+    self->reversed = NULL;
+    self->frame = NULL;
+    self->real = NULL;
+    self->imaginary = NULL;
+    init_energies(&self->energies);
+    self->framelist_type = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii", kwlist,
+                                     &sample_rate,
+                                     &channels))
+        return -1;
+
+    if (sample_rate < 8000) {
+        PyErr_SetString(PyExc_ValueError, "unsupported sample rate");
+        return -1;
+    }
+    if (channels <= 0) {
+        PyErr_SetString(PyExc_ValueError, "channels must be > 0");
+        return -1;
+    }
+
+    self->sample_rate = (unsigned)sample_rate;
+    self->channels = (unsigned)channels;
+
+    /*the longest power of 2 frame within MAX_FRAME_DURATION*/
+    for (bits = 1;
+         (1u << (bits + 1)) <= (unsigned)(sample_rate * MAX_FRAME_DURATION);
+         bits++)
+        /*do nothing*/;
+    self->frame_length = 1u << bits;
+
+    /*bands are spaced logarithmically in Hz
+      so that they cover the same spectrum at any sample rate*/
+    for (i = 0; i <= BANDS; i++) {
+        const double frequency =
+            LOW_FREQUENCY * pow(HIGH_FREQUENCY / LOW_FREQUENCY,
+                                (double)i / BANDS);
+        self->band_edges[i] = frequency * self->frame_length / sample_rate;
+    }
+
+    self->window = malloc(sizeof(double) * self->frame_length);
+    self->reversed = malloc(sizeof(unsigned) * self->frame_length);
+    for (i = 0; i < self->frame_length; i++) {
+        unsigned reversed = 0;
+        unsigned b;
+
+        self->window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / self->frame_length);
+        for (b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        self->reversed[i] = reversed;
+    }
+
+    self->cos_table = malloc(sizeof(double) * (self->frame_length / 2));
+    self->sin_table = malloc(sizeof(double) * (self->frame_length / 2));
+    for (i = 0; i < self->frame_length / 2; i++) {
+        self->cos_table[i] = cos(2 * M_PI * i / self->frame_length);
+        self->sin_table[i] = -sin(2 * M_PI * i / self->frame_length);
+    }
+
+    self->frame = malloc(sizeof(double) * self->frame_length);
+    self->frame_samples = 0;
+    self->real = malloc(sizeof(double) * self->frame_length);
+    self->imaginary = malloc(sizeof(double) * self->frame_length);
+
+    /*keep a copy of the FrameList class so we can check for it*/
+    if ((pcm = PyImport_ImportModule("audiotools.pcm")) == NULL)
+        return -1;
+    self->framelist_type = PyObject_GetAttrString(pcm, "FrameList");
+    Py_DECREF(pcm);
+    if (self->framelist_type == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+Fingerprinter_dealloc(fingerprint_Fingerprinter *self)
+{
+    free(self->window);
+    free(self->cos_table);
+    free(self->sin_table);
+    free(self->reversed);
+    free(self->frame);
+    free(self->real);
+    free(self->imaginary);
+    free_energies(&self->energies);
+
+    Py_XDECREF(self->framelist_type);
+
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+Fingerprinter_sample_rate(fingerprint_Fingerprinter *self, void *closure)
+{
+    return Py_BuildValue("I", self->sample_rate);
+}
+
+static PyObject*
+Fingerprinter_channels(fingerprint_Fingerprinter *self, void *closure)
+{
+    return Py_BuildValue("I", self->channels);
+}
+
+static PyObject*
+Fingerprinter_update(fingerprint_Fingerprinter *self, PyObject *args)
+{
+    pcm_FrameList *framelist;
+    const int *samples;
+    unsigned remaining;
+    double scale;
+
+    if (!PyArg_ParseTuple(args, "O!", self->framelist_type, &framelist))
+        return NULL;
+
+    if (framelist->channels != self->channels) {
+        PyErr_SetString(PyExc_ValueError,
+                        "FrameList channel count mismatch");
+        return NULL;
+    }
+    if ((framelist->bits_per_sample < 1) ||
+        (framelist->bits_per_sample > 32)) {
+        PyErr_SetString(PyExc_ValueError, "unsupported bits per sample");
+        return NULL;
+    }
+
+    FrameList_interleave(framelist);
+    samples = framelist->samples;
+    remaining = framelist->frames;
+    scale = 1.0 / ((int64_t)1 << (framelist->bits_per_sample - 1)) /
+            self->channels;
+
+    Py_BEGIN_ALLOW_THREADS
+    while (remaining) {
+        const unsigned to_process =
+            MIN(remaining, self->frame_length - self->frame_samples);
+        double *frame = self->frame + self->frame_samples;
+        unsigned i;
+
+        /*downmix the PCM frames to mono*/
+        if (self->channels == 1) {
+            for (i = 0; i < to_process; i++) {
+                frame[i] = samples[i] * scale;
+            }
+        } else {
+            for (i = 0; i < to_process; i++) {
+                const int *pcm_frame = samples + (i * self->channels);
+                int64_t sum = 0;
+                unsigned c;
+                for (c = 0; c < self->channels; c++) {
+                    sum += pcm_frame[c];
+                }
+                frame[i] = sum * scale;
+            }
+        }
+
+        self->frame_samples += to_process;
+        if (self->frame_samples == self->frame_length) {
+            analyze_frame(self);
+            self->frame_samples = 0;
+        }
+
+        remaining -= to_process;
+        samples += to_process * self->channels;
+    }
+    Py_END_ALLOW_THREADS
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+Fingerprinter_fingerprint(fingerprint_Fingerprinter *self, PyObject *args)
+{
+    const unsigned frames = self->energies.len;
+    double segments[SEGMENTS][BANDS];
+    uint8_t fingerprint[FINGERPRINT_BYTES];
+    unsigned s;
+    unsigned b;
+    unsigned bit = 0;
+
+    /*sum frame energies into segments of equal length,
+      leaving any incomplete final frame out*/
+    for (s = 0; s < SEGMENTS; s++) {
+        const unsigned first = (unsigned)(((uint64_t)frames * s) / SEGMENTS);
+        const unsigned last =
+            (unsigned)(((uint64_t)frames * (s + 1)) / SEGMENTS);
+        unsigned f;
+
+        for (b = 0; b < BANDS; b++) {
+            segments[s][b] = 0.0;
+        }
+        for (f = first; f < last; f++) {
+            const double *energies = self->energies.values + (f * BANDS);
+            for (b = 0; b < BANDS; b++) {
+                segments[s][b] += energies[b];
+            }
+        }
+    }
+
+    memset(fingerprint, 0, FINGERPRINT_BYTES);
+    for (s = 1; s < SEGMENTS; s++) {
+        for (b = 0; b < (BANDS - 1); b++) {
+            const double difference =
+                (segments[s][b] - segments[s][b + 1]) -
+                (segments[s - 1][b] - segments[s - 1][b + 1]);
+            if (difference > 0.0) {
+                fingerprint[bit / 8] |= 0x80 >> (bit % 8);
+            }
+            bit++;
+        }
+    }
+
+    return PyBytes_FromStringAndSize((char *)fingerprint, FINGERPRINT_BYTES);
+}
+
+static void
+analyze_frame(fingerprint_Fingerprinter *self)
+{
+    double *real = self->real;
+    double *imaginary = self->imaginary;
+    double *energies = append_frame(&self->energies);
+    unsigned i;
+    unsigned b;
+
+    for (i = 0; i < self->frame_length; i++) {
+        const unsigned j = self->reversed[i];
+        real[j] = self->frame[i] * self->window[i];
+        imaginary[j] = 0.0;
+    }
+
+    transform(self, real, imaginary);
+
+    /*each FFT bin spans half a bin either side of its center
+      and contributes to a band in proportion to their overlap
+      so that band energies don't jump as bins shift
+      from one sample rate to another*/
+    for (b = 0; b < BANDS; b++) {
+        const double low = self->band_edges[b];
+        const double high = self->band_edges[b + 1];
+        const unsigned last = MIN((unsigned)(high + 0.5),
+                                  self->frame_length / 2);
+        double energy = 0.0;
+
+        for (i = (unsigned)(low + 0.5); i <= last; i++) {
+            const double overlap = MIN(i + 0.5, high) - MAX(i - 0.5, low);
+            if (overlap > 0.0) {
+                energy += overlap * (real[i] * real[i] +
+                                     imaginary[i] * imaginary[i]);
+            }
+        }
+        energies[b] = energy;
+    }
+}
+
+static void
+transform(const fingerprint_Fingerprinter *self,
+          double real[],
+          double imaginary[])
+{
+    const unsigned length = self->frame_length;
+    unsigned half;
+
+    for (half = 1; half < length; half *= 2) {
+        const unsigned stride = length / (half * 2);
+        unsigned start;
+
+        for (start = 0; start < length; start += half * 2) {
+            unsigned k;
+
+            for (k = 0; k < half; k++) {
+                const double w_real = self->cos_table[k * stride];
+                const double w_imaginary = self->sin_table[k * stride];
+                const unsigned even = start + k;
+                const unsigned odd = even + half;
+                const double t_real = (real[odd] * w_real -
+                                       imaginary[odd] * w_imaginary);
+                const double t_imaginary = (real[odd] * w_imaginary +
+                                            imaginary[odd] * w_real);
+
+                real[odd] = real[even] - t_real;
+                imaginary[odd] = imaginary[even] - t_imaginary;
+                real[even] += t_real;
+                imaginary[even] += t_imaginary;
+            }
+        }
+    }
+}
+
+static void
+init_energies(struct energies *energies)
+{
+    energies->values = NULL;
+    energies->len = 0;
+    energies->size = 0;
+}
+
+static void
+free_energies(struct energies *energies)
+{
+    free(energies->values);
+}
+
+static double*
+append_frame(struct energies *energies)
+{
+    if (energies->len == energies->size) {
+        energies->size = energies->size ? energies->size * 2 : 256;
+        energies->values = realloc(energies->values,
+                                   sizeof(double) * BANDS * energies->size);
+    }
+    return energies->values + (BANDS * energies->len++);
+}
@@ -0,0 +1,170 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*the spectrum between these frequencies is split into BANDS bands
+  spaced logarithmically, which lossy codecs leave largely intact*/
+#define BANDS 17
+#define LOW_FREQUENCY 300.0
+#define HIGH_FREQUENCY 3000.0
+
+/*the track is split into SEGMENTS segments of equal length
+  and each pair of neighboring segments contributes
+  one bit per pair of neighboring bands*/
+#define SEGMENTS 17
+
+#define FINGERPRINT_BITS ((SEGMENTS - 1) * (BANDS - 1))
+#define FINGERPRINT_BYTES (FINGERPRINT_BITS / 8)
+
+/*a growable list of per-frame band energies, BANDS values per frame*/
+struct energies {
+    double *values;
+    unsigned len;   /*in frames*/
+    unsigned size;  /*in frames*/
+};
+
+typedef struct {
+    PyObject_HEAD
+
+    unsigned sample_rate;
+    unsigned channels;
+
+    unsigned frame_length;      /*samples per FFT frame, a power of 2*/
+    double band_edges[BANDS + 1]; /*the lower edge of each band
+                                    followed by the upper edge of the last,
+                                    in FFT bins*/
+
+    double *window;             /*the Hann window, frame_length values*/
+    double *cos_table;          /*frame_length / 2 twiddle factors*/
+    double *sin_table;
+    unsigned *reversed;         /*the bit-reversed index of each sample*/
+
+    double *frame;              /*the current frame's mono samples*/
+    unsigned frame_samples;     /*samples in the current frame so far*/
+
+    double *real;               /*the frame's transform*/
+    double *imaginary;
+
+    struct energies energies;
+
+    PyObject *framelist_type;
+} fingerprint_Fingerprinter;
+
+static PyObject*
+Fingerprinter_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+
+int
+Fingerprinter_init(fingerprint_Fingerprinter *self,
+                   PyObject *args, PyObject *kwds);
+
+void
+Fingerprinter_dealloc(fingerprint_Fingerprinter *self);
+
+static PyObject*
+Fingerprinter_sample_rate(fingerprint_Fingerprinter *self, void *closure);
+
+static PyObject*
+Fingerprinter_channels(fingerprint_Fingerprinter *self, void *closure);
+
+static PyObject*
+Fingerprinter_update(fingerprint_Fingerprinter *self, PyObject *args);
+
+static PyObject*
+Fingerprinter_fingerprint(fingerprint_Fingerprinter *self, PyObject *args);
+
+/*transforms the current frame and appends its band energies*/
+static void
+analyze_frame(fingerprint_Fingerprinter *self);
+
+/*an in-place radix-2 FFT of the frame_length values
+  in "real" and "imaginary", which must be in bit-reversed order*/
+static void
+transform(const fingerprint_Fingerprinter *self,
+          double real[],
+          double imaginary[]);
+
+static void
+init_energies(struct energies *energies);
+
+static void
+free_energies(struct energies *energies);
+
+/*returns space for the next frame's BANDS energies*/
+static double*
+append_frame(struct energies *energies);
+
+static PyGetSetDef Fingerprinter_getseters[] = {
+    {"sample_rate",
+     (getter)Fingerprinter_sample_rate, NULL, "sample rate", NULL},
+    {"channels",
+     (getter)Fingerprinter_channels, NULL, "channels", NULL},
+    {NULL}
+};
+
+static PyMethodDef Fingerprinter_methods[] = {
+    {"update", (PyCFunction)Fingerprinter_update,
+     METH_VARARGS, "update(framelist) -> None"},
+    {"fingerprint", (PyCFunction)Fingerprinter_fingerprint,
+     METH_NOARGS, "fingerprint() -> spectral fingerprint as bytes"},
+    {NULL}
+};
+
+static PyTypeObject fingerprint_FingerprinterType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "_fingerprint.Fingerprinter", /*tp_name*/
+    sizeof(fingerprint_Fingerprinter), /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)Fingerprinter_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    "Fingerprinter objects",   /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Fingerprinter_methods,     /* tp_methods */
+    0,                         /* tp_members */
+    Fingerprinter_getseters,   /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Fingerprinter_init, /* tp_init */
+    0,                         /* tp_alloc */
+    Fingerprinter_new,         /* tp_new */
+};
@@ -1,4 +1,6 @@
 #include "framelist.h"
+#include <stdlib.h>
+#include <string.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -56,6 +58,73 @@ empty_FrameList(PyObject* audiotools_pcm,
         audiotools_pcm,
         "empty_framelist", "ii", channels, bits_per_sample);
 }
+
+void
+shrink_FrameList(pcm_FrameList *framelist, unsigned pcm_frames)
+{
+    if (framelist->planar) {
+        unsigned c;
+        /*channel 0 is already where it belongs*/
+        for (c = 1; c < framelist->channels; c++) {
+            memmove(framelist->samples + (c * pcm_frames),
+                    FrameList_planar_channel(framelist, c),
+                    pcm_frames * sizeof(int));
+        }
+    }
+    framelist->frames = pcm_frames;
+}
+
+void
+frame_buffer_init(struct frame_buffer *buffer)
+{
+    buffer->samples = NULL;
+    buffer->size = 0;
+    buffer->channels = 0;
+    buffer->frames = 0;
+    buffer->offset = 0;
+}
+
+void
+frame_buffer_free(struct frame_buffer *buffer)
+{
+    free(buffer->samples);
+    frame_buffer_init(buffer);
+}
+
+int*
+frame_buffer_fill(struct frame_buffer *buffer,
+                  unsigned channels,
+                  unsigned pcm_frames)
+{
+    if ((channels * pcm_frames) > buffer->size) {
+        buffer->size = channels * pcm_frames;
+        buffer->samples = realloc(buffer->samples,
+                                  buffer->size * sizeof(int));
+    }
+    buffer->channels = channels;
+    buffer->frames = pcm_frames;
+    buffer->offset = 0;
+    return buffer->samples;
+}
+
+unsigned
+frame_buffer_move(struct frame_buffer *buffer,
+                  pcm_FrameList *framelist,
+                  unsigned position)
+{
+    const unsigned available = frame_buffer_remaining(buffer);
+    const unsigned to_move = ((framelist->frames - position) < available ?
+                              (framelist->frames - position) : available);
+    unsigned c;
+
+    for (c = 0; c < buffer->channels; c++) {
+        memcpy(FrameList_planar_channel(framelist, c) + position,
+               buffer->samples + (c * buffer->frames) + buffer->offset,
+               to_move * sizeof(int));
+    }
+    buffer->offset += to_move;
+    return to_move;
+}
 #endif
 
 void
@@ -73,6 +142,22 @@ put_channel_data(int *pcm_data,
     }
 }
 
+void
+interleave_channel_data(int *pcm_data,
+                        unsigned channel_count,
+                        unsigned pcm_frames,
+                        const int *planar_data)
+{
+    unsigned c;
+    for (c = 0; c < channel_count; c++) {
+        put_channel_data(pcm_data,
+                         c,
+                         channel_count,
+                         pcm_frames,
+                         planar_data + (c * pcm_frames));
+    }
+}
+
 void
 swap_channel_data(int *pcm_data,
                   unsigned channel_a,
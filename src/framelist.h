@@ -1,3 +1,6 @@
+#ifndef FRAMELIST_H
+#define FRAMELIST_H
+
 #ifndef STANDALONE
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
@@ -56,6 +59,62 @@ empty_FrameList(PyObject* audiotools_pcm,
                 unsigned channels,
                 unsigned bits_per_sample);
 
+/*shrinks a FrameList populated by a decoder to the given number
+  of PCM frames, which must be no more than it already has,
+  keeping planar FrameLists' channels contiguous*/
+void
+shrink_FrameList(pcm_FrameList *framelist, unsigned pcm_frames);
+
+/*a decoded frame's samples, stored channel-major,
+  which are handed out over as many reads as it takes
+
+  this lets decoders fill each FrameList with as many
+  PCM frames as were requested rather than one frame's worth,
+  keeping any remainder of the last frame for the next read*/
+struct frame_buffer {
+    int *samples;
+    unsigned size;       /*allocated size of samples, in samples*/
+    unsigned channels;
+    unsigned frames;     /*PCM frames in the buffered frame*/
+    unsigned offset;     /*PCM frames already handed out*/
+};
+
+void
+frame_buffer_init(struct frame_buffer *buffer);
+
+void
+frame_buffer_free(struct frame_buffer *buffer);
+
+/*returns a buffer for the decoder to populate with the given
+  number of PCM frames, each channel "pcm_frames" long,
+  discarding anything not yet handed out*/
+int*
+frame_buffer_fill(struct frame_buffer *buffer,
+                  unsigned channels,
+                  unsigned pcm_frames);
+
+/*discards anything not yet handed out, such as after seeking*/
+static inline void
+frame_buffer_clear(struct frame_buffer *buffer)
+{
+    buffer->frames = buffer->offset = 0;
+}
+
+/*returns the number of PCM frames not yet handed out*/
+static inline unsigned
+frame_buffer_remaining(const struct frame_buffer *buffer)
+{
+    return buffer->frames - buffer->offset;
+}
+
+/*hands out as many buffered PCM frames as fit in a planar FrameList
+  with the same number of channels, starting at PCM frame "position"
+  and returns the amount handed out*/
+unsigned
+frame_buffer_move(struct frame_buffer *buffer,
+                  pcm_FrameList *framelist,
+                  unsigned position);
+
 #endif
 
 /*pcm_data must contain at least:  channel_count * pcm_frames  entries
@@ -70,6 +129,18 @@ put_channel_data(int *pcm_data,
                  unsigned pcm_frames,
                  const int *channel_data);
 
+/*planar_data must contain at least:  channel_count * pcm_frames  entries
+  stored channel-major, each channel  pcm_frames  entries long
+
+  pcm_data must contain at least:  channel_count * pcm_frames  entries
+
+  interleaves every channel of planar_data into pcm_data*/
+void
+interleave_channel_data(int *pcm_data,
+                        unsigned channel_count,
+                        unsigned pcm_frames,
+                        const int *planar_data);
+
 static inline void
 put_sample(int *pcm_data,
            unsigned channel_number,
@@ -88,3 +159,5 @@ swap_channel_data(int *pcm_data,
                   unsigned channel_b,
                   unsigned channel_count,
                   unsigned pcm_frames);
+
+#endif
@@ -0,0 +1,775 @@
+#include "loudness.h"
+#include "pcm.h"
+#include "mod_defs.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/**********************************************************************
+  Loudness measurement as described in ITU-R BS.1770-4
+  and EBU Tech 3341 (momentary, short-term and integrated loudness)
+  and EBU Tech 3342 (loudness range)
+
+  K-weighting filter coefficients are calculated for the stream's
+  sample rate from the analog prototype parameters, as in libebur128
+ **********************************************************************/
+
+#ifndef MIN
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#endif
+#ifndef MAX
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+#endif
+
+/*PCM frames converted to floating point at a time*/
+#define CHUNK_SIZE 4096
+
+#define ABSOLUTE_GATE -70.0           /*LUFS*/
+#define INTEGRATED_RELATIVE_GATE -10.0 /*LU*/
+#define RANGE_RELATIVE_GATE -20.0      /*LU*/
+#define RANGE_LOW_PERCENTILE 0.10
+#define RANGE_HIGH_PERCENTILE 0.95
+
+static PyMethodDef loudness_methods[] = {
+    {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+MOD_INIT(loudness)
+{
+    PyObject* m;
+
+    MOD_DEF(m, "loudness",
+            "an EBU R128 loudness calculation module",
+            loudness_methods)
+
+    loudness_LoudnessType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&loudness_LoudnessType) < 0)
+        return MOD_ERROR_VAL;
+
+    Py_INCREF(&loudness_LoudnessType);
+    PyModule_AddObject(m, "Loudness",
+                       (PyObject *)&loudness_LoudnessType);
+
+    return MOD_SUCCESS_VAL(m);
+}
+
+static PyObject*
+Loudness_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    loudness_Loudness *self;
+
+    self = (loudness_Loudness *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+Loudness_init(loudness_Loudness *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"sample_rate",
+                             "channels",
+                             "channel_mask",
+                             NULL};
+    enum {
+        bL  = 0x10,
+        bR  = 0x20,
+        LFE = 0x8,
+        sL  = 0x200,
+        sR  = 0x400
+    };
+    int sample_rate;
+    int channels;
+    int channel_mask = 0;
+    PyObject *pcm;
+    double K;
+    double Vh;
+    double Vb;
+    double a0;
+    const double pre_f0 = 1681.974450955533;
+    const double pre_G = 3.999843853973347;
+    const double pre_Q = 0.7071752369554196;
+    const double rlb_f0 = 38.13547087602444;
+    const double rlb_Q = 0.5003270373238773;
+
+    self->channels = 0;
+    self->weights = NULL;
+    self->pre_filter.z1 = self->pre_filter.z2 = NULL;
+    self->rlb_filter.z1 = self->rlb_filter.z2 = NULL;
+    self->step_sums = NULL;
+    self->true_peak.history = NULL;
+    self->converted = NULL;
+    init_energies(&self->title_blocks);
+    init_energies(&self->title_short_terms);
+    init_energies(&self->album_blocks);
+    init_energies(&self->album_short_terms);
+    self->framelist_type = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii|i", kwlist,
+                                     &sample_rate,
+                                     &channels,
+                                     &channel_mask))
+        return -1;
+
+    if (sample_rate < 8000) {
+        PyErr_SetString(PyExc_ValueError, "unsupported sample rate");
+        return -1;
+    }
+    if (channels <= 0) {
+        PyErr_SetString(PyExc_ValueError, "channels must be > 0");
+        return -1;
+    }
+    if (channel_mask < 0) {
+        PyErr_SetString(PyExc_ValueError, "channel mask must be >= 0");
+        return -1;
+    }
+
+    self->sample_rate = (unsigned)sample_rate;
+    self->channels = (unsigned)channels;
+
+    /*channels are weighted by their position in the channel mask,
+      in which LFE is ignored and surrounds are boosted by ~1.5dB
+
+      if the mask doesn't define every channel,
+      all channels are weighted equally*/
+    self->weights = malloc(sizeof(double) * channels);
+    if (channel_mask) {
+        unsigned c = 0;
+        unsigned mask;
+
+        for (mask = 1;
+             (mask <= (unsigned)channel_mask) && (c < self->channels);
+             mask <<= 1) {
+            if (channel_mask & mask) {
+                switch (mask) {
+                case LFE:
+                    self->weights[c++] = 0.0;
+                    break;
+                case bL:
+                case bR:
+                case sL:
+                case sR:
+                    self->weights[c++] = 1.41;
+                    break;
+                default:
+                    self->weights[c++] = 1.0;
+                    break;
+                }
+            }
+        }
+        for (; c < self->channels; c++) {
+            self->weights[c] = 1.0;
+        }
+    } else {
+        unsigned c;
+        for (c = 0; c < self->channels; c++) {
+            self->weights[c] = 1.0;
+        }
+    }
+
+    /*the K-weighting pre-filter, a high shelf modelling the head*/
+    K = tan(M_PI * pre_f0 / sample_rate);
+    Vh = pow(10.0, pre_G / 20.0);
+    Vb = pow(Vh, 0.4996667741545416);
+    a0 = 1.0 + K / pre_Q + K * K;
+    init_biquad(&self->pre_filter,
+                self->channels,
+                (Vh + Vb * K / pre_Q + K * K) / a0,
+                2.0 * (K * K - Vh) / a0,
+                (Vh - Vb * K / pre_Q + K * K) / a0,
+                2.0 * (K * K - 1.0) / a0,
+                (1.0 - K / pre_Q + K * K) / a0);
+
+    /*the K-weighting RLB filter, a high pass*/
+    K = tan(M_PI * rlb_f0 / sample_rate);
+    a0 = 1.0 + K / rlb_Q + K * K;
+    init_biquad(&self->rlb_filter,
+                self->channels,
+                1.0,
+                -2.0,
+                1.0,
+                2.0 * (K * K - 1.0) / a0,
+                (1.0 - K / rlb_Q + K * K) / a0);
+
+    self->step_sums = malloc(sizeof(double) * channels);
+    self->step_length = (self->sample_rate + (STEPS_PER_SECOND / 2)) /
+                        STEPS_PER_SECOND;
+
+    init_true_peak(&self->true_peak, self->sample_rate, self->channels);
+
+    self->converted = malloc(sizeof(double) * channels * CHUNK_SIZE);
+
+    reset_title(self);
+    self->album_peak = 0.0;
+
+    /*keep a copy of the FrameList class so we can check for it*/
+    if ((pcm = PyImport_ImportModule("audiotools.pcm")) == NULL)
+        return -1;
+    self->framelist_type = PyObject_GetAttrString(pcm, "FrameList");
+    Py_DECREF(pcm);
+    if (self->framelist_type == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+Loudness_dealloc(loudness_Loudness *self)
+{
+    free(self->weights);
+    free_biquad(&self->pre_filter);
+    free_biquad(&self->rlb_filter);
+    free(self->step_sums);
+    free(self->true_peak.history);
+    free(self->converted);
+    free_energies(&self->title_blocks);
+    free_energies(&self->title_short_terms);
+    free_energies(&self->album_blocks);
+    free_energies(&self->album_short_terms);
+
+    Py_XDECREF(self->framelist_type);
+
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+Loudness_sample_rate(loudness_Loudness *self, void *closure)
+{
+    return Py_BuildValue("I", self->sample_rate);
+}
+
+static PyObject*
+Loudness_channels(loudness_Loudness *self, void *closure)
+{
+    return Py_BuildValue("I", self->channels);
+}
+
+static PyObject*
+Loudness_update(loudness_Loudness *self, PyObject *args)
+{
+    pcm_FrameList *framelist;
+    const int *samples;
+    unsigned remaining;
+    double scale;
+
+    if (!PyArg_ParseTuple(args, "O!", self->framelist_type, &framelist))
+        return NULL;
+
+    if (framelist->channels != self->channels) {
+        PyErr_SetString(PyExc_ValueError,
+                        "FrameList channel count mismatch");
+        return NULL;
+    }
+    if ((framelist->bits_per_sample < 1) ||
+        (framelist->bits_per_sample > 32)) {
+        PyErr_SetString(PyExc_ValueError, "unsupported bits per sample");
+        return NULL;
+    }
+
+    FrameList_interleave(framelist);
+    samples = framelist->samples;
+    remaining = framelist->frames;
+    scale = 1.0 / ((int64_t)1 << (framelist->bits_per_sample - 1));
+
+    Py_BEGIN_ALLOW_THREADS
+    while (remaining) {
+        const unsigned to_process = MIN(remaining, CHUNK_SIZE);
+        const unsigned total_samples = to_process * self->channels;
+        double *converted = self->converted;
+        double peak;
+        unsigned i;
+
+        for (i = 0; i < total_samples; i++) {
+            converted[i] = samples[i] * scale;
+        }
+
+        peak = update_true_peak(&self->true_peak,
+                                self->channels,
+                                converted,
+                                to_process);
+        self->title_peak = MAX(self->title_peak, peak);
+        self->album_peak = MAX(self->album_peak, peak);
+
+        process_samples(self, converted, to_process);
+
+        remaining -= to_process;
+        samples += total_samples;
+    }
+    Py_END_ALLOW_THREADS
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject*
+Loudness_momentary(loudness_Loudness *self, PyObject *args)
+{
+    if (self->steps_seen >= MOMENTARY_STEPS) {
+        return Py_BuildValue(
+            "d", energy_to_loudness(recent_energy(self, MOMENTARY_STEPS)));
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "Not enough samples to perform calculation");
+        return NULL;
+    }
+}
+
+static PyObject*
+Loudness_short_term(loudness_Loudness *self, PyObject *args)
+{
+    if (self->steps_seen >= SHORT_TERM_STEPS) {
+        return Py_BuildValue(
+            "d", energy_to_loudness(recent_energy(self, SHORT_TERM_STEPS)));
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "Not enough samples to perform calculation");
+        return NULL;
+    }
+}
+
+static PyObject*
+Loudness_title_loudness(loudness_Loudness *self, PyObject *args)
+{
+    if (self->title_blocks.len) {
+        return Py_BuildValue("d", integrated_loudness(&self->title_blocks));
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "Not enough samples to perform calculation");
+        return NULL;
+    }
+}
+
+static PyObject*
+Loudness_title_range(loudness_Loudness *self, PyObject *args)
+{
+    return Py_BuildValue("d", loudness_range(&self->title_short_terms));
+}
+
+static PyObject*
+Loudness_title_peak(loudness_Loudness *self, PyObject *args)
+{
+    return Py_BuildValue("d", self->title_peak);
+}
+
+static PyObject*
+Loudness_album_loudness(loudness_Loudness *self, PyObject *args)
+{
+    if (self->album_blocks.len) {
+        return Py_BuildValue("d", integrated_loudness(&self->album_blocks));
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "Not enough samples to perform calculation");
+        return NULL;
+    }
+}
+
+static PyObject*
+Loudness_album_range(loudness_Loudness *self, PyObject *args)
+{
+    return Py_BuildValue("d", loudness_range(&self->album_short_terms));
+}
+
+static PyObject*
+Loudness_album_peak(loudness_Loudness *self, PyObject *args)
+{
+    return Py_BuildValue("d", self->album_peak);
+}
+
+static PyObject*
+Loudness_next_title(loudness_Loudness *self, PyObject *args)
+{
+    reset_title(self);
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static void
+init_biquad(struct biquad *biquad,
+            unsigned channels,
+            double b0, double b1, double b2,
+            double a1, double a2)
+{
+    biquad->b0 = b0;
+    biquad->b1 = b1;
+    biquad->b2 = b2;
+    biquad->a1 = a1;
+    biquad->a2 = a2;
+    biquad->z1 = malloc(sizeof(double) * channels);
+    biquad->z2 = malloc(sizeof(double) * channels);
+    reset_biquad(biquad, channels);
+}
+
+static void
+free_biquad(struct biquad *biquad)
+{
+    free(biquad->z1);
+    free(biquad->z2);
+}
+
+static void
+reset_biquad(struct biquad *biquad, unsigned channels)
+{
+    unsigned c;
+    for (c = 0; c < channels; c++) {
+        biquad->z1[c] = biquad->z2[c] = 0.0;
+    }
+}
+
+static void
+init_true_peak(struct true_peak *true_peak,
+               unsigned sample_rate,
+               unsigned channels)
+{
+    /*BS.1770 only requires oversampling to 192kHz or so*/
+    if (sample_rate < 96000) {
+        true_peak->oversampling = 4;
+    } else if (sample_rate < 192000) {
+        true_peak->oversampling = 2;
+    } else {
+        true_peak->oversampling = 1;
+    }
+
+    /*a Hann-windowed sinc low pass at the original Nyquist frequency
+      split into one polyphase filter per interpolated sample
+
+      coefficients are stored oldest sample first
+      to match the order of the history buffer*/
+    if (true_peak->oversampling > 1) {
+        const unsigned factor = true_peak->oversampling;
+        const unsigned length = TRUE_PEAK_TAPS * factor;
+        unsigned n;
+
+        for (n = 0; n < length; n++) {
+            const double m = (n - (length - 1) / 2.0) / factor;
+            const double sinc = (m == 0.0) ? 1.0 : sin(M_PI * m) / (M_PI * m);
+            const double window =
+                0.5 - 0.5 * cos(2.0 * M_PI * (n + 1) / (length + 1));
+
+            true_peak->coefficients[n % factor]
+                [TRUE_PEAK_TAPS - 1 - (n / factor)] = sinc * window;
+        }
+    }
+
+    true_peak->history = malloc(sizeof(double) *
+                                channels * TRUE_PEAK_TAPS * 2);
+    reset_true_peak(true_peak, channels);
+}
+
+static void
+reset_true_peak(struct true_peak *true_peak, unsigned channels)
+{
+    unsigned i;
+    for (i = 0; i < channels * TRUE_PEAK_TAPS * 2; i++) {
+        true_peak->history[i] = 0.0;
+    }
+    true_peak->position = 0;
+}
+
+static void
+reset_title(loudness_Loudness *self)
+{
+    unsigned c;
+
+    reset_biquad(&self->pre_filter, self->channels);
+    reset_biquad(&self->rlb_filter, self->channels);
+    for (c = 0; c < self->channels; c++) {
+        self->step_sums[c] = 0.0;
+    }
+    self->step_frames = 0;
+    self->steps_seen = 0;
+    self->title_blocks.len = 0;
+    self->title_short_terms.len = 0;
+    reset_true_peak(&self->true_peak, self->channels);
+    self->title_peak = 0.0;
+}
+
+static void
+process_samples(loudness_Loudness *self,
+                const double samples[],
+                unsigned pcm_frames)
+{
+    const unsigned channels = self->channels;
+    const struct biquad *pre = &self->pre_filter;
+    const struct biquad *rlb = &self->rlb_filter;
+    double *restrict pre_z1 = pre->z1;
+    double *restrict pre_z2 = pre->z2;
+    double *restrict rlb_z1 = rlb->z1;
+    double *restrict rlb_z2 = rlb->z2;
+    double *restrict sums = self->step_sums;
+
+    while (pcm_frames) {
+        const unsigned to_process =
+            MIN(pcm_frames, self->step_length - self->step_frames);
+        unsigned i;
+
+        for (i = 0; i < to_process; i++) {
+            const double *frame = samples + (i * channels);
+            unsigned c;
+
+            /*both filter stages run in transposed direct form II
+              with the channels in the inner loop
+              so that they're filtered side-by-side*/
+            for (c = 0; c < channels; c++) {
+                const double x = frame[c];
+                const double y = pre->b0 * x + pre_z1[c];
+                double z;
+
+                pre_z1[c] = pre->b1 * x - pre->a1 * y + pre_z2[c];
+                pre_z2[c] = pre->b2 * x - pre->a2 * y;
+
+                z = rlb->b0 * y + rlb_z1[c];
+                rlb_z1[c] = rlb->b1 * y - rlb->a1 * z + rlb_z2[c];
+                rlb_z2[c] = rlb->b2 * y - rlb->a2 * z;
+
+                sums[c] += z * z;
+            }
+        }
+
+        samples += to_process * channels;
+        pcm_frames -= to_process;
+        self->step_frames += to_process;
+        if (self->step_frames == self->step_length) {
+            finish_step(self);
+        }
+    }
+}
+
+static double
+update_true_peak(struct true_peak *true_peak,
+                 unsigned channels,
+                 const double samples[],
+                 unsigned pcm_frames)
+{
+    const unsigned factor = true_peak->oversampling;
+    double peak = 0.0;
+    unsigned i;
+
+    if (factor == 1) {
+        for (i = 0; i < pcm_frames * channels; i++) {
+            peak = MAX(peak, fabs(samples[i]));
+        }
+        return peak;
+    }
+
+    for (i = 0; i < pcm_frames; i++) {
+        const unsigned position =
+            (true_peak->position + 1) % TRUE_PEAK_TAPS;
+        unsigned c;
+
+        true_peak->position = position;
+
+        for (c = 0; c < channels; c++) {
+            double *history =
+                true_peak->history + (c * TRUE_PEAK_TAPS * 2);
+            const double *window = history + position + 1;
+            const double x = samples[i * channels + c];
+            unsigned p;
+
+            history[position] = history[position + TRUE_PEAK_TAPS] = x;
+
+            peak = MAX(peak, fabs(x));
+
+            for (p = 0; p < factor; p++) {
+                const double *coefficients = true_peak->coefficients[p];
+                double sum = 0.0;
+                unsigned k;
+
+                for (k = 0; k < TRUE_PEAK_TAPS; k++) {
+                    sum += coefficients[k] * window[k];
+                }
+
+                peak = MAX(peak, fabs(sum));
+            }
+        }
+    }
+
+    return peak;
+}
+
+static void
+finish_step(loudness_Loudness *self)
+{
+    double energy = 0.0;
+    unsigned c;
+
+    for (c = 0; c < self->channels; c++) {
+        energy += self->weights[c] * self->step_sums[c];
+        self->step_sums[c] = 0.0;
+    }
+
+    self->steps[self->steps_seen % SHORT_TERM_STEPS] = energy;
+    self->steps_seen += 1;
+    self->step_frames = 0;
+
+    if (self->steps_seen >= MOMENTARY_STEPS) {
+        const double block = recent_energy(self, MOMENTARY_STEPS);
+        append_energy(&self->title_blocks, block);
+        append_energy(&self->album_blocks, block);
+    }
+    if (self->steps_seen >= SHORT_TERM_STEPS) {
+        const double block = recent_energy(self, SHORT_TERM_STEPS);
+        append_energy(&self->title_short_terms, block);
+        append_energy(&self->album_short_terms, block);
+    }
+}
+
+static double
+recent_energy(const loudness_Loudness *self, unsigned count)
+{
+    double sum = 0.0;
+    unsigned i;
+
+    for (i = 1; i <= count; i++) {
+        sum += self->steps[(self->steps_seen - i) % SHORT_TERM_STEPS];
+    }
+
+    return sum / ((double)count * self->step_length);
+}
+
+static void
+init_energies(struct energies *energies)
+{
+    energies->values = NULL;
+    energies->len = 0;
+    energies->size = 0;
+}
+
+static void
+free_energies(struct energies *energies)
+{
+    free(energies->values);
+}
+
+static void
+append_energy(struct energies *energies, double energy)
+{
+    if (energies->len == energies->size) {
+        energies->size = energies->size ? energies->size * 2 : 256;
+        energies->values = realloc(energies->values,
+                                   sizeof(double) * energies->size);
+    }
+    energies->values[energies->len++] = energy;
+}
+
+static double
+energy_to_loudness(double energy)
+{
+    if (energy > 0.0) {
+        return -0.691 + 10.0 * log10(energy);
+    } else {
+        return -HUGE_VAL;
+    }
+}
+
+static double
+loudness_to_energy(double loudness)
+{
+    return pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+static double
+integrated_loudness(const struct energies *blocks)
+{
+    const double absolute_gate = loudness_to_energy(ABSOLUTE_GATE);
+    double relative_gate;
+    double sum = 0.0;
+    unsigned count = 0;
+    unsigned i;
+
+    for (i = 0; i < blocks->len; i++) {
+        if (blocks->values[i] > absolute_gate) {
+            sum += blocks->values[i];
+            count++;
+        }
+    }
+    if (!count) {
+        return -HUGE_VAL;
+    }
+
+    relative_gate = (sum / count) *
+                    pow(10.0, INTEGRATED_RELATIVE_GATE / 10.0);
+    sum = 0.0;
+    count = 0;
+    for (i = 0; i < blocks->len; i++) {
+        if ((blocks->values[i] > absolute_gate) &&
+            (blocks->values[i] > relative_gate)) {
+            sum += blocks->values[i];
+            count++;
+        }
+    }
+
+    return energy_to_loudness(sum / count);
+}
+
+static int
+cmp_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double
+loudness_range(const struct energies *short_terms)
+{
+    const double absolute_gate = loudness_to_energy(ABSOLUTE_GATE);
+    double relative_gate;
+    double sum = 0.0;
+    unsigned count = 0;
+    double *gated;
+    double range;
+    unsigned i;
+
+    for (i = 0; i < short_terms->len; i++) {
+        if (short_terms->values[i] > absolute_gate) {
+            sum += short_terms->values[i];
+            count++;
+        }
+    }
+    if (!count) {
+        return 0.0;
+    }
+
+    relative_gate = (sum / count) * pow(10.0, RANGE_RELATIVE_GATE / 10.0);
+
+    gated = malloc(sizeof(double) * count);
+    count = 0;
+    for (i = 0; i < short_terms->len; i++) {
+        if ((short_terms->values[i] > absolute_gate) &&
+            (short_terms->values[i] > relative_gate)) {
+            gated[count++] = short_terms->values[i];
+        }
+    }
+
+    /*energies sort the same as their loudnesses*/
+    qsort(gated, count, sizeof(double), cmp_doubles);
+
+    range = energy_to_loudness(
+                gated[(unsigned)((count - 1) * RANGE_HIGH_PERCENTILE + 0.5)]) -
+            energy_to_loudness(
+                gated[(unsigned)((count - 1) * RANGE_LOW_PERCENTILE + 0.5)]);
+
+    free(gated);
+
+    return range;
+}
@@ -0,0 +1,290 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+/*loudness is measured in 100ms steps
+  with 400ms momentary blocks made of 4 steps (75% overlap)
+  and 3s short-term blocks made of 30 steps*/
+#define STEPS_PER_SECOND 10
+#define MOMENTARY_STEPS 4
+#define SHORT_TERM_STEPS 30
+
+/*taps per phase of the true peak interpolation filter*/
+#define TRUE_PEAK_TAPS 12
+
+/*the highest true peak oversampling factor, used below 96kHz*/
+#define MAX_OVERSAMPLING 4
+
+/*a growable list of block energies*/
+struct energies {
+    double *values;
+    unsigned len;
+    unsigned size;
+};
+
+/*the state of one biquad filter stage for all channels
+  stored channel-contiguous so that each sample's update
+  runs across every channel at once*/
+struct biquad {
+    double b0, b1, b2;
+    double a1, a2;
+
+    double *z1;  /*one delay value per channel*/
+    double *z2;
+};
+
+struct true_peak {
+    unsigned oversampling;    /*1, 2 or 4*/
+
+    /*the interpolation filter's coefficients
+      as "oversampling" phases of TRUE_PEAK_TAPS taps each*/
+    double coefficients[MAX_OVERSAMPLING][TRUE_PEAK_TAPS];
+
+    /*the last TRUE_PEAK_TAPS samples of each channel, stored twice
+      so that the newest TRUE_PEAK_TAPS are always contiguous*/
+    double *history;
+    unsigned position;
+};
+
+typedef struct {
+    PyObject_HEAD
+
+    unsigned sample_rate;
+    unsigned channels;
+
+    double *weights;          /*the BS.1770 weight of each channel*/
+
+    struct biquad pre_filter; /*the K-weighting high shelf*/
+    struct biquad rlb_filter; /*the K-weighting high pass*/
+
+    double *step_sums;        /*the current step's sum of squares
+                                for each channel*/
+    unsigned step_length;     /*PCM frames per 100ms step*/
+    unsigned step_frames;     /*PCM frames in the current step so far*/
+
+    /*the weighted sum of squares of the most recent steps*/
+    double steps[SHORT_TERM_STEPS];
+    unsigned steps_seen;      /*total steps completed in this title*/
+
+    struct energies title_blocks;
+    struct energies title_short_terms;
+    struct energies album_blocks;
+    struct energies album_short_terms;
+
+    struct true_peak true_peak;
+    double title_peak;
+    double album_peak;
+
+    double *converted;        /*a chunk of samples converted to doubles*/
+
+    PyObject *framelist_type;
+} loudness_Loudness;
+
+static PyObject*
+Loudness_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+
+int
+Loudness_init(loudness_Loudness *self, PyObject *args, PyObject *kwds);
+
+void
+Loudness_dealloc(loudness_Loudness *self);
+
+static PyObject*
+Loudness_sample_rate(loudness_Loudness *self, void *closure);
+
+static PyObject*
+Loudness_channels(loudness_Loudness *self, void *closure);
+
+static PyObject*
+Loudness_update(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_momentary(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_short_term(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_title_loudness(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_title_range(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_title_peak(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_album_loudness(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_album_range(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_album_peak(loudness_Loudness *self, PyObject *args);
+
+static PyObject*
+Loudness_next_title(loudness_Loudness *self, PyObject *args);
+
+/*sets the biquad's coefficients and allocates its state*/
+static void
+init_biquad(struct biquad *biquad,
+            unsigned channels,
+            double b0, double b1, double b2,
+            double a1, double a2);
+
+static void
+free_biquad(struct biquad *biquad);
+
+static void
+reset_biquad(struct biquad *biquad, unsigned channels);
+
+static void
+init_true_peak(struct true_peak *true_peak,
+               unsigned sample_rate,
+               unsigned channels);
+
+static void
+reset_true_peak(struct true_peak *true_peak, unsigned channels);
+
+/*resets all the per-title state, leaving album values alone*/
+static void
+reset_title(loudness_Loudness *self);
+
+/*processes "pcm_frames" of interlaced samples between -1.0 and 1.0*/
+static void
+process_samples(loudness_Loudness *self,
+                const double samples[],
+                unsigned pcm_frames);
+
+/*returns the highest interpolated peak of "pcm_frames" samples
+  updating the filter's history*/
+static double
+update_true_peak(struct true_peak *true_peak,
+                 unsigned channels,
+                 const double samples[],
+                 unsigned pcm_frames);
+
+/*called when a 100ms step has completed*/
+static void
+finish_step(loudness_Loudness *self);
+
+/*returns the mean weighted energy of the most recent "count" steps*/
+static double
+recent_energy(const loudness_Loudness *self, unsigned count);
+
+static void
+init_energies(struct energies *energies);
+
+static void
+free_energies(struct energies *energies);
+
+static void
+append_energy(struct energies *energies, double energy);
+
+/*converts a mean energy to LUFS*/
+static double
+energy_to_loudness(double energy);
+
+/*converts LUFS to a mean energy*/
+static double
+loudness_to_energy(double loudness);
+
+/*returns the gated integrated loudness of a set of 400ms blocks*/
+static double
+integrated_loudness(const struct energies *blocks);
+
+/*returns the loudness range, in LU, of a set of 3s blocks*/
+static double
+loudness_range(const struct energies *short_terms);
+
+static PyGetSetDef Loudness_getseters[] = {
+    {"sample_rate",
+     (getter)Loudness_sample_rate, NULL, "sample rate", NULL},
+    {"channels",
+     (getter)Loudness_channels, NULL, "channels", NULL},
+    {NULL}
+};
+
+static PyMethodDef Loudness_methods[] = {
+    {"update", (PyCFunction)Loudness_update,
+     METH_VARARGS, "update(framelist) -> None"},
+    {"momentary", (PyCFunction)Loudness_momentary,
+     METH_NOARGS, "momentary() -> loudness of the last 400ms in LUFS"},
+    {"short_term", (PyCFunction)Loudness_short_term,
+     METH_NOARGS, "short_term() -> loudness of the last 3s in LUFS"},
+    {"title_loudness", (PyCFunction)Loudness_title_loudness,
+     METH_NOARGS, "title_loudness() -> integrated loudness in LUFS"},
+    {"title_range", (PyCFunction)Loudness_title_range,
+     METH_NOARGS, "title_range() -> loudness range in LU"},
+    {"title_peak", (PyCFunction)Loudness_title_peak,
+     METH_NOARGS, "title_peak() -> true peak float"},
+    {"album_loudness", (PyCFunction)Loudness_album_loudness,
+     METH_NOARGS, "album_loudness() -> integrated loudness in LUFS"},
+    {"album_range", (PyCFunction)Loudness_album_range,
+     METH_NOARGS, "album_range() -> loudness range in LU"},
+    {"album_peak", (PyCFunction)Loudness_album_peak,
+     METH_NOARGS, "album_peak() -> true peak float"},
+    {"next_title", (PyCFunction)Loudness_next_title,
+     METH_NOARGS, "call after each title is completed"},
+    {NULL}
+};
+
+static PyTypeObject loudness_LoudnessType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "loudness.Loudness",       /*tp_name*/
+    sizeof(loudness_Loudness), /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)Loudness_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    "Loudness objects",        /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    Loudness_methods,          /* tp_methods */
+    0,                         /* tp_members */
+    Loudness_getseters,        /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)Loudness_init,   /* tp_init */
+    0,                         /* tp_alloc */
+    Loudness_new,              /* tp_new */
+};
@@ -1122,21 +1122,12 @@ BitstreamReader_init(bitstream_BitstreamReader *self,
                                          little_endian ?
                                          BS_LITTLE_ENDIAN : BS_BIG_ENDIAN);
     } else {
-        /*store a reference to the Python object so that it doesn't decref
-          (and close) the file out from under us*/
-        Py_INCREF(file_obj);
-
-        self->bitstream = br_open_external(
+        /*the reader stores a reference to the Python object
+          so that it doesn't decref (and close) the file out from under us*/
+        self->bitstream = br_open_python(
             file_obj,
             little_endian ? BS_LITTLE_ENDIAN : BS_BIG_ENDIAN,
-            (unsigned)buffer_size,
-            br_read_python,
-            bs_setpos_python,
-            bs_getpos_python,
-            bs_free_pos_python,
-            bs_fseek_python,
-            bs_close_python,
-            bs_free_python_decref);
+            (unsigned)buffer_size);
     }
 
     return 0;
@@ -377,18 +377,8 @@ PageReader_init(ogg_PageReader *self, PyObject *args, PyObject *kwds)
     if (!PyArg_ParseTuple(args, "O", &reader_obj))
         return -1;
 
-    /*wrap Python object in func-based BitstreamReader*/
-    Py_INCREF(reader_obj);
-    self->reader = br_open_external(reader_obj,
-                                    BS_LITTLE_ENDIAN,
-                                    4096,
-                                    br_read_python,
-                                    bs_setpos_python,
-                                    bs_getpos_python,
-                                    bs_free_pos_python,
-                                    bs_fseek_python,
-                                    bs_close_python,
-                                    bs_free_python_decref);
+    /*wrap Python object in a BitstreamReader*/
+    self->reader = br_open_python(reader_obj, BS_LITTLE_ENDIAN, 4096);
 
     return 0;
 }
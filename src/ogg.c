@@ -213,12 +213,17 @@ oggiterator_open(FILE *stream)
 {
     OggPacketIterator *iterator = malloc(sizeof(OggPacketIterator));
     iterator->reader = br_open(stream, BS_LITTLE_ENDIAN);
+    oggiterator_reset(iterator);
+    return iterator;
+}
 
+void
+oggiterator_reset(OggPacketIterator *iterator)
+{
     /*force next read to read in a new page*/
     iterator->page.header.segment_count = 0;
     iterator->current_segment = 1;
     iterator->page.header.stream_end = 0;
-    return iterator;
 }
 
 void
@@ -291,6 +296,110 @@ oggiterator_next_packet(OggPacketIterator *iterator,
 }
 
 
+OggPacketWriter*
+oggwriter_open(FILE *stream, unsigned serial_number)
+{
+    OggPacketWriter *writer = malloc(sizeof(OggPacketWriter));
+    writer->writer = bw_open(stream, BS_LITTLE_ENDIAN);
+
+    writer->page.header.magic_number = 0x5367674F;
+    writer->page.header.version = 0;
+    writer->page.header.packet_continuation = 0;
+    writer->page.header.stream_beginning = 1;
+    writer->page.header.stream_end = 0;
+    writer->page.header.granule_position = -1;
+    writer->page.header.bitstream_serial_number = serial_number;
+    writer->page.header.sequence_number = 0;
+    writer->page.header.checksum = 0;
+    writer->page.header.segment_count = 0;
+    writer->page_size = 0;
+    writer->page_closed = 0;
+
+    return writer;
+}
+
+/*writes the writer's current page, if any,
+  and starts a fresh one following it*/
+static void
+oggwriter_next_page(OggPacketWriter *writer, int continuation)
+{
+    struct ogg_page_header *header = &(writer->page.header);
+
+    if (header->segment_count) {
+        write_ogg_page(writer->writer, &(writer->page));
+        header->stream_beginning = 0;
+        header->sequence_number += 1;
+    }
+    header->packet_continuation = continuation;
+    header->granule_position = -1;
+    header->segment_count = 0;
+    writer->page_size = 0;
+    writer->page_closed = 0;
+}
+
+void
+oggwriter_write_packet(OggPacketWriter *writer,
+                       const uint8_t *packet,
+                       unsigned packet_size,
+                       int64_t granule_position,
+                       int flush)
+{
+    struct ogg_page_header *header = &(writer->page.header);
+    unsigned remaining = packet_size;
+
+    /*a packet whose size is a multiple of 255
+      ends with a 0 length segment, hence the "do"*/
+    do {
+        const unsigned segment_size = remaining < 255 ? remaining : 255;
+
+        if (writer->page_closed || (header->segment_count == 0xFF)) {
+            oggwriter_next_page(writer, remaining < packet_size);
+        }
+
+        header->segment_lengths[header->segment_count] = segment_size;
+        memcpy(writer->page.segment[header->segment_count],
+               packet,
+               segment_size);
+        header->segment_count += 1;
+        writer->page_size += segment_size;
+
+        packet += segment_size;
+        remaining -= segment_size;
+
+        if (segment_size < 255) {
+            /*packet completes on the current page*/
+            header->granule_position = granule_position;
+            break;
+        }
+    } while (1);
+
+    if (flush || (writer->page_size >= OGG_PAGE_TARGET_SIZE)) {
+        writer->page_closed = 1;
+    }
+}
+
+int
+oggwriter_close(OggPacketWriter *writer)
+{
+    int error = 0;
+
+    if (writer->page.header.segment_count) {
+        if (!setjmp(*bw_try(writer->writer))) {
+            writer->page.header.stream_end = 1;
+            write_ogg_page(writer->writer, &(writer->page));
+            bw_etry(writer->writer);
+        } else {
+            /*the stream is still closed and the writer freed*/
+            bw_etry(writer->writer);
+            error = 1;
+        }
+    }
+    writer->writer->close(writer->writer);
+    free(writer);
+    return error;
+}
+
+
 char *
 ogg_strerror(ogg_status err) {
     switch (err) {
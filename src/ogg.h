@@ -73,6 +73,14 @@ oggiterator_open(FILE *stream);
 void
 oggiterator_close(OggPacketIterator *iterator);
 
+/*discards whatever remains of the current page
+  so that the next segment is read from a fresh page
+  at the reader's current position
+
+  this should be called after repositioning the iterator's reader*/
+void
+oggiterator_reset(OggPacketIterator *iterator);
+
 /*places a pointer to the next segment in "segment_data"
   and its size in "segment_size"
   the segment is pulled directly from an internal Ogg page
@@ -96,6 +104,45 @@ oggiterator_next_packet(OggPacketIterator *iterator,
                         ogg_status *status);
 
 
+typedef struct OggPacketWriter_s {
+    BitstreamWriter *writer;
+    struct ogg_page page;     /*the page currently being filled*/
+    unsigned page_size;       /*the total size of the page's segments*/
+    int page_closed;          /*whether the next segment needs a new page*/
+} OggPacketWriter;
+
+/*the size at which a page is considered full
+  and subsequent packets are placed on a new one*/
+#define OGG_PAGE_TARGET_SIZE 4096
+
+/*opens a packet writer to the given stream
+  which will be closed when the writer is closed
+  the stream must be seekable in order to populate page checksums*/
+OggPacketWriter*
+oggwriter_open(FILE *stream, unsigned serial_number);
+
+/*appends a packet of the given size to the stream
+  whose granule position is stored in the page it completes on
+  if "flush" is set, the next packet will start on a new page
+
+  pages are only written once it's known they're not the last,
+  so that closing the writer marks the final page as end-of-stream*/
+void
+oggwriter_write_packet(OggPacketWriter *writer,
+                       const uint8_t *packet,
+                       unsigned packet_size,
+                       int64_t granule_position,
+                       int flush);
+
+/*writes any remaining page marked as end-of-stream,
+  closes the stream and deallocates the writer
+
+  returns 0 on success, or 1 if the final page couldn't be written
+  in which case the stream is closed and the writer deallocated anyway*/
+int
+oggwriter_close(OggPacketWriter *writer);
+
+
 char *
 ogg_strerror(ogg_status err);
 
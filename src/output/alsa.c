@@ -246,6 +246,7 @@ PyObject* ALSAAudio_play(output_ALSAAudio *self, PyObject *args)
         return NULL;
     }
 
+    FrameList_interleave(framelist);
     state = PyEval_SaveThread();
 
     if ((status = self->play(self, framelist)) != 0) {
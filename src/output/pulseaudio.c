@@ -43,7 +43,24 @@ static void set_volume_callback(pa_context *context,
 
 static void write_stream_callback(pa_stream *stream,
                                   size_t nbytes,
-                                  pa_threaded_mainloop *mainloop);
+                                  output_PulseAudio *self);
+
+/*appends "len" bytes of samples to the ring,
+  which must have room for them*/
+static void push_samples(sfifo_t *fifo, const uint8_t *data, int len);
+
+/*removes "samples" ints from the ring,
+  converting them to the stream's sample format in "output"*/
+static void pull_samples(sfifo_t *fifo,
+                         unsigned samples,
+                         unsigned bits_per_sample,
+                         uint8_t *output);
+
+/*writes as much of "nbytes" as the ring holds
+  directly into the stream's buffer
+
+  must be called with the mainloop locked*/
+static void fill_stream(output_PulseAudio *self, size_t nbytes);
 
 static void success_callback(pa_stream *stream,
                              int success,
@@ -51,48 +68,63 @@ static void success_callback(pa_stream *stream,
 
 static PyObject* PulseAudio_play(output_PulseAudio *self, PyObject *args)
 {
-    uint8_t *data;
-#ifdef PY_SSIZE_T_CLEAN
-    Py_ssize_t data_len;
-#else
-    int data_len;
-#endif
-
-    if (!PyArg_ParseTuple(args, "s#", &data, &data_len))
+    pcm_FrameList *framelist;
+    const uint8_t *data;
+    unsigned data_len;
+    const int ring_frame_size = (int)(sizeof(int) * self->channels);
+
+    if (!PyArg_ParseTuple(args, "O!", self->framelist_type, &framelist))
+        return NULL;
+
+    if (framelist->channels != self->channels) {
+        PyErr_SetString(PyExc_ValueError,
+                        "FrameList channel count mismatch");
+        return NULL;
+    }
+    if (framelist->bits_per_sample != self->bits_per_sample) {
+        PyErr_SetString(PyExc_ValueError,
+                        "FrameList bits per sample mismatch");
         return NULL;
+    }
 
     /*ensure output stream is still running*/
     /*FIXME*/
 
-    /*Use polling interface to push data into stream.
-      The callback is mostly useless
-      because it doesn't allow us to adjust the data length
-      like CoreAudio's does.*/
-    Py_BEGIN_ALLOW_THREADS
-    pa_threaded_mainloop_lock(self->mainloop);
+    /*samples are queued in the ring as-is
+      and converted by the write callback
+      so the server is never waited on here*/
+    FrameList_interleave(framelist);
+    data = (const uint8_t*)framelist->samples;
+    data_len = FrameList_samples_length(framelist) * sizeof(int);
 
+    Py_BEGIN_ALLOW_THREADS
     while (data_len > 0) {
-        size_t writeable_len;
+        int space;
 
-        while ((writeable_len = pa_stream_writable_size(self->stream)) == 0) {
-            pa_threaded_mainloop_wait(self->mainloop);
+        /*wait for the write callback to make room in the ring*/
+        pthread_mutex_lock(&self->fifo_mutex);
+        while ((space = (sfifo_space(&self->fifo) / ring_frame_size *
+                         ring_frame_size)) == 0) {
+            pthread_cond_wait(&self->fifo_drained, &self->fifo_mutex);
         }
+        pthread_mutex_unlock(&self->fifo_mutex);
 
-        if (writeable_len > (size_t)data_len)
-            writeable_len = data_len;
+        if ((unsigned)space > data_len)
+            space = (int)data_len;
 
-        pa_stream_write(self->stream,
-                        data,
-                        writeable_len,
-                        NULL,
-                        0,
-                        PA_SEEK_RELATIVE);
+        push_samples(&self->fifo, data, space);
 
-        data += writeable_len;
-        data_len -= writeable_len;
-    }
+        data += space;
+        data_len -= space;
 
-    pa_threaded_mainloop_unlock(self->mainloop);
+        /*if the ring ran dry before the server's last request was met,
+          the write callback won't be called again until it is*/
+        pa_threaded_mainloop_lock(self->mainloop);
+        if (self->starved) {
+            fill_stream(self, pa_stream_writable_size(self->stream));
+        }
+        pa_threaded_mainloop_unlock(self->mainloop);
+    }
     Py_END_ALLOW_THREADS
 
     Py_INCREF(Py_None);
@@ -162,6 +194,7 @@ static PyObject* PulseAudio_flush(output_PulseAudio *self, PyObject *args)
     /*ensure outuput stream is still running*/
     /*FIXME*/
 
+    Py_BEGIN_ALLOW_THREADS
     pa_threaded_mainloop_lock(self->mainloop);
 
     /*uncork output stream, if necessary*/
@@ -179,6 +212,17 @@ static PyObject* PulseAudio_flush(output_PulseAudio *self, PyObject *args)
         pa_operation_unref(op);
     }
 
+    pa_threaded_mainloop_unlock(self->mainloop);
+
+    /*wait for the write callback to pass the ring's samples to the server*/
+    pthread_mutex_lock(&self->fifo_mutex);
+    while (sfifo_used(&self->fifo) > 0) {
+        pthread_cond_wait(&self->fifo_drained, &self->fifo_mutex);
+    }
+    pthread_mutex_unlock(&self->fifo_mutex);
+
+    pa_threaded_mainloop_lock(self->mainloop);
+
     /*drain output stream*/
     op = pa_stream_drain(
         self->stream,
@@ -192,6 +236,7 @@ static PyObject* PulseAudio_flush(output_PulseAudio *self, PyObject *args)
     pa_operation_unref(op);
 
     pa_threaded_mainloop_unlock(self->mainloop);
+    Py_END_ALLOW_THREADS
 
     Py_INCREF(Py_None);
     return Py_None;
@@ -320,11 +365,15 @@ int PulseAudio_init(output_PulseAudio *self, PyObject *args, PyObject *kwds)
     int bits_per_sample;
     char *stream_name;
     pa_sample_spec sample_spec;
+    PyObject *pcm;
 
     self->mainloop = NULL;
     self->mainloop_api = NULL;
     self->context = NULL;
     self->stream = NULL;
+    self->fifo_initialized = 0;
+    self->starved = 0;
+    self->framelist_type = NULL;
 
     if (!PyArg_ParseTuple(args, "iiis",
                           &sample_rate,
@@ -367,6 +416,30 @@ int PulseAudio_init(output_PulseAudio *self, PyObject *args, PyObject *kwds)
         return -1;
     }
 
+    self->channels = (unsigned)channels;
+    self->bits_per_sample = (unsigned)bits_per_sample;
+
+    /*keep a copy of the FrameList class so we can check for it*/
+    if ((pcm = PyImport_ImportModule("audiotools.pcm")) == NULL)
+        return -1;
+    self->framelist_type = PyObject_GetAttrString(pcm, "FrameList");
+    Py_DECREF(pcm);
+    if (self->framelist_type == NULL) {
+        return -1;
+    }
+
+    /*initialize ring of samples between play() and the write callback*/
+    if (sfifo_init(&self->fifo,
+                   (int)(sample_rate * FIFO_DURATION) *
+                   channels * sizeof(int))) {
+        PyErr_SetString(
+            PyExc_ValueError, "unable to allocate sample buffer");
+        return -1;
+    }
+    pthread_mutex_init(&self->fifo_mutex, NULL);
+    pthread_cond_init(&self->fifo_drained, NULL);
+    self->fifo_initialized = 1;
+
     /*initialize threaded mainloop*/
     if ((self->mainloop = pa_threaded_mainloop_new()) == NULL) {
         PyErr_SetString(
@@ -442,11 +515,11 @@ int PulseAudio_init(output_PulseAudio *self, PyObject *args, PyObject *kwds)
         (pa_stream_notify_cb_t)stream_state_callback,
         self->mainloop);
 
-    /*setup stream write callback*/
+    /*setup stream write callback to drain the ring*/
     pa_stream_set_write_callback(
         self->stream,
         (pa_stream_request_cb_t)write_stream_callback,
-        self->mainloop);
+        self);
 
     /*perform connection to PulseAudio server's default output stream*/
     if (pa_stream_connect_playback(
@@ -507,6 +580,15 @@ void PulseAudio_dealloc(output_PulseAudio *self)
     if (self->mainloop != NULL)
         pa_threaded_mainloop_free(self->mainloop);
 
+    /*free the ring once the write callback can no longer be called*/
+    if (self->fifo_initialized) {
+        sfifo_close(&self->fifo);
+        pthread_mutex_destroy(&self->fifo_mutex);
+        pthread_cond_destroy(&self->fifo_drained);
+    }
+
+    Py_XDECREF(self->framelist_type);
+
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -569,9 +651,124 @@ static void set_volume_callback(pa_context *context,
 
 static void write_stream_callback(pa_stream *stream,
                                   size_t nbytes,
-                                  pa_threaded_mainloop *mainloop)
+                                  output_PulseAudio *self)
 {
-    pa_threaded_mainloop_signal(mainloop, 0);
+    fill_stream(self, nbytes);
+}
+
+static void push_samples(sfifo_t *fifo, const uint8_t *data, int len)
+{
+    int writepos = fifo->writepos & SFIFO_SIZEMASK(fifo);
+
+    if ((writepos + len) > fifo->size) {
+        const int tail = fifo->size - writepos;
+        memcpy(fifo->buffer + writepos, data, tail);
+        memcpy(fifo->buffer, data + tail, len - tail);
+    } else {
+        memcpy(fifo->buffer + writepos, data, len);
+    }
+
+    /*publish the samples only once they've been copied*/
+    __sync_synchronize();
+    fifo->writepos = (writepos + len) & SFIFO_SIZEMASK(fifo);
+}
+
+static void pull_samples(sfifo_t *fifo,
+                         unsigned samples,
+                         unsigned bits_per_sample,
+                         uint8_t *output)
+{
+    const int mask = SFIFO_SIZEMASK(fifo);
+    int readpos = fifo->readpos;
+
+    /*samples are written a whole frame at a time
+      to a ring whose size is a power of 2,
+      so no sample straddles the end of the ring*/
+    switch (bits_per_sample) {
+    case 8:
+        for (; samples; samples--) {
+            const int sample = *(const int*)(fifo->buffer + readpos);
+            *output++ = (uint8_t)(sample + 0x80);
+            readpos = (readpos + sizeof(int)) & mask;
+        }
+        break;
+    case 16:
+        for (; samples; samples--) {
+            const int sample = *(const int*)(fifo->buffer + readpos);
+            *output++ = sample & 0xFF;
+            *output++ = (sample >> 8) & 0xFF;
+            readpos = (readpos + sizeof(int)) & mask;
+        }
+        break;
+    case 24:
+        for (; samples; samples--) {
+            const int sample = *(const int*)(fifo->buffer + readpos);
+            *output++ = sample & 0xFF;
+            *output++ = (sample >> 8) & 0xFF;
+            *output++ = (sample >> 16) & 0xFF;
+            readpos = (readpos + sizeof(int)) & mask;
+        }
+        break;
+    }
+
+    /*free the space only once the samples have been read*/
+    __sync_synchronize();
+    fifo->readpos = readpos;
+}
+
+static void fill_stream(output_PulseAudio *self, size_t nbytes)
+{
+    const unsigned sample_size = self->bits_per_sample / 8;
+    const size_t frame_size = sample_size * self->channels;
+    const unsigned ring_frame_size = sizeof(int) * self->channels;
+
+    self->starved = 0;
+
+    while (nbytes >= frame_size) {
+        size_t frames = sfifo_used(&self->fifo) / ring_frame_size;
+        void *buffer;
+        size_t buffer_size = nbytes;
+
+        if (frames == 0) {
+            /*the ring ran dry, so play() must finish the request*/
+            self->starved = 1;
+            break;
+        }
+
+        /*convert directly into the server's buffer*/
+        if (pa_stream_begin_write(self->stream, &buffer, &buffer_size) < 0)
+            break;
+
+        if (frames > (buffer_size / frame_size))
+            frames = buffer_size / frame_size;
+        if (frames == 0) {
+            pa_stream_cancel_write(self->stream);
+            break;
+        }
+
+        /*make sure the samples are read
+          only after they're known to be present*/
+        __sync_synchronize();
+
+        pull_samples(&self->fifo,
+                     (unsigned)frames * self->channels,
+                     self->bits_per_sample,
+                     buffer);
+
+        pa_stream_write(self->stream,
+                        buffer,
+                        frames * frame_size,
+                        NULL,
+                        0,
+                        PA_SEEK_RELATIVE);
+
+        nbytes -= frames * frame_size;
+    }
+
+    /*wake play() or flush() if waiting on the ring*/
+    pthread_mutex_lock(&self->fifo_mutex);
+    pthread_cond_broadcast(&self->fifo_drained);
+    pthread_mutex_unlock(&self->fifo_mutex);
 }
 
 static void success_callback(pa_stream *stream,
@@ -580,3 +777,9 @@ static void success_callback(pa_stream *stream,
 {
     pa_threaded_mainloop_signal(mainloop, 0);
 }
+
+/*only part of the ring's API is used by this output*/
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#include "sfifo.c"
+#pragma GCC diagnostic pop
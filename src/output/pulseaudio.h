@@ -1,6 +1,10 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <pulse/pulseaudio.h>
+#include <pthread.h>
+#define SFIFO_STATIC
+#include "sfifo.h"
+#include "../pcm.h"
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -22,6 +26,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *******************************************************/
 
+/* Duration of the ring buffer in seconds */
+#define FIFO_DURATION 0.5
+
 typedef struct {
     PyObject_HEAD
 
@@ -29,6 +36,26 @@ typedef struct {
     pa_mainloop_api* mainloop_api;
     pa_context* context;
     pa_stream* stream;
+
+    unsigned channels;
+    unsigned bits_per_sample;
+
+    /*interleaved samples as ints, written by play()
+      and drained by the stream's write callback,
+      which converts them directly into the server's buffer*/
+    sfifo_t fifo;
+
+    /*set by the write callback when it empties the ring
+      before the server's request is met,
+      so that play() knows to write the rest itself*/
+    int starved;
+
+    /*signaled by the write callback whenever it drains the ring*/
+    int fifo_initialized;
+    pthread_mutex_t fifo_mutex;
+    pthread_cond_t fifo_drained;
+
+    PyObject *framelist_type;
 } output_PulseAudio;
 
 static PyObject* PulseAudio_play(output_PulseAudio *self, PyObject *args);
@@ -25,6 +25,7 @@
 *******************************************************/
 
 #include "pcm.h"
+#include "pcm_sink.h"
 
 #ifndef MIN
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
@@ -240,7 +241,12 @@ FrameList_init(pcm_FrameList *self, PyObject *args, PyObject *kwds)
 pcm_FrameList*
 FrameList_create(void)
 {
-    return (pcm_FrameList*)_PyObject_New(&pcm_FrameListType);
+    pcm_FrameList *framelist =
+        (pcm_FrameList*)_PyObject_New(&pcm_FrameListType);
+    if (framelist) {
+        framelist->planar = 0;
+    }
+    return framelist;
 }
 
 PyObject*
@@ -337,6 +343,8 @@ PyObject
 int
 FrameList_equals(pcm_FrameList *a, pcm_FrameList *b)
 {
+    FrameList_interleave(a);
+    FrameList_interleave(b);
     return ((a->frames == b->frames) &&
             (a->channels == b->channels) &&
             (a->bits_per_sample == b->bits_per_sample) &&
@@ -348,6 +356,7 @@ FrameList_equals(pcm_FrameList *a, pcm_FrameList *b)
 PyObject*
 FrameList_GetItem(pcm_FrameList *o, Py_ssize_t i)
 {
+    FrameList_interleave(o);
     if ((i >= 0) && (i < FrameList_samples_length(o))) {
         return Py_BuildValue("i", o->samples[i]);
     } else {
@@ -369,6 +378,7 @@ FrameList_frame(pcm_FrameList *self, PyObject *args)
         return NULL;
     }
 
+    FrameList_interleave(self);
     frame = FrameList_create();
     frame->frames = 1;
     frame->channels = self->channels;
@@ -400,9 +410,15 @@ FrameList_channel(pcm_FrameList *self, PyObject *args)
     channel->bits_per_sample = self->bits_per_sample;
     channel->samples = malloc(sizeof(int) * self->frames);
 
-    for (i = 0; i < self->frames; i++) {
-        channel->samples[i] = \
-            self->samples[channel_number + (i * self->channels)];
+    if (self->planar) {
+        memcpy(channel->samples,
+               FrameList_planar_channel(self, (unsigned)channel_number),
+               sizeof(int) * self->frames);
+    } else {
+        for (i = 0; i < self->frames; i++) {
+            channel->samples[i] = \
+                self->samples[channel_number + (i * self->channels)];
+        }
     }
 
     return (PyObject*)channel;
@@ -424,6 +440,7 @@ FrameList_to_bytes(pcm_FrameList *self, PyObject *args)
                 PyBytes_FromStringAndSize(NULL, bytes_size)) == NULL) {
         return NULL;
     } else {
+        FrameList_interleave(self);
         int_to_pcm_converter(
             self->bits_per_sample,
             is_big_endian,
@@ -471,6 +488,7 @@ FrameList_split(pcm_FrameList *self, PyObject *args)
             split_point * self->channels;
         const unsigned tail_samples_length =
             (self->frames - split_point) * self->channels;
+        FrameList_interleave(self);
         head = FrameList_create();
         head->frames = split_point;
         head->samples = malloc(head_samples_length * sizeof(int));
@@ -523,6 +541,8 @@ FrameList_concat(pcm_FrameList *a, PyObject *bb)
         return NULL;
     }
 
+    FrameList_interleave(a);
+    FrameList_interleave(b);
     concat = FrameList_create();
     concat->frames = a->frames + b->frames;
     concat->channels = a->channels;
@@ -545,6 +565,7 @@ FrameList_repeat(pcm_FrameList *a, Py_ssize_t i)
     Py_ssize_t j;
     const unsigned a_samples_length = FrameList_samples_length(a);
 
+    FrameList_interleave(a);
     repeat->frames = (unsigned int)(a->frames * i);
     repeat->channels = a->channels;
     repeat->bits_per_sample = a->bits_per_sample;
@@ -564,6 +585,7 @@ PyObject*
 FrameList_to_float(pcm_FrameList *self, PyObject *args)
 {
     pcm_FloatFrameList *framelist = FloatFrameList_create();
+    FrameList_interleave(self);
     framelist->frames = self->frames;
     framelist->channels = self->channels;
     framelist->samples = malloc(sizeof(double) *
@@ -894,6 +916,7 @@ int
 FrameList_converter(PyObject* obj, void** framelist)
 {
     if (PyObject_TypeCheck(obj, &pcm_FrameListType)) {
+        FrameList_interleave((pcm_FrameList*)obj);
         *framelist = obj;
         return 1;
     } else {
@@ -1584,12 +1607,19 @@ MOD_INIT(pcm)
     if (PyType_Ready(&pcm_FloatFrameListType) < 0)
         return MOD_ERROR_VAL;
 
+    pcm_PCMSinkType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&pcm_PCMSinkType) < 0)
+        return MOD_ERROR_VAL;
+
     Py_INCREF(&pcm_FrameListType);
     PyModule_AddObject(m, "FrameList",
                        (PyObject *)&pcm_FrameListType);
     Py_INCREF(&pcm_FloatFrameListType);
     PyModule_AddObject(m, "FloatFrameList",
                        (PyObject *)&pcm_FloatFrameListType);
+    Py_INCREF(&pcm_PCMSinkType);
+    PyModule_AddObject(m, "PCMSink",
+                       (PyObject *)&pcm_PCMSinkType);
 
     return MOD_SUCCESS_VAL(m);
 }
@@ -41,6 +41,11 @@ typedef struct {
     int* samples;            /*the actual sample data itself,
                                stored raw as 32-bit signed integers
                                whose total length is frames * channels*/
+
+    int planar;              /*whether "samples" is stored channel-major,
+                               every frame of channel 0 followed by
+                               every frame of channel 1 and so on,
+                               rather than interleaved frame by frame*/
 } pcm_FrameList;
 
 /*returns total length of framelist's "samples" field*/
@@ -50,6 +55,48 @@ FrameList_samples_length(const pcm_FrameList *framelist)
     return framelist->frames * framelist->channels;
 }
 
+/*returns a pointer to the given channel's samples
+  in a planar FrameList*/
+static inline int*
+FrameList_planar_channel(const pcm_FrameList *framelist, unsigned channel)
+{
+    return framelist->samples + (channel * framelist->frames);
+}
+
+/*converts a planar FrameList's samples to interleaved order in place,
+  doing nothing if they're interleaved already
+
+  decoders may hand out planar FrameLists for native consumers to
+  use directly, so anything reading "samples" in interleaved order
+  should call this first*/
+static inline void
+FrameList_interleave(pcm_FrameList *framelist)
+{
+    if (framelist->planar &&
+        ((framelist->channels == 1) || (framelist->frames <= 1))) {
+        /*both orders are the same*/
+        framelist->planar = 0;
+    } else if (framelist->planar) {
+        const unsigned channels = framelist->channels;
+        const unsigned frames = framelist->frames;
+        int *interleaved =
+            malloc(sizeof(int) * FrameList_samples_length(framelist));
+        unsigned c;
+
+        for (c = 0; c < channels; c++) {
+            const int *channel = FrameList_planar_channel(framelist, c);
+            unsigned i;
+            for (i = 0; i < frames; i++) {
+                interleaved[(i * channels) + c] = channel[i];
+            }
+        }
+
+        free(framelist->samples);
+        framelist->samples = interleaved;
+        framelist->planar = 0;
+    }
+}
+
 #ifdef PCM_MODULE
 void
 FrameList_dealloc(pcm_FrameList* self);
@@ -1,6 +1,7 @@
 #include "pcm_conv.h"
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -283,18 +284,12 @@ pcm_SB16_to_int(unsigned total_samples,
                 const unsigned char pcm_samples[],
                 int int_samples[])
 {
-    for (; total_samples; total_samples--) {
-        if (pcm_samples[0] & 0x80) {
-            /*negative*/
-            int_samples[0] =
-                -(int)(0x10000 - ((pcm_samples[0] << 8) | pcm_samples[1]));
-        } else {
-            /*positive*/
-            int_samples[0] =
-                (int)(pcm_samples[0] << 8) | pcm_samples[1];
-        }
-        pcm_samples += 2;
-        int_samples += 1;
+    unsigned i;
+
+    /*an indexed, branch-free loop the compiler can vectorize*/
+    for (i = 0; i < total_samples; i++) {
+        int_samples[i] = (int16_t)((pcm_samples[i * 2 + 0] << 8) |
+                                   pcm_samples[i * 2 + 1]);
     }
 }
 
@@ -328,18 +323,11 @@ pcm_SL16_to_int(unsigned total_samples,
                 const unsigned char pcm_samples[],
                 int int_samples[])
 {
-    for (; total_samples; total_samples--) {
-        if (pcm_samples[1] & 0x80) {
-            /*negative*/
-            int_samples[0] =
-               -(int)(0x10000 - ((pcm_samples[1] << 8) | pcm_samples[0]));
-        } else {
-            /*positive*/
-            int_samples[0] =
-               (int)(pcm_samples[1] << 8) | pcm_samples[0];
-        }
-        pcm_samples += 2;
-        int_samples += 1;
+    unsigned i;
+
+    for (i = 0; i < total_samples; i++) {
+        int_samples[i] = (int16_t)((pcm_samples[i * 2 + 1] << 8) |
+                                   pcm_samples[i * 2 + 0]);
     }
 }
 
@@ -657,13 +645,15 @@ int_to_UL24_pcm(unsigned total_samples,
                         const float float_samples[],                       \
                         int int_samples[])                                 \
   {                                                                        \
-      for (; total_samples; total_samples--) {                             \
-          const register double d = float_samples[0];                      \
-          const int value =                                                \
-              d * (signbit(d) ? -(NEGATIVE_MIN) : POSITIVE_MAX);           \
-          int_samples[0] = MIN(MAX(value, NEGATIVE_MIN), POSITIVE_MAX);    \
-          float_samples += 1;                                              \
-          int_samples += 1;                                                \
+      /*clamping before the integer conversion                          \
+        lets the compiler vectorize this loop*/                            \
+      unsigned i;                                                          \
+      for (i = 0; i < total_samples; i++) {                                \
+          const double d = float_samples[i];                               \
+          const double value =                                             \
+              d * ((d < 0.0) ? -(NEGATIVE_MIN) : POSITIVE_MAX);            \
+          int_samples[i] =                                                 \
+              (int)MIN(MAX(value, NEGATIVE_MIN), POSITIVE_MAX);            \
       }                                                                    \
   }
 
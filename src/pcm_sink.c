@@ -0,0 +1,334 @@
+#ifndef STANDALONE
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+#include "pcm.h"
+#include "pcm_sink.h"
+
+/*the largest number of bytes converted and written at once
+
+  FrameLists larger than this are written in frame-aligned blocks
+  so the conversion buffer never needs to grow*/
+#define MAX_BLOCK_SIZE (1 << 18)
+
+#ifndef STANDALONE
+
+PyMethodDef PCMSink_methods[] = {
+    {"write", (PyCFunction)PCMSink_write,
+     METH_VARARGS,
+     "S.write(framelist) -- writes FrameList to file descriptor"},
+    {"close", (PyCFunction)PCMSink_close,
+     METH_NOARGS,
+     "S.close() -- detaches sink from file descriptor, "
+     "which is left open"},
+    {"__enter__", (PyCFunction)PCMSink_enter,
+     METH_NOARGS, "enter() -> self"},
+    {"__exit__", (PyCFunction)PCMSink_exit,
+     METH_VARARGS, "exit(exc_type, exc_value, traceback) -> None"},
+    {NULL}
+};
+
+PyGetSetDef PCMSink_getseters[] = {
+    {"fd", (getter)PCMSink_fileno,
+     0, "file descriptor being written to", NULL},
+    {"frames_written", (getter)PCMSink_frames_written,
+     0, "total PCM frames written", NULL},
+    {"bytes_written", (getter)PCMSink_bytes_written,
+     0, "total PCM bytes written", NULL},
+    {"syscalls", (getter)PCMSink_syscalls,
+     0, "total write calls made", NULL},
+    {"write_time", (getter)PCMSink_write_time,
+     0, "total seconds spent writing", NULL},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject pcm_PCMSinkType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pcm.PCMSink",             /*tp_name*/
+    sizeof(pcm_PCMSink),       /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)PCMSink_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    "PCMSink(fd, is_big_endian, is_signed)", /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    PCMSink_methods,           /* tp_methods */
+    0,                         /* tp_members */
+    PCMSink_getseters,         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)PCMSink_init,    /* tp_init */
+    0,                         /* tp_alloc */
+    PCMSink_new,               /* tp_new */
+};
+
+static size_t
+page_size(void)
+{
+    const long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+static double
+monotonic_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+void
+PCMSink_dealloc(pcm_PCMSink* self)
+{
+    free(self->buffer);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+PyObject*
+PCMSink_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    pcm_PCMSink *self;
+
+    self = (pcm_PCMSink *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+PCMSink_init(pcm_PCMSink *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"fd",
+                             "is_big_endian",
+                             "is_signed",
+                             NULL};
+
+    self->buffer = NULL;
+    self->closed = 0;
+    self->frames_written = 0;
+    self->bytes_written = 0;
+    self->syscalls = 0;
+    self->write_time = 0.0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "iii", kwlist,
+                                     &(self->fd),
+                                     &(self->is_big_endian),
+                                     &(self->is_signed)))
+        return -1;
+
+    if (posix_memalign((void**)&(self->buffer),
+                       page_size(),
+                       MAX_BLOCK_SIZE)) {
+        self->buffer = NULL;
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    return 0;
+}
+
+/*waits for the file descriptor to become writable
+  for descriptors opened in non-blocking mode*/
+static void
+wait_writable(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    Py_BEGIN_ALLOW_THREADS
+    poll(&pfd, 1, -1);
+    Py_END_ALLOW_THREADS
+}
+
+/*writes "size" bytes from "data" to the sink's file descriptor
+  returns 0 on success, or -1 with a Python exception set*/
+static int
+write_block(pcm_PCMSink *self, const unsigned char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t written;
+        const double start = monotonic_time();
+
+        Py_BEGIN_ALLOW_THREADS
+        written = write(self->fd, data, size);
+        Py_END_ALLOW_THREADS
+
+        self->write_time += (monotonic_time() - start);
+        self->syscalls += 1;
+
+        if (written >= 0) {
+            data += written;
+            size -= written;
+            self->bytes_written += written;
+        } else if (errno == EINTR) {
+            if (PyErr_CheckSignals() < 0) {
+                return -1;
+            }
+        } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            wait_writable(self->fd);
+        } else {
+            PyErr_SetFromErrno(PyExc_IOError);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+PyObject*
+PCMSink_write(pcm_PCMSink *self, PyObject *args)
+{
+    pcm_FrameList *framelist;
+    int_to_pcm_f converter;
+    unsigned bytes_per_frame;
+    unsigned block_frames;
+    unsigned frames_remaining;
+    const int *samples;
+
+    if (!PyArg_ParseTuple(args, "O&", FrameList_converter, &framelist))
+        return NULL;
+
+    if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "cannot write closed sink");
+        return NULL;
+    }
+
+    if ((converter = int_to_pcm_converter(framelist->bits_per_sample,
+                                          self->is_big_endian,
+                                          self->is_signed)) == NULL) {
+        PyErr_SetString(PyExc_ValueError,
+                        "unsupported number of bits per sample");
+        return NULL;
+    }
+
+    bytes_per_frame = framelist->channels * (framelist->bits_per_sample / 8);
+    block_frames = MAX_BLOCK_SIZE / bytes_per_frame;
+    if (block_frames == 0) {
+        block_frames = 1;
+    }
+
+    samples = framelist->samples;
+    frames_remaining = framelist->frames;
+
+    while (frames_remaining > 0) {
+        const unsigned frames =
+            frames_remaining < block_frames ? frames_remaining : block_frames;
+
+        converter(frames * framelist->channels, samples, self->buffer);
+
+        if (write_block(self, self->buffer,
+                        (size_t)frames * bytes_per_frame)) {
+            return NULL;
+        }
+
+        samples += frames * framelist->channels;
+        frames_remaining -= frames;
+        self->frames_written += frames;
+    }
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject*
+PCMSink_close(pcm_PCMSink *self, PyObject *args)
+{
+    self->closed = 1;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject*
+PCMSink_enter(pcm_PCMSink *self, PyObject *args)
+{
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+PyObject*
+PCMSink_exit(pcm_PCMSink *self, PyObject *args)
+{
+    self->closed = 1;
+
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject*
+PCMSink_fileno(pcm_PCMSink *self, void *closure)
+{
+    return Py_BuildValue("i", self->fd);
+}
+
+PyObject*
+PCMSink_frames_written(pcm_PCMSink *self, void *closure)
+{
+    return PyLong_FromUnsignedLongLong(self->frames_written);
+}
+
+PyObject*
+PCMSink_bytes_written(pcm_PCMSink *self, void *closure)
+{
+    return PyLong_FromUnsignedLongLong(self->bytes_written);
+}
+
+PyObject*
+PCMSink_syscalls(pcm_PCMSink *self, void *closure)
+{
+    return PyLong_FromUnsignedLongLong(self->syscalls);
+}
+
+PyObject*
+PCMSink_write_time(pcm_PCMSink *self, void *closure)
+{
+    return PyFloat_FromDouble(self->write_time);
+}
+
+#endif
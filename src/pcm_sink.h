@@ -0,0 +1,103 @@
+#ifndef PCM_SINK_H
+#define PCM_SINK_H
+
+#include <stdint.h>
+#include "pcm_conv.h"
+
+/********************************************************
+ Audio Tools, a module and set of tools for manipulating audio data
+ Copyright (C) 2007-2016  Brian Langenberger
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*******************************************************/
+
+
+/****************
+  PCMSink Object
+*****************/
+
+/*a PCMSink converts FrameList objects to raw PCM bytes
+  in a reusable, page-aligned buffer
+  and writes them directly to a file descriptor
+  without allocating any intermediate Python objects
+
+  pipes are written to like any other descriptor
+  since pages vmspliced into them may still be referenced
+  by whatever reads the pipe after the buffer is reused*/
+
+#ifndef STANDALONE
+
+typedef struct {
+    PyObject_HEAD;
+
+    int fd;                   /*the file descriptor being written to
+                                which is not owned by this object*/
+    int is_big_endian;
+    int is_signed;
+    int closed;
+
+    unsigned char *buffer;    /*page-aligned conversion buffer*/
+
+    /*throughput counters*/
+    uint64_t frames_written;
+    uint64_t bytes_written;
+    uint64_t syscalls;
+    double write_time;        /*seconds spent in write calls*/
+} pcm_PCMSink;
+
+extern PyTypeObject pcm_PCMSinkType;
+
+void
+PCMSink_dealloc(pcm_PCMSink* self);
+
+PyObject*
+PCMSink_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+
+int
+PCMSink_init(pcm_PCMSink *self, PyObject *args, PyObject *kwds);
+
+/*writes the given FrameList to the file descriptor*/
+PyObject*
+PCMSink_write(pcm_PCMSink *self, PyObject *args);
+
+/*detaches the sink from its file descriptor,
+  which is left open*/
+PyObject*
+PCMSink_close(pcm_PCMSink *self, PyObject *args);
+
+PyObject*
+PCMSink_enter(pcm_PCMSink *self, PyObject *args);
+
+PyObject*
+PCMSink_exit(pcm_PCMSink *self, PyObject *args);
+
+PyObject*
+PCMSink_fileno(pcm_PCMSink *self, void *closure);
+
+PyObject*
+PCMSink_frames_written(pcm_PCMSink *self, void *closure);
+
+PyObject*
+PCMSink_bytes_written(pcm_PCMSink *self, void *closure);
+
+PyObject*
+PCMSink_syscalls(pcm_PCMSink *self, void *closure);
+
+PyObject*
+PCMSink_write_time(pcm_PCMSink *self, void *closure);
+
+#endif
+
+#endif
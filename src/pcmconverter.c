@@ -1,5 +1,6 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <stdint.h>
 #include "mod_defs.h"
 #include "framelist.h"
 #include "pcmreader.h"
@@ -8,6 +9,9 @@
 #include "samplerate/samplerate.h"
 #include "pcmconverter.h"
 #include "dither.c"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /********************************************************
  Audio Tools, a module and set of tools for manipulating audio data
@@ -37,15 +41,104 @@
 
 #define CHUNK_SIZE 4096
 
-static inline void
-fade_samples(int samples[], unsigned channels, unsigned index, unsigned total)
+/*returns the gain of frame "index" of a fade from silence
+  "total" frames long*/
+static inline int
+fade_gain(unsigned index, unsigned total)
 {
-    double adjustment = index;
-    adjustment /= total;
+    return (index < total) ?
+           (int)(((uint64_t)index << GAIN_BITS) / total) :
+           GAIN_UNITY;
+}
+
+/*multiplies each of the "pcm_frames" interleaved frames in "input"
+  by its gain, placing the result in "output"
+  which may be the same as "input"*/
+static void
+scale_samples(int output[],
+              const int input[],
+              unsigned channels,
+              unsigned bits_per_sample,
+              unsigned pcm_frames,
+              const int gains[])
+{
+    unsigned i = 0;
+
+    if (bits_per_sample <= 16) {
+        /*samples of up to 16 bits only need 15 bits of gain,
+          so their products fit in 32 bits*/
+#ifdef __SSE2__
+        /*such samples are sign-extended in their 32-bit lanes
+          and gains short of unity fit in 15 bits,
+          so multiplying the low halves of each lane with madd
+          gets their exact product*/
+        if (channels <= 2) {
+            const __m128i unity = _mm_set1_epi32(1 << 15);
+            const __m128i round = _mm_set1_epi32(1 << 14);
+            const __m128i gain_round = _mm_set1_epi32(1 << (GAIN_BITS - 16));
+
+            for (; (i + 4) <= pcm_frames; i += 4) {
+                const __m128i frame_gains =
+                    _mm_srli_epi32(
+                        _mm_add_epi32(
+                            _mm_loadu_si128((const __m128i*)(gains + i)),
+                            gain_round),
+                        GAIN_BITS - 15);
+                __m128i lane_gains[2];
+                unsigned v;
+
+                if (channels == 1) {
+                    lane_gains[0] = frame_gains;
+                } else {
+                    lane_gains[0] = _mm_unpacklo_epi32(frame_gains,
+                                                       frame_gains);
+                    lane_gains[1] = _mm_unpackhi_epi32(frame_gains,
+                                                       frame_gains);
+                }
+
+                for (v = 0; v < channels; v++) {
+                    const __m128i samples =
+                        _mm_loadu_si128(
+                            (const __m128i*)(input +
+                                             (i * channels) + (v * 4)));
+                    const __m128i is_unity = _mm_cmpeq_epi32(lane_gains[v],
+                                                             unity);
+                    const __m128i scaled =
+                        _mm_srai_epi32(
+                            _mm_add_epi32(
+                                _mm_madd_epi16(samples, lane_gains[v]),
+                                round),
+                            15);
+
+                    /*unity gains pass their samples through unchanged*/
+                    _mm_storeu_si128(
+                        (__m128i*)(output + (i * channels) + (v * 4)),
+                        _mm_or_si128(_mm_and_si128(is_unity, samples),
+                                     _mm_andnot_si128(is_unity, scaled)));
+                }
+            }
+        }
+#endif
 
-    for (; channels; channels--) {
-        samples[0] = (int)(lround(adjustment * samples[0]));
-        samples += 1;
+        for (; i < pcm_frames; i++) {
+            const int gain = (gains[i] + (1 << (GAIN_BITS - 16))) >>
+                             (GAIN_BITS - 15);
+            unsigned c;
+            for (c = 0; c < channels; c++) {
+                output[(i * channels) + c] =
+                    (input[(i * channels) + c] * gain + (1 << 14)) >> 15;
+            }
+        }
+    } else {
+        for (; i < pcm_frames; i++) {
+            const int64_t gain = gains[i];
+            unsigned c;
+            for (c = 0; c < channels; c++) {
+                output[(i * channels) + c] =
+                    (int)((input[(i * channels) + c] * gain +
+                           (1 << (GAIN_BITS - 1))) >> GAIN_BITS);
+            }
+        }
     }
 }
 
@@ -118,10 +211,11 @@ static PyObject*
 Averager_read(pcmconverter_Averager *self, PyObject *args)
 {
     const unsigned channel_count = self->pcmreader->channels;
-    int pcm_data[CHUNK_SIZE * channel_count];
-    const unsigned frames_read = self->pcmreader->read(self->pcmreader,
-                                                       CHUNK_SIZE,
-                                                       pcm_data);
+    const int *pcm_data;
+    const unsigned frames_read =
+        self->pcmreader->acquire(self->pcmreader,
+                                 CHUNK_SIZE,
+                                 &pcm_data);
     pcm_FrameList *framelist;
     unsigned i;
 
@@ -145,6 +239,8 @@ Averager_read(pcmconverter_Averager *self, PyObject *args)
                    (int)(accumulator / channel_count));
     }
 
+    self->pcmreader->release(self->pcmreader, frames_read);
+
     return (PyObject*)framelist;
 }
 
@@ -230,10 +326,11 @@ Downmixer_read(pcmconverter_Downmixer *self, PyObject *args)
     const int SAMPLE_MAX = (1 << (self->pcmreader->bits_per_sample - 1)) - 1;
     unsigned mask;
     unsigned input_mask;
-    int pcm_data[CHUNK_SIZE * self->pcmreader->channels];
-    const unsigned frames_read = self->pcmreader->read(self->pcmreader,
-                                                       CHUNK_SIZE,
-                                                       pcm_data);
+    const int *pcm_data;
+    const unsigned frames_read =
+        self->pcmreader->acquire(self->pcmreader,
+                                 CHUNK_SIZE,
+                                 &pcm_data);
     pcm_FrameList *framelist;
     unsigned input_channel = 0;
     unsigned output_channel = 0;
@@ -292,6 +389,8 @@ Downmixer_read(pcmconverter_Downmixer *self, PyObject *args)
         }
     }
 
+    self->pcmreader->release(self->pcmreader, frames_read);
+
     for (i = 0; i < frames_read; i++) {
         /*bM (back mono) = 0.7 * (bL + bR)*/
         const double mono_rear = 0.7 * (bL[i] + bR[i]);
@@ -342,6 +441,9 @@ Resampler_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
 int
 Resampler_init(pcmconverter_Resampler *self, PyObject *args, PyObject *kwds)
 {
+    static char *kwlist[] = {"pcmreader", "sample_rate", "quality", NULL};
+    char *quality = "best";
+    int converter;
     int error;
 
     self->pcmreader = NULL;
@@ -350,10 +452,11 @@ Resampler_init(pcmconverter_Resampler *self, PyObject *args, PyObject *kwds)
     self->src_data.data_out = NULL;
     self->audiotools_pcm = NULL;
 
-    if (!PyArg_ParseTuple(args, "O&i",
-                          py_obj_to_pcmreader,
-                          &(self->pcmreader),
-                          &(self->sample_rate)))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&i|s", kwlist,
+                                     py_obj_to_pcmreader,
+                                     &(self->pcmreader),
+                                     &(self->sample_rate),
+                                     &quality))
         return -1;
 
     /*basic sanity checking*/
@@ -363,10 +466,27 @@ Resampler_init(pcmconverter_Resampler *self, PyObject *args, PyObject *kwds)
         return -1;
     }
 
+    /*each quality uses one of libsamplerate's sinc filters,
+      which differ only in the length of their coefficient tables*/
+    if (!strcmp(quality, "best")) {
+        converter = SRC_SINC_BEST_QUALITY;
+    } else if (!strcmp(quality, "medium")) {
+        converter = SRC_SINC_MEDIUM_QUALITY;
+    } else if (!strcmp(quality, "fastest")) {
+        converter = SRC_SINC_FASTEST;
+    } else {
+        PyErr_SetString(PyExc_ValueError,
+                        "quality must be \"fastest\", \"medium\" or \"best\"");
+        return -1;
+    }
+
     /*allocate fresh resampler state*/
-    self->src_state = src_new(SRC_SINC_BEST_QUALITY,
-                              self->pcmreader->channels,
-                              &error);
+    if ((self->src_state = src_new(converter,
+                                   self->pcmreader->channels,
+                                   &error)) == NULL) {
+        PyErr_SetString(PyExc_ValueError, src_strerror(error));
+        return -1;
+    }
 
     /*allocate fresh resampler I/O state*/
     self->src_data.data_in =
@@ -409,12 +529,12 @@ Resampler_read(pcmconverter_Resampler *self, PyObject *args)
     /*get data from PCMReader*/
     const unsigned channels = self->pcmreader->channels;
     const unsigned bits_per_sample = self->pcmreader->bits_per_sample;
-    int pcm_data[RESAMPLER_BLOCK_SIZE * channels];
+    const int *pcm_data;
     const unsigned frames_read =
-        self->pcmreader->read(
+        self->pcmreader->acquire(
             self->pcmreader,
             (unsigned)(RESAMPLER_BLOCK_SIZE - self->src_data.input_frames),
-            pcm_data);
+            &pcm_data);
     int process_result;
     pcm_FrameList *framelist;
 
@@ -428,6 +548,7 @@ Resampler_read(pcmconverter_Resampler *self, PyObject *args)
                          pcm_data,
                          self->src_data.data_in +
                          (self->src_data.input_frames * channels));
+    self->pcmreader->release(self->pcmreader, frames_read);
     self->src_data.input_frames += frames_read;
     self->src_data.end_of_input = (frames_read == 0);
 
@@ -593,48 +714,50 @@ BPSConverter_read(pcmconverter_BPSConverter *self, PyObject *args)
 {
     int shift = self->bits_per_sample - self->pcmreader->bits_per_sample;
 
-    /*read FrameList from PCMReader*/
-    pcm_FrameList *framelist = new_FrameList(
-        self->audiotools_pcm,
-        self->pcmreader->channels,
-        self->bits_per_sample,
-        CHUNK_SIZE);
-
+    /*borrow samples from PCMReader*/
+    const int *pcm_data;
     const unsigned frames_read =
-        self->pcmreader->read(self->pcmreader,
-                              CHUNK_SIZE,
-                              framelist->samples);
-
+        self->pcmreader->acquire(self->pcmreader,
+                                 CHUNK_SIZE,
+                                 &pcm_data);
+    pcm_FrameList *framelist;
+    unsigned samples_length;
     unsigned i;
 
     if (!frames_read && (self->pcmreader->status != PCM_OK)) {
-        Py_DECREF((PyObject*)framelist);
         return NULL;
     }
 
-    framelist->frames = frames_read;
+    /*and shift them into a new FrameList*/
+    framelist = new_FrameList(self->audiotools_pcm,
+                              self->pcmreader->channels,
+                              self->bits_per_sample,
+                              frames_read);
+    samples_length = FrameList_samples_length(framelist);
 
     if (shift > 0) {
         /*going from fewer bits-per-sample to more, like 16 to 24 bps
           so perform left shift on each sample*/
-        const unsigned samples_length = FrameList_samples_length(framelist);
         for (i = 0; i < samples_length; i++) {
-            framelist->samples[i] <<= shift;
+            framelist->samples[i] = pcm_data[i] << shift;
         }
     } else if (shift < 0) {
         /*going from more bits-per-sample to fewer, like 24bps to 16
           so perform right shift on each sample and add dither*/
-        const unsigned samples_length = FrameList_samples_length(framelist);
         BitstreamReader *white_noise = self->white_noise;
         br_read_f read = white_noise->read;
 
         shift = abs(shift);
         for (i = 0; i < samples_length; i++) {
-            framelist->samples[i] >>= shift;
-            framelist->samples[i] |= read(white_noise, 1);
+            framelist->samples[i] =
+                (pcm_data[i] >> shift) | read(white_noise, 1);
         }
+    } else {
+        memcpy(framelist->samples, pcm_data, sizeof(int) * samples_length);
     }
 
+    self->pcmreader->release(self->pcmreader, frames_read);
+
     return (PyObject*)framelist;
 }
 
@@ -908,16 +1031,27 @@ FadeInReader_read(pcmconverter_FadeInReader *self, PyObject *args)
         framelist->frames = frames_read;
     }
 
-    /*perform fade in on samples in-place*/
-    for (frame = 0; frame < frames_read; frame++) {
-        fade_samples(framelist->samples + (frame * channels),
-                     channels,
-                     self->frame_index,
-                     self->frame_total);
+    /*perform fade in on samples in-place, a chunk at a time*/
+    for (frame = 0; frame < frames_read; frame += CHUNK_SIZE) {
+        const unsigned chunk = MIN(frames_read - frame, CHUNK_SIZE);
+        int gains[CHUNK_SIZE];
+        unsigned i;
+
+        for (i = 0; i < chunk; i++) {
+            gains[i] = fade_gain(self->frame_index,
+                                 self->frame_total);
 
-        if (self->frame_index < self->frame_total) {
-            self->frame_index += 1;
+            if (self->frame_index < self->frame_total) {
+                self->frame_index += 1;
+            }
         }
+
+        scale_samples(framelist->samples + (frame * channels),
+                      framelist->samples + (frame * channels),
+                      channels,
+                      self->pcmreader->bits_per_sample,
+                      chunk,
+                      gains);
     }
 
     /*return faded FrameList object*/
@@ -1056,16 +1190,27 @@ FadeOutReader_read(pcmconverter_FadeOutReader *self, PyObject *args)
         framelist->frames = frames_read;
     }
 
-    /*perform fade out on samples in-place*/
-    for (frame = 0; frame < frames_read; frame++) {
-        fade_samples(framelist->samples + (frame * channels),
-                     channels,
-                     self->frame_total - self->frame_index,
-                     self->frame_total);
+    /*perform fade out on samples in-place, a chunk at a time*/
+    for (frame = 0; frame < frames_read; frame += CHUNK_SIZE) {
+        const unsigned chunk = MIN(frames_read - frame, CHUNK_SIZE);
+        int gains[CHUNK_SIZE];
+        unsigned i;
 
-        if (self->frame_index < self->frame_total) {
-            self->frame_index += 1;
+        for (i = 0; i < chunk; i++) {
+            gains[i] = fade_gain(self->frame_total - self->frame_index,
+                                 self->frame_total);
+
+            if (self->frame_index < self->frame_total) {
+                self->frame_index += 1;
+            }
         }
+
+        scale_samples(framelist->samples + (frame * channels),
+                      framelist->samples + (frame * channels),
+                      channels,
+                      self->pcmreader->bits_per_sample,
+                      chunk,
+                      gains);
     }
 
     /*return faded FrameList object*/
@@ -1084,6 +1229,346 @@ FadeOutReader_close(pcmconverter_FadeOutReader *self, PyObject *args)
 }
 
 
+static PyObject*
+CatReader_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    pcmconverter_CatReader *self;
+
+    self = (pcmconverter_CatReader *)type->tp_alloc(type, 0);
+
+    return (PyObject *)self;
+}
+
+int
+CatReader_init(pcmconverter_CatReader *self,
+               PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"pcmreaders",
+                             "envelope",
+                             NULL};
+    PyObject *pcmreaders_obj;
+    PyObject *envelope_obj = NULL;
+    PyObject *pcmreaders_seq;
+    Py_ssize_t count;
+    Py_ssize_t i;
+
+    self->closed = 0;
+    self->pcmreaders = NULL;
+    self->count = 0;
+    self->index = 0;
+    self->position = 0;
+    self->envelope.points = NULL;
+    self->envelope.count = 0;
+    self->envelope.next = 0;
+    self->audiotools_pcm = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", kwlist,
+                                     &pcmreaders_obj,
+                                     &envelope_obj))
+        return -1;
+
+    if ((pcmreaders_seq =
+         PySequence_Fast(pcmreaders_obj,
+                         "pcmreaders must be a sequence")) == NULL)
+        return -1;
+
+    if ((count = PySequence_Fast_GET_SIZE(pcmreaders_seq)) == 0) {
+        Py_DECREF(pcmreaders_seq);
+        PyErr_SetString(PyExc_ValueError,
+                        "at least one PCMReader is required");
+        return -1;
+    }
+
+    self->pcmreaders = malloc(sizeof(struct PCMReader*) * count);
+    for (i = 0; i < count; i++) {
+        struct PCMReader *reader = pcmreader_open_python(
+            PySequence_Fast_GET_ITEM(pcmreaders_seq, i));
+        if (reader == NULL) {
+            Py_DECREF(pcmreaders_seq);
+            return -1;
+        }
+        self->pcmreaders[self->count++] = reader;
+
+        if ((reader->sample_rate != self->pcmreaders[0]->sample_rate) ||
+            (reader->channels != self->pcmreaders[0]->channels) ||
+            (reader->bits_per_sample !=
+             self->pcmreaders[0]->bits_per_sample)) {
+            Py_DECREF(pcmreaders_seq);
+            PyErr_SetString(PyExc_ValueError,
+                            "all PCMReaders must have the same "
+                            "sample rate, channels and bits per sample");
+            return -1;
+        }
+    }
+    Py_DECREF(pcmreaders_seq);
+
+    if ((envelope_obj != NULL) && (envelope_obj != Py_None)) {
+        if (!envelope_init(&self->envelope, envelope_obj))
+            return -1;
+    }
+
+    if ((self->audiotools_pcm = open_audiotools_pcm()) == NULL)
+        return -1;
+
+    return 0;
+}
+
+void
+CatReader_dealloc(pcmconverter_CatReader *self)
+{
+    unsigned i;
+
+    for (i = 0; i < self->count; i++) {
+        self->pcmreaders[i]->del(self->pcmreaders[i]);
+    }
+    free(self->pcmreaders);
+    free(self->envelope.points);
+    Py_XDECREF(self->audiotools_pcm);
+
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject*
+CatReader_sample_rate(pcmconverter_CatReader *self,
+                      void *closure)
+{
+    return Py_BuildValue("I", self->pcmreaders[0]->sample_rate);
+}
+
+static PyObject*
+CatReader_bits_per_sample(pcmconverter_CatReader *self,
+                          void *closure)
+{
+    return Py_BuildValue("I", self->pcmreaders[0]->bits_per_sample);
+}
+
+static PyObject*
+CatReader_channels(pcmconverter_CatReader *self,
+                   void *closure)
+{
+    return Py_BuildValue("I", self->pcmreaders[0]->channels);
+}
+
+static PyObject*
+CatReader_channel_mask(pcmconverter_CatReader *self,
+                       void *closure)
+{
+    return Py_BuildValue("I", self->pcmreaders[0]->channel_mask);
+}
+
+static PyObject*
+CatReader_read(pcmconverter_CatReader *self, PyObject *args)
+{
+    int pcm_frames;
+    pcm_FrameList *framelist;
+    unsigned frames_read = 0;
+    const unsigned channels = self->pcmreaders[0]->channels;
+    const unsigned bits_per_sample = self->pcmreaders[0]->bits_per_sample;
+
+    if (!PyArg_ParseTuple(args, "i", &pcm_frames)) {
+        return NULL;
+    } else if (self->closed) {
+        PyErr_SetString(PyExc_ValueError, "cannot read from closed stream");
+        return NULL;
+    }
+
+    pcm_frames = MAX(pcm_frames, 1);
+
+    /*generate FrameList to populate*/
+    framelist = new_FrameList(self->audiotools_pcm,
+                              channels,
+                              bits_per_sample,
+                              pcm_frames);
+
+    /*populate FrameList from one sub-pcmreader after another
+      so that a read across a boundary between them
+      still returns as many frames as requested*/
+    while ((frames_read < (unsigned)pcm_frames) &&
+           (self->index < self->count)) {
+        struct PCMReader *reader = self->pcmreaders[self->index];
+        const int *samples;
+        const unsigned frames_acquired =
+            reader->acquire(reader, pcm_frames - frames_read, &samples);
+        unsigned frame;
+
+        if (!frames_acquired) {
+            if (reader->status != PCM_OK) {
+                Py_DECREF((PyObject*)framelist);
+                if (!PyErr_Occurred()) {
+                    PyErr_SetString(PyExc_ValueError,
+                                    "invalid FrameList from stream");
+                }
+                return NULL;
+            } else {
+                /*empty FrameList indicates the end of the stream*/
+                self->index += 1;
+                continue;
+            }
+        }
+
+        /*transfer samples to the FrameList
+          with the gain envelope applied, a chunk at a time*/
+        for (frame = 0; frame < frames_acquired; frame += CHUNK_SIZE) {
+            const unsigned chunk = MIN(frames_acquired - frame, CHUNK_SIZE);
+            const int *input = samples + (frame * channels);
+            int *output = framelist->samples +
+                          ((frames_read + frame) * channels);
+            int gains[CHUNK_SIZE];
+
+            if (envelope_gains(&self->envelope,
+                               self->position + frame,
+                               chunk,
+                               gains)) {
+                memcpy(output, input, sizeof(int) * chunk * channels);
+            } else {
+                scale_samples(output,
+                              input,
+                              channels,
+                              bits_per_sample,
+                              chunk,
+                              gains);
+            }
+        }
+
+        reader->release(reader, frames_acquired);
+        frames_read += frames_acquired;
+        self->position += frames_acquired;
+    }
+
+    framelist->frames = frames_read;
+
+    return (PyObject*)framelist;
+}
+
+static PyObject*
+CatReader_close(pcmconverter_CatReader *self, PyObject *args)
+{
+    if (!self->closed) {
+        unsigned i;
+
+        self->closed = 1;
+        for (i = 0; i < self->count; i++) {
+            self->pcmreaders[i]->close(self->pcmreaders[i]);
+        }
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static int
+envelope_init(struct envelope *envelope, PyObject *points)
+{
+    PyObject *points_seq;
+    Py_ssize_t count;
+    Py_ssize_t i;
+
+    if ((points_seq =
+         PySequence_Fast(points, "envelope must be a sequence")) == NULL)
+        return 0;
+
+    count = PySequence_Fast_GET_SIZE(points_seq);
+    envelope->points = malloc(sizeof(struct envelope_point) * MAX(count, 1));
+    envelope->count = 0;
+    envelope->next = 0;
+
+    for (i = 0; i < count; i++) {
+        PyObject *point = PySequence_Fast_GET_ITEM(points_seq, i);
+        unsigned long long pcm_frame;
+        double gain;
+
+        if (!PyTuple_Check(point)) {
+            Py_DECREF(points_seq);
+            PyErr_SetString(PyExc_TypeError,
+                            "envelope points must be (pcm_frame, gain) tuples");
+            return 0;
+        }
+        if (!PyArg_ParseTuple(point, "Kd", &pcm_frame, &gain)) {
+            Py_DECREF(points_seq);
+            return 0;
+        }
+        if ((gain < 0.0) || (gain > 1.0)) {
+            Py_DECREF(points_seq);
+            PyErr_SetString(PyExc_ValueError,
+                            "envelope gains must be between 0 and 1");
+            return 0;
+        }
+        if (i && (pcm_frame < envelope->points[i - 1].pcm_frame)) {
+            Py_DECREF(points_seq);
+            PyErr_SetString(PyExc_ValueError,
+                            "envelope PCM frames must be in order");
+            return 0;
+        }
+
+        envelope->points[i].pcm_frame = pcm_frame;
+        envelope->points[i].gain = (int)lround(gain * GAIN_UNITY);
+        envelope->count += 1;
+    }
+
+    Py_DECREF(points_seq);
+    return 1;
+}
+
+static int
+envelope_gains(struct envelope *envelope,
+               uint64_t position,
+               unsigned pcm_frames,
+               int gains[])
+{
+    const struct envelope_point *points = envelope->points;
+    int unity = 1;
+    unsigned i = 0;
+
+    if (envelope->count == 0) {
+        return 1;
+    }
+
+    while (i < pcm_frames) {
+        const uint64_t frame = position + i;
+        unsigned run;
+        unsigned j;
+
+        while ((envelope->next < envelope->count) &&
+               (points[envelope->next].pcm_frame <= frame)) {
+            envelope->next += 1;
+        }
+
+        if ((envelope->next == 0) || (envelope->next == envelope->count)) {
+            /*gain holds steady before the first point
+              and after the last*/
+            const int gain = points[envelope->next ?
+                                    envelope->count - 1 : 0].gain;
+            run = envelope->next ?
+                  pcm_frames - i :
+                  (unsigned)MIN(pcm_frames - i, points[0].pcm_frame - frame);
+            for (j = 0; j < run; j++) {
+                gains[i + j] = gain;
+            }
+            unity &= (gain == GAIN_UNITY);
+        } else {
+            /*gain ramps linearly between the points either side*/
+            const struct envelope_point *start = &points[envelope->next - 1];
+            const struct envelope_point *end = &points[envelope->next];
+            const double rise = end->gain - start->gain;
+            const double length = (double)(end->pcm_frame -
+                                           start->pcm_frame);
+
+            run = (unsigned)MIN(pcm_frames - i, end->pcm_frame - frame);
+            for (j = 0; j < run; j++) {
+                gains[i + j] = start->gain +
+                    (int)(rise * ((double)(frame + j - start->pcm_frame) /
+                                  length));
+            }
+            unity &= ((start->gain == GAIN_UNITY) &&
+                      (end->gain == GAIN_UNITY));
+        }
+
+        i += run;
+    }
+
+    return unity;
+}
+
+
 MOD_INIT(pcmconverter)
 {
     PyObject* m;
@@ -1119,6 +1604,10 @@ MOD_INIT(pcmconverter)
     if (PyType_Ready(&pcmconverter_FadeOutReaderType) < 0)
         return MOD_ERROR_VAL;
 
+    pcmconverter_CatReaderType.tp_new = PyType_GenericNew;
+    if (PyType_Ready(&pcmconverter_CatReaderType) < 0)
+        return MOD_ERROR_VAL;
+
     Py_INCREF(&pcmconverter_AveragerType);
     PyModule_AddObject(m, "Averager",
                        (PyObject *)&pcmconverter_AveragerType);
@@ -1147,5 +1636,9 @@ MOD_INIT(pcmconverter)
     PyModule_AddObject(m, "FadeOutReader",
                        (PyObject *)&pcmconverter_FadeOutReaderType);
 
+    Py_INCREF(&pcmconverter_CatReaderType);
+    PyModule_AddObject(m, "CatReader",
+                       (PyObject *)&pcmconverter_CatReaderType);
+
     return MOD_SUCCESS_VAL(m);
 }
@@ -705,3 +705,142 @@ PyTypeObject pcmconverter_FadeOutReaderType = {
     0,                         /* tp_alloc */
     FadeOutReader_new,         /* tp_new */
 };
+
+
+/*gains are fixed-point values from 0 to GAIN_UNITY*/
+#define GAIN_BITS 30
+#define GAIN_UNITY (1 << GAIN_BITS)
+
+/*a gain envelope ramping linearly from one point to the next*/
+struct envelope_point {
+    uint64_t pcm_frame;
+    int gain;
+};
+
+struct envelope {
+    struct envelope_point *points;
+    unsigned count;
+    unsigned next;  /*the first point after the most recent position*/
+};
+
+typedef struct {
+    PyObject_HEAD
+
+    int closed;
+    struct PCMReader **pcmreaders;
+    unsigned count;
+    unsigned index;             /*the reader currently being read from*/
+
+    uint64_t position;          /*PCM frames returned so far*/
+    struct envelope envelope;
+
+    PyObject *audiotools_pcm;
+} pcmconverter_CatReader;
+
+static PyObject*
+CatReader_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+
+int
+CatReader_init(pcmconverter_CatReader *self,
+               PyObject *args, PyObject *kwds);
+
+void
+CatReader_dealloc(pcmconverter_CatReader *self);
+
+static PyObject*
+CatReader_sample_rate(pcmconverter_CatReader *self,
+                      void *closure);
+
+static PyObject*
+CatReader_bits_per_sample(pcmconverter_CatReader *self,
+                          void *closure);
+
+static PyObject*
+CatReader_channels(pcmconverter_CatReader *self,
+                   void *closure);
+
+static PyObject*
+CatReader_channel_mask(pcmconverter_CatReader *self,
+                       void *closure);
+
+static PyObject*
+CatReader_read(pcmconverter_CatReader *self, PyObject *args);
+
+static PyObject*
+CatReader_close(pcmconverter_CatReader *self, PyObject *args);
+
+/*populates the envelope from a sequence of (pcm_frame, gain) tuples
+  returns 1 on success, or 0 with an exception set*/
+static int
+envelope_init(struct envelope *envelope, PyObject *points);
+
+/*places the envelope's gain for each of the "pcm_frames" starting from
+  "position" in "gains", where "position" must not precede that
+  of the previous call
+
+  returns 1 if every gain is GAIN_UNITY, in which case
+  "gains" may be left unpopulated*/
+static int
+envelope_gains(struct envelope *envelope,
+               uint64_t position,
+               unsigned pcm_frames,
+               int gains[]);
+
+PyGetSetDef CatReader_getseters[] = {
+    {"sample_rate", (getter)CatReader_sample_rate,
+     NULL, "sample rate", NULL},
+    {"bits_per_sample", (getter)CatReader_bits_per_sample,
+     NULL, "bits per sample", NULL},
+    {"channels", (getter)CatReader_channels,
+     NULL, "channels", NULL},
+    {"channel_mask", (getter)CatReader_channel_mask,
+     NULL, "channel_mask", NULL},
+    {NULL}
+};
+
+PyMethodDef CatReader_methods[] = {
+    {"read", (PyCFunction)CatReader_read, METH_VARARGS, ""},
+    {"close", (PyCFunction)CatReader_close, METH_NOARGS, ""},
+    {NULL}
+};
+
+PyTypeObject pcmconverter_CatReaderType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pcmconverter.CatReader",  /*tp_name*/
+    sizeof(pcmconverter_CatReader), /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)CatReader_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /*tp_flags*/
+    "CatReader objects",       /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    CatReader_methods,         /* tp_methods */
+    0,                         /* tp_members */
+    CatReader_getseters,       /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)CatReader_init,  /* tp_init */
+    0,                         /* tp_alloc */
+    CatReader_new,             /* tp_new */
+};
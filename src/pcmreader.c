@@ -39,8 +39,47 @@ pcmreader_##name##_del(struct PCMReader *self);
 #ifdef STANDALONE
 READER_DEFS(raw)
 READER_DEFS(error)
+
+/*lends frames from a buffer filled by the reader's own read() method*/
+static unsigned
+pcmreader_buffered_acquire(struct PCMReader *self,
+                           unsigned pcm_frames,
+                           const int **pcm_data);
+
+static void
+pcmreader_buffered_release(struct PCMReader *self, unsigned pcm_frames);
+
+/*reads planar frames by splitting the channels of lent frames*/
+static unsigned
+pcmreader_buffered_read_planar(struct PCMReader *self,
+                               unsigned pcm_frames,
+                               int *pcm_data);
 #else
 READER_DEFS(python)
+
+/*returns the FrameList most recently read from the wrapped PCMReader
+  object, reading a new one of up to "pcm_frames" if it's exhausted
+
+  returns NULL and sets the status attribute if an error occurs*/
+static pcm_FrameList*
+pcmreader_python_framelist(struct PCMReader *self, unsigned pcm_frames);
+
+/*reads planar frames from FrameLists,
+  copying channels whole from those which are planar already*/
+static unsigned
+pcmreader_python_read_planar(struct PCMReader *self,
+                             unsigned pcm_frames,
+                             int *pcm_data);
+
+/*lends frames from the FrameList most recently read
+  from the wrapped PCMReader object*/
+static unsigned
+pcmreader_python_acquire(struct PCMReader *self,
+                         unsigned pcm_frames,
+                         const int **pcm_data);
+
+static void
+pcmreader_python_release(struct PCMReader *self, unsigned pcm_frames);
 #endif
 
 
@@ -77,7 +116,15 @@ pcmreader_open_raw(FILE *file,
 
     reader->status = PCM_OK;
 
+    reader->lent.samples = NULL;
+    reader->lent.size = 0;
+    reader->lent.frames = 0;
+    reader->lent.offset = 0;
+
     reader->read = pcmreader_raw_read;
+    reader->read_planar = pcmreader_buffered_read_planar;
+    reader->acquire = pcmreader_buffered_acquire;
+    reader->release = pcmreader_buffered_release;
     reader->close = pcmreader_raw_close;
     reader->del = pcmreader_raw_del;
     return reader;
@@ -107,7 +154,15 @@ pcmreader_open_error(FILE *file,
 
     reader->status = PCM_OK;
 
+    reader->lent.samples = NULL;
+    reader->lent.size = 0;
+    reader->lent.frames = 0;
+    reader->lent.offset = 0;
+
     reader->read = pcmreader_error_read;
+    reader->read_planar = pcmreader_buffered_read_planar;
+    reader->acquire = pcmreader_buffered_acquire;
+    reader->release = pcmreader_buffered_release;
     reader->close = pcmreader_error_close;
     reader->del = pcmreader_error_del;
     return reader;
@@ -179,6 +234,9 @@ pcmreader_open_python(PyObject *obj)
     reader->status = PCM_OK;
 
     reader->read = pcmreader_python_read;
+    reader->read_planar = pcmreader_python_read_planar;
+    reader->acquire = pcmreader_python_acquire;
+    reader->release = pcmreader_python_release;
     reader->close = pcmreader_python_close;
     reader->del = pcmreader_python_del;
     return reader;
@@ -275,6 +333,7 @@ pcmreader_raw_close(struct PCMReader *self)
 static void
 pcmreader_raw_del(struct PCMReader *self)
 {
+    free(self->lent.samples);
     free(self);
 }
 
@@ -328,9 +387,77 @@ pcmreader_error_close(struct PCMReader *self)
 static void
 pcmreader_error_del(struct PCMReader *self)
 {
+    free(self->lent.samples);
     free(self);
 }
 
+static unsigned
+pcmreader_buffered_acquire(struct PCMReader *self,
+                           unsigned pcm_frames,
+                           const int **pcm_data)
+{
+    if (!self->lent.frames) {
+        /*buffer exhausted, so refill it from the reader*/
+        if (pcm_frames > self->lent.size) {
+            self->lent.size = pcm_frames;
+            self->lent.samples = realloc(self->lent.samples,
+                                         sizeof(int) *
+                                         self->channels *
+                                         self->lent.size);
+        }
+        self->lent.offset = 0;
+        self->lent.frames = self->read(self, pcm_frames, self->lent.samples);
+    }
+
+    *pcm_data = self->lent.samples + (self->lent.offset * self->channels);
+    return MIN(self->lent.frames, pcm_frames);
+}
+
+static void
+pcmreader_buffered_release(struct PCMReader *self, unsigned pcm_frames)
+{
+    self->lent.frames -= pcm_frames;
+    self->lent.offset += pcm_frames;
+}
+
+static unsigned
+pcmreader_buffered_read_planar(struct PCMReader *self,
+                               unsigned pcm_frames,
+                               int *pcm_data)
+{
+    unsigned frames_read = 0;
+
+    while (frames_read < pcm_frames) {
+        const int *samples;
+        const unsigned frames_acquired =
+            pcmreader_buffered_acquire(self,
+                                       pcm_frames - frames_read,
+                                       &samples);
+        unsigned c;
+
+        if (!frames_acquired) {
+            if (self->status != PCM_OK) {
+                return 0;
+            } else {
+                break;
+            }
+        }
+
+        for (c = 0; c < self->channels; c++) {
+            get_channel_data(samples,
+                             c,
+                             self->channels,
+                             frames_acquired,
+                             pcm_data + (c * pcm_frames) + frames_read);
+        }
+
+        pcmreader_buffered_release(self, frames_acquired);
+        frames_read += frames_acquired;
+    }
+
+    return frames_read;
+}
+
 #else
 
 static unsigned
@@ -339,69 +466,157 @@ pcmreader_python_read(struct PCMReader *self,
                       int *pcm_data)
 {
     const unsigned initial_frames = pcm_frames;
-    int stream_finished = 0;
 
-    while (pcm_frames && !stream_finished) {
-        unsigned to_transfer;
-        pcm_FrameList *framelist;
+    while (pcm_frames) {
+        const int *samples;
+        const unsigned frames_acquired =
+            pcmreader_python_acquire(self, pcm_frames, &samples);
+        if (!frames_acquired && (self->status != PCM_OK)) {
+            return 0;
+        }
 
-        if (self->input.python.framelist) {
-            framelist = self->input.python.framelist;
+        /*transfer data from FrameList to buffer*/
+        memcpy(pcm_data,
+               samples,
+               sizeof(int) * self->channels * frames_acquired);
+        pcmreader_python_release(self, frames_acquired);
+
+        if (frames_acquired) {
+            /*advance buffer*/
+            pcm_frames -= frames_acquired;
+            pcm_data += (frames_acquired * self->channels);
         } else {
-            PyObject *framelist_obj;
-
-            /*need to read a new framelist from wrapped PCMReader*/
-            if ((framelist_obj =
-                 PyObject_CallMethod(self->input.python.obj,
-                                     "read", "i", pcm_frames)) == NULL) {
-                /*ensure result isn't an exception*/
-                self->status = PCM_READ_ERROR;
-                return 0;
-            }
+            /*empty FrameList indicates the end of the stream*/
+            break;
+        }
+    }
+
+    return initial_frames - pcm_frames;
+}
+
+static pcm_FrameList*
+pcmreader_python_framelist(struct PCMReader *self, unsigned pcm_frames)
+{
+    PyObject *framelist_obj;
+    pcm_FrameList *framelist;
+
+    if (self->input.python.framelist) {
+        return self->input.python.framelist;
+    }
+
+    /*need to read a new framelist from wrapped PCMReader*/
+    if ((framelist_obj =
+         PyObject_CallMethod(self->input.python.obj,
+                             "read", "i", pcm_frames)) == NULL) {
+        /*ensure result isn't an exception*/
+        self->status = PCM_READ_ERROR;
+        return NULL;
+    }
+
+    /*ensure result is a pcm.FrameList object*/
+    if (Py_TYPE(framelist_obj) ==
+        (PyTypeObject*)self->input.python.framelist_type) {
+        framelist = (pcm_FrameList*)framelist_obj;
+    } else {
+        self->status = PCM_NON_FRAMELIST;
+        Py_DECREF(framelist_obj);
+        return NULL;
+    }
+
+    /*ensure FrameList object matches stream's parameters*/
+    if ((framelist->channels != self->channels) ||
+        (framelist->bits_per_sample != self->bits_per_sample)) {
+        self->status = PCM_INVALID_FRAMELIST;
+        Py_DECREF(framelist_obj);
+        return NULL;
+    }
+
+    self->input.python.framelist = framelist;
+    self->input.python.frames_remaining = framelist->frames;
+    return framelist;
+}
+
+static unsigned
+pcmreader_python_read_planar(struct PCMReader *self,
+                             unsigned pcm_frames,
+                             int *pcm_data)
+{
+    unsigned frames_read = 0;
+
+    while (frames_read < pcm_frames) {
+        pcm_FrameList *framelist =
+            pcmreader_python_framelist(self, pcm_frames - frames_read);
+        unsigned offset;
+        unsigned frames;
+        unsigned c;
+
+        if (framelist == NULL) {
+            return 0;
+        }
+
+        offset = framelist->frames - self->input.python.frames_remaining;
+        frames = MIN(self->input.python.frames_remaining,
+                     pcm_frames - frames_read);
+
+        for (c = 0; c < self->channels; c++) {
+            int *channel_data = pcm_data + (c * pcm_frames) + frames_read;
 
-            /*ensure result is a pcm.FrameList object*/
-            if (Py_TYPE(framelist_obj) ==
-                (PyTypeObject*)self->input.python.framelist_type) {
-                framelist = (pcm_FrameList*)framelist_obj;
+            if (framelist->planar) {
+                memcpy(channel_data,
+                       FrameList_planar_channel(framelist, c) + offset,
+                       sizeof(int) * frames);
             } else {
-                self->status = PCM_NON_FRAMELIST;
-                Py_DECREF(framelist_obj);
-                return 0;
+                get_channel_data(framelist->samples +
+                                 (offset * self->channels),
+                                 c,
+                                 self->channels,
+                                 frames,
+                                 channel_data);
             }
+        }
 
-            /*ensure FrameList object matches stream's parameters*/
-            if ((framelist->channels != self->channels) ||
-                (framelist->bits_per_sample != self->bits_per_sample)) {
-                self->status = PCM_INVALID_FRAMELIST;
-                Py_DECREF(framelist_obj);
-                return 0;
-            }
+        pcmreader_python_release(self, frames);
 
-            stream_finished = (framelist->frames == 0);
-            self->input.python.framelist = framelist;
-            self->input.python.frames_remaining = framelist->frames;
+        if (frames) {
+            frames_read += frames;
+        } else {
+            /*empty FrameList indicates the end of the stream*/
+            break;
         }
+    }
 
-        /*transfer data from FrameList to buffer*/
-        to_transfer = MIN(self->input.python.frames_remaining, pcm_frames);
+    return frames_read;
+}
 
-        memcpy(pcm_data,
-               framelist->samples +
-               (framelist->channels *
-                (framelist->frames - self->input.python.frames_remaining)),
-               sizeof(int) * framelist->channels * to_transfer);
-
-        /*advance buffers*/
-        pcm_frames -= to_transfer;
-        pcm_data += (to_transfer * framelist->channels);
-        if ((self->input.python.frames_remaining -= to_transfer) == 0) {
-            /*and remove FrameList if we've exhausted it*/
-            Py_DECREF((PyObject*)self->input.python.framelist);
-            self->input.python.framelist = NULL;
-        }
+static unsigned
+pcmreader_python_acquire(struct PCMReader *self,
+                         unsigned pcm_frames,
+                         const int **pcm_data)
+{
+    pcm_FrameList *framelist = pcmreader_python_framelist(self, pcm_frames);
+
+    if (framelist == NULL) {
+        return 0;
     }
 
-    return initial_frames - pcm_frames;
+    /*lend the FrameList's own samples, which it keeps alive,
+      in interleaved order*/
+    FrameList_interleave(framelist);
+    *pcm_data = framelist->samples +
+                (framelist->channels *
+                 (framelist->frames - self->input.python.frames_remaining));
+    return MIN(self->input.python.frames_remaining, pcm_frames);
+}
+
+static void
+pcmreader_python_release(struct PCMReader *self, unsigned pcm_frames)
+{
+    if (self->input.python.framelist &&
+        ((self->input.python.frames_remaining -= pcm_frames) == 0)) {
+        /*remove FrameList once it's been exhausted*/
+        Py_DECREF((PyObject*)self->input.python.framelist);
+        self->input.python.framelist = NULL;
+    }
 }
 
 static void
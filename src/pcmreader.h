@@ -58,6 +58,16 @@ struct PCMReader {
         #endif
     } input;
 
+    #ifdef STANDALONE
+    /*frames read in advance which are lent out by acquire()*/
+    struct {
+        int *samples;
+        unsigned size;       /*allocated size of samples, in PCM frames*/
+        unsigned frames;     /*PCM frames remaining to be lent*/
+        unsigned offset;     /*PCM frame offset of the next frame to lend*/
+    } lent;
+    #endif
+
     unsigned sample_rate;
     unsigned channels;
     unsigned channel_mask;
@@ -84,6 +94,50 @@ struct PCMReader {
                      unsigned pcm_frames,
                      int *pcm_data);
 
+    /*reads up to the given number of PCM frames
+      from this reader to the data array in planar order,
+      every frame of channel 0 followed by every frame of channel 1
+      and so on, where each channel starts "pcm_frames" entries
+      after the previous one regardless of how many are actually read
+
+      the data array must be at least:
+
+      pcm_frames * channels
+
+      long in order to hold the returned data
+
+      returns the amount of frames actually read
+      which is less than the number requested
+      only at the end of the stream
+
+      if an error occurs during reading, 0 is returned
+      and the status attribute is set to an error code*/
+    unsigned (*read_planar)(struct PCMReader *self,
+                            unsigned pcm_frames,
+                            int *pcm_data);
+
+    /*lends up to the given number of PCM frames
+      directly from this reader's internal buffer
+      by placing a pointer to them in "pcm_data"
+
+      the samples are interleaved as with read()
+      and remain valid until the next call to release(),
+      which must be made before any other reads
+
+      returns the amount of frames actually lent
+      which may be less than the number requested
+
+      if an error occurs during reading, 0 is returned
+      and the status attribute is set to an error code*/
+    unsigned (*acquire)(struct PCMReader *self,
+                        unsigned pcm_frames,
+                        const int **pcm_data);
+
+    /*returns the first "pcm_frames" of the most recently acquired frames,
+      which must be no more than the amount acquired,
+      any remaining frames are lent again by the next call to acquire()*/
+    void (*release)(struct PCMReader *self, unsigned pcm_frames);
+
     /*forwards a call to "close" to the wrapped PCMReader object*/
     void (*close)(struct PCMReader *self);
 
@@ -259,6 +259,7 @@ ReplayGain_update(replaygain_ReplayGain *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "O!", self->framelist_type, &framelist))
         return NULL;
 
+    FrameList_interleave(framelist);
     peak_shift = 1 << (framelist->bits_per_sample - 1);
     total_frames = framelist->frames;
     samples = framelist->samples;
@@ -923,37 +924,36 @@ ReplayGainReader_read(replaygain_ReplayGainReader* self, PyObject *args) {
         const int min_value = -(1 << (self->pcmreader->bits_per_sample - 1));
         const double multiplier = self->multiplier;
 
-        pcm_FrameList *framelist = new_FrameList(
-            self->audiotools_pcm,
-            self->pcmreader->channels,
-            self->pcmreader->bits_per_sample,
-            pcm_frames);
-
+        const int *pcm_data;
         const unsigned frames_read =
-            self->pcmreader->read(self->pcmreader,
-                                  pcm_frames,
-                                  framelist->samples);
+            self->pcmreader->acquire(self->pcmreader,
+                                     (unsigned)pcm_frames,
+                                     &pcm_data);
         const unsigned total_samples =
             frames_read * self->pcmreader->channels;
+        pcm_FrameList *framelist;
         unsigned i;
 
         if (!frames_read && (self->pcmreader->status != PCM_OK)) {
-            Py_DECREF((PyObject*)framelist);
             return NULL;
-        } else {
-            framelist->frames = frames_read;
         }
 
-        /*apply our multiplier to framelist's integer samples
+        framelist = new_FrameList(self->audiotools_pcm,
+                                  self->pcmreader->channels,
+                                  self->pcmreader->bits_per_sample,
+                                  frames_read);
+
+        /*apply our multiplier to the borrowed integer samples
           and apply dithering*/
         for (i = 0; i < total_samples; i++) {
+            const int sample = (int)lround(pcm_data[i] * multiplier);
             framelist->samples[i] =
-                (int)lround(framelist->samples[i] * multiplier);
-            framelist->samples[i] =
-                (MIN(MAX(framelist->samples[i], min_value), max_value) ^
+                (MIN(MAX(sample, min_value), max_value) ^
                  self->white_noise->read(self->white_noise, 1));
         }
 
+        self->pcmreader->release(self->pcmreader, frames_read);
+
         /*return integer samples as a new FrameList object*/
         return (PyObject*)framelist;
     }
@@ -30,6 +30,10 @@
 #include "float_cast.h"
 #include "common.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define	SINC_MAGIC_MARKER	MAKE_MAGIC (' ', 's', 'i', 'n', 'c', ' ')
 
 /*========================================================================================
@@ -69,6 +73,9 @@ typedef struct
 	/* Sure hope noone does more than 128 channels at once. */
 	double left_calc [128], right_calc [128] ;
 
+	/* Both halves' interpolated coefficients for the current output sample. */
+	double	*icoeffs ;
+
 	/* C99 struct flexible array. */
 	float	buffer [] ;
 } SINC_FILTER ;
@@ -155,7 +162,8 @@ int
 sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
 {	SINC_FILTER *filter, temp_filter ;
 	increment_t count ;
-	int bits ;
+	size_t icoeffs_offset ;
+	int bits, icoeffs_len ;
 
 	/* Quick sanity check. */
 	if (SHIFT_BITS >= sizeof (increment_t) * 8 - 1)
@@ -230,12 +238,22 @@ sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
 	temp_filter.b_len = MAX (temp_filter.b_len, 4096) ;
 	temp_filter.b_len *= temp_filter.channels ;
 
-	if ((filter = calloc (1, sizeof (SINC_FILTER) + sizeof (filter->buffer [0]) * (temp_filter.b_len + temp_filter.channels))) == NULL)
+	/*
+	** Room for both halves' coefficients at the lowest ratio allowed,
+	** kept after the buffer so the filter is still freed in one go.
+	*/
+	icoeffs_offset = sizeof (SINC_FILTER) + sizeof (filter->buffer [0]) * (temp_filter.b_len + temp_filter.channels) ;
+	icoeffs_offset = (icoeffs_offset + sizeof (double) - 1) / sizeof (double) * sizeof (double) ;
+	icoeffs_len = 2 * ((int) lrint ((temp_filter.coeff_half_len + 2.0) * SRC_MAX_RATIO / temp_filter.index_inc) + 4) ;
+
+	if ((filter = calloc (1, icoeffs_offset + sizeof (double) * icoeffs_len)) == NULL)
 		return SRC_ERR_MALLOC_FAILED ;
 
 	*filter = temp_filter ;
 	memset (&temp_filter, 0xEE, sizeof (temp_filter)) ;
 
+	filter->icoeffs = (double *) ((char *) filter + icoeffs_offset) ;
+
 	psrc->private_data = filter ;
 
 	sinc_reset (psrc) ;
@@ -273,56 +291,150 @@ sinc_reset (SRC_PRIVATE *psrc)
 **	Beware all ye who dare pass this point. There be dragons here.
 */
 
-static inline double
-calc_output_single (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index)
-{	double		fraction, left, right, icoeff ;
-	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
+/*
+**	Each half of the filter is walked exactly as the scalar loops walked it,
+**	from its outermost coefficient inwards, accumulating in double precision
+**	in the same order so that the output is unchanged. SSE2 interpolates two
+**	coefficients at a time into filter->icoeffs and applies them to a pair of
+**	channels at a time, each channel keeping its own running sum.
+*/
+
+/* Finds the filter index, coefficient count and first buffer index of each
+** half, both walked with the filter index falling by "increment" per sample.
+** The left half's buffer index rises by the channel count per sample and the
+** right half's falls by it.
+*/
+static inline void
+calc_halves (const SINC_FILTER *filter, increment_t increment, increment_t start_filter_index,
+			increment_t * left_index, int * left_len, int * left_data,
+			increment_t * right_index, int * right_len, int * right_data)
+{	increment_t	filter_index, max_filter_index ;
+	int			coeff_count ;
 
 	/* Convert input parameters into fixed point. */
 	max_filter_index = int_to_fp (filter->coeff_half_len) ;
 
-	/* First apply the left half of the filter. */
+	/* The left half runs while the filter index is at least zero. */
 	filter_index = start_filter_index ;
 	coeff_count = (max_filter_index - filter_index) / increment ;
 	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - coeff_count ;
+	*left_index = filter_index ;
+	*left_len = filter_index / increment + 1 ;
+	*left_data = filter->b_current - filter->channels * coeff_count ;
 
-	left = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+	/* The right half runs while the filter index is above zero,
+	** but at least once. */
+	filter_index = increment - start_filter_index ;
+	coeff_count = (max_filter_index - filter_index) / increment ;
+	filter_index = filter_index + coeff_count * increment ;
+	*right_index = filter_index ;
+	*right_len = MAX ((filter_index + increment - 1) / increment, 1) ;
+	*right_data = filter->b_current + filter->channels * (1 + coeff_count) ;
+} /* calc_halves */
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+static inline double
+interpolate_coeff (const SINC_FILTER *filter, increment_t filter_index)
+{	double		fraction ;
+	int			indx ;
+
+	fraction = fp_to_double (filter_index) ;
+	indx = fp_to_int (filter_index) ;
+
+	return filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+} /* interpolate_coeff */
+
+#ifdef __SSE2__
+/* Loads two consecutive floats. */
+static inline __m128
+load_floats (const float * x)
+{	return _mm_castsi128_ps (_mm_loadl_epi64 ((const __m128i *) x)) ;
+} /* load_floats */
+
+/* Interpolates the coefficients at filter_index and filter_index - increment
+** as interpolate_coeff does, taking each difference in single precision. */
+static inline __m128d
+interpolate_pair (const SINC_FILTER *filter, increment_t filter_index, increment_t increment)
+{	__m128		pairs, fraction_ps ;
+	__m128d		fraction ;
+
+	/* first coefficients in the low two lanes, second coefficients above */
+	pairs = _mm_unpacklo_ps (load_floats (filter->coeffs + fp_to_int (filter_index)),
+							load_floats (filter->coeffs + fp_to_int (filter_index - increment))) ;
+	fraction_ps = _mm_sub_ps (_mm_movehl_ps (pairs, pairs), pairs) ;
+	fraction = _mm_mul_pd (_mm_cvtepi32_pd (_mm_set_epi32 (0, 0, fp_fraction_part (filter_index - increment), fp_fraction_part (filter_index))),
+							_mm_set1_pd (INV_FP_ONE)) ;
+
+	return _mm_add_pd (_mm_cvtps_pd (pairs), _mm_mul_pd (fraction, _mm_cvtps_pd (fraction_ps))) ;
+} /* interpolate_pair */
+#endif
 
-		left += icoeff * filter->buffer [data_index] ;
+static inline void
+interpolate_coeffs (const SINC_FILTER *filter, increment_t filter_index, increment_t increment, int count, double * icoeffs)
+{	int			k = 0 ;
 
+#ifdef __SSE2__
+	for ( ; k + 2 <= count ; k += 2)
+	{	_mm_storeu_pd (icoeffs + k, interpolate_pair (filter, filter_index, increment)) ;
+		filter_index -= 2 * increment ;
+		} ;
+#endif
+
+	for ( ; k < count ; k++)
+	{	icoeffs [k] = interpolate_coeff (filter, filter_index) ;
 		filter_index -= increment ;
-		data_index = data_index + 1 ;
-		}
-	while (filter_index >= MAKE_INCREMENT_T (0)) ;
+		} ;
+} /* interpolate_coeffs */
 
-	/* Now apply the right half of the filter. */
-	filter_index = increment - start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + 1 + coeff_count ;
+/* Sums each channel's samples weighted by the coefficients in order,
+** stepping "stride" floats through the buffer per coefficient. */
+static inline void
+convolve (const double * icoeffs, int count, const float * data, int stride, int channels, double * result)
+{	const float	*x ;
+	int			k, ch = 0 ;
 
-	right = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
+#ifdef __SSE2__
+	for ( ; ch + 2 <= channels ; ch += 2)
+	{	__m128d		acc = _mm_setzero_pd () ;
 
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
+		for (k = 0, x = data + ch ; k < count ; k++, x += stride)
+			acc = _mm_add_pd (acc, _mm_mul_pd (_mm_set1_pd (icoeffs [k]), _mm_cvtps_pd (load_floats (x)))) ;
 
-		right += icoeff * filter->buffer [data_index] ;
+		_mm_storeu_pd (result + ch, acc) ;
+		} ;
+#endif
 
-		filter_index -= increment ;
-		data_index = data_index - 1 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+	for ( ; ch < channels ; ch++)
+	{	result [ch] = 0.0 ;
+		for (k = 0, x = data + ch ; k < count ; k++, x += stride)
+			result [ch] += icoeffs [k] * x [0] ;
+		} ;
+} /* convolve */
+
+/* Applies each half of the filter to every channel,
+** leaving the sums in filter->left_calc and filter->right_calc. */
+static inline void
+calc_output_channels (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index)
+{	increment_t	left_index, right_index ;
+	int			left_len, left_data, right_len, right_data ;
+
+	calc_halves (filter, increment, start_filter_index,
+				&left_index, &left_len, &left_data, &right_index, &right_len, &right_data) ;
+
+	interpolate_coeffs (filter, left_index, increment, left_len, filter->icoeffs) ;
+	interpolate_coeffs (filter, right_index, increment, right_len, filter->icoeffs + left_len) ;
+
+	convolve (filter->icoeffs, left_len, filter->buffer + left_data, filter->channels,
+				filter->channels, filter->left_calc) ;
+	convolve (filter->icoeffs + left_len, right_len, filter->buffer + right_data, -filter->channels,
+				filter->channels, filter->right_calc) ;
+} /* calc_output_channels */
 
-	return (left + right) ;
+static inline double
+calc_output_single (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index)
+{
+	calc_output_channels (filter, increment, start_filter_index) ;
+
+	return (filter->left_calc [0] + filter->right_calc [0]) ;
 } /* calc_output_single */
 
 static int
@@ -421,57 +533,11 @@ sinc_mono_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 static inline void
 calc_output_stereo (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [2], right [2], icoeff ;
-	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
-
-	/* Convert input parameters into fixed point. */
-	max_filter_index = int_to_fp (filter->coeff_half_len) ;
-
-	/* First apply the left half of the filter. */
-	filter_index = start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
-
-	left [0] = left [1] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		left [0] += icoeff * filter->buffer [data_index] ;
-		left [1] += icoeff * filter->buffer [data_index + 1] ;
-
-		filter_index -= increment ;
-		data_index = data_index + 2 ;
-		}
-	while (filter_index >= MAKE_INCREMENT_T (0)) ;
-
-	/* Now apply the right half of the filter. */
-	filter_index = increment - start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
-
-	right [0] = right [1] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
-
-		filter_index -= increment ;
-		data_index = data_index - 2 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+{
+	calc_output_channels (filter, increment, start_filter_index) ;
 
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
+	output [0] = scale * (filter->left_calc [0] + filter->right_calc [0]) ;
+	output [1] = scale * (filter->left_calc [1] + filter->right_calc [1]) ;
 } /* calc_output_stereo */
 
 static int
@@ -569,63 +635,13 @@ sinc_stereo_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 static inline void
 calc_output_quad (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [4], right [4], icoeff ;
-	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
-
-	/* Convert input parameters into fixed point. */
-	max_filter_index = int_to_fp (filter->coeff_half_len) ;
-
-	/* First apply the left half of the filter. */
-	filter_index = start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
-
-	left [0] = left [1] = left [2] = left [3] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		left [0] += icoeff * filter->buffer [data_index] ;
-		left [1] += icoeff * filter->buffer [data_index + 1] ;
-		left [2] += icoeff * filter->buffer [data_index + 2] ;
-		left [3] += icoeff * filter->buffer [data_index + 3] ;
-
-		filter_index -= increment ;
-		data_index = data_index + 4 ;
-		}
-	while (filter_index >= MAKE_INCREMENT_T (0)) ;
-
-	/* Now apply the right half of the filter. */
-	filter_index = increment - start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
-
-	right [0] = right [1] = right [2] = right [3] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
-		right [2] += icoeff * filter->buffer [data_index + 2] ;
-		right [3] += icoeff * filter->buffer [data_index + 3] ;
-
-		filter_index -= increment ;
-		data_index = data_index - 4 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
+{
+	calc_output_channels (filter, increment, start_filter_index) ;
 
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
-	output [2] = scale * (left [2] + right [2]) ;
-	output [3] = scale * (left [3] + right [3]) ;
+	output [0] = scale * (filter->left_calc [0] + filter->right_calc [0]) ;
+	output [1] = scale * (filter->left_calc [1] + filter->right_calc [1]) ;
+	output [2] = scale * (filter->left_calc [2] + filter->right_calc [2]) ;
+	output [3] = scale * (filter->left_calc [3] + filter->right_calc [3]) ;
 } /* calc_output_quad */
 
 static int
@@ -723,69 +739,15 @@ sinc_quad_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 static inline void
 calc_output_hex (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, double scale, float * output)
-{	double		fraction, left [6], right [6], icoeff ;
-	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx ;
-
-	/* Convert input parameters into fixed point. */
-	max_filter_index = int_to_fp (filter->coeff_half_len) ;
-
-	/* First apply the left half of the filter. */
-	filter_index = start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - filter->channels * coeff_count ;
-
-	left [0] = left [1] = left [2] = left [3] = left [4] = left [5] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		left [0] += icoeff * filter->buffer [data_index] ;
-		left [1] += icoeff * filter->buffer [data_index + 1] ;
-		left [2] += icoeff * filter->buffer [data_index + 2] ;
-		left [3] += icoeff * filter->buffer [data_index + 3] ;
-		left [4] += icoeff * filter->buffer [data_index + 4] ;
-		left [5] += icoeff * filter->buffer [data_index + 5] ;
-
-		filter_index -= increment ;
-		data_index = data_index + 6 ;
-		}
-	while (filter_index >= MAKE_INCREMENT_T (0)) ;
-
-	/* Now apply the right half of the filter. */
-	filter_index = increment - start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + filter->channels * (1 + coeff_count) ;
-
-	right [0] = right [1] = right [2] = right [3] = right [4] = right [5] = 0.0 ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		right [0] += icoeff * filter->buffer [data_index] ;
-		right [1] += icoeff * filter->buffer [data_index + 1] ;
-		right [2] += icoeff * filter->buffer [data_index + 2] ;
-		right [3] += icoeff * filter->buffer [data_index + 3] ;
-		right [4] += icoeff * filter->buffer [data_index + 4] ;
-		right [5] += icoeff * filter->buffer [data_index + 5] ;
-
-		filter_index -= increment ;
-		data_index = data_index - 6 ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
-
-	output [0] = scale * (left [0] + right [0]) ;
-	output [1] = scale * (left [1] + right [1]) ;
-	output [2] = scale * (left [2] + right [2]) ;
-	output [3] = scale * (left [3] + right [3]) ;
-	output [4] = scale * (left [4] + right [4]) ;
-	output [5] = scale * (left [5] + right [5]) ;
+{
+	calc_output_channels (filter, increment, start_filter_index) ;
+
+	output [0] = scale * (filter->left_calc [0] + filter->right_calc [0]) ;
+	output [1] = scale * (filter->left_calc [1] + filter->right_calc [1]) ;
+	output [2] = scale * (filter->left_calc [2] + filter->right_calc [2]) ;
+	output [3] = scale * (filter->left_calc [3] + filter->right_calc [3]) ;
+	output [4] = scale * (filter->left_calc [4] + filter->right_calc [4]) ;
+	output [5] = scale * (filter->left_calc [5] + filter->right_calc [5]) ;
 } /* calc_output_hex */
 
 static int
@@ -883,156 +845,12 @@ sinc_hex_vari_process (SRC_PRIVATE *psrc, SRC_DATA *data)
 
 static inline void
 calc_output_multi (SINC_FILTER *filter, increment_t increment, increment_t start_filter_index, int channels, double scale, float * output)
-{	double		fraction, icoeff ;
-	/* The following line is 1999 ISO Standard C. If your compiler complains, get a better compiler. */
-	double		*left, *right ;
-	increment_t	filter_index, max_filter_index ;
-	int			data_index, coeff_count, indx, ch ;
-
-	left = filter->left_calc ;
-	right = filter->right_calc ;
-
-	/* Convert input parameters into fixed point. */
-	max_filter_index = int_to_fp (filter->coeff_half_len) ;
-
-	/* First apply the left half of the filter. */
-	filter_index = start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current - channels * coeff_count ;
-
-	memset (left, 0, sizeof (left [0]) * channels) ;
+{	int			ch ;
 
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		/*
-		**	Duff's Device.
-		**	See : http://en.wikipedia.org/wiki/Duff's_device
-		*/
-		ch = channels ;
-		do
-		{
-			switch (ch % 8)
-			{	default :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 7 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 6 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 5 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 4 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 3 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 2 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 1 :
-					ch -- ;
-					left [ch] += icoeff * filter->buffer [data_index + ch] ;
-				} ;
-			}
-		while (ch > 0) ;
-
-		filter_index -= increment ;
-		data_index = data_index + channels ;
-		}
-	while (filter_index >= MAKE_INCREMENT_T (0)) ;
-
-	/* Now apply the right half of the filter. */
-	filter_index = increment - start_filter_index ;
-	coeff_count = (max_filter_index - filter_index) / increment ;
-	filter_index = filter_index + coeff_count * increment ;
-	data_index = filter->b_current + channels * (1 + coeff_count) ;
-
-	memset (right, 0, sizeof (right [0]) * channels) ;
-	do
-	{	fraction = fp_to_double (filter_index) ;
-		indx = fp_to_int (filter_index) ;
-
-		icoeff = filter->coeffs [indx] + fraction * (filter->coeffs [indx + 1] - filter->coeffs [indx]) ;
-
-		ch = channels ;
-		do
-		{
-			switch (ch % 8)
-			{	default :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 7 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 6 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 5 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 4 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 3 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 2 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				case 1 :
-					ch -- ;
-					right [ch] += icoeff * filter->buffer [data_index + ch] ;
-				} ;
-			}
-		while (ch > 0) ;
-
-		filter_index -= increment ;
-		data_index = data_index - channels ;
-		}
-	while (filter_index > MAKE_INCREMENT_T (0)) ;
-
-	ch = channels ;
-	do
-	{
-		switch (ch % 8)
-		{	default :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 7 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 6 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 5 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 4 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 3 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 2 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			case 1 :
-				ch -- ;
-				output [ch] = scale * (left [ch] + right [ch]) ;
-			} ;
-		}
-	while (ch > 0) ;
+	calc_output_channels (filter, increment, start_filter_index) ;
 
-	return ;
+	for (ch = 0 ; ch < channels ; ch++)
+		output [ch] = scale * (filter->left_calc [ch] + filter->right_calc [ch]) ;
 } /* calc_output_multi */
 
 static int
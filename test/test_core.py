@@ -212,6 +212,86 @@ class PCMCat(unittest.TestCase):
         for r in main_readers:
             self.assertRaises(ValueError, r.read, 2)
 
+    @LIB_PCM
+    def test_envelope(self):
+        from audiotools.pcm import from_list
+
+        def constant_reader(value, pcm_frames, channels, bits_per_sample):
+            return audiotools.PCMFileReader(
+                BytesIO(from_list([value] * (pcm_frames * channels),
+                                  channels,
+                                  bits_per_sample,
+                                  True).to_bytes(False, True)),
+                sample_rate=44100,
+                channels=channels,
+                channel_mask=0,
+                bits_per_sample=bits_per_sample,
+                signed=True,
+                big_endian=False)
+
+        def gain(envelope, pcm_frame):
+            if pcm_frame <= envelope[0][0]:
+                return envelope[0][1]
+            for ((start, start_gain),
+                 (end, end_gain)) in zip(envelope, envelope[1:]):
+                if start <= pcm_frame < end:
+                    return (start_gain +
+                            (end_gain - start_gain) *
+                            float(pcm_frame - start) / (end - start))
+            return envelope[-1][1]
+
+        # a dip down and back up across the boundaries
+        # of three 30 frame segments, beginning with a fade in
+        envelope = [(0, 0.0), (10, 1.0),
+                    (25, 1.0), (30, 0.0), (35, 1.0),
+                    (55, 1.0), (60, 0.5), (70, 0.5), (90, 0.0)]
+
+        for (channels, bits_per_sample, value) in [(1, 16, -32768),
+                                                   (2, 16, 32767),
+                                                   (3, 16, 1000),
+                                                   (2, 24, -8388608),
+                                                   (2, 8, 127)]:
+            reader = audiotools.PCMCat(
+                [constant_reader(value, 30, channels, bits_per_sample)
+                 for i in range(3)],
+                envelope)
+
+            # reads span segment boundaries
+            # and return as many frames as requested
+            framelists = []
+            f = reader.read(7)
+            while len(f) > 0:
+                self.assertEqual(f.channels, channels)
+                self.assertEqual(f.bits_per_sample, bits_per_sample)
+                framelists.append(f)
+                f = reader.read(7)
+            reader.close()
+            self.assertEqual([f.frames for f in framelists],
+                             [7] * 12 + [6])
+
+            samples = [f.frame(i) for f in framelists for i in range(f.frames)]
+            for (pcm_frame, frame) in enumerate(samples):
+                for sample in frame:
+                    self.assertLessEqual(
+                        abs(sample - value * gain(envelope, pcm_frame)), 1)
+
+        # without an envelope, samples pass through unchanged
+        reader = audiotools.PCMCat(
+            [constant_reader(-5, 10, 2, 16), constant_reader(5, 10, 2, 16)])
+        self.assertEqual(list(reader.read(4096)), [-5] * 20 + [5] * 20)
+        reader.close()
+
+        # envelopes must be in order with gains from 0 to 1
+        for envelope in [[(10, 1.0), (5, 0.0)],
+                         [(0, -0.5)],
+                         [(0, 1.5)],
+                         [(0, )],
+                         [10]]:
+            self.assertRaises((ValueError, TypeError),
+                              audiotools.PCMCat,
+                              [constant_reader(1, 10, 1, 16)],
+                              envelope)
+
 
 class BufferedPCMReader(unittest.TestCase):
     @LIB_PCM
@@ -861,6 +941,47 @@ class PCMConverter(unittest.TestCase):
                 # when converter is closed
                 self.assertRaises(ValueError, main_reader.read, 4096)
 
+    @LIB_PCM
+    def test_resample_quality(self):
+        from audiotools.pcmconverter import Resampler
+
+        def resampled(pcmreader):
+            frames = []
+            f = pcmreader.read(4096)
+            while len(f) > 0:
+                frames.extend(f.channel(0))
+                f = pcmreader.read(4096)
+            pcmreader.close()
+            return frames
+
+        self.assertRaises(ValueError,
+                          Resampler,
+                          test_streams.Sine16_Mono(44100, 44100,
+                                                   441.0, 0.50, 0.0, 0.0),
+                          48000,
+                          "bogus")
+
+        # every quality should produce about the same amount of output
+        # which for a low tone should differ only slightly
+        best = resampled(audiotools.PCMConverter(
+            test_streams.Sine16_Mono(44100, 44100, 441.0, 0.50, 0.0, 0.0),
+            48000, 1, 0x4, 16))
+        self.assertEqual(len(best), 48000)
+
+        for quality in audiotools.RESAMPLE_QUALITIES:
+            for (channels, channel_mask) in [(1, 0x4), (2, 0x3), (6, 0x3F)]:
+                converted = resampled(audiotools.PCMConverter(
+                    test_streams.Sine16_Mono(44100, 44100,
+                                             441.0, 0.50, 0.0, 0.0),
+                    48000,
+                    channels,
+                    channel_mask,
+                    16,
+                    resample_quality=quality))
+                self.assertLessEqual(abs(len(converted) - len(best)), 1)
+                self.assertLess(max([abs(x - y) for (x, y) in
+                                     zip(converted, best)]), 64)
+
 
 class Test_ReplayGain(unittest.TestCase):
     @LIB_CORE
@@ -1842,6 +1963,153 @@ class TestFrameList(unittest.TestCase):
                           [0.0] * 4, -1)
 
 
+class TestPCMSink(unittest.TestCase):
+    def framelists(self, bits_per_sample):
+        for (channels, frames) in [(1, 1), (2, 4096), (6, 100000)]:
+            samples = [random.choice(range(-(2 ** (bits_per_sample - 1)),
+                                           2 ** (bits_per_sample - 1)))
+                       for i in range(channels * frames)]
+            yield audiotools.pcm.from_list(samples,
+                                           channels,
+                                           bits_per_sample,
+                                           True)
+
+    @LIB_PCM
+    def test_file(self):
+        for bits_per_sample in [8, 16, 24]:
+            for is_big_endian in [False, True]:
+                for is_signed in [False, True]:
+                    temp = tempfile.TemporaryFile()
+                    try:
+                        sink = audiotools.pcm.PCMSink(temp.fileno(),
+                                                      is_big_endian,
+                                                      is_signed)
+                        expected = []
+                        for framelist in self.framelists(bits_per_sample):
+                            sink.write(framelist)
+                            expected.append(
+                                framelist.to_bytes(is_big_endian,
+                                                   is_signed))
+                        expected = b"".join(expected)
+                        self.assertEqual(sink.bytes_written, len(expected))
+                        self.assertEqual(sink.frames_written,
+                                         1 + 4096 + 100000)
+                        self.assertGreater(sink.syscalls, 0)
+                        sink.close()
+                        self.assertRaises(ValueError,
+                                          sink.write,
+                                          audiotools.pcm.empty_framelist(
+                                              2, bits_per_sample))
+                        temp.seek(0, 0)
+                        self.assertEqual(temp.read(), expected)
+                    finally:
+                        temp.close()
+
+    @LIB_PCM
+    def test_pipe(self):
+        import threading
+
+        framelists = list(self.framelists(16)) * 10
+        expected = b"".join([f.to_bytes(False, True) for f in framelists])
+
+        (read_fd, write_fd) = os.pipe()
+        received = []
+
+        def reader():
+            with os.fdopen(read_fd, "rb") as r:
+                received.append(r.read())
+
+        thread = threading.Thread(target=reader)
+        thread.start()
+        with audiotools.pcm.PCMSink(write_fd, False, True) as sink:
+            for framelist in framelists:
+                sink.write(framelist)
+        os.close(write_fd)
+        thread.join()
+
+        self.assertEqual(received[0], expected)
+
+        # a consumer which splices the pipe onward to another pipe
+        # and only reads that one after the sink has moved on
+        # must still receive exactly what was written
+        if hasattr(os, "splice"):
+            (read_fd, write_fd) = os.pipe()
+            (relay_read_fd, relay_write_fd) = os.pipe()
+            try:
+                import fcntl
+                fcntl.fcntl(relay_write_fd, fcntl.F_SETPIPE_SZ, 1 << 20)
+            except (ImportError, AttributeError, IOError, OSError):
+                pass
+            relay_done = threading.Event()
+            received = []
+
+            def relay():
+                try:
+                    while os.splice(read_fd, relay_write_fd, 65536) > 0:
+                        pass
+                finally:
+                    os.close(relay_write_fd)
+                    os.close(read_fd)
+                    relay_done.set()
+
+            def reader():
+                with os.fdopen(relay_read_fd, "rb") as r:
+                    # let the sink get well ahead of the reader
+                    relay_done.wait(0.5)
+                    received.append(r.read())
+
+            threads = [threading.Thread(target=relay),
+                       threading.Thread(target=reader)]
+            for thread in threads:
+                thread.start()
+            with audiotools.pcm.PCMSink(write_fd, False, True) as sink:
+                for framelist in framelists:
+                    sink.write(framelist)
+            os.close(write_fd)
+            for thread in threads:
+                thread.join()
+
+            self.assertEqual(received[0], expected)
+
+    @LIB_PCM
+    def test_transfer(self):
+        # writing to a real file goes through the sink
+        # and leaves the file object's position consistent
+        temp = tempfile.TemporaryFile()
+        try:
+            temp.write(b"header")
+            audiotools.transfer_framelist_data(
+                test_streams.Sine24_Stereo(100000, 44100,
+                                           441.0, 0.50, 441.0, 0.49, 1.0),
+                temp.write, True, False)
+            self.assertEqual(temp.tell(), 6 + 100000 * 2 * 3)
+            temp.write(b"footer")
+            temp.seek(0, 0)
+            data = temp.read()
+            self.assertEqual(data[0:6], b"header")
+            self.assertEqual(data[-6:], b"footer")
+            self.assertEqual(len(data), 12 + 100000 * 2 * 3)
+        finally:
+            temp.close()
+
+        # which should match the data written without it
+        a = tempfile.TemporaryFile()
+        b = BytesIO()
+        try:
+            audiotools.transfer_framelist_data(
+                test_streams.Sine16_Stereo(100000, 44100,
+                                           441.0, 0.50, 441.0, 0.49, 1.0),
+                a.write, False, True)
+            audiotools.transfer_framelist_data(
+                test_streams.Sine16_Stereo(100000, 44100,
+                                           441.0, 0.50, 441.0, 0.49, 1.0),
+                b.write, False, True)
+            a.seek(0, 0)
+            self.assertEqual(a.read(), b.getvalue())
+        finally:
+            a.close()
+
+
 class TestFloatFrameList(unittest.TestCase):
     @LIB_CORE
     def test_basics(self):
@@ -3931,6 +4199,97 @@ class Bitstream(unittest.TestCase):
             bitstream.setpos(pos)
             self.assertEqual(bitstream.read(12), 0x3BE)
 
+    @LIB_BITSTREAM
+    def test_descriptor_reader(self):
+        from audiotools.bitstream import BitstreamReader
+
+        # readers of files opened on regular files read from
+        # their descriptors, but must leave the files' positions
+        # where read() would have whenever the reader is
+        # repositioned, closed or deleted
+        import io
+
+        data = bytes(bytearray([i % 256 for i in range(16384)]))
+        temp = tempfile.NamedTemporaryFile()
+        try:
+            temp.write(data)
+            temp.flush()
+
+            def operations(f):
+                # returns the values read and the file's positions
+                # from a sequence of reads and seeks
+                results = []
+                f.seek(100, 0)
+                reader = BitstreamReader(f, False, 4096)
+                results.append(reader.read(8))
+                results.append(reader.read_bytes(4095))
+                results.append(reader.read_bytes(2))
+
+                pos = reader.getpos()
+                results.append(reader.read_bytes(10))
+                reader.setpos(pos)
+                results.append(f.tell())
+                results.append(reader.read_bytes(10))
+
+                reader.skip_bytes(4086)
+                results.append(reader.read_bytes(5000))
+
+                reader.seek(20, 0)
+                results.append(f.tell())
+                results.append(reader.read_bytes(2))
+                reader.seek(-2, 2)
+                results.append(reader.read_bytes(2))
+
+                reader.seek(5000, 0)
+                results.append(reader.read_bytes(10))
+                del(reader)
+                results.append(f.tell())
+                results.append(f.read(4))
+                return results
+
+            expected = operations(BytesIO(data))
+            self.assertEqual(expected[-2:], [5000 + 4096,
+                                             data[5000 + 4096:
+                                                  5000 + 4096 + 4]])
+
+            for (mode, buffering) in [("rb", 0), ("rb", -1), ("r+b", -1)]:
+                with open(temp.name, mode, buffering) as f:
+                    self.assertEqual(operations(f), expected)
+
+            # closing the reader leaves the file where read() would have
+            # before closing it
+            class ClosingBytesIO(BytesIO):
+                def close(self):
+                    self.closed_at = self.tell()
+                    BytesIO.close(self)
+
+            class ClosingReader(io.BufferedReader):
+                def close(self):
+                    self.closed_at = self.tell()
+                    io.BufferedReader.close(self)
+
+            for f in [ClosingBytesIO(data),
+                      ClosingReader(io.FileIO(temp.name, "rb"))]:
+                f.seek(100, 0)
+                reader = BitstreamReader(f, False, 4096)
+                self.assertEqual(reader.read_bytes(10), data[100:110])
+                reader.close()
+                del(reader)
+                self.assertTrue(f.closed)
+                self.assertEqual(f.closed_at, 100 + 4096)
+
+            # writes still buffered by the file are read back
+            with open(temp.name, "r+b") as f:
+                reader = BitstreamReader(f, False, 4096)
+                pos = reader.getpos()
+                f.write(b"\xFF" * 16)
+                reader.setpos(pos)
+                self.assertEqual(reader.read_bytes(20),
+                                 b"\xFF" * 16 + data[16:20])
+                del(reader)
+        finally:
+            temp.close()
+
     @LIB_BITSTREAM
     def test_simple_writer(self):
         from audiotools.bitstream import BitstreamWriter
@@ -4548,6 +4907,122 @@ class TestReplayGain(unittest.TestCase):
             dummy2.close()
 
 
+class TestLoudness(unittest.TestCase):
+    def __sine__(self, sample_rate, seconds, decibels, channels):
+        from math import sin, pi
+        from audiotools.pcm import from_list
+
+        amplitude = 10 ** (decibels / 20.0) * ((1 << 23) - 1)
+        samples = []
+        for i in range(int(sample_rate * seconds)):
+            samples.extend(
+                [int(round(amplitude *
+                           sin(2 * pi * 1000 * i / sample_rate)))] *
+                channels)
+        return from_list(samples, channels, 24, True)
+
+    @LIB_LOUDNESS
+    def test_basics(self):
+        from audiotools.loudness import Loudness
+        from audiotools.pcm import from_list
+
+        # check for invalid arguments
+        self.assertRaises(ValueError, Loudness, 1000, 2)
+        self.assertRaises(ValueError, Loudness, 44100, 0)
+        self.assertRaises(ValueError, Loudness, 44100, 2, -1)
+
+        # check for no samples
+        loudness = Loudness(44100, 2, 0x3)
+        self.assertEqual(loudness.sample_rate, 44100)
+        self.assertEqual(loudness.channels, 2)
+        self.assertRaises(ValueError, loudness.momentary)
+        self.assertRaises(ValueError, loudness.short_term)
+        self.assertRaises(ValueError, loudness.title_loudness)
+        self.assertRaises(ValueError, loudness.album_loudness)
+        self.assertEqual(loudness.title_range(), 0.0)
+        self.assertEqual(loudness.title_peak(), 0.0)
+
+        # check for mismatched FrameList
+        self.assertRaises(ValueError,
+                          loudness.update,
+                          from_list([0] * 10, 1, 16, True))
+
+        # silence has no loudness
+        loudness.update(from_list([0] * 2 * 44100, 2, 16, True))
+        self.assertEqual(loudness.title_loudness(), float("-inf"))
+        self.assertEqual(loudness.momentary(), float("-inf"))
+
+    @LIB_LOUDNESS
+    def test_sine(self):
+        from audiotools.loudness import Loudness
+
+        # a -23dBFS 1kHz stereo sine should be -23 LUFS
+        # across sample rates, per EBU Tech 3341
+        for sample_rate in [44100, 48000, 96000, 192000]:
+            loudness = Loudness(sample_rate, 2, 0x3)
+            loudness.update(self.__sine__(sample_rate, 4, -23.0, 2))
+            self.assertLess(abs(loudness.title_loudness() + 23.0), 0.1)
+            self.assertLess(abs(loudness.momentary() + 23.0), 0.1)
+            self.assertLess(abs(loudness.short_term() + 23.0), 0.1)
+            self.assertLess(loudness.title_range(), 0.1)
+            self.assertLess(abs(loudness.title_peak() - 0.0708), 0.001)
+
+    @LIB_LOUDNESS
+    def test_channels(self):
+        from audiotools.loudness import Loudness
+
+        # surround channels are weighted higher and LFE is ignored
+        front = Loudness(48000, 1, 0x4)
+        front.update(self.__sine__(48000, 1, -23.0, 1))
+        back = Loudness(48000, 1, 0x10)
+        back.update(self.__sine__(48000, 1, -23.0, 1))
+        lfe = Loudness(48000, 1, 0x8)
+        lfe.update(self.__sine__(48000, 1, -23.0, 1))
+        self.assertGreater(back.title_loudness(), front.title_loudness())
+        self.assertEqual(lfe.title_loudness(), float("-inf"))
+
+        # any number of channels is supported
+        loudness = Loudness(48000, 8)
+        loudness.update(self.__sine__(48000, 1, -23.0, 8))
+        self.assertGreater(loudness.title_loudness(), -23.0)
+
+    @LIB_LOUDNESS
+    def test_true_peak(self):
+        from math import sin, pi
+        from audiotools.loudness import Loudness
+        from audiotools.pcm import from_list
+
+        # a quarter sample rate sine 45 degrees out of phase
+        # never samples its own peak
+        loudness = Loudness(48000, 1)
+        loudness.update(
+            from_list([int(round(0.5 * ((1 << 23) - 1) *
+                                 sin(2 * pi * i / 4 + pi / 4)))
+                       for i in range(48000)], 1, 24, True))
+        self.assertGreater(loudness.title_peak(), 0.49)
+        self.assertLess(loudness.title_peak(), 0.51)
+
+    @LIB_LOUDNESS
+    def test_album(self):
+        from audiotools.loudness import Loudness
+
+        loudness = Loudness(48000, 2, 0x3)
+        loudness.update(self.__sine__(48000, 4, -20.0, 2))
+        title1 = loudness.title_loudness()
+        loudness.next_title()
+        self.assertRaises(ValueError, loudness.title_loudness)
+        loudness.update(self.__sine__(48000, 4, -30.0, 2))
+        title2 = loudness.title_loudness()
+
+        self.assertLess(abs(title1 + 20.0), 0.1)
+        self.assertLess(abs(title2 + 30.0), 0.1)
+        album = loudness.album_loudness()
+        self.assertLess(album, title1)
+        self.assertGreater(album, title2)
+        self.assertGreater(loudness.album_range(), 9.0)
+        self.assertGreater(loudness.album_peak(), loudness.title_peak())
+
+
 class testsheet(unittest.TestCase):
     @LIB_CORE
     def test_track_lengths(self):
@@ -6952,6 +7427,226 @@ class Test_Lookup(unittest.TestCase):
             self.assertEqual(len(choice), total_tracks)
         time.sleep(1)
 
+    @LIB_CORE
+    def test_lookup_client(self):
+        import shutil
+        import socket
+        import threading
+        import time
+        from audiotools.lookup import (LookupBackend,
+                                       LookupClient,
+                                       ResponseCache)
+        try:
+            from urllib.request import HTTPError
+        except ImportError:
+            from urllib2 import HTTPError
+
+        class StubBackend(LookupBackend):
+            def __init__(self, delay=0):
+                self.delay = delay
+                self.requests = []
+                self.lock = threading.Lock()
+
+            def fetch(self, url, data=None):
+                with self.lock:
+                    self.requests.append((time.time(), url, data))
+                time.sleep(self.delay)
+                if url.endswith("/missing"):
+                    raise HTTPError(url, 404, "Not Found", {}, None)
+                else:
+                    return url.encode("ascii") + (data if data else b"")
+
+        cache_dir = tempfile.mkdtemp()
+        try:
+            # responses and 404s are both cached
+            backend = StubBackend()
+            client = LookupClient(backend=backend,
+                                  cache=ResponseCache(cache_dir))
+            for i in range(2):
+                self.assertEqual(client.fetch("http://a.test/1"),
+                                 b"http://a.test/1")
+                self.assertEqual(client.fetch("http://a.test/1", b"post"),
+                                 b"http://a.test/1post")
+                self.assertEqual(client.urlopen("http://a.test/2").read(),
+                                 b"http://a.test/2")
+                self.assertRaises(HTTPError,
+                                  client.fetch, "http://a.test/missing")
+            self.assertEqual(len(backend.requests), 4)
+
+            # a new client reuses the cache on disk
+            backend = StubBackend()
+            client = LookupClient(backend=backend,
+                                  cache=ResponseCache(cache_dir))
+            self.assertEqual(client.fetch("http://a.test/1"),
+                             b"http://a.test/1")
+            self.assertRaises(HTTPError,
+                              client.fetch, "http://a.test/missing")
+            self.assertEqual(len(backend.requests), 0)
+
+            # unless its responses have expired
+            client = LookupClient(backend=backend,
+                                  cache=ResponseCache(cache_dir, -1))
+            self.assertEqual(client.fetch("http://a.test/1"),
+                             b"http://a.test/1")
+            self.assertEqual(len(backend.requests), 1)
+
+            # 404s may expire sooner than responses
+            backend = StubBackend()
+            client = LookupClient(backend=backend,
+                                  cache=ResponseCache(cache_dir, None, -1))
+            self.assertEqual(client.fetch("http://a.test/1"),
+                             b"http://a.test/1")
+            self.assertRaises(HTTPError,
+                              client.fetch, "http://a.test/missing")
+            self.assertEqual(len(backend.requests), 1)
+
+            # as may individual requests
+            backend = StubBackend()
+            client = LookupClient(backend=backend,
+                                  cache=ResponseCache(cache_dir))
+            self.assertEqual(client.fetch("http://a.test/2"),
+                             b"http://a.test/2")
+            self.assertEqual(client.fetch("http://a.test/2", max_age=-1),
+                             b"http://a.test/2")
+            self.assertEqual(len(backend.requests), 1)
+        finally:
+            shutil.rmtree(cache_dir)
+
+        # simultaneous requests for the same response are sent once
+        backend = StubBackend(delay=0.2)
+        client = LookupClient(backend=backend)
+        self.assertEqual(client.map(client.fetch,
+                                    ["http://b.test/1"] * 4,
+                                    workers=4),
+                         [b"http://b.test/1"] * 4)
+        self.assertEqual(len(backend.requests), 1)
+
+        # and any failure is raised in every waiting thread
+        class DroppedBackend(StubBackend):
+            def fetch(self, url, data=None):
+                StubBackend.fetch(self, url, data)
+                raise socket.timeout("timed out")
+
+        backend = DroppedBackend(delay=0.2)
+        client = LookupClient(backend=backend)
+        results = []
+
+        def fetch():
+            try:
+                results.append(client.fetch("http://b.test/2"))
+            except socket.timeout as err:
+                results.append(err)
+
+        threads = [threading.Thread(target=fetch) for i in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(len(results), 4)
+        for result in results:
+            self.assertIsInstance(result, socket.timeout)
+        self.assertEqual(len(backend.requests), 1)
+
+        # results are returned in order
+        # and requests to a rate-limited host are spaced out
+        # while requests to other hosts aren't held up
+        backend = StubBackend()
+        client = LookupClient(backend=backend,
+                              rate_limits={"slow.test": 0.1})
+        urls = ["http://{}/{:d}".format(host, i)
+                for i in range(4)
+                for host in ["www.slow.test", "fast.test"]]
+        self.assertEqual(client.map(client.fetch, urls, workers=8),
+                         [u.encode("ascii") for u in urls])
+        self.assertEqual(client.rate_limit("www.slow.test"), 0.1)
+        self.assertEqual(client.rate_limit("fast.test"), 0)
+        slow = sorted([t for (t, url, data) in backend.requests
+                       if "slow.test" in url])
+        fast = sorted([t for (t, url, data) in backend.requests
+                       if "fast.test" in url])
+        self.assertEqual(len(slow), 4)
+        for (t1, t2) in zip(slow, slow[1:]):
+            self.assertGreaterEqual(t2 - t1, 0.09)
+        self.assertLess(fast[-1] - fast[0], 0.25)
+
+        # refused requests are retried after Retry-After seconds
+        class BusyBackend(StubBackend):
+            def fetch(self, url, data=None):
+                if len(self.requests) < 2:
+                    self.requests.append((time.time(), url, data))
+                    raise HTTPError(url, 503, "Service Unavailable",
+                                    {"Retry-After": "0"}, None)
+                else:
+                    return StubBackend.fetch(self, url, data)
+
+        backend = BusyBackend()
+        client = LookupClient(backend=backend, retries=2)
+        self.assertEqual(client.fetch("http://c.test/1"), b"http://c.test/1")
+        self.assertEqual(len(backend.requests), 3)
+
+        backend = BusyBackend()
+        client = LookupClient(backend=backend, retries=1)
+        self.assertRaises(HTTPError, client.fetch, "http://c.test/1")
+
+    @LIB_CORE
+    def test_batched_lookups(self):
+        from audiotools.musicbrainz import DiscID as MDiscID
+        from audiotools.lookup import (LookupBackend,
+                                       LookupClient,
+                                       set_default_client)
+        try:
+            from urllib.request import HTTPError
+        except ImportError:
+            from urllib2 import HTTPError
+
+        disc_ids = [MDiscID(first_track_number=1,
+                            last_track_number=tracks,
+                            lead_out_offset=150 + tracks * 10000,
+                            offsets=[150 + i * 10000 for i in range(tracks)])
+                    for tracks in [3, 5, 2, 7]]
+
+        # a stand-in MusicBrainz server which knows every other disc
+        class StubMusicBrainz(LookupBackend):
+            def fetch(self, url, data=None):
+                for (i, disc_id) in enumerate(disc_ids):
+                    if (u"/discid/{}?".format(disc_id) in url) and (i % 2):
+                        return (u"<metadata><disc><release-list><release>" +
+                                u"<title>Album {:d}</title>".format(i) +
+                                u"<medium-list><medium><disc-list>" +
+                                u"<disc id=\"{}\"/>".format(disc_id) +
+                                u"</disc-list><track-list>" +
+                                u"".join([u"<track><title>Track {:d}</title>"
+                                          u"</track>".format(t)
+                                          for t in range(1, len(
+                                              disc_id.offsets) + 1)]) +
+                                u"</track-list></medium></medium-list>" +
+                                u"</release></release-list></disc>" +
+                                u"</metadata>").encode("utf-8")
+                else:
+                    raise HTTPError(url, 404, "Not Found", {}, None)
+
+        previous = set_default_client(
+            LookupClient(backend=StubMusicBrainz()))
+        try:
+            results = audiotools.metadata_lookups(disc_ids, workers=4)
+        finally:
+            set_default_client(previous)
+
+        self.assertEqual(len(results), len(disc_ids))
+        for (i, (disc_id, choices)) in enumerate(zip(disc_ids, results)):
+            self.assertEqual(len(choices), 1)
+            self.assertEqual(len(choices[0]), len(disc_id.offsets))
+            for (t, metadata) in enumerate(choices[0], 1):
+                self.assertEqual(metadata.track_number, t)
+                self.assertEqual(metadata.track_total, len(disc_id.offsets))
+                if i % 2:
+                    self.assertEqual(metadata.album_name,
+                                     u"Album {:d}".format(i))
+                    self.assertEqual(metadata.track_name,
+                                     u"Track {:d}".format(t))
+                else:
+                    self.assertEqual(metadata.album_name, None)
+
 
 class Test_Ogg(unittest.TestCase):
     @LIB_OGG
@@ -7033,6 +7728,140 @@ class Test_Image(unittest.TestCase):
             self.assertEqual(tiff.mime_type, "image/tiff")
 
 
+class Test_ArtCache(unittest.TestCase):
+    @LIB_IMAGE
+    def test_embedded_images(self):
+        from audiotools.artcache import (embedded_images,
+                                         image_digest,
+                                         EmbeddedImage)
+        from hashlib import sha1
+
+        with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+            track = audiotools.FlacAudio.from_pcm(temp.name,
+                                                  BLANK_PCM_Reader(1))
+            metadata = track.get_metadata()
+            metadata.add_image(audiotools.Image.new(TEST_COVER1, u"front",
+                                                    audiotools.FRONT_COVER))
+            metadata.add_image(audiotools.Image.new(TEST_COVER2, u"back",
+                                                    audiotools.BACK_COVER))
+            track.update_metadata(metadata)
+
+            track = audiotools.open(temp.name)
+            parsed = track.get_metadata().images()
+            embedded = embedded_images(track)
+            self.assertEqual(len(embedded), len(parsed))
+            for (e, p) in zip(embedded, parsed):
+                self.assertIsInstance(e, EmbeddedImage)
+                self.assertEqual(e.data, p.data)
+                self.assertEqual(e.length, len(p.data))
+                self.assertEqual(e.mime_type, p.mime_type)
+                self.assertEqual(e.width, p.width)
+                self.assertEqual(e.height, p.height)
+                self.assertEqual(e.description, p.description)
+                self.assertEqual(e.type, p.type)
+                self.assertEqual(image_digest(e),
+                                 sha1(p.data).hexdigest())
+
+            # truncating the file short of the image data is an I/O error
+            with open(temp.name, "rb") as f:
+                data = f.read()
+            with open(temp.name, "wb") as f:
+                f.write(data[0:embedded[-1].offset + 10])
+            self.assertRaises(IOError, lambda: embedded[-1].data)
+
+    @LIB_IMAGE
+    def test_dedup(self):
+        import shutil
+        from audiotools.artcache import (ArtCache,
+                                         CachedImage,
+                                         EmbeddedImage,
+                                         embedded_images)
+
+        cache_dir = tempfile.mkdtemp()
+        fresh_dir = tempfile.mkdtemp()
+        track1_file = tempfile.NamedTemporaryFile(suffix=".flac")
+        track2_file = tempfile.NamedTemporaryFile(suffix=".flac")
+        try:
+            # two tracks sharing the same front cover
+            tracks = []
+            for (temp, images) in [(track1_file,
+                                    [(TEST_COVER1, audiotools.FRONT_COVER)]),
+                                   (track2_file,
+                                    [(TEST_COVER1, audiotools.FRONT_COVER),
+                                     (TEST_COVER3, audiotools.BACK_COVER)])]:
+                track = audiotools.FlacAudio.from_pcm(temp.name,
+                                                      BLANK_PCM_Reader(1))
+                metadata = track.get_metadata()
+                for (data, type) in images:
+                    metadata.add_image(audiotools.Image.new(data, u"", type))
+                track.update_metadata(metadata)
+                tracks.append(audiotools.open(temp.name))
+
+            cache = ArtCache(directory=cache_dir, workers=2)
+            images1 = cache.images(tracks[0])
+            images2 = cache.images(tracks[1])
+            self.assertEqual(len(images1), 1)
+            self.assertEqual(len(images2), 2)
+            for image in images1 + images2:
+                self.assertIsInstance(image, CachedImage)
+            self.assertEqual(images1[0].digest, images2[0].digest)
+            self.assertNotEqual(images1[0].digest, images2[1].digest)
+            self.assertEqual(images1[0].data, TEST_COVER1)
+            self.assertEqual(images2[1].data, TEST_COVER3)
+            self.assertEqual(images2[1].type, audiotools.BACK_COVER)
+            self.assertEqual(images1[0].filename, images2[0].filename)
+
+            # prefetching already-cached tracks stores nothing new
+            cache.prefetch([t.filename for t in tracks] + ["/dev/null"])
+            cache.join()
+
+            stored = []
+            for (directory, subdirs, files) in os.walk(cache_dir):
+                stored.extend([f for f in files if "-" not in f])
+            self.assertEqual(sorted(stored),
+                             sorted([images1[0].digest, images2[1].digest]))
+
+            # thumbnails are optional, but must exist if reported
+            for image in images2:
+                thumbnail = cache.thumbnail(image.digest)
+                if thumbnail is not None:
+                    self.assertTrue(os.path.isfile(thumbnail))
+
+            # embedded images are read once, whether cached or not
+            class CountedImage(EmbeddedImage):
+                reads = 0
+
+                def chunks(self):
+                    CountedImage.reads += 1
+                    return EmbeddedImage.chunks(self)
+
+            fresh_cache = ArtCache(directory=fresh_dir, workers=1)
+            for embedded in embedded_images(tracks[1]):
+                counted = CountedImage(
+                    embedded.filename, embedded.offset, embedded.length,
+                    embedded.mime_type, embedded.width, embedded.height,
+                    embedded.color_depth, embedded.color_count,
+                    embedded.description, embedded.type)
+                # once when new to the cache, once when already stored
+                for i in range(2):
+                    self.assertIn(fresh_cache.add(counted).digest,
+                                  [image.digest for image in images2])
+            self.assertEqual(CountedImage.reads, 4)
+            fresh_cache.join()
+
+            # and no temporary files are left behind
+            stored = []
+            for (directory, subdirs, files) in os.walk(fresh_dir):
+                stored.extend([f for f in files if "-" not in f])
+            self.assertEqual(sorted(stored),
+                             sorted([image.digest for image in images2]))
+        finally:
+            track1_file.close()
+            track2_file.close()
+            shutil.rmtree(cache_dir)
+            shutil.rmtree(fresh_dir)
+
+
 class Test_ExecProgressQueue(unittest.TestCase):
     @LIB_CORE
     def test_queue(self):
@@ -7067,6 +7896,365 @@ class Test_ExecProgressQueue(unittest.TestCase):
             for i in range(max_processes):
                 self.assertEqual(results[i], sum(range(i, i + 10)))
 
+    @LIB_CORE
+    def test_worker_reuse(self):
+        def worker_pid(job, progress):
+            from fractions import Fraction
+
+            progress(Fraction(1, 2))
+            return (job, os.getpid())
+
+        queue = audiotools.ExecProgressQueue(audiotools.SilentMessenger())
+
+        for i in range(50):
+            queue.execute(function=worker_pid, job=i)
+
+        results = queue.run(4)
+
+        # results are still returned in the order they were queued
+        self.assertEqual([r[0] for r in results], list(range(50)))
+
+        # but no more than "max_processes" processes are used to run them
+        pids = set([r[1] for r in results])
+        self.assertLessEqual(len(pids), 4)
+        self.assertNotIn(os.getpid(), pids)
+
+    @LIB_CORE
+    def test_exception(self):
+        def fail_on(job, bad_job, progress):
+            if job == bad_job:
+                raise ValueError(job)
+            else:
+                return job
+
+        queue = audiotools.ExecProgressQueue(audiotools.SilentMessenger())
+        for i in range(10):
+            queue.execute(function=fail_on, job=i, bad_job=5)
+
+        self.assertRaises(ValueError, queue.run, 3)
+
+    @LIB_CORE
+    def test_worker_placement(self):
+        from audiotools.topology import available_cpus
+
+        def worker_cpus(job, progress):
+            return (os.getpid(), sorted(os.sched_getaffinity(0)))
+
+        if not hasattr(os, "sched_getaffinity"):
+            return
+
+        cpus = available_cpus()
+        queue = audiotools.ExecProgressQueue(audiotools.SilentMessenger())
+        for i in range(8):
+            queue.execute(function=worker_cpus, job=i)
+
+        # a worker's CPUs never extend beyond those available
+        for (pid, affinity) in queue.run(4):
+            self.assertNotEqual(pid, os.getpid())
+            self.assertTrue(set(affinity).issubset(set(cpus)))
+
+        # and pinning workers leaves the parent unpinned
+        self.assertEqual(available_cpus(), cpus)
+
+
+class Test_Topology(unittest.TestCase):
+    def setUp(self):
+        # a dual-socket system of 8 CPUs
+        # with two 2-CPU last-level caches per socket
+        # and sockets 0 and 1 as NUMA nodes 0 and 1
+        self.sysfs = tempfile.mkdtemp()
+
+        def write(path, text):
+            path = os.path.join(self.sysfs, *path.split("/"))
+            if not os.path.isdir(os.path.dirname(path)):
+                os.makedirs(os.path.dirname(path))
+            with open(path, "w") as f:
+                f.write(text + "\n")
+
+        write("node/node0/cpulist", "0-3")
+        write("node/node1/cpulist", "4-7")
+        for cpu in range(8):
+            cpu_dir = "cpu/cpu{:d}".format(cpu)
+            write(cpu_dir + "/topology/physical_package_id",
+                  "{:d}".format(cpu // 4))
+            for (index, level, cache_type, shared) in [
+                    (0, 1, "Data", "{:d}".format(cpu)),
+                    (1, 1, "Instruction", "{:d}".format(cpu)),
+                    (2, 3, "Unified", "{:d}-{:d}".format(cpu & ~1,
+                                                         cpu | 1))]:
+                index_dir = "{}/cache/index{:d}".format(cpu_dir, index)
+                write(index_dir + "/level", "{:d}".format(level))
+                write(index_dir + "/type", cache_type)
+                write(index_dir + "/shared_cpu_list", shared)
+
+    def tearDown(self):
+        import shutil
+
+        shutil.rmtree(self.sysfs)
+
+    @LIB_CORE
+    def test_parse_cpu_list(self):
+        from audiotools.topology import parse_cpu_list
+
+        self.assertEqual(parse_cpu_list(u"0"), [0])
+        self.assertEqual(parse_cpu_list(u"0-3,8-11\n"),
+                         [0, 1, 2, 3, 8, 9, 10, 11])
+        self.assertEqual(parse_cpu_list(u"5,1-2,2"), [1, 2, 5])
+        self.assertEqual(parse_cpu_list(u""), [])
+        self.assertRaises(ValueError, parse_cpu_list, u"0-x")
+
+    @LIB_CORE
+    def test_nodes(self):
+        import shutil
+        from audiotools.topology import cpu_nodes, shared_cache_cpus
+
+        self.assertEqual(cpu_nodes(range(8), self.sysfs),
+                         {0: 0, 1: 0, 2: 0, 3: 0, 4: 1, 5: 1, 6: 1, 7: 1})
+        self.assertEqual(shared_cache_cpus(5, self.sysfs), [4, 5])
+        self.assertEqual(shared_cache_cpus(8, self.sysfs), None)
+
+        # without NUMA nodes, CPUs are grouped by package
+        shutil.rmtree(os.path.join(self.sysfs, "node"))
+        self.assertEqual(cpu_nodes([0, 3, 4], self.sysfs),
+                         {0: 0, 3: 0, 4: 1})
+
+    @LIB_CORE
+    def test_clusters(self):
+        import shutil
+        from audiotools.topology import cpu_clusters
+
+        # clusters alternate between nodes
+        self.assertEqual(cpu_clusters("node", range(8), self.sysfs),
+                         [[0, 1, 2, 3], [4, 5, 6, 7]])
+        self.assertEqual(cpu_clusters("cache", range(8), self.sysfs),
+                         [[0, 1], [4, 5], [2, 3], [6, 7]])
+        self.assertEqual(cpu_clusters("none", range(8), self.sysfs),
+                         [list(range(8))])
+
+        # clusters only include the given CPUs
+        self.assertEqual(cpu_clusters("cache", [1, 2, 3, 6], self.sysfs),
+                         [[1], [6], [2, 3]])
+        self.assertEqual(cpu_clusters("cache", [3], self.sysfs), [[3]])
+
+        # CPUs without cache information are clustered by node
+        shutil.rmtree(os.path.join(self.sysfs, "cpu"))
+        self.assertEqual(cpu_clusters("cache", range(8), self.sysfs),
+                         [[0, 1, 2, 3], [4, 5, 6, 7]])
+
+
+class Test_Fingerprint(unittest.TestCase):
+    def melody(self, seed, notes=20):
+        # a half second sine tone per note
+        # so the spectrum changes from one segment to the next
+        r = random.Random(seed)
+        return audiotools.PCMCat(
+            [test_streams.Sine16_Mono(22050, 44100,
+                                      r.uniform(300.0, 2800.0), 0.4,
+                                      r.uniform(300.0, 2800.0), 0.2)
+             for i in range(notes)])
+
+    @LIB_CORE
+    def test_fingerprint(self):
+        from audiotools.fingerprint import (FingerprintReader,
+                                            fingerprint_track,
+                                            SIMILAR_BITS)
+
+        temp_dir = tempfile.mkdtemp()
+        try:
+            tracks = [audio_class.from_pcm(
+                          os.path.join(temp_dir,
+                                       "track." + audio_class.SUFFIX),
+                          self.melody(1))
+                      for audio_class in [audiotools.WaveAudio,
+                                          audiotools.FlacAudio,
+                                          audiotools.ALACAudio]]
+
+            # lossless encodings of the same PCM data are identical
+            fingerprints = [fingerprint_track(t) for t in tracks]
+            for fingerprint in fingerprints:
+                self.assertEqual(fingerprint.pcm_frames, 22050 * 20)
+                self.assertTrue(fingerprint.identical(fingerprints[0]))
+                self.assertEqual(fingerprint.distance(fingerprints[0]), 0)
+        finally:
+            import shutil
+            shutil.rmtree(temp_dir)
+
+        # the fingerprint isn't available until the reader is closed
+        reader = FingerprintReader(self.melody(1))
+        audiotools.transfer_data(reader.read, lambda f: None)
+        self.assertRaises(ValueError, reader.fingerprint)
+        reader.close()
+        self.assertTrue(reader.fingerprint().identical(fingerprints[0]))
+
+        # requantizing and resampling the PCM data
+        # changes its digest but not its spectrum much
+        for (sample_rate, bits_per_sample) in [(44100, 8), (48000, 16)]:
+            reader = FingerprintReader(
+                audiotools.PCMConverter(self.melody(1),
+                                        sample_rate=sample_rate,
+                                        channels=1,
+                                        channel_mask=0x4,
+                                        bits_per_sample=bits_per_sample))
+            audiotools.transfer_data(reader.read, lambda f: None)
+            reader.close()
+            self.assertFalse(reader.fingerprint().identical(fingerprints[0]))
+            self.assertTrue(reader.fingerprint().similar(fingerprints[0]))
+
+        # while different PCM data differs in both
+        for seed in range(2, 6):
+            reader = FingerprintReader(self.melody(seed))
+            audiotools.transfer_data(reader.read, lambda f: None)
+            reader.close()
+            self.assertFalse(reader.fingerprint().identical(fingerprints[0]))
+            self.assertGreater(reader.fingerprint().distance(fingerprints[0]),
+                               SIMILAR_BITS)
+
+        # and lengths which differ too much are never similar
+        reader = FingerprintReader(self.melody(1, notes=22))
+        audiotools.transfer_data(reader.read, lambda f: None)
+        reader.close()
+        self.assertFalse(reader.fingerprint().similar(fingerprints[0]))
+
+    @LIB_CORE
+    def test_index(self):
+        from audiotools.fingerprint import (FingerprintIndex,
+                                            FingerprintReader,
+                                            fingerprint_track)
+
+        temp_dir = tempfile.mkdtemp()
+        try:
+            index_path = os.path.join(temp_dir, "index.db")
+
+            # two recordings, one of which has
+            # two lossless copies and a requantized copy
+            paths = []
+            for (name, audio_class, seed, bits_per_sample) in [
+                    ("a.flac", audiotools.FlacAudio, 1, 16),
+                    ("b.m4a", audiotools.ALACAudio, 1, 16),
+                    ("c.flac", audiotools.FlacAudio, 1, 8),
+                    ("d.flac", audiotools.FlacAudio, 2, 16)]:
+                path = os.path.join(temp_dir, name)
+                audio_class.from_pcm(
+                    path,
+                    audiotools.PCMConverter(self.melody(seed),
+                                            sample_rate=44100,
+                                            channels=1,
+                                            channel_mask=0x4,
+                                            bits_per_sample=bits_per_sample))
+                paths.append(path)
+
+            with FingerprintIndex(index_path) as index:
+                self.assertEqual(len(index), 0)
+                for path in paths:
+                    self.assertNotIn(path, index)
+                    self.assertIsNone(index.get(path))
+                    index.add(path, fingerprint_track(audiotools.open(path)))
+                    self.assertIn(path, index)
+
+                # adding a path again replaces its entry
+                index.add(paths[0],
+                          fingerprint_track(audiotools.open(paths[0])))
+                self.assertEqual(len(index), 4)
+                self.assertEqual(index.paths(), sorted(paths))
+
+            # the index persists once closed
+            with FingerprintIndex(index_path) as index:
+                self.assertEqual(len(index), 4)
+                fingerprint = index.get(paths[0])
+                self.assertTrue(
+                    fingerprint.identical(
+                        fingerprint_track(audiotools.open(paths[0]))))
+
+                self.assertEqual(index.identical(fingerprint),
+                                 sorted(paths[0:2]))
+                self.assertEqual(
+                    sorted([path for (distance, path) in
+                            index.similar(fingerprint)]),
+                    sorted(paths[0:3]))
+                self.assertEqual(index.similar(fingerprint)[0][0], 0)
+                self.assertEqual(
+                    [path for (distance, path) in
+                     index.similar(index.get(paths[3]))],
+                    [paths[3]])
+
+                self.assertEqual(list(index.duplicates()),
+                                 [sorted(paths[0:3])])
+
+                # changing a file invalidates its fingerprint
+                os.utime(paths[1], (0, 0))
+                self.assertIsNone(index.get(paths[1]))
+                self.assertIn(paths[1], index)
+
+                # and removing it drops it from lookups
+                index.remove(paths[1])
+                self.assertNotIn(paths[1], index)
+                self.assertEqual(index.identical(fingerprint), [paths[0]])
+                self.assertEqual(list(index.duplicates()),
+                                 [sorted([paths[0], paths[2]])])
+        finally:
+            import shutil
+            shutil.rmtree(temp_dir)
+
+
+class Test_PulseAudioOutput(unittest.TestCase):
+    @LIB_CORE
+    def test_play(self):
+        from audiotools.player import PulseAudioOutput
+
+        # requires a running PulseAudio server,
+        # such as one started with only a null sink:
+        # pulseaudio -n --load=module-null-sink --exit-idle-time=-1 -D
+        if not PulseAudioOutput.available():
+            return
+
+        for (channels, channel_mask, bits_per_sample) in [(1, 0x4, 8),
+                                                          (2, 0x3, 16),
+                                                          (2, 0x3, 24)]:
+            output = PulseAudioOutput()
+            try:
+                output.set_format(44100, channels, channel_mask,
+                                  bits_per_sample)
+            except ValueError:
+                # no server to connect to
+                return
+
+            try:
+                # FrameLists are played as-is
+                # whether larger or smaller than the output's buffer
+                for frames in [1, 10, 4096, 44100]:
+                    output.play(audiotools.pcm.from_list(
+                        [(i % 100) - 50 for i in range(frames * channels)],
+                        channels,
+                        bits_per_sample,
+                        True))
+
+                # but must match the output's format
+                self.assertRaises(
+                    ValueError,
+                    output.play,
+                    audiotools.pcm.from_list([0] * (channels + 1),
+                                             channels + 1,
+                                             bits_per_sample,
+                                             True))
+                self.assertRaises(
+                    ValueError,
+                    output.play,
+                    audiotools.pcm.from_list([0] * channels,
+                                             channels,
+                                             (bits_per_sample % 24) + 8,
+                                             True))
+
+                # playback can be paused while FrameLists are queued
+                output.pause()
+                output.play(audiotools.pcm.from_list([0] * channels,
+                                                     channels,
+                                                     bits_per_sample,
+                                                     True))
+                output.resume()
+            finally:
+                # closing waits for every queued FrameList to be played
+                output.close()
+
 
 class Test_Output_Text(unittest.TestCase):
     @LIB_CORE
@@ -2388,7 +2388,52 @@ class AiffFileTest(TestForeignAiffChunks, LosslessFileTest):
             fixed.close()
 
 
-class ALACFileTest(LosslessFileTest):
+class TestBatchedReads:
+    @FORMAT_LOSSLESS
+    def test_batched_reads(self):
+        total_pcm_frames = 44100 * 3 + 17
+        with tempfile.NamedTemporaryFile(suffix=self.suffix) as temp_file:
+            track = self.audio_class.from_pcm(
+                temp_file.name,
+                EXACT_RANDOM_PCM_Reader(pcm_frames=total_pcm_frames,
+                                        channels=3,
+                                        channel_mask=0x7),
+                total_pcm_frames=total_pcm_frames)
+
+            with open(temp_file.name, "rb") as f:
+                with self.decoder(f) as decoder:
+                    all_frames = decoder.read(total_pcm_frames * 2)
+                    self.assertEqual(all_frames.frames, total_pcm_frames)
+                    self.assertEqual(len(decoder.read(4096)), 0)
+
+            # every read but the last should return
+            # exactly as many PCM frames as requested
+            # regardless of the stream's block size
+            for pcm_frames in [100, 4096, 5000, 99999]:
+                framelists = []
+                with open(temp_file.name, "rb") as f:
+                    with self.decoder(f) as decoder:
+                        framelist = decoder.read(pcm_frames)
+                        while len(framelist) > 0:
+                            framelists.append(framelist)
+                            framelist = decoder.read(pcm_frames)
+                joined = framelists[0]
+                for framelist in framelists[1:]:
+                    self.assertEqual(joined.frames % pcm_frames, 0)
+                    joined += framelist
+                self.assertEqual(joined, all_frames)
+
+            # seeking discards whatever was left over from the last read
+            with open(temp_file.name, "rb") as f:
+                with self.decoder(f) as decoder:
+                    decoder.read(333)
+                    offset = decoder.seek(0)
+                    self.assertEqual(offset, 0)
+                    self.assertEqual(decoder.read(1000),
+                                     all_frames.split(1000)[0])
+
+
+class ALACFileTest(TestBatchedReads, LosslessFileTest):
     def setUp(self):
         self.audio_class = audiotools.ALACAudio
         self.suffix = "." + self.audio_class.SUFFIX
@@ -2431,6 +2476,47 @@ class ALACFileTest(LosslessFileTest):
                 track2 = audiotools.open(temp.name)
                 self.assertEqual(track2.bits_per_sample(), bps)
 
+    @FORMAT_ALAC
+    def test_encoding_verification(self):
+        # verified encodes should decode to their input
+        # whether or not the stream's length is known in advance
+        for stream in [
+            test_streams.Sine16_Mono(44101, 44100,
+                                     441.0, 0.50, 882.0, 0.49),
+            test_streams.Sine16_Stereo(44101, 44100,
+                                       441.0, 0.50, 4410.0, 0.49, 1.0),
+            test_streams.Sine24_Stereo(44101, 44100,
+                                       8820.0, 0.70, 4410.0, 0.29, 0.1),
+            test_streams.Simple_Sine(44101, 44100, 0x003F, 16,
+                                     (6400, 10000),
+                                     (11520, 15000),
+                                     (16640, 20000),
+                                     (21760, 25000),
+                                     (26880, 30000),
+                                     (30720, 35000))]:
+            for total_pcm_frames in [0, 44101]:
+                stream.reset()
+                with tempfile.NamedTemporaryFile(suffix=self.suffix) as temp:
+                    with open(temp.name, "wb") as f:
+                        self.encode(
+                            file=f,
+                            pcmreader=stream,
+                            total_pcm_frames=total_pcm_frames,
+                            block_size=4096,
+                            initial_history=self.audio_class.INITIAL_HISTORY,
+                            history_multiplier=(
+                                self.audio_class.HISTORY_MULTIPLIER),
+                            maximum_k=self.audio_class.MAXIMUM_K,
+                            version="Python Audio Tools " + audiotools.VERSION,
+                            verify=True)
+                    md5sum = md5()
+                    with audiotools.open(temp.name).to_pcm() as d:
+                        f = d.read(audiotools.FRAMELIST_SIZE)
+                        while len(f) > 0:
+                            md5sum.update(f.to_bytes(False, True))
+                            f = d.read(audiotools.FRAMELIST_SIZE)
+                    self.assertEqual(md5sum.digest(), stream.digest())
+
     @FORMAT_ALAC
     def test_channel_mask(self):
         with tempfile.NamedTemporaryFile(suffix=self.suffix) as temp:
@@ -3088,6 +3174,7 @@ class AUFileTest(LosslessFileTest):
 
 class FlacFileTest(TestForeignAiffChunks,
                    TestForeignWaveChunks,
+                   TestBatchedReads,
                    LosslessFileTest):
     def setUp(self):
         self.audio_class = audiotools.FlacAudio
@@ -3167,6 +3254,92 @@ class FlacFileTest(TestForeignAiffChunks,
 
         self.assertRaises(IOError, self.decoder, "filename")
 
+    def __flac_to_oggflac__(self, flac_filename, oggflac_filename):
+        """rewraps a native FLAC file's frames in Ogg pages,
+        one frame per page with its ending sample as the granule position"""
+
+        from audiotools.flac import OggFlacMetaData
+        from audiotools.ogg import packet_to_pages
+        from audiotools._ogg import PageWriter
+
+        frame_sizes = []
+        with self.decoder(open(flac_filename, "rb")) as decoder:
+            frame_size = decoder.frame_size()
+            while frame_size is not None:
+                frame_sizes.append(frame_size)
+                frame_size = decoder.frame_size()
+
+        with open(flac_filename, "rb") as f:
+            flac_data = f.read()
+        offset = len(flac_data) - sum(s for (s, f) in frame_sizes)
+
+        metadata = OggFlacMetaData.converted(
+            audiotools.open(flac_filename).get_metadata())
+
+        with open(oggflac_filename, "wb") as f:
+            writer = PageWriter(f)
+            sequence_number = metadata.build(writer, 1)
+            granule_position = 0
+            for (i, (byte_size, pcm_frames)) in enumerate(frame_sizes):
+                granule_position += pcm_frames
+                for page in packet_to_pages(
+                        flac_data[offset:offset + byte_size],
+                        1,
+                        sequence_number):
+                    page.granule_position = granule_position
+                    page.stream_end = (i == (len(frame_sizes) - 1))
+                    writer.write(page)
+                    sequence_number += 1
+                offset += byte_size
+            writer.close()
+
+    @FORMAT_FLAC
+    def test_oggflac_decoder(self):
+        from audiotools.decoders import OggFlacDecoder
+
+        with tempfile.NamedTemporaryFile(suffix=".flac") as flac_file:
+            with tempfile.NamedTemporaryFile(suffix=".oga") as oggflac_file:
+                self.audio_class.from_pcm(
+                    flac_file.name,
+                    test_streams.Sine24_Stereo(200000, 44100,
+                                               441.0, 0.50,
+                                               441.0, 0.49, 1.0))
+                self.__flac_to_oggflac__(flac_file.name, oggflac_file.name)
+
+                # both containers should decode to the same samples
+                # and the Ogg FLAC stream's MD5 sum should validate
+                self.assertTrue(
+                    audiotools.pcm_cmp(
+                        self.decoder(open(flac_file.name, "rb")),
+                        OggFlacDecoder(oggflac_file.name, 0x3)))
+
+                # seeking should land on the latest frame
+                # starting at or before the desired offset
+                decoder = OggFlacDecoder(oggflac_file.name, 0x3)
+                for offset in [0, 1, 4095, 4096, 5000, 199999, 300000]:
+                    seeked = decoder.seek(offset)
+                    self.assertLessEqual(seeked, offset)
+                    self.assertGreater(seeked + 4096, min(offset, 199999))
+                    reference = self.decoder(open(flac_file.name, "rb"))
+                    remaining = seeked
+                    while remaining > 0:
+                        remaining -= reference.read(4096).frames
+                    self.assertEqual(remaining, 0)
+                    self.assertEqual(decoder.read(4096), reference.read(4096))
+                    reference.close()
+
+                # reading the whole stream after seeking back to the start
+                # should validate the MD5 sum again
+                self.assertEqual(decoder.seek(0), 0)
+                total_frames = 0
+                framelist = decoder.read(4096)
+                while len(framelist) > 0:
+                    total_frames += framelist.frames
+                    framelist = decoder.read(4096)
+                self.assertEqual(total_frames, 200000)
+                decoder.close()
+                self.assertRaises(ValueError, decoder.read, 4096)
+
     @FORMAT_FLAC
     def test_metadata2(self):
         from bz2 import decompress
@@ -3359,6 +3532,203 @@ class FlacFileTest(TestForeignAiffChunks,
             self.assertEqual(streaminfo.total_samples, 96000)
             self.assertEqual(streaminfo.md5sum, b"\x01" * 16)
 
+    @FORMAT_FLAC
+    def test_header(self):
+        from audiotools.decoders import FlacHeader, FlacDecoder
+
+        with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+            flac_file = audiotools.FlacAudio.from_pcm(
+                temp.name,
+                EXACT_RANDOM_PCM_Reader(pcm_frames=44100 * 3,
+                                        channels=6,
+                                        channel_mask=0x3F))
+            metadata = flac_file.get_metadata()
+            metadata.track_name = u"Track Name"
+            metadata.add_image(audiotools.Image.new(TEST_COVER1, u"", 0))
+            flac_file.set_metadata(metadata)
+            metadata = flac_file.get_metadata()
+
+            with open(temp.name, "rb") as f:
+                header = FlacHeader(f)
+            streaminfo = metadata.get_block(
+                audiotools.flac.Flac_STREAMINFO.BLOCK_ID)
+            vorbis_comment = metadata.get_block(
+                audiotools.flac.Flac_VORBISCOMMENT.BLOCK_ID)
+
+            # ensure the native parse agrees with FlacMetaData
+            self.assertEqual(header.sample_rate, streaminfo.sample_rate)
+            self.assertEqual(header.channels, streaminfo.channels)
+            self.assertEqual(header.bits_per_sample,
+                             streaminfo.bits_per_sample)
+            self.assertEqual(header.total_samples, streaminfo.total_samples)
+            self.assertEqual(header.md5sum, streaminfo.md5sum)
+            self.assertEqual(header.channel_mask, 0x3F)
+            self.assertEqual(header.vendor_string,
+                             vorbis_comment.vendor_string)
+            self.assertEqual(header.comments,
+                             vorbis_comment.comment_strings)
+            self.assertEqual(
+                header.seekpoints,
+                metadata.get_block(
+                    audiotools.flac.Flac_SEEKTABLE.BLOCK_ID).seekpoints)
+            self.assertEqual([block[0] for block in header.blocks],
+                             [block.BLOCK_ID for block in metadata.blocks()])
+            self.assertEqual(header.frames_offset, 4 + metadata.size())
+
+            offset = 4
+            for ((block_type, block_offset, block_size),
+                 block) in zip(header.blocks, metadata.blocks()):
+                self.assertEqual(block_offset, offset)
+                self.assertEqual(block_size, block.size())
+                offset += 4 + block_size
+
+            # ensure a header gone stale underfoot
+            # falls back to parsing the stream
+            metadata.add_image(audiotools.Image.new(TEST_COVER2, u"", 0))
+            flac_file.update_metadata(metadata)
+            with open(temp.name, "rb") as f:
+                self.assertNotEqual(FlacHeader(f).frames_offset,
+                                    header.frames_offset)
+            with open(temp.name, "rb") as f:
+                with FlacDecoder(f, header) as decoder:
+                    self.assertTrue(
+                        audiotools.pcm_frame_cmp(decoder,
+                                                 flac_file.to_pcm()) is None)
+
+            # even if the header was of an empty stream
+            # which has no frames to check
+            with open(temp.name, "rb") as f:
+                frames_offset = FlacHeader(f).frames_offset
+                f.seek(0, 0)
+                data = bytearray(f.read(frames_offset))
+            # zero STREAMINFO's 36 bit total samples field
+            data[21] &= 0xF0
+            data[22:26] = b"\x00" * 4
+            with tempfile.NamedTemporaryFile(suffix=".flac") as empty:
+                empty.write(bytes(data))
+                empty.flush()
+                with open(empty.name, "rb") as f:
+                    header = FlacHeader(f)
+            self.assertEqual(header.total_samples, 0)
+            metadata.add_image(audiotools.Image.new(TEST_COVER1, u"", 0))
+            metadata.add_image(audiotools.Image.new(TEST_COVER2, u"", 0))
+            flac_file.update_metadata(metadata)
+            with open(temp.name, "rb") as f:
+                self.assertNotEqual(FlacHeader(f).frames_offset,
+                                    header.frames_offset)
+            with open(temp.name, "rb") as f:
+                with FlacDecoder(f, header) as decoder:
+                    self.assertTrue(
+                        audiotools.pcm_frame_cmp(decoder,
+                                                 flac_file.to_pcm()) is None)
+
+            # signed, padded or empty channel masks are ignored
+            for mask in [u"-4", u"+4", u" 4", u""]:
+                metadata = flac_file.get_metadata()
+                metadata.get_block(
+                    audiotools.flac.Flac_VORBISCOMMENT.BLOCK_ID)[
+                    u"WAVEFORMATEXTENSIBLE_CHANNEL_MASK"] = [mask]
+                flac_file.update_metadata(metadata)
+                with open(temp.name, "rb") as f:
+                    self.assertIsNone(FlacHeader(f).channel_mask)
+
+    @FORMAT_FLAC
+    def test_autotune(self):
+        from audiotools.encoders import trial_encode_flac
+
+        # trial sizes should match the frames of a real encode
+        framelist = test_streams.Sine16_Stereo(
+            44100, 44100, 441.0, 0.50, 4410.0, 0.49, 1.0).read(44100)
+        for compression in ["0", "4", "8"]:
+            options = audiotools.FlacAudio.COMPRESSION_OPTIONS[compression]
+            with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+                flac_file = audiotools.FlacAudio.from_pcm(
+                    temp.name,
+                    test_streams.Sine16_Stereo(
+                        44100, 44100, 441.0, 0.50, 4410.0, 0.49, 1.0),
+                    compression)
+                self.assertEqual(
+                    trial_encode_flac(framelist, 44100, **options),
+                    os.path.getsize(temp.name) -
+                    flac_file.__header__.frames_offset)
+
+        self.assertRaises(TypeError, trial_encode_flac, None, 44100)
+        self.assertRaises(ValueError, trial_encode_flac, framelist, 0)
+        self.assertRaises(ValueError, trial_encode_flac, framelist, 44100,
+                          block_size=0)
+
+        # the chosen options should make a valid encode of every track
+        temp_files = [tempfile.NamedTemporaryFile(suffix=".flac")
+                      for i in range(3)]
+        try:
+            tracks = [audiotools.FlacAudio.from_pcm(
+                      temp.name,
+                      EXACT_RANDOM_PCM_Reader(pcm_frames=44100 * (i + 1),
+                                              channels=2))
+                      for (i, temp) in enumerate(temp_files)]
+            trial = audiotools.FlacAudio.autotune(tracks,
+                                                  sample_seconds=1,
+                                                  workers=2)
+            self.assertGreater(trial.size, 0)
+            with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+                flac_file = audiotools.FlacAudio.from_pcm(
+                    temp.name,
+                    tracks[2].to_pcm(),
+                    encoding_options=trial.options)
+                self.assertTrue(
+                    audiotools.pcm_frame_cmp(flac_file.to_pcm(),
+                                             tracks[2].to_pcm()) is None)
+        finally:
+            for temp in temp_files:
+                temp.close()
+
+    @FORMAT_FLAC
+    def test_encoding_verification(self):
+        # verified encodes should match unverified ones exactly
+        # whether or not the stream's length is known in advance
+        for (stream, options) in [
+            (test_streams.Sine8_Stereo(44101, 44100,
+                                       441.0, 0.50, 4410.0, 0.49, 1.0),
+             {}),
+            (test_streams.Sine16_Mono(44101, 44100,
+                                      441.0, 0.50, 882.0, 0.49),
+             {}),
+            (test_streams.Sine16_Stereo(44101, 44100,
+                                        441.0, 0.50, 4410.0, 0.49, 1.0),
+             {"mid_side": True, "adaptive_mid_side": True}),
+            (test_streams.Sine24_Stereo(44101, 44100,
+                                        8820.0, 0.70, 4410.0, 0.29, 0.1),
+             {"mid_side": True}),
+            (test_streams.Simple_Sine(44101, 44100, 0x003F, 16,
+                                      (6400, 10000),
+                                      (11520, 15000),
+                                      (16640, 20000),
+                                      (21760, 25000),
+                                      (26880, 30000),
+                                      (30720, 35000)),
+             {"block_size": 1152})]:
+            for total_pcm_frames in [0, 44101]:
+                encoded = []
+                for verify in [False, True]:
+                    stream.reset()
+                    with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+                        self.encode(temp.name,
+                                    stream,
+                                    "Python Audio Tools " + audiotools.VERSION,
+                                    total_pcm_frames=total_pcm_frames,
+                                    verify=verify,
+                                    **options)
+                        with open(temp.name, "rb") as f:
+                            encoded.append(f.read())
+                self.assertEqual(encoded[0], encoded[1])
+
+        with tempfile.NamedTemporaryFile(suffix=".flac") as temp:
+            flac_file = self.audio_class.from_pcm(
+                temp.name,
+                EXACT_RANDOM_PCM_Reader(pcm_frames=44101),
+                encoding_options={"verify": True})
+            self.assertTrue(flac_file.verify())
+
     @FORMAT_FLAC
     def test_verify(self):
         from test_core import bytes_to_ints, ints_to_bytes
@@ -4181,6 +4551,73 @@ class M4AFileTest(LossyFileTest):
             self.assertEqual(u"{}".format(metadata[b'ilst'][b'\xa9too']),
                              encoder)
 
+    @FORMAT_M4A
+    def test_in_process_codecs(self):
+        try:
+            from audiotools.encoders import encode_aac
+            from audiotools.decoders import AACDecoder
+        except ImportError:
+            self.skipTest("libfaac and libfaad2 required for this test")
+
+        class ShortReads(object):
+            # returns no more than a few hundred PCM frames per read
+            # regardless of how many are requested
+            def __init__(self, pcmreader):
+                self.pcmreader = pcmreader
+                self.sample_rate = pcmreader.sample_rate
+                self.channels = pcmreader.channels
+                self.channel_mask = pcmreader.channel_mask
+                self.bits_per_sample = pcmreader.bits_per_sample
+
+            def read(self, pcm_frames):
+                return self.pcmreader.read(min(pcm_frames, 333))
+
+            def close(self):
+                self.pcmreader.close()
+
+        def framelist(pcmreader):
+            data = audiotools.pcm.empty_framelist(pcmreader.channels,
+                                                  pcmreader.bits_per_sample)
+            f = pcmreader.read(4096)
+            while len(f) > 0:
+                data += f
+                f = pcmreader.read(4096)
+            pcmreader.close()
+            return data
+
+        for total_pcm_frames in [1, 1023, 1024, 1025, 44100, 100001]:
+            original = framelist(
+                test_streams.Sine16_Stereo(total_pcm_frames, 44100,
+                                           441.0, 0.50, 441.0, 0.49, 1.0))
+
+            with tempfile.NamedTemporaryFile(suffix=self.suffix) as temp:
+                with open(temp.name, "wb") as f:
+                    encode_aac(f,
+                               ShortReads(
+                                   test_streams.Sine16_Stereo(
+                                       total_pcm_frames, 44100,
+                                       441.0, 0.50, 441.0, 0.49, 1.0)),
+                               total_pcm_frames=total_pcm_frames)
+
+                # the edit list trims the encoder's delay and padding
+                # so the track keeps its original length
+                track = audiotools.open(temp.name)
+                self.assertEqual(track.total_frames(), total_pcm_frames)
+                with open(temp.name, "rb") as f:
+                    decoded = framelist(AACDecoder(f))
+                self.assertEqual(decoded.frames, total_pcm_frames)
+
+                # and short reads are encoded without gaps,
+                # which would throw the decoded sine out of phase
+                for start in range(0, total_pcm_frames - 4096, 4096):
+                    error = sum((a - b) ** 2
+                                for i in range(start, start + 4096)
+                                for (a, b) in zip(decoded.frame(i),
+                                                  original.frame(i)))
+                    signal = sum(a ** 2 for i in range(start, start + 4096)
+                                 for a in original.frame(i))
+                    self.assertLess(error, signal // 4)
+
 
 class MP3FileTest(LossyFileTest):
     def setUp(self):
@@ -5299,7 +5736,7 @@ class WavPackFileTest(TestForeignWaveChunks,
                 self.__test_reader__(g, 200000, **opts)
 
 
-class TTAFileTest(LosslessFileTest):
+class TTAFileTest(TestBatchedReads, LosslessFileTest):
     def setUp(self):
         self.audio_class = audiotools.TrueAudio
         self.suffix = "." + self.audio_class.SUFFIX
@@ -5777,6 +6214,66 @@ class TTAFileTest(LosslessFileTest):
                         bits_per_sample=16)),
                 pcm_frames)
 
+    @FORMAT_TTA
+    def test_threads(self):
+        from io import BytesIO
+        from audiotools.encoders import encode_tta
+
+        def encode(threads, total_pcm_frames):
+            # more frames than the largest batch, ending on a partial frame
+            output = BytesIO()
+            encode_tta(file=output,
+                       pcmreader=test_streams.Sine16_Stereo(
+                           46080 * 9 + 17, 44100,
+                           441.0, 0.61, 661.5, 0.37, 1.0),
+                       total_pcm_frames=total_pcm_frames,
+                       threads=threads)
+            return output.getvalue()
+
+        self.assertRaises(ValueError, encode, 0, 0)
+
+        for total_pcm_frames in [0, 46080 * 9 + 17]:
+            single_threaded = encode(1, total_pcm_frames)
+            for threads in [2, 3, 4, 8]:
+                self.assertEqual(encode(threads, total_pcm_frames),
+                                 single_threaded)
+
+    @FORMAT_TTA
+    def test_encoding_verification(self):
+        from io import BytesIO
+        from audiotools.encoders import encode_tta
+
+        # verified encodes should match unverified ones exactly
+        # whether or not the stream's length is known in advance
+        # and however many frames are encoded at once
+        for stream in [
+            test_streams.Sine8_Stereo(46080 * 4 + 17, 44100,
+                                      441.0, 0.50, 4410.0, 0.49, 1.0),
+            test_streams.Sine16_Mono(46080 * 4 + 17, 44100,
+                                     441.0, 0.50, 882.0, 0.49),
+            test_streams.Sine24_Stereo(46080 * 4 + 17, 44100,
+                                       8820.0, 0.70, 4410.0, 0.29, 0.1),
+            test_streams.Simple_Sine(46080 * 4 + 17, 44100, 0x003F, 16,
+                                     (6400, 10000),
+                                     (11520, 15000),
+                                     (16640, 20000),
+                                     (21760, 25000),
+                                     (26880, 30000),
+                                     (30720, 35000))]:
+            for total_pcm_frames in [0, 46080 * 4 + 17]:
+                for threads in [1, 3]:
+                    encoded = []
+                    for verify in [False, True]:
+                        stream.reset()
+                        output = BytesIO()
+                        encode_tta(file=output,
+                                   pcmreader=stream,
+                                   total_pcm_frames=total_pcm_frames,
+                                   threads=threads,
+                                   verify=verify)
+                        encoded.append(output.getvalue())
+                    self.assertEqual(encoded[0], encoded[1])
+
 
 class SineStreamTest(unittest.TestCase):
     @FORMAT_SINES
@@ -2194,6 +2194,77 @@ class track2track(UtilTest):
                         unsupported_bps_file.name),
                     bps=8))
 
+    @UTIL_TRACK2TRACK
+    def test_journal(self):
+        from audiotools.text import LAB_JOURNAL_RESUMED
+
+        track2 = self.input_format.from_pcm(
+            os.path.join(self.input_dir,
+                         "02.{}".format(self.input_format.SUFFIX)),
+            BLANK_PCM_Reader(2))
+        track2.set_metadata(audiotools.MetaData(track_name=u"Track 2",
+                                                track_number=2,
+                                                album_name=u"Album",
+                                                artist_name=u"Artist"))
+
+        journal = os.path.join(self.cwd_dir, "journal")
+        arguments = ["track2track",
+                     "-t", self.type,
+                     "-q", self.quality,
+                     "-d", self.output_dir,
+                     "--format", self.format,
+                     "--no-replay-gain",
+                     "--journal", journal,
+                     self.track1.filename,
+                     track2.filename]
+        outputs = [os.path.join(self.output_dir,
+                                "{:02d} - Track {:d}.{}".format(
+                                    i, i, self.output_format.SUFFIX))
+                   for i in [1, 2]]
+
+        # both conversions are journaled
+        # and no partial files are left behind
+        self.assertEqual(self.__run_app__(arguments), 0)
+        self.assertEqual(sorted(os.listdir(self.output_dir)),
+                         sorted(map(os.path.basename, outputs)))
+        with open(journal, "rb") as f:
+            self.assertEqual(len(f.read().splitlines()), 2)
+        for (output, track) in zip(outputs, [self.track1, track2]):
+            self.assertTrue(audiotools.pcm_cmp(
+                audiotools.open(output).to_pcm(), track.to_pcm()))
+
+        # resuming skips the completed conversion
+        # but redoes the one whose output has gone missing
+        mtime = os.stat(outputs[0]).st_mtime
+        os.unlink(outputs[1])
+        self.assertEqual(self.__run_app__(arguments), 0)
+        self.__check_info__(LAB_JOURNAL_RESUMED.format(1))
+        self.assertEqual(os.stat(outputs[0]).st_mtime, mtime)
+        self.assertTrue(audiotools.pcm_cmp(
+            audiotools.open(outputs[1]).to_pcm(), track2.to_pcm()))
+        with open(journal, "rb") as f:
+            self.assertEqual(len(f.read().splitlines()), 3)
+
+        # changing the source redoes its conversion
+        self.track1.set_metadata(self.track_metadata)
+        os.utime(self.track1.filename, (0, 0))
+        self.assertEqual(self.__run_app__(arguments), 0)
+        self.__check_info__(LAB_JOURNAL_RESUMED.format(1))
+        with open(journal, "rb") as f:
+            self.assertEqual(len(f.read().splitlines()), 4)
+
+        # changing the ReplayGain option redoes both conversions
+        # and journals the ReplayGain added to their album
+        arguments[arguments.index("--no-replay-gain")] = "--replay-gain"
+        self.assertEqual(self.__run_app__(arguments), 0)
+        for resumed in [1, 2]:
+            self.assertNotIn(LAB_JOURNAL_RESUMED.format(resumed),
+                             self.stderr.getvalue())
+        for output in outputs:
+            self.assertIsNotNone(audiotools.open(output).get_replay_gain())
+        with open(journal, "rb") as f:
+            self.assertEqual(len(f.read().splitlines()), 7)
+
     @UTIL_TRACK2TRACK
     def test_replay_gain(self):
         from audiotools.text import (LAB_ENCODE,
@@ -6142,3 +6213,31 @@ class trackverify(UtilTest):
             self.__check_output__(audiotools.VERSION_STR)
         else:
             self.__check_info__(audiotools.VERSION_STR.decode("ascii"))
+
+    @UTIL_TRACKVERIFY
+    def test_journal(self):
+        from shutil import rmtree
+        from audiotools.text import LAB_JOURNAL_RESUMED
+
+        temp_dir = tempfile.mkdtemp()
+        try:
+            good = audiotools.FlacAudio.from_pcm(
+                os.path.join(temp_dir, "good.flac"),
+                BLANK_PCM_Reader(1))
+            with open(good.filename, "rb") as f:
+                data = f.read()
+            with open(os.path.join(temp_dir, "bad.flac"), "wb") as f:
+                f.write(data[0:-10])
+            journal = os.path.join(temp_dir, "journal")
+            arguments = ["trackverify", "--journal", journal,
+                         good.filename, os.path.join(temp_dir, "bad.flac")]
+
+            # failed verifications are journaled as well
+            # and still fail when resumed
+            for i in range(2):
+                self.assertEqual(self.__run_app__(arguments), 1)
+                with open(journal, "rb") as f:
+                    self.assertEqual(len(f.read().splitlines()), 2)
+            self.__check_info__(LAB_JOURNAL_RESUMED.format(2))
+        finally:
+            rmtree(temp_dir)